@@ -2,6 +2,18 @@
 #include "tetris_graphics.h"
 #include "tetris_sound.h"
 #include "tetris_random.h"
+#include "tetris_board.h"
+#include "tetris_rules.h"
+#include "tetris_bot.h"
+#include "tetris_history.h"
+#include "tetris_hint.h"
+#include "tetris_game_state.h"
+#include "tetris_versus.h"
+#include "tetris_replay.h"
+#include "tetris_telemetry.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 
 /*
@@ -21,13 +33,7 @@ THINGS TO DO:
 
 #define AUDIO_CHANNEL_COUNT 32
 
-#define BOARD_WIDTH  10
-#define BOARD_HEIGHT 20
-
-#define AUTO_MOVE_DELAY 0.2f
-#define AUTO_MOVE       0.05f
-#define SOFT_DROP       0.033f
-#define LOCK_DELAY      0.5f
+#define MAX_TICKS_PER_FRAME 250
 
 #define BACKGROUND_MUSIC 0.75f
 #define SFX_MOVE         1.0f
@@ -38,68 +44,35 @@ THINGS TO DO:
 #define SFX_LEVEL_UP     1.5f
 #define SFX_SOFT_DROP    0.8f
 
-#define SCORE_SINGLE    40
-#define SCORE_DOUBLE    100
-#define SCORE_TRIPLE    300
-#define SCORE_TETRIS    1200
-#define SCORE_SOFT_DROP 1
-#define SCORE_HARD_DROP 2
-
-#define SAVE_DATA_PATH "data/data.txt"
-
-
-#define PRESSED(key) ((key).isDown && (key).didChangeState)
-
-
-typedef enum tetromino_type {
-    tetromino_type_empty = 0,
-    tetromino_type_I,
-    tetromino_type_O,
-    tetromino_type_T,
-    tetromino_type_S,
-    tetromino_type_Z,
-    tetromino_type_J,
-    tetromino_type_L,
-} tetromino_type;
-
-static const u16 TETROMINO_EMPTY[4] = { 0b0000000000000000, 0b0000000000000000, 0b0000000000000000, 0b0000000000000000 };
-static const u16 TETROMINO_I[4]     = { 0b0000111100000000, 0b0100010001000100, 0b0000000011110000, 0b0010001000100010 };
-static const u16 TETROMINO_O[4]     = { 0b0000011001100000, 0b0000011001100000, 0b0000011001100000, 0b0000011001100000 };
-static const u16 TETROMINO_T[4]     = { 0b0010011100000000, 0b0010011000100000, 0b0000011100100000, 0b0010001100100000 };
-static const u16 TETROMINO_S[4]     = { 0b0110001100000000, 0b0010011001000000, 0b0000011000110000, 0b0001001100100000 };
-static const u16 TETROMINO_Z[4]     = { 0b0011011000000000, 0b0100011000100000, 0b0000001101100000, 0b0010001100010000 };
-static const u16 TETROMINO_J[4]     = { 0b0001011100000000, 0b0110001000100000, 0b0000011101000000, 0b0010001000110000 };
-static const u16 TETROMINO_L[4]     = { 0b0100011100000000, 0b0010001001100000, 0b0000011100010000, 0b0011001000100000 };
-
-static const u16* TETROMINOES[8] = {
-    TETROMINO_EMPTY,
-    TETROMINO_I,
-    TETROMINO_O,
-    TETROMINO_T,
-    TETROMINO_S,
-    TETROMINO_Z,
-    TETROMINO_J,
-    TETROMINO_L
-};
-
-typedef struct tetromino_t {
-    tetromino_type type;
-    i32 rotation;
-    i32 x;
-    i32 y;
-} tetromino_t;
+#define DEMO_DELAY       20.0f // Seconds of nothing happening on the main menu before the bot starts playing
+#define DEMO_INPUT_DELAY 0.06f // Between the bot's key presses, so it looks like someone is playing. 0 plays as fast as the game allows
+#define BOT_MAX_REPLANS  8     // Per piece. The move generator doesn't know about gravity, so some paths can never be followed
+#define HINT_OPACITY     128   // The ghost piece is 64
+
+#define BOARD_VIEW_WIDTH_PX  450 // The frame in the background the board goes in
+#define BOARD_VIEW_HEIGHT_PX 900
+#define MARATHON_TILE_SIZE   15  // Boards bigger than normal get smaller tiles, so more of them fits in the frame
+#define MARATHON_MAX_SIZE    4096
+
+#define NEXT_BOX_X    1298 // Where the pieces in the next box get drawn, the first one at the top
+#define NEXT_BOX_Y    788
+#define NEXT_BOX_STEP 135
+#define HOLD_BOX_X    533
+#define HOLD_BOX_Y    788
+
+#define REPLAY_SEEK_SHORT 5.0f  // Seconds left and right skip in the replay viewer
+#define REPLAY_SEEK_LONG  60.0f // Same for up and down
+
+#define VERSUS_TILE_SIZE   30   // Of the other player's board, which goes where there is room on the right
+#define VERSUS_REMOTE_X    1450
+#define VERSUS_REMOTE_Y    240
+#define VERSUS_GARBAGE_BAR 0xCC3333
+
+#define SAVE_DATA_PATH      "data/data.txt"
+#define SUSPENDED_GAME_PATH "data/suspended.bin" // Only there while a game is suspended
+#define REPLAY_PATH         "data/replay.bin"    // Of the last game played, up to where it ended or got suspended
+#define TELEMETRY_PATH      "data/telemetry.bin" // Stats of every piece ever played, see tetris_telemetry.c
 
-typedef struct board_t {
-    tetromino_type* tiles;
-    i32 width;
-    i32 height;
-    i32 size;     // ?
-    i32 x;
-    i32 y;
-    i32 tileSize;
-    i32 widthPx;  // ?
-    i32 heightPx; // ?
-} board_t;
 
 typedef enum button_state {
     button_state_idle = 0,
@@ -132,6 +105,20 @@ typedef struct global_state {
     i32 musicSampleIndex; // Bad solution
 
     save_data saveData;
+
+    // Of the boards games get played on. Anything other than BOARD_WIDTH by BOARD_HEIGHT is marathon mode, see OnStartup
+    i32 boardWidth;
+    i32 boardHeight;
+    b32 isPractice; // Placements can be undone and redone
+    b32 isHinting;  // Scene1 shows where the bot would put the current piece
+
+    // -versus, see OnStartup. Start on the main menu goes to Scene6 instead
+    b32 isVersus;
+    u16 versusLocalPort;
+    u16 versusRemotePort;
+    versus_network_settings versusNetwork;
+
+    char replayPath[256]; // -replay, see OnStartup
 } global_state;
 
 typedef struct global_data {
@@ -150,6 +137,9 @@ static void* g_sceneData;
     * Scene 2: Main menu
     * Scene 3: Paused
     * Scene 4: Options
+    * Scene 5: Controls
+    * Scene 6: Versus
+    * Scene 7: Replay
 */
 
 static void InitScene1(void);
@@ -157,173 +147,88 @@ static void InitScene2(void);
 static void InitScene3(void);
 static void InitScene4(void);
 static void InitScene5(void);
+static void InitScene6(void);
+static void InitScene7(void);
 static void Scene1(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
 static void Scene2(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
 static void Scene3(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
 static void Scene5(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
 static void Scene4(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
+static void Scene6(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
+static void Scene7(bitmap_buffer*, sound_buffer*, keyboard_state*, f32);
 static void CloseScene1(void);
 static void CloseScene2(void);
 static void CloseScene3(void);
 static void CloseScene4(void);
 static void CloseScene5(void);
+static void CloseScene6(void);
+static void CloseScene7(void);
 
 
-static board_t InitBoard(i32 width, i32 height, i32 x, i32 y, i32 tileSize) {
-    return (board_t) {
-        .tiles    = EngineAllocate(width * height * sizeof(tetromino_type)),
-        .width    = width,
-        .height   = height,
-        .x        = x,
-        .y        = y,
-        .tileSize = tileSize,
-        .size     = width * height,
-        .widthPx  = width * tileSize,
-        .heightPx = height * tileSize
-    };
-}
-
-static void SetBoardTileSize(board_t* board, i32 tileSize) {
-    board->tileSize = tileSize;
-    board->widthPx  = board->width  * tileSize;
-    board->heightPx = board->height * tileSize;
-}
-
-static void ClearBoard(board_t* board) {
-    for (i32 i = 0; i < board->size; ++i) {
-        board->tiles[i] = tetromino_type_empty;
+static void DrawTetrominoInScreen(bitmap_buffer* graphicsBuffer, tetromino_t* tetromino, i32 size, bitmap_buffer* sprite, i32 opacity) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    for (i32 i = 0; i < shape->cellsCount; ++i) {
+        i32 xOffset = shape->cells[i].x * size;
+        i32 yOffset = shape->cells[i].y * size;
+        DrawBitmap(graphicsBuffer, sprite, tetromino->x + xOffset, tetromino->y + yOffset, size, opacity);
     }
 }
 
-static tetromino_t InitTetromino(tetromino_type type, i32 rotation, i32 x, i32 y) {
-    return (tetromino_t){ .type = type, .rotation = rotation, .x = x, .y = y };
-}
-
-static void PlaceTetromino(board_t* board, tetromino_t* tetromino) {
-    u16 bitField = TETROMINOES[tetromino->type][tetromino->rotation];
-    for (i32 i = 0; i < 16; ++i) { 
-        if (bitField & (1 << i)) {
-            i32 x = tetromino->x + i % 4;
-            i32 y = tetromino->y + i / 4;
-            board->tiles[y * board->width + x] = tetromino->type;
-        }
+// Draws a tile at a (possibly in between) position on the board, unless it is out of the board's view
+static void DrawTileInBoard(bitmap_buffer* graphicsBuffer, board_t* board, f32 x, f32 y, bitmap_buffer* sprite, i32 opacity) {
+    x -= board->viewX;
+    y -= board->viewY;
+    if (x < -0.5f || x >= board->viewColumns - 0.5f || y < -0.5f || y >= board->viewRows - 0.5f) {
+        return;
     }
-}
 
-static void DrawTetrominoInScreen(bitmap_buffer* graphicsBuffer, tetromino_t* tetromino, i32 size, bitmap_buffer* sprite, i32 opacity) {
-    u16 bitField = TETROMINOES[tetromino->type][tetromino->rotation];
-    for (i32 i = 0; i < 16; ++i) { 
-        if (bitField & (1 << i)) {
-            i32 xOffset = (i % 4) * size;
-            i32 yOffset = (i / 4) * size;
-            DrawBitmap(graphicsBuffer, sprite, tetromino->x + xOffset, tetromino->y + yOffset, size, opacity);
-        }
-    }
+    i32 xPx = board->x + (i32)(x * board->tileSize + 0.5f);
+    i32 yPx = board->y + (i32)(y * board->tileSize + 0.5f);
+    DrawBitmap(graphicsBuffer, sprite, xPx, yPx, board->tileSize, opacity);
 }
 
 static void DrawTetrominoInBoard(bitmap_buffer* graphicsBuffer, board_t* board, tetromino_t* tetromino, bitmap_buffer* sprite, i32 opacity) {
-    u16 bitField = TETROMINOES[tetromino->type][tetromino->rotation];
-    for (i32 i = 0; i < 16; ++i) { 
-        if (bitField & (1 << i)) {
-            i32 x = tetromino->x + (i % 4);
-            i32 y = tetromino->y + (i / 4);
-            DrawBitmap(graphicsBuffer, sprite, board->x + x * board->tileSize, board->y + y * board->tileSize, board->tileSize, opacity);
-        }
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    for (i32 i = 0; i < shape->cellsCount; ++i) {
+        i32 x = tetromino->x + shape->cells[i].x;
+        i32 y = tetromino->y + shape->cells[i].y;
+        DrawTileInBoard(graphicsBuffer, board, (f32)x, (f32)y, sprite, opacity);
     }
 }
 
-static void DrawBoard(bitmap_buffer* graphicsBuffer, board_t* board, bitmap_buffer* sprites) {
-    for (i32 y = 0; y < board->height; ++y) {
-        for (i32 x = 0; x < board->width; ++x) {
-            tetromino_type tile = board->tiles[y * board->width + x];
-            if (tile != tetromino_type_empty) {
-                DrawBitmap(graphicsBuffer, &sprites[tile], board->x + x * board->tileSize, board->y + y * board->tileSize, board->tileSize, 255);
-            }
-        }
-    }
-}
-
-static b32 IsTetrominoPosValid(board_t* board, tetromino_t* tetromino) {
-    u16 bitField = TETROMINOES[tetromino->type][tetromino->rotation];
-    for (i32 i = 0; i < 16; ++i) { 
-        if (bitField & (1 << i)) {
-            i32 x = tetromino->x + (i % 4);
-            i32 y = tetromino->y + (i / 4);
-            if (x < 0 || x >= board->width || y < 0 || board->tiles[y * board->width + x] != tetromino_type_empty) {
-                return false;
-            }
-        }
+// Slides between where the tetromino was and where it is now. Anything other than a single step (rotating, holding, spawning) just snaps
+static void DrawTetrominoInBoardInterpolated(bitmap_buffer* graphicsBuffer, board_t* board, tetromino_t* previous, tetromino_t* current, f32 t, bitmap_buffer* sprite, i32 opacity) {
+    i32 dx = current->x - previous->x;
+    i32 dy = current->y - previous->y;
+    if (previous->type != current->type || previous->rotation != current->rotation || dx < -1 || dx > 1 || dy < -1 || dy > 1) {
+        DrawTetrominoInBoard(graphicsBuffer, board, current, sprite, opacity);
+        return;
     }
 
-    return true;
-}
-
-static i32 ProcessLineClears(board_t* board, tetromino_t* tetromino) {
-    i32 lineClearCount = 0;
-
-    i32 y = tetromino->y + 3;
-    while (y >= 0 && y >= tetromino->y) {
-        b32 isLineClear = true;
-        for (i32 x = 0; x < board->width; ++x) {
-            if (board->tiles[y * board->width + x] == tetromino_type_empty) {
-                isLineClear = false;
-                break;
-            }
-        }
+    f32 x = previous->x + t * dx;
+    f32 y = previous->y + t * dy;
 
-        if (isLineClear) {
-            ++lineClearCount;
-            for (i32 i = y; i < board->height - 1; ++i) {
-                for (i32 j = 0; j < board->width; ++j) {
-                    board->tiles[i * board->width + j] = board->tiles[(i + 1) * board->width + j];
-                }
-            }
-        }
-
-        --y;
+    const piece_shape* shape = GetPieceShape(current->type, current->rotation);
+    for (i32 i = 0; i < shape->cellsCount; ++i) {
+        DrawTileInBoard(graphicsBuffer, board, x + shape->cells[i].x, y + shape->cells[i].y, sprite, opacity);
     }
-
-    return lineClearCount;
 }
 
-static void RandomizeBag(tetromino_type* bag) {
-    for (i32 i = 0; i < 7;) {
-        i32 attempt = RandomI32InRange(1, 7);
-        for (i32 j = 0; j < i; ++j) {
-            if (bag[j] == attempt) {
-                attempt = -1;
-                break;
+// Only looks at the tiles in view, and not at the rows in view above the stack, so it costs the same for any size of board
+static void DrawBoard(bitmap_buffer* graphicsBuffer, board_t* board, bitmap_buffer* sprites) {
+    i32 top = Min(board->viewY + board->viewRows, board->stackHeight);
+    for (i32 y = board->viewY; y < top; ++y) {
+        for (i32 x = board->viewX; x < board->viewX + board->viewColumns; ++x) {
+            tetromino_type tile = GetBoardTile(board, x, y);
+            if (tile != tetromino_type_empty) {
+                i32 xPx = board->x + (x - board->viewX) * board->tileSize;
+                i32 yPx = board->y + (y - board->viewY) * board->tileSize;
+                DrawBitmap(graphicsBuffer, &sprites[tile], xPx, yPx, board->tileSize, 255);
             }
         }
-        if (attempt == -1) {
-            continue;
-        }
-        bag[i] = attempt;
-        ++i;
     }
 }
 
-static tetromino_type GetNextTetrominoFromBag(tetromino_type* bag, i32* bagIndex) {
-    tetromino_type result = bag[(*bagIndex)++];
-
-    if (*bagIndex >= 7) {
-        *bagIndex = 0;
-        RandomizeBag(bag);
-    }
-
-    return result;
-}
-
-static f32 GetCurrentGravityInSeconds(i32 level) {
-    f32 gravityInSeconds = 1.0f;
-    f32 base = 0.8f - (level - 1) * 0.007f;
-    for (i32 i = 0; i < level - 1; ++i) {
-        gravityInSeconds *= base;
-    }
-
-    return gravityInSeconds;
-}
-
 static void ResetSaveData(save_data* data) {
     *data = (save_data){
         .highScore = 0,
@@ -355,6 +260,77 @@ static void WriteSaveData(const char* filePath, save_data* data) {
     EngineWriteEntireFile(filePath, data, sizeof(save_data));
 }
 
+// Subscribed to game_event_game_over of games a person played
+static void SaveHighScore(void* data, game_event* event) {
+    if (event->score <= g_globalState.saveData.highScore) {
+        return;
+    }
+
+    g_globalState.saveData.highScore = event->score;
+
+    save_data saveData = ReadSaveData(SAVE_DATA_PATH);
+    saveData.highScore = g_globalState.saveData.highScore;
+    WriteSaveData(SAVE_DATA_PATH, &saveData);
+}
+
+// What a game sounds like. Scenes with a game in them subscribe PlayGameEventSound to its events with this as the data
+typedef struct game_sounds {
+    sound_buffer move;
+    sound_buffer rotate;
+    sound_buffer lock;
+    sound_buffer lineClear;
+    sound_buffer hold;
+    sound_buffer levelUp;
+    sound_buffer softDrop;
+} game_sounds;
+
+#define GAME_SOUND_EVENTS (GAME_EVENT_BIT(game_event_moved) | GAME_EVENT_BIT(game_event_rotated) | GAME_EVENT_BIT(game_event_held) | GAME_EVENT_BIT(game_event_soft_dropped) | \
+                           GAME_EVENT_BIT(game_event_locked) | GAME_EVENT_BIT(game_event_cleared) | GAME_EVENT_BIT(game_event_level_up))
+
+static void LoadGameSounds(game_sounds* sounds) {
+    // Look these over
+    sounds->move      = LoadWAV("assets/audio/sfx1.wav");
+    sounds->rotate    = LoadWAV("assets/audio/sfx4.wav");
+    sounds->lock      = LoadWAV("assets/audio/sfx3.wav");
+    sounds->lineClear = LoadWAV("assets/audio/sfx5.wav");
+    sounds->hold      = LoadWAV("assets/audio/sfx2.wav");
+    sounds->levelUp   = LoadWAV("assets/audio/sfx6.wav");
+    sounds->softDrop  = LoadWAV("assets/audio/sfx1.wav");
+}
+
+// A piece that locks makes one sound: the level up one if it did that, the line clear one if it did that, and the lock one otherwise
+static void PlayGameEventSound(void* data, game_event* event) {
+    game_sounds* sounds = data;
+
+    sound_buffer* sound = 0;
+    f32 volume = 0.0f;
+    switch (event->type) {
+        case game_event_moved:        sound = &sounds->move;     volume = SFX_MOVE;      break;
+        case game_event_rotated:      sound = &sounds->rotate;   volume = SFX_ROTATE;    break;
+        case game_event_held:         sound = &sounds->hold;     volume = SFX_HOLD;      break;
+        case game_event_soft_dropped: sound = &sounds->softDrop; volume = SFX_SOFT_DROP; break;
+        case game_event_level_up:     sound = &sounds->levelUp;  volume = SFX_LEVEL_UP;  break;
+        case game_event_cleared:
+            if (!event->cleared.didLevelUp) {
+                sound = &sounds->lineClear;
+                volume = SFX_LINE_CLEAR;
+            }
+            break;
+        case game_event_locked:
+            if (event->locked.linesCount == 0) {
+                sound = &sounds->lock;
+                volume = SFX_LOCK;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (sound) {
+        PlaySound(sound, false, volume * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    }
+}
+
 static inline b32 IsPointInRect(i32 px, i32 py, i32 rxl, i32 ryl, i32 rxr, i32 ryr) {
     return px >= rxl && px < rxr && py >= ryl && py < ryr;
 }
@@ -395,24 +371,70 @@ static void UpdateButtonState(button_t* button, i32 mouseX, i32 mouseY, keyboard
 
 // SCENE 1: Gameplay //
 
-typedef struct scene1_state {
-    f32 timerFall;
-    f32 timerAutoMoveDelay;
-    f32 timerAutoMove;
-    f32 timerLockDelay;
-
-    board_t board;
-    tetromino_t current;
-    tetromino_t next[3];
-    tetromino_t hold;
-    b32 didUseHoldBox;
-    tetromino_type bag[7];
-    i32 bagIndex;
+typedef struct tick_input_event {
+    u32 tick; // The tick that should see this change
+    i32 keyIndex;
+    b32 isDown;
+} tick_input_event;
+
+// What practice mode keeps of the game every time a piece spawns, apart from the board
+typedef struct scene1_snapshot {
+    tetromino_type current;
+    tetromino_type next[3];
+    tetromino_type hold;
+    tetromino_bag bag;
     i32 score;
     i32 level;
     i32 lines;
+} scene1_snapshot;
+
+typedef struct scene1_state {
+    game_state game;
+    board_t board;
+    b32 isBoardInGame;    // Normal boards use game's tiles, bigger ones have their own. Only the first kind can be suspended
+
+    f32 secondsSinceLastTick;
+    keyboard_state input; // What the keyboard looked like as of the last tick
+    tick_input_event pendingEvents[2 * MAX_INPUT_EVENTS];
+    i32 pendingEventsCount;
+
+    game_events events; // Of the tick being run, published at the end of it
+    game_event_bus eventBus;
 
     button_t buttonPause;
+
+    b32 isPractice;
+    board_history history;
+
+    b32 isRecording; // Everything but the demo
+    replay_recorder replay;
+
+    // Normal games only. Practice games get undone and demo games aren't played by anyone, so their stats would mean little
+    b32 hasTelemetry;
+    telemetry_t telemetry;
+    u32 telemetryGame;
+    u32 telemetryPiece; // piecesSpawned as of the piece the two below are about
+    u32 pieceSpawnTick;
+    i32 pieceInputsCount;
+
+    b32 isHinting;
+    hint_t hint;
+    i32 hintId;    // Of the request for the current piece
+    u32 hintPiece; // piecesSpawned when it went out
+
+    // Demo mode. The bot presses keys in input instead of the player
+    b32 isDemo;
+    bot_t bot;
+    bot_move botMove;
+    b32 hasBotMove;
+    u32 botPiece; // piecesSpawned when the inputs below were planned
+    move_input botInputs[MOVE_GEN_MAX_PATH];
+    tetromino_t botExpected[MOVE_GEN_MAX_PATH]; // Where the piece should be after each of the inputs
+    tetromino_t botStart;
+    i32 botInputsCount;
+    i32 botInputIndex;
+    i32 botReplansCount;
+    i32 timerBotInput;
 } scene1_state;
 
 typedef struct scene1_data {
@@ -424,18 +446,13 @@ typedef struct scene1_data {
     bitmap_buffer buttonPauseUnpaused;
 
     sound_buffer backgroundMusic;
-    sound_buffer sfxMove;
-    sound_buffer sfxRotate;
-    sound_buffer sfxLock;
-    sound_buffer sfxLineClear;
-    sound_buffer sfxHold;
-    sound_buffer sfxLevelUp;
-    sound_buffer sfxSoftDrop;
+    game_sounds sounds;
 } scene1_data;
 
-static void InitScene1(void) {
-    g_sceneState = EngineAllocate(sizeof(scene1_state));
-    g_sceneData  = EngineAllocate(sizeof(scene1_data));
+static void InitScene1WithBoard(i32 boardWidth, i32 boardHeight) {
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene1_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene1_data), memory_tag_scene);
 
     scene1_state* state = g_sceneState;
     scene1_data*  data  = g_sceneData;
@@ -462,15 +479,7 @@ static void InitScene1(void) {
     data->buttonPauseUnpaused = LoadBMP("assets/graphics/button_pause_unpaused.bmp");
 
     data->backgroundMusic = LoadWAV("assets/audio/tetris_theme.wav");
-
-    // Look these over
-    data->sfxMove      = LoadWAV("assets/audio/sfx1.wav");
-    data->sfxRotate    = LoadWAV("assets/audio/sfx4.wav");
-    data->sfxLock      = LoadWAV("assets/audio/sfx3.wav");
-    data->sfxLineClear = LoadWAV("assets/audio/sfx5.wav"); 
-    data->sfxHold      = LoadWAV("assets/audio/sfx2.wav");
-    data->sfxLevelUp   = LoadWAV("assets/audio/sfx6.wav");
-    data->sfxSoftDrop  = LoadWAV("assets/audio/sfx1.wav");
+    LoadGameSounds(&data->sounds);
 
     StopAllSounds(g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
     PlaySound(&data->backgroundMusic, true, BACKGROUND_MUSIC * g_globalState.saveData.musicVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
@@ -480,19 +489,17 @@ static void InitScene1(void) {
 
     RandomInit();
 
-    state->board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 735, 90, 45);
-
-    RandomizeBag(state->bag);
-
-    state->current = InitTetromino(GetNextTetrominoFromBag(state->bag, &state->bagIndex), 0, BOARD_WIDTH / 2 - 2, BOARD_HEIGHT - 4);
-    state->next[0] = InitTetromino(GetNextTetrominoFromBag(state->bag, &state->bagIndex), 0, 1298, 788);
-    state->next[1] = InitTetromino(GetNextTetrominoFromBag(state->bag, &state->bagIndex), 0, 1298, 653);
-    state->next[2] = InitTetromino(GetNextTetrominoFromBag(state->bag, &state->bagIndex), 0, 1298, 518);
-    state->hold = InitTetromino(tetromino_type_empty, 0, 533, 788);
+    if (boardWidth == BOARD_WIDTH && boardHeight == BOARD_HEIGHT) {
+        state->board = InitBoardInMemory(boardWidth, boardHeight, state->game.boardMemory, 735, 90, 45);
+        state->isBoardInGame = true;
+    }
+    else {
+        state->board = InitBoardInMemory(boardWidth, boardHeight, EngineAllocateScene(BOARD_MEMORY_SIZE(boardWidth, boardHeight), memory_tag_game), 735, 90, MARATHON_TILE_SIZE);
+        SetBoardView(&state->board, BOARD_VIEW_WIDTH_PX / MARATHON_TILE_SIZE, BOARD_VIEW_HEIGHT_PX / MARATHON_TILE_SIZE);
+    }
 
-    state->score = 0;
-    state->level = 1;
-    state->lines = 0;
+    InitGameState(&state->game, &state->board, RandomSplit());
+    SubscribeToGameEvents(&state->eventBus, GAME_SOUND_EVENTS, PlayGameEventSound, &data->sounds);
 
     save_data saveData = ReadSaveData(SAVE_DATA_PATH);
     g_globalState.saveData.highScore = saveData.highScore;
@@ -506,49 +513,348 @@ static void InitScene1(void) {
     };
 }
 
-static void CloseScene1(void) {
+// Subscribed to game_event_locked when there is telemetry
+static void RecordScene1Piece(void* data, game_event* event) {
+    scene1_state* state = data;
+    tetromino_t* piece = &event->locked.piece;
+
+    telemetry_piece record = {
+        .game       = state->telemetryGame,
+        .tick       = event->tick,
+        .spawnTicks = event->tick - state->pieceSpawnTick,
+        .x          = (i16)piece->x,
+        .y          = (i16)piece->y,
+        .type       = (u8)piece->type,
+        .rotation   = (u8)piece->rotation,
+        .lines      = (u8)event->locked.linesCount,
+        .inputs     = (u8)Min(state->pieceInputsCount, 255),
+        .level      = (u16)event->locked.level
+    };
+    RecordTelemetryPiece(&state->telemetry, &record);
+}
+
+static void PushScene1Snapshot(scene1_state* state) {
+    scene1_snapshot snapshot = {
+        .current = state->game.current.type,
+        .next    = { state->game.next[0], state->game.next[1], state->game.next[2] },
+        .hold    = state->game.hold,
+        .bag     = state->game.bag,
+        .score   = state->game.score,
+        .level   = state->game.level,
+        .lines   = state->game.lines
+    };
+    PushBoardHistory(&state->history, &state->board, &snapshot);
+}
+
+// The board is already back to how it was, this does the rest
+static void RestoreScene1Snapshot(scene1_state* state, scene1_snapshot* snapshot) {
+    state->game.current = SpawnTetromino(&state->board, snapshot->current);
+    state->game.previous = state->game.current;
+    ++state->game.piecesSpawned;
+    for (i32 i = 0; i < 3; ++i) {
+        state->game.next[i] = snapshot->next[i];
+    }
+    state->game.hold = snapshot->hold;
+    state->game.didUseHoldBox = false;
+    state->game.bag = snapshot->bag;
+    state->game.score = snapshot->score;
+    state->game.level = snapshot->level;
+    state->game.lines = snapshot->lines;
+
+    state->game.timerFall = 0;
+    state->game.timerAutoMoveDelay = 0;
+    state->game.timerAutoMove = 0;
+    state->game.timerLockDelay = 0;
+}
+
+static void InitScene1(void) {
+    InitScene1WithBoard(g_globalState.boardWidth, g_globalState.boardHeight);
+
     scene1_state* state = g_sceneState;
-    scene1_data*  data  = g_sceneData;
 
+    // Picks up a suspended game where it was left, and only once
+    game_state suspended;
+    if (state->isBoardInGame && ReadGameStateFile(SUSPENDED_GAME_PATH, &suspended)) {
+        RestoreGameState(&state->game, &state->board, &suspended);
+        EngineDeleteFile(SUSPENDED_GAME_PATH);
+    }
 
-    EngineFree(data->tetrominoes[1].memory);
-    EngineFree(data->tetrominoes[2].memory);
-    EngineFree(data->tetrominoes[3].memory);
-    EngineFree(data->tetrominoes[4].memory);
-    EngineFree(data->tetrominoes[5].memory);
-    EngineFree(data->tetrominoes[6].memory);
-    EngineFree(data->tetrominoes[7].memory);
+    if (g_globalState.isPractice) {
+        state->isPractice = true;
+        InitBoardHistory(&state->history, &state->board, sizeof(scene1_snapshot));
+        PushScene1Snapshot(state);
+    }
 
-    EngineFree(data->tetrominoesUI[1].memory);
-    EngineFree(data->tetrominoesUI[2].memory);
-    EngineFree(data->tetrominoesUI[3].memory);
-    EngineFree(data->tetrominoesUI[4].memory);
-    EngineFree(data->tetrominoesUI[5].memory);
-    EngineFree(data->tetrominoesUI[6].memory);
-    EngineFree(data->tetrominoesUI[7].memory);
+    // The bot only knows normal boards
+    if (g_globalState.isHinting && g_globalState.boardWidth == BOARD_WIDTH && g_globalState.boardHeight == BOARD_HEIGHT) {
+        state->isHinting = InitHint(&state->hint);
+        state->hintPiece = state->game.piecesSpawned - 1; // So the first piece gets one too
+    }
 
-    EngineFree(data->background.memory);
+    state->isRecording = true;
+    InitReplayRecorder(&state->replay, &state->game, &state->board);
 
-    EngineFree(data->buttonPauseUnpaused.memory);
+    if (state->isBoardInGame && !state->isPractice) {
+        state->hasTelemetry = InitTelemetry(&state->telemetry, TELEMETRY_PATH);
+        state->telemetryGame = RandomU32();
+        state->telemetryPiece = state->game.piecesSpawned;
+        state->pieceSpawnTick = state->game.tickCount;
+    }
+    if (state->hasTelemetry) {
+        SubscribeToGameEvents(&state->eventBus, GAME_EVENT_BIT(game_event_locked), RecordScene1Piece, state);
+    }
 
-    EngineFree(data->backgroundMusic.samples);
-    EngineFree(data->sfxMove.samples);
-    EngineFree(data->sfxRotate.samples);
-    EngineFree(data->sfxLock.samples);
-    EngineFree(data->sfxLineClear.samples);
-    EngineFree(data->sfxHold.samples);
-    EngineFree(data->sfxLevelUp.samples);
-    EngineFree(data->sfxSoftDrop.samples);
+    // Undo makes a practice score worth nothing
+    if (!state->isPractice) {
+        SubscribeToGameEvents(&state->eventBus, GAME_EVENT_BIT(game_event_game_over), SaveHighScore, 0);
+    }
+}
+
+static void CloseScene1(void) {
+    scene1_state* state = g_sceneState;
 
-    EngineFree(state->board.tiles);
+
+    // The sprites, sounds and the board (when it isn't the game's own) are scene memory, EnginePopSceneMemory takes care of them
+    if (state->isPractice) {
+        FreeBoardHistory(&state->history);
+    }
+    if (state->isDemo) {
+        FreeBot(&state->bot);
+    }
+    if (state->isHinting) {
+        FreeHint(&state->hint);
+    }
+    if (state->isRecording) {
+        WriteReplayFile(&state->replay, REPLAY_PATH);
+        FreeReplayRecorder(&state->replay);
+    }
+    if (state->hasTelemetry) {
+        FreeTelemetry(&state->telemetry);
+    }
 
 
-    EngineFree(g_sceneState);
-    EngineFree(g_sceneData);
+    EnginePopSceneMemory();
     g_sceneState = 0;
     g_sceneData  = 0;
 }
 
+// Applies the pending events that are due by the given tick, in order. A key only changes once per tick, so that
+// a tap that is released within the same tick still gets seen as a press. Whatever is left waits for the next tick
+static void ApplyTickInputEvents(scene1_state* state, u32 tick) {
+    b32 didKeyChange[ArraySize(state->input.keys)] = { 0 };
+
+    i32 appliedCount = 0;
+    while (appliedCount < state->pendingEventsCount) {
+        tick_input_event* event = &state->pendingEvents[appliedCount];
+        if ((i32)(event->tick - tick) > 0 || didKeyChange[event->keyIndex]) {
+            break;
+        }
+
+        keyboard_key_state* key = &state->input.keys[event->keyIndex];
+        if (key->isDown != event->isDown) {
+            key->isDown = event->isDown;
+            key->didChangeState = true;
+            didKeyChange[event->keyIndex] = true;
+        }
+        ++appliedCount;
+    }
+
+    state->pendingEventsCount -= appliedCount;
+    for (i32 i = 0; i < state->pendingEventsCount; ++i) {
+        state->pendingEvents[i] = state->pendingEvents[i + appliedCount];
+    }
+}
+
+// Always on a normal board, that is all the bot knows how to play
+static void InitScene1Demo(void) {
+    InitScene1WithBoard(BOARD_WIDTH, BOARD_HEIGHT);
+
+    scene1_state* state = g_sceneState;
+    state->isDemo = true;
+    InitBot(&state->bot);
+}
+
+static keyboard_key_state* GetBotInputKey(keyboard_state* input, move_input moveInput) {
+    switch (moveInput) {
+        case move_input_left:       return &input->left;
+        case move_input_right:      return &input->right;
+        case move_input_rotate_cw:  return &input->x;
+        case move_input_rotate_ccw: return &input->z;
+        case move_input_soft_drop:  return &input->down;
+        case move_input_hard_drop:  return &input->spacebar;
+        default:                    return 0;
+    }
+}
+
+static void SetBotKey(keyboard_key_state* key, b32 isDown) {
+    if (key->isDown != isDown) {
+        key->isDown = isDown;
+        key->didChangeState = true;
+    }
+}
+
+static inline b32 AreTetrominoesEqual(tetromino_t* a, tetromino_t* b) {
+    return a->type == b->type && a->rotation == b->rotation && a->x == b->x && a->y == b->y;
+}
+
+// Finds the inputs that take the current piece from where it is now to where the bot wants it. Returns false if it can't get there anymore
+static b32 PlanBotInputs(scene1_state* state) {
+    move_generator* generator = &state->bot.generators[0]; // Thread 0 is us when no jobs are running
+    i32 placementsCount = GeneratePlacements(generator, &state->board, &state->game.current);
+
+    for (i32 i = 0; i < placementsCount; ++i) {
+        if (!DoTetrominoesCoverSameTiles(&generator->placements[i].tetromino, &state->botMove.placement)) {
+            continue;
+        }
+
+        state->botInputsCount = GetPlacementPath(generator, i, state->botInputs, ArraySize(state->botInputs));
+        state->botInputIndex = 0;
+        state->botStart = state->game.current;
+        state->botPiece = state->game.piecesSpawned;
+
+        // Play the inputs out with the same rules the tick uses, so we can tell when something (gravity) got in the way
+        tetromino_t expected = state->game.current;
+        for (i32 j = 0; j < state->botInputsCount; ++j) {
+            switch (state->botInputs[j]) {
+                case move_input_left:       TryMoveTetromino(&state->board, &expected, -1, 0); break;
+                case move_input_right:      TryMoveTetromino(&state->board, &expected, 1, 0);  break;
+                case move_input_rotate_cw:  TryRotateTetromino(&state->board, &expected, 1);   break;
+                case move_input_rotate_ccw: TryRotateTetromino(&state->board, &expected, -1);  break;
+                case move_input_soft_drop:  TryMoveTetromino(&state->board, &expected, 0, -1); break;
+                case move_input_hard_drop:  expected.y -= GetDropDistance(&state->board, &expected); break;
+                default: break;
+            }
+            state->botExpected[j] = expected;
+        }
+
+        return state->botInputsCount > 0;
+    }
+
+    return false;
+}
+
+// Presses keys in state->input like a player would. Keys get let go of the tick after they were pressed, except for
+// soft drop, which is held until the piece gets low enough
+static void UpdateBotInput(scene1_state* state) {
+    keyboard_state* input = &state->input;
+
+    b32 isSoftDropping = false;
+    if (state->botPiece == state->game.piecesSpawned && state->botInputIndex < state->botInputsCount && state->botInputs[state->botInputIndex] == move_input_soft_drop) {
+        tetromino_t* target = &state->botExpected[state->botInputIndex];
+        isSoftDropping = state->game.current.x == target->x && state->game.current.rotation == target->rotation && state->game.current.y >= target->y;
+        while (isSoftDropping && state->game.current.y <= state->botExpected[state->botInputIndex].y) {
+            ++state->botInputIndex;
+            isSoftDropping = state->botInputIndex < state->botInputsCount && state->botInputs[state->botInputIndex] == move_input_soft_drop;
+        }
+    }
+
+    for (i32 i = 0; i < ArraySize(input->keys); ++i) {
+        if (&input->keys[i] != &input->down || !isSoftDropping) {
+            SetBotKey(&input->keys[i], false);
+        }
+    }
+
+    if (isSoftDropping) {
+        SetBotKey(&input->down, true);
+        return;
+    }
+
+    ++state->timerBotInput;
+    if (state->timerBotInput < SecondsToTicks(DEMO_INPUT_DELAY)) {
+        return;
+    }
+
+    if (state->botPiece != state->game.piecesSpawned || !state->hasBotMove) {
+        // Just pressed hold to get here, so the plan still stands
+        b32 didHold = state->hasBotMove && state->botMove.useHold && state->botPiece + 1 == state->game.piecesSpawned;
+        if (didHold) {
+            state->botMove.useHold = false;
+        }
+        else {
+            tetromino_type next[BOT_PREVIEW_COUNT] = { state->game.next[0], state->game.next[1], state->game.next[2] };
+            state->hasBotMove = FindBotMove(&state->bot, &state->board, &state->game.current, next, state->game.hold, !state->game.didUseHoldBox, &state->botMove);
+            if (!state->hasBotMove) {
+                SetBotKey(&input->spacebar, true); // Nowhere to go, may as well get it over with
+                return;
+            }
+
+            if (state->botMove.useHold) {
+                state->botPiece = state->game.piecesSpawned;
+                state->botInputsCount = 0;
+                state->timerBotInput = 0;
+                SetBotKey(&input->c, true);
+                return;
+            }
+        }
+
+        state->botReplansCount = 0;
+        if (!PlanBotInputs(state)) {
+            state->hasBotMove = false;
+            return;
+        }
+    }
+    else {
+        tetromino_t* expected = state->botInputIndex > 0 ? &state->botExpected[state->botInputIndex - 1] : &state->botStart;
+        if (!AreTetrominoesEqual(&state->game.current, expected)) {
+            if (++state->botReplansCount > BOT_MAX_REPLANS) {
+                // Gravity keeps undoing the plan, probably a path that climbs up the stack with kicks. Take what we can get
+                state->botInputs[0] = move_input_hard_drop;
+                state->botInputsCount = 1;
+                state->botInputIndex = 0;
+            }
+            else if (!PlanBotInputs(state)) {
+                state->hasBotMove = false; // Gravity took the spot away. Think again next tick
+                return;
+            }
+        }
+    }
+
+    if (state->botInputIndex >= state->botInputsCount) {
+        return;
+    }
+
+    keyboard_key_state* key = GetBotInputKey(input, state->botInputs[state->botInputIndex]);
+    if (key->didChangeState) {
+        return; // Was let go of just now. Pressing it again in the same tick wouldn't register
+    }
+
+    SetBotKey(key, true);
+    state->timerBotInput = 0;
+    if (state->botInputs[state->botInputIndex] != move_input_soft_drop) {
+        ++state->botInputIndex;
+    }
+}
+
+// Runs one fixed step of the game. Returns false if the game is over
+static b32 UpdateScene1Tick(scene1_state* state, keyboard_state* keyboardState) {
+    // Presses count towards the piece they happened to, even the one that locks it
+    if (state->hasTelemetry) {
+        keyboard_key_state* keys[] = { &keyboardState->left, &keyboardState->right, &keyboardState->z, &keyboardState->x, &keyboardState->up, &keyboardState->spacebar };
+        for (i32 i = 0; i < ArraySize(keys); ++i) {
+            if (PRESSED((*keys[i]))) {
+                ++state->pieceInputsCount;
+            }
+        }
+    }
+
+    b32 isAlive = UpdateGameState(&state->game, &state->board, keyboardState, &state->events);
+
+    if (isAlive && HasGameEvent(&state->events, game_event_locked) && state->isPractice) {
+        PushScene1Snapshot(state);
+    }
+
+    PublishGameEvents(&state->eventBus, &state->events);
+
+    // Locking or holding. After publishing, so RecordScene1Piece still sees the piece that locked
+    if (state->hasTelemetry && state->game.piecesSpawned != state->telemetryPiece) {
+        state->telemetryPiece = state->game.piecesSpawned;
+        state->pieceSpawnTick = state->game.tickCount;
+        state->pieceInputsCount = 0;
+    }
+
+    return isAlive;
+}
+
 static void Scene1(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, keyboard_state* keyboardState, f32 deltaTime) {
     scene1_state* state = g_sceneState;
     scene1_data*  data  = g_sceneData;
@@ -556,6 +862,21 @@ static void Scene1(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, key
 
     UpdateButtonState(&state->buttonPause, keyboardState->mouseX, keyboardState->mouseY, &keyboardState->mouseLeft);
 
+    // Anything the player does ends the demo
+    if (state->isDemo) {
+        b32 didPlayerDoAnything = PRESSED(keyboardState->mouseLeft) || PRESSED(keyboardState->mouseRight);
+        for (i32 i = 0; i < ArraySize(keyboardState->keys); ++i) {
+            didPlayerDoAnything |= PRESSED(keyboardState->keys[i]);
+        }
+
+        if (didPlayerDoAnything) {
+            CloseScene1();
+            InitScene2();
+            g_globalState.currentScene = &Scene2;
+            return;
+        }
+    }
+
     // This is not a good solution
     if (PRESSED(keyboardState->esc) || state->buttonPause.state == button_state_pressed) {
         InitScene3();
@@ -568,225 +889,122 @@ static void Scene1(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, key
         return;
     }
 
-    if (keyboardState->right.isDown) {
-        state->timerAutoMoveDelay += deltaTime;
-        if (state->timerAutoMoveDelay >= AUTO_MOVE_DELAY) {
-            state->timerAutoMove += deltaTime;
-        }
-        if (state->timerAutoMove >= AUTO_MOVE || keyboardState->right.didChangeState) {
-            state->timerAutoMove = 0.0f;
-            ++state->current.x;
-            if (!IsTetrominoPosValid(&state->board, &state->current)) {
-                --state->current.x;
-            }
-            else {
-                PlaySound(&data->sfxMove, false, SFX_MOVE * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    // U goes back to when the last piece spawned, R undoes that
+    if (state->isPractice && (PRESSED(keyboardState->u) || PRESSED(keyboardState->r))) {
+        scene1_snapshot snapshot;
+        b32 didMove = PRESSED(keyboardState->u) ? UndoBoardHistory(&state->history, &state->board, &snapshot) : RedoBoardHistory(&state->history, &state->board, &snapshot);
+        if (didMove) {
+            RestoreScene1Snapshot(state, &snapshot);
+            if (state->isRecording) {
+                AddReplayKeyframe(&state->replay, &state->game, &state->board);
             }
         }
     }
-    else if (keyboardState->left.isDown) {
-        state->timerAutoMoveDelay += deltaTime;
-        if (state->timerAutoMoveDelay >= AUTO_MOVE_DELAY) {
-            state->timerAutoMove += deltaTime;
-        }
-        if (state->timerAutoMove >= AUTO_MOVE || keyboardState->left.didChangeState) {
-            state->timerAutoMove = 0.0f;
-            --state->current.x;
-            if (!IsTetrominoPosValid(&state->board, &state->current)) {
-                ++state->current.x;
-            }
-            else {
-                PlaySound(&data->sfxMove, false, SFX_MOVE * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-            }
-        }
-    }
-    else {
-        state->timerAutoMoveDelay = 0.0f;
-    }
-
-    i32 rotationDirection = PRESSED(keyboardState->x) - PRESSED(keyboardState->z);
-    if (rotationDirection) {
-        b32 didRotate = true;
-
-        state->current.rotation = (state->current.rotation + rotationDirection + 4) % 4;
-        if (!IsTetrominoPosValid(&state->board, &state->current)) {
-            state->current.x += 1;
-            if (!IsTetrominoPosValid(&state->board, &state->current)) {
-                state->current.x -= 2;
-                if (!IsTetrominoPosValid(&state->board, &state->current)) {
-                    state->current.x += 1;
-                    state->current.y += 1;
-                    if (!IsTetrominoPosValid(&state->board, &state->current)) {
-                        state->current.y -= 1;
-                        state->current.rotation = (state->current.rotation - rotationDirection + 4) % 4;
-                        didRotate = false;
-                    }
-                }
-            }
-        }
 
-        if (didRotate) {
-            PlaySound(&data->sfxRotate, false, SFX_ROTATE * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    // The events happened over the last deltaTime seconds, which is exactly the stretch of game time we are about to simulate
+    for (i32 i = 0; i < keyboardState->eventsCount && !state->isDemo; ++i) {
+        input_event* event = &keyboardState->events[i];
+        if (state->pendingEventsCount < ArraySize(state->pendingEvents)) {
+            state->pendingEvents[state->pendingEventsCount++] = (tick_input_event){
+                .tick     = state->game.tickCount + Max((i32)((state->secondsSinceLastTick + event->time) / SECONDS_PER_TICK + 1.0f), 1),
+                .keyIndex = event->keyIndex,
+                .isDown   = event->isDown
+            };
         }
     }
 
-    if (PRESSED(keyboardState->c) && !state->didUseHoldBox) {
-        state->didUseHoldBox = true;
+    // The game always runs at TICKS_PER_SECOND no matter how fast we render. After a long stall (eg. dragging the window) we drop time rather than catch up
+    state->secondsSinceLastTick += Min(deltaTime, MAX_TICKS_PER_FRAME * SECONDS_PER_TICK);
+    while (state->secondsSinceLastTick >= SECONDS_PER_TICK) {
+        state->secondsSinceLastTick -= SECONDS_PER_TICK;
 
-        tetromino_type currentType = state->current.type;
-        if (state->hold.type == tetromino_type_empty) {
-            state->current = InitTetromino(state->next[0].type, 0, BOARD_WIDTH / 2 - 2, BOARD_HEIGHT - 4, &data->tetrominoes);
-            state->next[0].type = state->next[1].type;
-            state->next[1].type = state->next[2].type;
-            state->next[2].type = GetNextTetrominoFromBag(state->bag, &state->bagIndex);
+        if (state->isDemo) {
+            UpdateBotInput(state);
         }
         else {
-            state->current = InitTetromino(state->hold.type, 0, BOARD_WIDTH / 2 - 2, BOARD_HEIGHT - 4, &data->tetrominoes);
+            ApplyTickInputEvents(state, state->game.tickCount + 1);
         }
-        state->hold.type = currentType;
 
-        PlaySound(&data->sfxHold, false, SFX_HOLD * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-    }
+        b32 isAlive = UpdateScene1Tick(state, &state->input);
+        if (state->isRecording) {
+            RecordReplayTick(&state->replay, &state->game, &state->board, &state->input);
+        }
+
+        if (!isAlive) {
+            CloseScene1();
+            InitScene2();
+            g_globalState.currentScene = &Scene2;
+            return;
+        }
 
-    b32 didSoftDrop = false;
-    f32 gravityInSeconds = GetCurrentGravityInSeconds(state->level);
-    if (keyboardState->down.isDown && gravityInSeconds > SOFT_DROP) {
-        didSoftDrop = true;
-        gravityInSeconds = SOFT_DROP;
+        for (i32 i = 0; i < ArraySize(state->input.keys); ++i) {
+            state->input.keys[i].didChangeState = false;
+        }
     }
 
-    b32 didHardDrop = false;
-    if (PRESSED(keyboardState->up) || PRESSED(keyboardState->spacebar)) {
-        didHardDrop = true;
-        while (IsTetrominoPosValid(&state->board, &state->current)) {
-            --state->current.y;
-            state->score += SCORE_HARD_DROP * state->level;
+    // Only if nothing is in flight, otherwise we would skip ahead of events that haven't been applied yet. Catches anything dropped or missed while paused
+    if (state->pendingEventsCount == 0 && !state->isDemo) {
+        for (i32 i = 0; i < ArraySize(state->input.keys); ++i) {
+            state->input.keys[i].isDown = keyboardState->keys[i].isDown;
         }
-        ++state->current.y;
-        state->score -= SCORE_HARD_DROP * state->level;
-    }
-
-    state->timerFall += deltaTime;
-    if (state->timerFall >= gravityInSeconds || didHardDrop || state->timerLockDelay >= 0.0001f) {
-        state->timerFall = 0.0f;
-
-        --state->current.y;
-
-        if (!IsTetrominoPosValid(&state->board, &state->current)) {
-            ++state->current.y;
-
-            state->timerLockDelay += deltaTime;
-            if (state->timerLockDelay >= LOCK_DELAY || didHardDrop) {
-                PlaceTetromino(&state->board, &state->current);
-
-                i32 lineClearCount = ProcessLineClears(&state->board, &state->current);
-                state->lines += lineClearCount;
-                switch (lineClearCount) {
-                    case 1: {
-                        state->score += SCORE_SINGLE * state->level;
-                    } break;
-                    case 2: {
-                        state->score += SCORE_DOUBLE * state->level;
-                    } break;
-                    case 3: {
-                        state->score += SCORE_TRIPLE * state->level;
-                    } break;
-                    case 4: {
-                        state->score += SCORE_TETRIS * state->level;
-                    } break;
-                }
-
-
-                if (state->lines >= state->level * 10) {
-                    ++state->level;
-                    PlaySound(&data->sfxLevelUp, false, SFX_LEVEL_UP * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-                }
-                else {
-                    switch (lineClearCount) {
-                        case 1: {
-                            PlaySound(&data->sfxLineClear, false, SFX_LINE_CLEAR * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-                        } break;
-                        case 2: {
-                            PlaySound(&data->sfxLineClear, false, SFX_LINE_CLEAR * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-                        } break;
-                        case 3: {
-                            PlaySound(&data->sfxLineClear, false, SFX_LINE_CLEAR * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-                        } break;
-                        case 4: {
-                            PlaySound(&data->sfxLineClear, false, SFX_LINE_CLEAR * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-                        } break;
-
-                        default: {
-                            PlaySound(&data->sfxLock, false, SFX_LOCK * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-                        } break;
-                    }
-                }
-
-                state->current = InitTetromino(state->next[0].type, 0, BOARD_WIDTH / 2 - 2, BOARD_HEIGHT - 4, &data->tetrominoes);
-                state->next[0].type = state->next[1].type;
-                state->next[1].type = state->next[2].type;
-                state->next[2].type = GetNextTetrominoFromBag(state->bag, &state->bagIndex);
-
-                if (!IsTetrominoPosValid(&state->board, &state->current)) {
-                    if (state->score > g_globalState.saveData.highScore) {
-                        g_globalState.saveData.highScore = state->score;
-
-                        save_data saveData = ReadSaveData(SAVE_DATA_PATH);
-                        saveData.highScore = g_globalState.saveData.highScore;
-                        WriteSaveData(SAVE_DATA_PATH, &saveData);
-                    }
-
-                    CloseScene1();
-                    InitScene2();
-                    g_globalState.currentScene = &Scene2;
-                    return;
-                }
-
-                state->timerAutoMoveDelay = 0.0f;
-                state->timerLockDelay = 0.0f;
-                state->didUseHoldBox = false;
-            }
+    }
+
+    tetromino_t ghost = state->game.current;
+    ghost.y -= GetDropDistance(&state->board, &ghost);
+
+    // Asked for as soon as the piece is there, and the worker is done within the bot's time budget, which is less than
+    // a frame. A result for an older piece is never shown
+    hint_result* hint = 0;
+    if (state->isHinting) {
+        if (state->hintPiece != state->game.piecesSpawned) {
+            tetromino_type next[BOT_PREVIEW_COUNT] = { state->game.next[0], state->game.next[1], state->game.next[2] };
+            state->hintId = RequestHint(&state->hint, &state->board, &state->game.current, next, state->game.hold, !state->game.didUseHoldBox);
+            state->hintPiece = state->game.piecesSpawned;
         }
-        else {
-            state->timerLockDelay = 0.0f;
 
-            if (didSoftDrop) {
-                state->score += SCORE_SOFT_DROP * state->level;
-                PlaySound(&data->sfxSoftDrop, false, SFX_SOFT_DROP * g_globalState.saveData.soundVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
-            }
+        hint = GetLatestHint(&state->hint);
+        if (hint->id != state->hintId || !hint->hasMove) {
+            hint = 0;
         }
     }
 
-    tetromino_t ghost = state->current;
-    while (IsTetrominoPosValid(&state->board, &ghost)) {
-        --ghost.y;
-    }
-    ++ghost.y;
+    ScrollBoardViewTo(&state->board, &state->game.current);
 
     DrawBitmapStupid(graphicsBuffer, &data->background, 0, 0);
 
     DrawBoard(graphicsBuffer, &state->board, data->tetrominoes);
 
-    DrawTetrominoInBoard(graphicsBuffer, &state->board, &state->current, &data->tetrominoes[state->current.type], 255);
+    DrawTetrominoInBoardInterpolated(graphicsBuffer, &state->board, &state->game.previous, &state->game.current, state->secondsSinceLastTick / SECONDS_PER_TICK, &data->tetrominoes[state->game.current.type], 255);
 
     DrawTetrominoInBoard(graphicsBuffer, &state->board, &ghost, &data->tetrominoes[ghost.type], 64); // <-- Feedback :)
 
+    if (hint) {
+        DrawTetrominoInBoard(graphicsBuffer, &state->board, &hint->move.placement, &data->tetrominoes[hint->move.placement.type], HINT_OPACITY);
+    }
+
     // Could be replaced by DrawBitmapStupidWithOpacity for the sake of performance
     // The same goes for the rest of the calls to DrawBitmap that doesn't require scaling
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->next[0].type], state->next[0].x, state->next[0].y, 90, 255);
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->next[1].type], state->next[1].x, state->next[1].y, 90, 255);
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->next[2].type], state->next[2].x, state->next[2].y, 90, 255);
+    for (i32 i = 0; i < ArraySize(state->game.next); ++i) {
+        DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->game.next[i]], NEXT_BOX_X, NEXT_BOX_Y - i * NEXT_BOX_STEP, 90, 255);
+    }
 
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->hold.type], state->hold.x, state->hold.y, 90, state->didUseHoldBox ? 128 : 255);
+    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->game.hold], HOLD_BOX_X, HOLD_BOX_Y, 90, state->game.didUseHoldBox ? 128 : 255);
 
-    DrawNumber(graphicsBuffer, &g_globalData.font, state->level, 578, 322, 3, true);
-    DrawNumber(graphicsBuffer, &g_globalData.font, state->score, 578, 232, 3, true);
-    DrawNumber(graphicsBuffer, &g_globalData.font, state->lines, 578, 142, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, state->game.level, 578, 322, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, state->game.score, 578, 232, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, state->game.lines, 578, 142, 3, true);
 
     DrawNumber(graphicsBuffer, &g_globalData.font, g_globalState.saveData.highScore, 578, 457, 3, true);
 
     // Redo graphic
     DrawBitmap(graphicsBuffer, &data->buttonPauseUnpaused, state->buttonPause.x, state->buttonPause.y, state->buttonPause.width, 255);
+
+    if (state->isDemo) {
+        DrawText(graphicsBuffer, &g_globalData.font, "Demo", 960, 1010, 3, true);
+    }
+    else if (state->isPractice) {
+        DrawText(graphicsBuffer, &g_globalData.font, "Practice", 960, 1010, 3, true);
+    }
 }
 
 // SCENE 2: Main menu //
@@ -797,6 +1015,7 @@ typedef struct scene2_state {
     button_t buttonControls;
     button_t buttonQuit;
     i32 currentButtonIndex;
+    f32 secondsIdle;
 } scene2_state;
 
 typedef struct scene2_data {
@@ -813,8 +1032,9 @@ typedef struct scene2_data {
 } scene2_data;
 
 static void InitScene2(void) {
-    g_sceneState = EngineAllocate(sizeof(scene2_state));
-    g_sceneData  = EngineAllocate(sizeof(scene2_data));
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene2_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene2_data), memory_tag_scene);
 
     scene2_state* state = g_sceneState;
     scene2_data*  data  = g_sceneData;
@@ -873,24 +1093,7 @@ static void InitScene2(void) {
 }
 
 static void CloseScene2(void) {
-    scene2_state* state = g_sceneState;
-    scene2_data*  data  = g_sceneData;
-
-
-    EngineFree(data->background.memory);
-
-    EngineFree(data->buttonStart.memory);
-    EngineFree(data->buttonOptions.memory);
-    EngineFree(data->buttonControls.memory);
-    EngineFree(data->buttonQuit.memory);
-
-    EngineFree(data->backgroundMusic.samples);
-
-    EngineFree(data->sfxButtonSwitch.samples);
-
-
-    EngineFree(g_sceneState);
-    EngineFree(g_sceneData);
+    EnginePopSceneMemory();
     g_sceneState = 0;
     g_sceneData  = 0;
 }
@@ -909,6 +1112,23 @@ static void Scene2(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, key
 
     i32 initialButtonIndex = state->currentButtonIndex;
 
+    state->secondsIdle += deltaTime;
+    if (keyboardState->didMouseMove || keyboardState->mouseLeft.isDown || keyboardState->mouseRight.isDown) {
+        state->secondsIdle = 0.0f;
+    }
+    for (i32 i = 0; i < ArraySize(keyboardState->keys); ++i) {
+        if (keyboardState->keys[i].isDown) {
+            state->secondsIdle = 0.0f;
+        }
+    }
+
+    if (state->secondsIdle >= DEMO_DELAY) {
+        CloseScene2();
+        InitScene1Demo();
+        g_globalState.currentScene = &Scene1;
+        return;
+    }
+
     if (state->buttonStart.state == button_state_hover) {
         state->currentButtonIndex = 0;
     }
@@ -931,8 +1151,14 @@ static void Scene2(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, key
 
     if (state->buttonStart.state == button_state_pressed || (state->currentButtonIndex == 0 && isAnyRelevantKeyPressed)) {
         CloseScene2();
-        InitScene1();
-        g_globalState.currentScene = &Scene1;
+        if (g_globalState.isVersus) {
+            InitScene6();
+            g_globalState.currentScene = &Scene6;
+        }
+        else {
+            InitScene1();
+            g_globalState.currentScene = &Scene1;
+        }
         return;
     }
 
@@ -1020,8 +1246,9 @@ typedef struct scene3_data {
 } scene3_data;
 
 static void InitScene3(void) {
-    g_sceneState = EngineAllocate(sizeof(scene3_state));
-    g_sceneData  = EngineAllocate(sizeof(scene3_data));
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene3_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene3_data), memory_tag_scene);
 
     scene3_state* state = g_sceneState;
     scene3_data*  data  = g_sceneData;
@@ -1052,33 +1279,7 @@ static void InitScene3(void) {
 }
 
 static void CloseScene3(void) {
-    scene3_state* state = g_sceneState;
-    scene3_data*  data  = g_sceneData;
-
-
-    EngineFree(data->tetrominoes[1].memory);
-    EngineFree(data->tetrominoes[2].memory);
-    EngineFree(data->tetrominoes[3].memory);
-    EngineFree(data->tetrominoes[4].memory);
-    EngineFree(data->tetrominoes[5].memory);
-    EngineFree(data->tetrominoes[6].memory);
-    EngineFree(data->tetrominoes[7].memory);
-
-    EngineFree(data->tetrominoesUI[1].memory);
-    EngineFree(data->tetrominoesUI[2].memory);
-    EngineFree(data->tetrominoesUI[3].memory);
-    EngineFree(data->tetrominoesUI[4].memory);
-    EngineFree(data->tetrominoesUI[5].memory);
-    EngineFree(data->tetrominoesUI[6].memory);
-    EngineFree(data->tetrominoesUI[7].memory);
-
-    EngineFree(data->background.memory);
-
-    EngineFree(data->buttonPausePaused.memory);
-
-
-    EngineFree(g_sceneState);
-    EngineFree(g_sceneData);
+    EnginePopSceneMemory();
     g_sceneState = 0;
     g_sceneData  = 0;
 }
@@ -1090,35 +1291,53 @@ static void Scene3(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, key
 
     UpdateButtonState(&state->scene1->buttonPause, keyboardState->mouseX, keyboardState->mouseY, &keyboardState->mouseLeft);
 
-    tetromino_t ghost = state->scene1->current;
-    while (IsTetrominoPosValid(&state->scene1->board, &ghost)) {
-        --ghost.y;
-    }
-    ++ghost.y;
+    tetromino_t ghost = state->scene1->game.current;
+    ghost.y -= GetDropDistance(&state->scene1->board, &ghost);
 
     DrawBitmapStupid(graphicsBuffer, &data->background, 0, 0);
 
     DrawBoard(graphicsBuffer, &state->scene1->board, data->tetrominoes);
 
-    DrawTetrominoInBoard(graphicsBuffer, &state->scene1->board, &state->scene1->current, &data->tetrominoes[state->scene1->current.type], 255);
+    DrawTetrominoInBoard(graphicsBuffer, &state->scene1->board, &state->scene1->game.current, &data->tetrominoes[state->scene1->game.current.type], 255);
 
     DrawTetrominoInBoard(graphicsBuffer, &state->scene1->board, &ghost, &data->tetrominoes[ghost.type], 64);
 
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->scene1->next[0].type], state->scene1->next[0].x, state->scene1->next[0].y, 90, 255);
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->scene1->next[1].type], state->scene1->next[1].x, state->scene1->next[1].y, 90, 255);
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->scene1->next[2].type], state->scene1->next[2].x, state->scene1->next[2].y, 90, 255);
+    for (i32 i = 0; i < ArraySize(state->scene1->game.next); ++i) {
+        DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->scene1->game.next[i]], NEXT_BOX_X, NEXT_BOX_Y - i * NEXT_BOX_STEP, 90, 255);
+    }
 
-    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->scene1->hold.type], state->scene1->hold.x, state->scene1->hold.y, 90, state->scene1->didUseHoldBox ? 128 : 255);
+    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[state->scene1->game.hold], HOLD_BOX_X, HOLD_BOX_Y, 90, state->scene1->game.didUseHoldBox ? 128 : 255);
 
-    DrawNumber(graphicsBuffer, &g_globalData.font, state->scene1->level, 578, 322, 3, true);
-    DrawNumber(graphicsBuffer, &g_globalData.font, state->scene1->score, 578, 232, 3, true);
-    DrawNumber(graphicsBuffer, &g_globalData.font, state->scene1->lines, 578, 142, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, state->scene1->game.level, 578, 322, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, state->scene1->game.score, 578, 232, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, state->scene1->game.lines, 578, 142, 3, true);
 
     DrawNumber(graphicsBuffer, &g_globalData.font, g_globalState.saveData.highScore, 578, 457, 3, true);
 
     DrawBitmap(graphicsBuffer, &data->buttonPausePaused, state->scene1->buttonPause.x, state->scene1->buttonPause.y, state->scene1->buttonPause.width, 255);
 
     DrawText(graphicsBuffer, &g_globalData.font, "Paused", 960, 540, 3, true);
+    if (state->scene1->isBoardInGame) {
+        DrawText(graphicsBuffer, &g_globalData.font, "Press Enter to save and quit", 960, 460, 3, true);
+    }
+
+    // Puts the game away for later, Start on the main menu picks it back up. Stays paused if it couldn't be written
+    if (state->scene1->isBoardInGame && PRESSED(keyboardState->enter) && WriteGameStateFile(SUSPENDED_GAME_PATH, &state->scene1->game, &state->scene1->board)) {
+        scene1_state* tempState = state->scene1;
+        scene1_data* tempData = data->scene1;
+
+        CopyAudioChannels(g_globalState.audioChannels, data->tempAudioChannels, AUDIO_CHANNEL_COUNT);
+
+        CloseScene3();
+
+        g_sceneState = tempState;
+        g_sceneData  = tempData;
+        CloseScene1();
+
+        InitScene2();
+        g_globalState.currentScene = &Scene2;
+        return;
+    }
 
     // Assumes scene 1 was never closed
     if (PRESSED(keyboardState->esc) || state->scene1->buttonPause.state == button_state_pressed) {
@@ -1171,8 +1390,9 @@ typedef struct scene4_data {
 } scene4_data;
 
 static void InitScene4(void) {
-    g_sceneState = EngineAllocate(sizeof(scene4_state));
-    g_sceneData  = EngineAllocate(sizeof(scene4_data));
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene4_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene4_data), memory_tag_scene);
 
     scene4_state* state = g_sceneState;
     scene4_data*  data  = g_sceneData;
@@ -1270,30 +1490,10 @@ static void InitScene4(void) {
 }
 
 static void CloseScene4(void) {
-    scene4_state* state = g_sceneState;
-    scene4_data*  data  = g_sceneData;
-
-
-    EngineFree(data->background.memory);
-
-    EngineFree(data->labelMasterVolume.memory);
-    EngineFree(data->labelSoundVolume.memory);
-    EngineFree(data->labelMusicVolume.memory);
-
-    EngineFree(data->buttonResetHighcore.memory);
-
-    EngineFree(data->buttonBack.memory);
-
-    EngineFree(data->backgroundMusic.samples);
-
-    EngineFree(data->sfxButtonSwitch.samples);
-
-
     WriteSaveData(SAVE_DATA_PATH, &g_globalState.saveData);
 
 
-    EngineFree(g_sceneState);
-    EngineFree(g_sceneData);
+    EnginePopSceneMemory();
     g_sceneState = 0;
     g_sceneData  = 0;
 }
@@ -1491,8 +1691,9 @@ typedef struct scene5_data {
 } scene5_data;
 
 static void InitScene5(void) {
-    g_sceneState = EngineAllocate(sizeof(scene5_state));
-    g_sceneData  = EngineAllocate(sizeof(scene5_data));
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene5_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene5_data), memory_tag_scene);
 
     scene5_state* state = g_sceneState;
     scene5_data*  data  = g_sceneData;
@@ -1520,19 +1721,7 @@ static void InitScene5(void) {
 }
 
 static void CloseScene5(void) {
-    scene5_state* state = g_sceneState;
-    scene5_data*  data  = g_sceneData;
-
-
-    EngineFree(data->background.memory);
-
-    EngineFree(data->buttonBack.memory);
-
-    EngineFree(data->backgroundMusic.samples);
-
-
-    EngineFree(g_sceneState);
-    EngineFree(g_sceneData);
+    EnginePopSceneMemory();
     g_sceneState = 0;
     g_sceneData  = 0;
 }
@@ -1563,12 +1752,403 @@ static void Scene5(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, key
     DrawRectangle(graphicsBuffer, 1030, 115, 12, 3 * 12, 0xFFFFFF);
 }
 
+// SCENE 6: Versus //
+
+typedef struct scene6_state {
+    versus_session* session; // Too big for the scene state to copy around, see tetris_versus.h
+    b32 isSessionOpen;       // False if the port was taken
+    u8 input;
+    game_event_bus eventBus; // For the local player's game
+} scene6_state;
+
+typedef struct scene6_data {
+    bitmap_buffer tetrominoes[8];
+    bitmap_buffer tetrominoesUI[8];
+
+    bitmap_buffer background;
+
+    sound_buffer backgroundMusic;
+    game_sounds sounds;
+} scene6_data;
+
+static void InitScene6(void) {
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene6_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene6_data), memory_tag_scene);
+
+    scene6_state* state = g_sceneState;
+    scene6_data*  data  = g_sceneData;
+
+
+    data->tetrominoes[1] = LoadBMP("assets/graphics/tetrominoes/tetromino_i.bmp");
+    data->tetrominoes[2] = LoadBMP("assets/graphics/tetrominoes/tetromino_o.bmp");
+    data->tetrominoes[3] = LoadBMP("assets/graphics/tetrominoes/tetromino_t.bmp");
+    data->tetrominoes[4] = LoadBMP("assets/graphics/tetrominoes/tetromino_s.bmp");
+    data->tetrominoes[5] = LoadBMP("assets/graphics/tetrominoes/tetromino_z.bmp");
+    data->tetrominoes[6] = LoadBMP("assets/graphics/tetrominoes/tetromino_j.bmp");
+    data->tetrominoes[7] = LoadBMP("assets/graphics/tetrominoes/tetromino_l.bmp");
+
+    data->tetrominoesUI[1] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_I_UI.bmp");
+    data->tetrominoesUI[2] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_O_UI.bmp");
+    data->tetrominoesUI[3] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_T_UI.bmp");
+    data->tetrominoesUI[4] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_S_UI.bmp");
+    data->tetrominoesUI[5] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_Z_UI.bmp");
+    data->tetrominoesUI[6] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_J_UI.bmp");
+    data->tetrominoesUI[7] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_L_UI.bmp");
+
+    data->background = LoadBMP("assets/graphics/background_gameplay.bmp");
+
+    data->backgroundMusic = LoadWAV("assets/audio/tetris_theme.wav");
+    LoadGameSounds(&data->sounds);
+
+    StopAllSounds(g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    PlaySound(&data->backgroundMusic, true, BACKGROUND_MUSIC * g_globalState.saveData.musicVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    if (g_globalState.musicSampleIndex != 0) {
+        SetSampleIndex(g_globalState.musicSampleIndex, 0, g_globalState.audioChannels);
+    }
+
+    SubscribeToGameEvents(&state->eventBus, GAME_SOUND_EVENTS, PlayGameEventSound, &data->sounds);
+
+    // Only player 0's seed gets used, so it doesn't matter that both sides pick one
+    RandomInit();
+
+    state->session = EngineAllocateScene(sizeof(versus_session), memory_tag_game);
+    state->isSessionOpen = InitVersusSession(state->session, g_globalState.versusLocalPort, g_globalState.versusRemotePort, RandomU32(), &g_globalState.versusNetwork);
+
+    versus_session* session = state->session;
+    i32 localPlayer = session->localPlayer;
+    session->boards[localPlayer].x = 735;
+    session->boards[localPlayer].y = 90;
+    SetBoardTileSize(&session->boards[localPlayer], 45);
+    session->boards[1 - localPlayer].x = VERSUS_REMOTE_X;
+    session->boards[1 - localPlayer].y = VERSUS_REMOTE_Y;
+    SetBoardTileSize(&session->boards[1 - localPlayer], VERSUS_TILE_SIZE);
+}
+
+static void CloseScene6(void) {
+    scene6_state* state = g_sceneState;
+
+
+    if (state->isSessionOpen) {
+        FreeVersusSession(state->session);
+    }
+
+
+    EnginePopSceneMemory();
+    g_sceneState = 0;
+    g_sceneData  = 0;
+}
+
+// The VERSUS_INPUT_ bits for this frame. A key that went down and up again since the last one still counts
+static u8 GetVersusInput(keyboard_state* keyboardState) {
+    keyboard_key_state* keys[] = { &keyboardState->left, &keyboardState->right, &keyboardState->x, &keyboardState->z, &keyboardState->c, &keyboardState->down, &keyboardState->spacebar, &keyboardState->up };
+    u8 bits[] = { VERSUS_INPUT_LEFT, VERSUS_INPUT_RIGHT, VERSUS_INPUT_ROTATE_CW, VERSUS_INPUT_ROTATE_CCW, VERSUS_INPUT_HOLD, VERSUS_INPUT_SOFT_DROP, VERSUS_INPUT_HARD_DROP, VERSUS_INPUT_HARD_DROP };
+
+    u8 input = 0;
+    for (i32 i = 0; i < ArraySize(keys); ++i) {
+        b32 isDown = keys[i]->isDown;
+        for (i32 j = 0; j < keyboardState->eventsCount; ++j) {
+            input_event* event = &keyboardState->events[j];
+            isDown |= event->isDown && &keyboardState->keys[event->keyIndex] == keys[i];
+        }
+
+        if (isDown) {
+            input |= bits[i];
+        }
+    }
+
+    return input;
+}
+
+static void Scene6(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, keyboard_state* keyboardState, f32 deltaTime) {
+    scene6_state* state = g_sceneState;
+    scene6_data*  data  = g_sceneData;
+
+    versus_session* session = state->session;
+
+
+    // Leaving mid-game is the same as losing the connection for the other side, they time out
+    b32 isOver = !state->isSessionOpen || session->result != versus_result_playing;
+    if (PRESSED(keyboardState->esc) || (isOver && PRESSED(keyboardState->enter))) {
+        CloseScene6();
+        InitScene2();
+        g_globalState.currentScene = &Scene2;
+        return;
+    }
+
+    if (state->isSessionOpen) {
+        UpdateVersusSession(session, deltaTime, GetVersusInput(keyboardState));
+    }
+
+    // Only ever from frames that are simulated for the first time, so a rollback doesn't play anything twice
+    PublishGameEvents(&state->eventBus, &session->localEvents);
+
+    DrawBitmapStupid(graphicsBuffer, &data->background, 0, 0);
+
+    if (!state->isSessionOpen) {
+        DrawText(graphicsBuffer, &g_globalData.font, "Could not open the port", 960, 1010, 3, true);
+        return;
+    }
+
+    if (!session->isStarted) {
+        DrawText(graphicsBuffer, &g_globalData.font, "Waiting for opponent", 960, 1010, 3, true);
+        return;
+    }
+
+    for (i32 player = 0; player < 2; ++player) {
+        game_state* game = &session->world.games[player];
+        board_t* board = &session->boards[player];
+
+        DrawBoard(graphicsBuffer, board, data->tetrominoes);
+
+        if (!session->world.isGameOver[player]) {
+            tetromino_t ghost = game->current;
+            ghost.y -= GetDropDistance(board, &ghost);
+
+            DrawTetrominoInBoard(graphicsBuffer, board, &game->current, &data->tetrominoes[game->current.type], 255);
+            DrawTetrominoInBoard(graphicsBuffer, board, &ghost, &data->tetrominoes[ghost.type], 64);
+        }
+
+        // The rows that come up at the next lock, next to the board
+        i32 garbage = Min(session->world.pendingGarbage[player], board->height);
+        DrawRectangle(graphicsBuffer, board->x - board->tileSize / 3, board->y, board->tileSize / 4, garbage * board->tileSize, VERSUS_GARBAGE_BAR);
+    }
+
+    game_state* game = &session->world.games[session->localPlayer];
+    for (i32 i = 0; i < ArraySize(game->next); ++i) {
+        DrawBitmap(graphicsBuffer, &data->tetrominoesUI[game->next[i]], NEXT_BOX_X, NEXT_BOX_Y - i * NEXT_BOX_STEP, 90, 255);
+    }
+
+    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[game->hold], HOLD_BOX_X, HOLD_BOX_Y, 90, game->didUseHoldBox ? 128 : 255);
+
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->level, 578, 322, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->score, 578, 232, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->lines, 578, 142, 3, true);
+
+    switch (session->result) {
+        case versus_result_playing:      DrawText(graphicsBuffer, &g_globalData.font, "Versus", 960, 1010, 3, true); break;
+        case versus_result_won:          DrawText(graphicsBuffer, &g_globalData.font, "You win", 960, 1010, 3, true); break;
+        case versus_result_lost:         DrawText(graphicsBuffer, &g_globalData.font, "You lose", 960, 1010, 3, true); break;
+        case versus_result_draw:         DrawText(graphicsBuffer, &g_globalData.font, "Draw", 960, 1010, 3, true); break;
+        case versus_result_disconnected: DrawText(graphicsBuffer, &g_globalData.font, "Disconnected", 960, 1010, 3, true); break;
+        case versus_result_desynced:     DrawText(graphicsBuffer, &g_globalData.font, "Desync", 960, 1010, 3, true); break;
+    }
+}
+
+// SCENE 7: Replay //
+
+typedef struct scene7_state {
+    replay_t replay;
+    b32 isOpen; // False if there was no replay to open
+    b32 isPaused;
+    f32 secondsSinceLastTick;
+} scene7_state;
+
+typedef struct scene7_data {
+    bitmap_buffer tetrominoes[8];
+    bitmap_buffer tetrominoesUI[8];
+
+    bitmap_buffer background;
+
+    sound_buffer backgroundMusic;
+} scene7_data;
+
+static void InitScene7(void) {
+    EnginePushSceneMemory();
+    g_sceneState = EngineAllocateScene(sizeof(scene7_state), memory_tag_scene);
+    g_sceneData  = EngineAllocateScene(sizeof(scene7_data), memory_tag_scene);
+
+    scene7_state* state = g_sceneState;
+    scene7_data*  data  = g_sceneData;
+
+
+    data->tetrominoes[1] = LoadBMP("assets/graphics/tetrominoes/tetromino_i.bmp");
+    data->tetrominoes[2] = LoadBMP("assets/graphics/tetrominoes/tetromino_o.bmp");
+    data->tetrominoes[3] = LoadBMP("assets/graphics/tetrominoes/tetromino_t.bmp");
+    data->tetrominoes[4] = LoadBMP("assets/graphics/tetrominoes/tetromino_s.bmp");
+    data->tetrominoes[5] = LoadBMP("assets/graphics/tetrominoes/tetromino_z.bmp");
+    data->tetrominoes[6] = LoadBMP("assets/graphics/tetrominoes/tetromino_j.bmp");
+    data->tetrominoes[7] = LoadBMP("assets/graphics/tetrominoes/tetromino_l.bmp");
+
+    data->tetrominoesUI[1] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_I_UI.bmp");
+    data->tetrominoesUI[2] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_O_UI.bmp");
+    data->tetrominoesUI[3] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_T_UI.bmp");
+    data->tetrominoesUI[4] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_S_UI.bmp");
+    data->tetrominoesUI[5] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_Z_UI.bmp");
+    data->tetrominoesUI[6] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_J_UI.bmp");
+    data->tetrominoesUI[7] = LoadBMP("assets/graphics/tetrominoes_ui/tetromino_L_UI.bmp");
+
+    data->background = LoadBMP("assets/graphics/background_gameplay.bmp");
+
+    data->backgroundMusic = LoadWAV("assets/audio/tetris_theme.wav");
+
+    StopAllSounds(g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    PlaySound(&data->backgroundMusic, true, BACKGROUND_MUSIC * g_globalState.saveData.musicVolume, g_globalState.audioChannels, AUDIO_CHANNEL_COUNT);
+    if (g_globalState.musicSampleIndex != 0) {
+        SetSampleIndex(g_globalState.musicSampleIndex, 0, g_globalState.audioChannels);
+    }
+
+    state->isOpen = OpenReplay(&state->replay, g_globalState.replayPath, 735, 90, 45);
+
+    // Marathon replays get the same view of the board as the game had
+    board_t* board = &state->replay.board;
+    if (state->isOpen && !state->replay.isBoardInGame) {
+        SetBoardTileSize(board, MARATHON_TILE_SIZE);
+        SetBoardView(board, BOARD_VIEW_WIDTH_PX / MARATHON_TILE_SIZE, BOARD_VIEW_HEIGHT_PX / MARATHON_TILE_SIZE);
+    }
+}
+
+static void CloseScene7(void) {
+    scene7_state* state = g_sceneState;
+
+
+    if (state->isOpen) {
+        CloseReplay(&state->replay);
+    }
+
+
+    EnginePopSceneMemory();
+    g_sceneState = 0;
+    g_sceneData  = 0;
+}
+
+// Space pauses, left and right skip a few seconds and up and down a minute. Seeking is never more than
+// REPLAY_KEYFRAME_TICKS of simulation on normal boards, however long the game is
+static void Scene7(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, keyboard_state* keyboardState, f32 deltaTime) {
+    scene7_state* state = g_sceneState;
+    scene7_data*  data  = g_sceneData;
+
+    replay_t* replay = &state->replay;
+
+
+    if (PRESSED(keyboardState->esc) || PRESSED(keyboardState->enter)) {
+        CloseScene7();
+        InitScene2();
+        g_globalState.currentScene = &Scene2;
+        return;
+    }
+
+    DrawBitmapStupid(graphicsBuffer, &data->background, 0, 0);
+
+    if (!state->isOpen) {
+        DrawText(graphicsBuffer, &g_globalData.font, "No replay", 960, 1010, 3, true);
+        return;
+    }
+
+    if (PRESSED(keyboardState->spacebar)) {
+        state->isPaused = !state->isPaused;
+    }
+
+    i32 seekTicks = 0;
+    seekTicks += PRESSED(keyboardState->right) ? SecondsToTicks(REPLAY_SEEK_SHORT) : 0;
+    seekTicks -= PRESSED(keyboardState->left)  ? SecondsToTicks(REPLAY_SEEK_SHORT) : 0;
+    seekTicks += PRESSED(keyboardState->up)    ? SecondsToTicks(REPLAY_SEEK_LONG)  : 0;
+    seekTicks -= PRESSED(keyboardState->down)  ? SecondsToTicks(REPLAY_SEEK_LONG)  : 0;
+    if (seekTicks != 0) {
+        SeekReplay(replay, (u32)Max((i64)replay->game.tickCount + seekTicks, 0));
+        state->secondsSinceLastTick = 0.0f;
+    }
+
+    if (!state->isPaused) {
+        state->secondsSinceLastTick += Min(deltaTime, MAX_TICKS_PER_FRAME * SECONDS_PER_TICK);
+        while (state->secondsSinceLastTick >= SECONDS_PER_TICK) {
+            state->secondsSinceLastTick -= SECONDS_PER_TICK;
+            StepReplay(replay, 0);
+        }
+    }
+
+    game_state* game = &replay->game;
+    board_t* board = &replay->board;
+
+    tetromino_t ghost = game->current;
+    ghost.y -= GetDropDistance(board, &ghost);
+
+    ScrollBoardViewTo(board, &game->current);
+
+    DrawBoard(graphicsBuffer, board, data->tetrominoes);
+
+    DrawTetrominoInBoard(graphicsBuffer, board, &game->current, &data->tetrominoes[game->current.type], 255);
+
+    DrawTetrominoInBoard(graphicsBuffer, board, &ghost, &data->tetrominoes[ghost.type], 64);
+
+    for (i32 i = 0; i < ArraySize(game->next); ++i) {
+        DrawBitmap(graphicsBuffer, &data->tetrominoesUI[game->next[i]], NEXT_BOX_X, NEXT_BOX_Y - i * NEXT_BOX_STEP, 90, 255);
+    }
+
+    DrawBitmap(graphicsBuffer, &data->tetrominoesUI[game->hold], HOLD_BOX_X, HOLD_BOX_Y, 90, game->didUseHoldBox ? 128 : 255);
+
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->level, 578, 322, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->score, 578, 232, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->lines, 578, 142, 3, true);
+
+    DrawText(graphicsBuffer, &g_globalData.font, state->isPaused ? "Replay - paused" : "Replay", 960, 1010, 3, true);
+    DrawNumber(graphicsBuffer, &g_globalData.font, game->tickCount / TICKS_PER_SECOND, 960, 40, 3, true);
+}
+
+
+// -marathon <width> <height> on the command line plays on a board of that size instead, and -practice lets you undo.
+// -versus <local port> <remote port> plays against whoever started the game with the same ports the other way round,
+// on this machine. -latency <ms>, -jitter <ms> and -loss <percent> make the connection worse on purpose.
+// -replay [<file>] watches a replay, the last game by default
+void OnStartup(const char* commandLine) {
+    g_globalState.isPractice = strstr(commandLine, "-practice") != 0;
+    g_globalState.isHinting  = strstr(commandLine, "-hint") != 0;
+
+    const char* versus = strstr(commandLine, "-versus");
+    if (versus) {
+        char* end = 0;
+        g_globalState.isVersus = true;
+        g_globalState.versusLocalPort  = (u16)strtol(versus + strlen("-versus"), &end, 10);
+        g_globalState.versusRemotePort = (u16)strtol(end, 0, 10);
+
+        const char* latency = strstr(commandLine, "-latency");
+        const char* jitter  = strstr(commandLine, "-jitter");
+        const char* loss    = strstr(commandLine, "-loss");
+        g_globalState.versusNetwork.latency = latency ? strtol(latency + strlen("-latency"), 0, 10) / 1000.0f : 0.0f;
+        g_globalState.versusNetwork.jitter  = jitter  ? strtol(jitter  + strlen("-jitter"),  0, 10) / 1000.0f : 0.0f;
+        g_globalState.versusNetwork.loss    = loss    ? strtol(loss    + strlen("-loss"),    0, 10) / 100.0f  : 0.0f;
+    }
+
+    g_globalState.boardWidth  = BOARD_WIDTH;
+    g_globalState.boardHeight = BOARD_HEIGHT;
+
+    const char* marathon = strstr(commandLine, "-marathon");
+    if (marathon) {
+        char* end = 0;
+        i32 width  = strtol(marathon + strlen("-marathon"), &end, 10);
+        i32 height = strtol(end, 0, 10);
+        g_globalState.boardWidth  = Clamp(width, 4, MARATHON_MAX_SIZE);
+        g_globalState.boardHeight = Clamp(height, BOARD_HEIGHT, MARATHON_MAX_SIZE);
+    }
 
-void OnStartup(void) {
     g_globalData.font = InitFont("assets/graphics/letters_sprite_sheet.bmp", 13, 5, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz,.-");
 
     g_globalState.saveData = ReadSaveData(SAVE_DATA_PATH);
 
+    const char* replay = strstr(commandLine, "-replay");
+    if (replay) {
+        const char* path = replay + strlen("-replay");
+        while (*path == ' ') {
+            ++path;
+        }
+
+        i32 length = 0;
+        while (path[length] && path[length] != ' ' && path[0] != '-' && length < ArraySize(g_globalState.replayPath) - 1) {
+            ++length;
+        }
+
+        if (length > 0) {
+            memcpy(g_globalState.replayPath, path, length);
+        }
+        else {
+            strcpy(g_globalState.replayPath, REPLAY_PATH);
+        }
+
+        InitScene7();
+        g_globalState.currentScene = &Scene7;
+        return;
+    }
+
 
     InitScene2();
     g_globalState.currentScene = &Scene2;
@@ -25,6 +25,17 @@ typedef struct keyboard_key_state {
     b32 didChangeState;
 } keyboard_key_state;
 
+#define PRESSED(key) ((key).isDown && (key).didChangeState)
+
+#define MAX_INPUT_EVENTS 64
+
+// Every key change since the last frame, in the order they happened
+typedef struct input_event {
+    f32 time;     // Seconds since the previous call to Update. Only finer than the system timer tick with -inputthread
+    i32 keyIndex; // Index into keyboard_state.keys
+    b32 isDown;
+} input_event;
+
 typedef struct keyboard_state {
     union {
         struct {
@@ -55,12 +66,18 @@ typedef struct keyboard_state {
             keyboard_key_state enter;
             keyboard_key_state esc;
             keyboard_key_state f;
+            keyboard_key_state u;
+            keyboard_key_state r;
         };
-        keyboard_key_state keys[11];
+        keyboard_key_state keys[13];
     };
+
+    input_event events[MAX_INPUT_EVENTS];
+    i32 eventsCount;
 } keyboard_state;
 
-extern void OnStartup(void);
+extern b32 RunTool(const char* commandLine);
+extern void OnStartup(const char* commandLine);
 extern void Update(bitmap_buffer* graphicsBuffer, sound_buffer* soundBuffer, keyboard_state* keyboardState, f32 deltaTime);
 
 #endif
\ No newline at end of file
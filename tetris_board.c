@@ -0,0 +1,505 @@
+#include "tetris_board.h"
+
+
+// Where a rotation gets tried, in order. First in place, then one step right, one step left and finally one step up
+const i32 ROTATION_KICKS[4][2] = { { 0, 0 }, { 1, 0 }, { -1, 0 }, { 0, 1 } };
+
+
+// The tiles and the metadata share one allocation, see BOARD_MEMORY_SIZE
+board_t InitBoard(i32 width, i32 height, i32 x, i32 y, i32 tileSize) {
+    return InitBoardInMemory(width, height, EngineAllocate(BOARD_MEMORY_SIZE(width, height), memory_tag_game), x, y, tileSize);
+}
+
+// memory has to be BOARD_MEMORY_SIZE(width, height) zeroed bytes, 8 byte aligned, and outlive the board. FreeBoard
+// is only for boards from InitBoard. Every slot starts out holding the row with the same index
+board_t InitBoardInMemory(i32 width, i32 height, void* memory, i32 x, i32 y, i32 tileSize) {
+    board_t board = {
+        .width    = width,
+        .height   = height,
+        .size     = width * height,
+        .rowWords = BOARD_ROW_WORDS(width),
+        .x        = x,
+        .y        = y
+    };
+    SetBoardMemory(&board, memory);
+
+    for (i32 i = 0; i < height; ++i) {
+        board.rowSlots[i] = i;
+    }
+
+    SetBoardView(&board, width, height);
+    SetBoardTileSize(&board, tileSize);
+
+    return board;
+}
+
+// Points the board at a block laid out like InitBoardInMemory's, without touching what is in it. hash and stackHeight
+// aren't in the block, so they have to come along some other way
+void SetBoardMemory(board_t* board, void* memory) {
+    board->rowMasks      = memory;
+    board->tiles         = (tetromino_type*)(board->rowMasks + board->height * board->rowWords);
+    board->columnHeights = (i32*)(board->tiles + board->size);
+    board->rowFillCounts = board->columnHeights + board->width;
+    board->rowSlots      = board->rowFillCounts + board->height;
+    board->slotVersions  = (u32*)(board->rowSlots + board->height);
+}
+
+void FreeBoard(board_t* board) {
+    EngineFree(board->rowMasks);
+    board->tiles = 0;
+    board->rowMasks = 0;
+    board->rowSlots = 0;
+    board->columnHeights = 0;
+    board->rowFillCounts = 0;
+    board->slotVersions = 0;
+}
+
+// Both boards need the same width and height
+void CopyBoard(board_t* dest, board_t* source) {
+    Assert(dest->width == source->width && dest->height == source->height);
+
+    for (i32 i = 0; i < source->size; ++i) {
+        dest->tiles[i] = source->tiles[i];
+    }
+    for (i32 i = 0; i < source->height * source->rowWords; ++i) {
+        dest->rowMasks[i] = source->rowMasks[i];
+    }
+    for (i32 x = 0; x < source->width; ++x) {
+        dest->columnHeights[x] = source->columnHeights[x];
+    }
+    for (i32 y = 0; y < source->height; ++y) {
+        dest->rowFillCounts[y] = source->rowFillCounts[y];
+        dest->rowSlots[y] = source->rowSlots[y];
+        dest->slotVersions[y] = source->slotVersions[y];
+    }
+    dest->stackHeight = source->stackHeight;
+    dest->hash = source->hash;
+}
+
+void SetBoardTileSize(board_t* board, i32 tileSize) {
+    board->tileSize = tileSize;
+    board->widthPx  = board->viewColumns * tileSize;
+    board->heightPx = board->viewRows    * tileSize;
+}
+
+// How many columns and rows get drawn. The view starts out in the bottom left corner
+void SetBoardView(board_t* board, i32 columns, i32 rows) {
+    board->viewColumns = Clamp(columns, 1, board->width);
+    board->viewRows    = Clamp(rows, 1, board->height);
+    board->viewX = 0;
+    board->viewY = 0;
+    SetBoardTileSize(board, board->tileSize);
+}
+
+// Moves the view as little as it can while keeping the tetromino's 4x4 box in it, or as much of it as fits
+void ScrollBoardViewTo(board_t* board, tetromino_t* tetromino) {
+    if (tetromino->x < board->viewX) {
+        board->viewX = tetromino->x;
+    }
+    else if (tetromino->x + 4 > board->viewX + board->viewColumns) {
+        board->viewX = tetromino->x + 4 - board->viewColumns;
+    }
+    if (tetromino->y < board->viewY) {
+        board->viewY = tetromino->y;
+    }
+    else if (tetromino->y + 4 > board->viewY + board->viewRows) {
+        board->viewY = tetromino->y + 4 - board->viewRows;
+    }
+
+    board->viewX = Clamp(board->viewX, 0, board->width  - board->viewColumns);
+    board->viewY = Clamp(board->viewY, 0, board->height - board->viewRows);
+}
+
+void ClearBoard(board_t* board) {
+    for (i32 i = 0; i < board->size; ++i) {
+        board->tiles[i] = tetromino_type_empty;
+    }
+    for (i32 i = 0; i < board->height * board->rowWords; ++i) {
+        board->rowMasks[i] = 0;
+    }
+    for (i32 x = 0; x < board->width; ++x) {
+        board->columnHeights[x] = 0;
+    }
+    for (i32 y = 0; y < board->height; ++y) {
+        board->rowFillCounts[y] = 0;
+        ++board->slotVersions[y];
+    }
+    board->stackHeight = 0;
+    board->hash = 0;
+}
+
+static inline b32 IsBoardTileFilled(board_t* board, i32 x, i32 y) {
+    return (board->rowMasks[board->rowSlots[y] * board->rowWords + x / BOARD_ROW_WORD_BITS] >> (x % BOARD_ROW_WORD_BITS)) & 1;
+}
+
+tetromino_type GetBoardTile(board_t* board, i32 x, i32 y) {
+    return board->tiles[board->rowSlots[y] * board->width + x];
+}
+
+static inline b32 IsBoardHashed(board_t* board) {
+    return board->width <= BOARD_MAX_HASHED_WIDTH;
+}
+
+// For setting boards up by hand. Keeps the metadata right, but isn't meant to be fast
+void SetBoardTile(board_t* board, i32 x, i32 y, tetromino_type type) {
+    i32 slot = board->rowSlots[y];
+    tetromino_type* tile = &board->tiles[slot * board->width + x];
+    u64 bit = 1ull << (x % BOARD_ROW_WORD_BITS);
+    if (*tile == tetromino_type_empty && type != tetromino_type_empty) {
+        ++board->rowFillCounts[slot];
+        board->rowMasks[slot * board->rowWords + x / BOARD_ROW_WORD_BITS] |= bit;
+        board->hash ^= IsBoardHashed(board) ? GetTileZobristKey(x, y) : 0;
+    }
+    else if (*tile != tetromino_type_empty && type == tetromino_type_empty) {
+        --board->rowFillCounts[slot];
+        board->rowMasks[slot * board->rowWords + x / BOARD_ROW_WORD_BITS] &= ~bit;
+        board->hash ^= IsBoardHashed(board) ? GetTileZobristKey(x, y) : 0;
+    }
+    *tile = type;
+    ++board->slotVersions[slot];
+
+    i32 height = board->height;
+    while (height > 0 && !IsBoardTileFilled(board, x, height - 1)) {
+        --height;
+    }
+    board->columnHeights[x] = height;
+
+    board->stackHeight = 0;
+    for (i32 i = 0; i < board->width; ++i) {
+        board->stackHeight = Max(board->stackHeight, board->columnHeights[i]);
+    }
+}
+
+// width tiles, leftmost first. Only good until the board changes
+const tetromino_type* GetBoardRow(board_t* board, i32 y) {
+    return &board->tiles[board->rowSlots[y] * board->width];
+}
+
+// Overwrites a whole row. Doesn't touch the column heights or stackHeight, call RecalculateBoardHeights once all the
+// rows that are going to change have
+void SetBoardRow(board_t* board, i32 y, const tetromino_type* tiles) {
+    i32 slot = board->rowSlots[y];
+    tetromino_type* row = &board->tiles[slot * board->width];
+    u64* mask = &board->rowMasks[slot * board->rowWords];
+    b32 isHashed = IsBoardHashed(board);
+
+    for (i32 word = 0; word < board->rowWords; ++word) {
+        mask[word] = 0;
+    }
+    board->rowFillCounts[slot] = 0;
+    for (i32 x = 0; x < board->width; ++x) {
+        if (isHashed && (row[x] != tetromino_type_empty) != (tiles[x] != tetromino_type_empty)) {
+            board->hash ^= GetTileZobristKey(x, y);
+        }
+
+        row[x] = tiles[x];
+        if (tiles[x] != tetromino_type_empty) {
+            mask[x / BOARD_ROW_WORD_BITS] |= 1ull << (x % BOARD_ROW_WORD_BITS);
+            ++board->rowFillCounts[slot];
+        }
+    }
+    ++board->slotVersions[slot];
+}
+
+// Works the column heights and stackHeight out again. Nothing can be filled from topRow up
+void RecalculateBoardHeights(board_t* board, i32 topRow) {
+    board->stackHeight = 0;
+    for (i32 x = 0; x < board->width; ++x) {
+        i32 height = Min(topRow, board->height);
+        while (height > 0 && !IsBoardTileFilled(board, x, height - 1)) {
+            --height;
+        }
+        board->columnHeights[x] = height;
+        board->stackHeight = Max(board->stackHeight, height);
+    }
+}
+
+// Bit x of rows[y] is set if that tile is filled. Only works for boards up to 16 wide
+void GetBoardRows(board_t* board, u16* rows) {
+    Assert(board->width <= 16);
+
+    for (i32 y = 0; y < board->height; ++y) {
+        rows[y] = (u16)board->rowMasks[board->rowSlots[y] * board->rowWords];
+    }
+}
+
+/*
+    Zobrist hashing: every filled tile has a random 64-bit key and a board's hash is all of them xored together, so
+    filling or emptying a tile is a single xor. The keys come from mixing the tile's position (splitmix64) rather than
+    from a table, so they are the same on every run and for any board size. The pieces in the hold box and the queue
+    get keys the same way, per slot, so GetPiecesZobristHash(...) ^ board->hash tells whole game states apart.
+
+    A line clear moves every row above it, so the hash of all of those has to be redone. That is fine for the boards
+    the bot plays, but would make clears on big boards cost as much as the stack, so boards wider than
+    BOARD_MAX_HASHED_WIDTH just leave their hash at 0.
+*/
+
+static inline u64 MixZobristKey(u64 value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+u64 GetTileZobristKey(i32 x, i32 y) {
+    return MixZobristKey(((u64)(u32)y << 16) | (u32)x);
+}
+
+// queue[0] is the piece being played. Slots past the end of the queue don't get a key, so queues of different lengths hash differently
+u64 GetPiecesZobristHash(tetromino_type hold, tetromino_type* queue, i32 queueCount) {
+    u64 hash = MixZobristKey((1ull << 48) | hold);
+    for (i32 i = 0; i < queueCount; ++i) {
+        hash ^= MixZobristKey((2ull << 48) | ((u64)i << 8) | queue[i]);
+    }
+
+    return hash;
+}
+
+// The same thing board_t.hash holds, for the rows GetBoardRows gives. Only rows from fromRow up count
+u64 HashBoardRows(const u16* rows, i32 fromRow, i32 height) {
+    u64 hash = 0;
+    for (i32 y = fromRow; y < height; ++y) {
+        for (u32 row = rows[y]; row; row &= row - 1) {
+            i32 x = 0;
+            while (!(row & (1u << x))) {
+                ++x;
+            }
+            hash ^= GetTileZobristKey(x, y);
+        }
+    }
+
+    return hash;
+}
+
+// Same as above, for rows of the board itself. Only for boards narrow enough to be hashed
+static u64 HashBoardTiles(board_t* board, i32 fromRow) {
+    u64 hash = 0;
+    for (i32 y = fromRow; y < board->stackHeight; ++y) {
+        for (u64 row = board->rowMasks[board->rowSlots[y] * board->rowWords]; row; row &= row - 1) {
+            i32 x = 0;
+            while (!(row & (1ull << x))) {
+                ++x;
+            }
+            hash ^= GetTileZobristKey(x, y);
+        }
+    }
+
+    return hash;
+}
+
+tetromino_t InitTetromino(tetromino_type type, i32 rotation, i32 x, i32 y) {
+    return (tetromino_t){ .type = type, .rotation = rotation, .x = x, .y = y };
+}
+
+// Where new pieces come in. The same as SPAWN_X and SPAWN_Y on a normal board, on taller ones it is that far above
+// the stack instead of at the very top, so pieces don't take forever to fall
+tetromino_t SpawnTetromino(board_t* board, tetromino_type type) {
+    i32 x = board->width / 2 - 2;
+    i32 y = Min(board->height - 4, board->stackHeight + BOARD_HEIGHT - 4);
+    return InitTetromino(type, 0, x, y);
+}
+
+void PlaceTetromino(board_t* board, tetromino_t* tetromino) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    for (i32 i = 0; i < shape->cellsCount; ++i) {
+        i32 x = tetromino->x + shape->cells[i].x;
+        i32 y = tetromino->y + shape->cells[i].y;
+        i32 slot = board->rowSlots[y];
+        board->tiles[slot * board->width + x] = tetromino->type;
+        ++board->slotVersions[slot];
+        board->rowMasks[slot * board->rowWords + x / BOARD_ROW_WORD_BITS] |= 1ull << (x % BOARD_ROW_WORD_BITS);
+
+        ++board->rowFillCounts[slot];
+        board->columnHeights[x] = Max(board->columnHeights[x], y + 1);
+        board->stackHeight = Max(board->stackHeight, y + 1);
+        board->hash ^= IsBoardHashed(board) ? GetTileZobristKey(x, y) : 0;
+    }
+}
+
+b32 IsTetrominoPosValid(board_t* board, tetromino_t* tetromino) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    if (tetromino->x + shape->minX < 0 || tetromino->x + shape->maxX >= board->width || tetromino->y + shape->minY < 0 || tetromino->y + shape->maxY >= board->height) {
+        return false;
+    }
+
+    for (i32 i = 0; i < shape->cellsCount; ++i) {
+        if (IsBoardTileFilled(board, tetromino->x + shape->cells[i].x, tetromino->y + shape->cells[i].y)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Different rotations can cover the exact same tiles (the O always does, I, S and Z do when flipped)
+b32 DoTetrominoesCoverSameTiles(tetromino_t* a, tetromino_t* b) {
+    const piece_shape* shapeA = GetPieceShape(a->type, a->rotation);
+    const piece_shape* shapeB = GetPieceShape(b->type, b->rotation);
+    if (shapeA->cellsCount != shapeB->cellsCount) {
+        return false;
+    }
+
+    for (i32 i = 0; i < shapeA->cellsCount; ++i) {
+        i32 x = a->x + shapeA->cells[i].x - b->x;
+        i32 y = a->y + shapeA->cells[i].y - b->y;
+        if (x < 0 || x >= PIECE_MAX_SIZE || y < 0 || y >= PIECE_MAX_SIZE || !(shapeB->rowMasks[y] & (1 << x))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+b32 TryMoveTetromino(board_t* board, tetromino_t* tetromino, i32 dx, i32 dy) {
+    tetromino_t moved = *tetromino;
+    moved.x += dx;
+    moved.y += dy;
+    if (!IsTetrominoPosValid(board, &moved)) {
+        return false;
+    }
+
+    *tetromino = moved;
+    return true;
+}
+
+// direction is 1 for clockwise and -1 for counterclockwise
+b32 TryRotateTetromino(board_t* board, tetromino_t* tetromino, i32 direction) {
+    tetromino_t rotated = *tetromino;
+    rotated.rotation = (tetromino->rotation + direction + 4) % 4;
+
+    for (i32 i = 0; i < ArraySize(ROTATION_KICKS); ++i) {
+        rotated.x = tetromino->x + ROTATION_KICKS[i][0];
+        rotated.y = tetromino->y + ROTATION_KICKS[i][1];
+        if (IsTetrominoPosValid(board, &rotated)) {
+            *tetromino = rotated;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// How far the tetromino can fall from where it is. Only needs to look at the columns it covers, unless it is tucked in under something
+i32 GetDropDistance(board_t* board, tetromino_t* tetromino) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+
+    i32 distance = board->height;
+    for (i32 column = shape->minX; column <= shape->maxX; ++column) {
+        if (shape->columnBottoms[column] < 0) {
+            continue;
+        }
+
+        i32 x = tetromino->x + column;
+        i32 y = tetromino->y + shape->columnBottoms[column];
+        if (y < board->columnHeights[x]) {
+            // Below the top of the stack, so the heights tell us nothing
+            tetromino_t dropped = *tetromino;
+            while (IsTetrominoPosValid(board, &dropped)) {
+                --dropped.y;
+            }
+            return tetromino->y - dropped.y - 1;
+        }
+
+        distance = Min(distance, y - board->columnHeights[x]);
+    }
+
+    return distance;
+}
+
+static void RecalculateColumnHeights(board_t* board, i32 linesCleared) {
+    board->stackHeight = 0;
+    for (i32 x = 0; x < board->width; ++x) {
+        // A cleared line is full, so it is always below the top of every column
+        i32 height = board->columnHeights[x] - linesCleared;
+        while (height > 0 && !IsBoardTileFilled(board, x, height - 1)) {
+            --height;
+        }
+        board->columnHeights[x] = height;
+        board->stackHeight = Max(board->stackHeight, height);
+    }
+}
+
+// Empties the full rows and moves their slots to the top of the stack, with the rows in between sliding down. Rows
+// above the stack are all empty, so their order doesn't matter and they stay where they are
+i32 ProcessLineClears(board_t* board, tetromino_t* tetromino) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    i32 fullRows[PIECE_MAX_SIZE];
+    i32 lineClearCount = 0;
+    for (i32 y = Max(tetromino->y + shape->minY, 0); y <= Min(tetromino->y + shape->maxY, board->height - 1); ++y) {
+        if (board->rowFillCounts[board->rowSlots[y]] == board->width) {
+            fullRows[lineClearCount++] = y;
+        }
+    }
+
+    if (!lineClearCount) {
+        return 0;
+    }
+
+    // Everything from the lowest full row up moves, so that part of the hash gets taken out now and put back once it has
+    b32 isHashed = IsBoardHashed(board);
+    if (isHashed) {
+        board->hash ^= HashBoardTiles(board, fullRows[0]);
+    }
+
+    i32 clearedSlots[PIECE_MAX_SIZE];
+    i32 clearedCount = 0;
+    i32 row = fullRows[0];
+    for (i32 y = fullRows[0]; y < board->stackHeight; ++y) {
+        if (clearedCount < lineClearCount && y == fullRows[clearedCount]) {
+            clearedSlots[clearedCount++] = board->rowSlots[y];
+        }
+        else {
+            board->rowSlots[row++] = board->rowSlots[y];
+        }
+    }
+
+    for (i32 i = 0; i < lineClearCount; ++i) {
+        i32 slot = clearedSlots[i];
+        for (i32 x = 0; x < board->width; ++x) {
+            board->tiles[slot * board->width + x] = tetromino_type_empty;
+        }
+        for (i32 word = 0; word < board->rowWords; ++word) {
+            board->rowMasks[slot * board->rowWords + word] = 0;
+        }
+        board->rowFillCounts[slot] = 0;
+        ++board->slotVersions[slot];
+        board->rowSlots[row++] = slot;
+    }
+
+    RecalculateColumnHeights(board, lineClearCount);
+    if (isHashed) {
+        board->hash ^= HashBoardTiles(board, fullRows[0]);
+    }
+
+    return lineClearCount;
+}
+
+// Fisher-Yates
+static void RandomizeBag(tetromino_bag* bag) {
+    for (i32 i = 0; i < 7; ++i) {
+        bag->pieces[i] = tetromino_type_I + i;
+    }
+    for (i32 i = 6; i > 0; --i) {
+        i32 j = NextRandomBelow(&bag->random, i + 1);
+        tetromino_type temp = bag->pieces[i];
+        bag->pieces[i] = bag->pieces[j];
+        bag->pieces[j] = temp;
+    }
+
+    bag->index = 0;
+}
+
+void InitBag(tetromino_bag* bag, random_state random) {
+    bag->random = random;
+    RandomizeBag(bag);
+}
+
+tetromino_type GetNextTetrominoFromBag(tetromino_bag* bag) {
+    tetromino_type result = bag->pieces[bag->index++];
+
+    if (bag->index >= 7) {
+        RandomizeBag(bag);
+    }
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef TETRIS_BOARD_H
+#define TETRIS_BOARD_H
+
+#include "tetris.h"
+#include "tetris_random.h"
+#include "tetris_pieces.h"
+
+
+#define BOARD_WIDTH  10
+#define BOARD_HEIGHT 20
+
+#define SPAWN_X (BOARD_WIDTH / 2 - 2)
+#define SPAWN_Y (BOARD_HEIGHT - 4)
+
+typedef enum tetromino_type {
+    tetromino_type_empty = 0,
+    tetromino_type_I,
+    tetromino_type_O,
+    tetromino_type_T,
+    tetromino_type_S,
+    tetromino_type_Z,
+    tetromino_type_J,
+    tetromino_type_L,
+} tetromino_type;
+
+typedef struct tetromino_t {
+    tetromino_type type;
+    i32 rotation;
+    i32 x;
+    i32 y;
+} tetromino_t;
+
+// 7-bag randomizer. Every game has its own, so games on different threads don't share any random state
+typedef struct tetromino_bag {
+    tetromino_type pieces[7];
+    i32 index; // The next one to deal
+    random_state random;
+} tetromino_bag;
+
+#define BOARD_ROW_WORD_BITS    64
+#define BOARD_MAX_HASHED_WIDTH 16 // Wider boards don't keep a hash, the bot can't play them anyway (see GetBoardRows)
+
+#define BOARD_ROW_WORDS(width) (((width) + BOARD_ROW_WORD_BITS - 1) / BOARD_ROW_WORD_BITS)
+// Everything a board points to, in one block: rowMasks, tiles, then columnHeights, rowFillCounts, rowSlots and slotVersions
+#define BOARD_MEMORY_SIZE(width, height) ((height) * BOARD_ROW_WORDS(width) * sizeof(u64) + (width) * (height) * sizeof(tetromino_type) + ((width) + 3 * (height)) * sizeof(i32))
+
+/*
+    Boards can be any size. Rows live in slots and rowSlots says which slot holds which row, so a line clear empties
+    the cleared slots and shuffles slot indices around instead of moving tiles. That, and only looking at rows below
+    stackHeight, keeps a clear about as expensive as the rows it clears no matter how big the board is.
+
+    columnHeights, rowFillCounts, rowMasks, slotVersions, stackHeight and hash are kept up to date by PlaceTetromino,
+    ProcessLineClears, SetBoardTile and SetBoardRow. Don't write to tiles directly, and go through GetBoardTile to
+    read them
+*/
+typedef struct board_t {
+    tetromino_type* tiles; // By slot, width per slot
+    u64* rowMasks;         // By slot, rowWords per slot. Bit x % 64 of word x / 64 is set if that tile is filled
+    i32* rowSlots;         // The slot of each row, bottom row first
+    i32* columnHeights;    // One above the highest filled tile, 0 for an empty column
+    i32* rowFillCounts;    // Number of filled tiles in each slot
+    u32* slotVersions;     // Goes up every time a slot's tiles change, so anything that has seen a slot can tell if it still holds the same thing
+    u64 hash;              // Zobrist hash of which tiles are filled. The tile types don't count
+    i32 width;
+    i32 height;
+    i32 size;
+    i32 rowWords;
+    i32 stackHeight;       // The highest of the column heights, nothing is filled from this row up
+
+    // Where on the screen the board goes. Only the part in view gets drawn, viewX and viewY are the leftmost column and
+    // lowest row of it
+    i32 x;
+    i32 y;
+    i32 tileSize;
+    i32 viewX;
+    i32 viewY;
+    i32 viewColumns;
+    i32 viewRows;
+    i32 widthPx;  // Of the view
+    i32 heightPx;
+} board_t;
+
+extern const i32 ROTATION_KICKS[4][2];
+
+extern board_t InitBoard(i32 width, i32 height, i32 x, i32 y, i32 tileSize);
+extern board_t InitBoardInMemory(i32 width, i32 height, void* memory, i32 x, i32 y, i32 tileSize);
+extern void SetBoardMemory(board_t* board, void* memory);
+extern void FreeBoard(board_t* board);
+extern void CopyBoard(board_t* dest, board_t* source);
+extern void SetBoardTileSize(board_t* board, i32 tileSize);
+extern void SetBoardView(board_t* board, i32 columns, i32 rows);
+extern void ScrollBoardViewTo(board_t* board, tetromino_t* tetromino);
+extern void ClearBoard(board_t* board);
+extern void SetBoardTile(board_t* board, i32 x, i32 y, tetromino_type type);
+extern tetromino_type GetBoardTile(board_t* board, i32 x, i32 y);
+extern const tetromino_type* GetBoardRow(board_t* board, i32 y);
+extern void SetBoardRow(board_t* board, i32 y, const tetromino_type* tiles);
+extern void RecalculateBoardHeights(board_t* board, i32 topRow);
+extern void GetBoardRows(board_t* board, u16* rows);
+extern u64 GetTileZobristKey(i32 x, i32 y);
+extern u64 GetPiecesZobristHash(tetromino_type hold, tetromino_type* queue, i32 queueCount);
+extern u64 HashBoardRows(const u16* rows, i32 fromRow, i32 height);
+extern tetromino_t InitTetromino(tetromino_type type, i32 rotation, i32 x, i32 y);
+extern tetromino_t SpawnTetromino(board_t* board, tetromino_type type);
+extern void PlaceTetromino(board_t* board, tetromino_t* tetromino);
+extern b32 IsTetrominoPosValid(board_t* board, tetromino_t* tetromino);
+extern b32 DoTetrominoesCoverSameTiles(tetromino_t* a, tetromino_t* b);
+extern b32 TryMoveTetromino(board_t* board, tetromino_t* tetromino, i32 dx, i32 dy);
+extern b32 TryRotateTetromino(board_t* board, tetromino_t* tetromino, i32 direction);
+extern i32 GetDropDistance(board_t* board, tetromino_t* tetromino);
+extern i32 ProcessLineClears(board_t* board, tetromino_t* tetromino);
+extern void InitBag(tetromino_bag* bag, random_state random);
+extern tetromino_type GetNextTetrominoFromBag(tetromino_bag* bag);
+
+#endif
\ No newline at end of file
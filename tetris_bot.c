@@ -0,0 +1,404 @@
+#include "tetris_bot.h"
+
+#include <stdlib.h>
+
+/*
+    Beam search over the current piece and the preview, with hold. Every node is a board after some number of pieces.
+    Each step expands every node in the beam with all the placements of the next piece (and of the piece we would get
+    by holding), scores the children and keeps the best BOT_BEAM_WIDTH of them. The move we make is the first move of
+    the best line after the last step that finished within the time budget.
+
+    The nodes of a step get expanded in parallel with EngineRunJobs, one job per node. Every job writes into its own
+    slots in bot->children. The only other thing they share is bot->transpositions, which remembers the best way found
+    so far to every node of the step, so most of the worse ways of getting to the same node can be dropped before they
+    are scored. The table can lose stores and the jobs race each other, so that is only a shortcut. Which way to a node
+    is kept is decided after the jobs are done, on one thread: the one with the most reward, and the lowest slot in
+    bot->children on a tie. That doesn't depend on thread timing, so neither does the beam.
+*/
+
+#define FULL_ROW ((1 << BOARD_WIDTH) - 1)
+
+const bot_weights BOT_DEFAULT_WEIGHTS = {
+    .features = {
+        [board_feature_holes]            = -4.0f,
+        [board_feature_aggregate_height] = -0.5f,
+        [board_feature_max_height]       = -0.5f,
+        [board_feature_bumpiness]        = -0.35f,
+        [board_feature_wells]            = -0.25f
+    },
+    .lineClears = { 0.0f, -2.0f, -1.5f, -1.0f, 8.0f }
+};
+
+
+// One board at a time. The search scores whole batches instead, which comes out the same
+f32 EvaluateBotRows(bot_weights* weights, const u16* rows) {
+    f32 features[board_feature_count];
+    GetBoardFeatures(rows, 0, features);
+
+    f32 score = 0.0f;
+    for (i32 i = 0; i < board_feature_count; ++i) {
+        score += weights->features[i] * features[i];
+    }
+
+    return score;
+}
+
+// Places the tetromino into the rows and removes full lines, keeping the hash up to date. Returns the number of lines cleared
+static i32 PlaceTetrominoInRows(u16* rows, u64* hash, tetromino_t* tetromino) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    i32 lowestFullRow = -1;
+    for (i32 row = shape->minY; row <= shape->maxY; ++row) {
+        u32 mask = shape->rowMasks[row];
+        i32 y = tetromino->y + row;
+        rows[y] |= (u16)(tetromino->x >= 0 ? mask << tetromino->x : mask >> -tetromino->x);
+        if (rows[y] == FULL_ROW && lowestFullRow < 0) {
+            lowestFullRow = y;
+        }
+    }
+    for (i32 i = 0; i < shape->cellsCount; ++i) {
+        *hash ^= GetTileZobristKey(tetromino->x + shape->cells[i].x, tetromino->y + shape->cells[i].y);
+    }
+
+    if (lowestFullRow < 0) {
+        return 0;
+    }
+
+    // Everything from the lowest full row up moves
+    *hash ^= HashBoardRows(rows, lowestFullRow, BOARD_HEIGHT);
+
+    i32 linesCleared = 0;
+    for (i32 y = Max(tetromino->y + shape->minY, 0); y < Min(tetromino->y + shape->maxY + 1, BOARD_HEIGHT) - linesCleared;) {
+        if (rows[y] == FULL_ROW) {
+            for (i32 i = y; i < BOARD_HEIGHT - 1; ++i) {
+                rows[i] = rows[i + 1];
+            }
+            rows[BOARD_HEIGHT - 1] = 0;
+            ++linesCleared;
+        }
+        else {
+            ++y;
+        }
+    }
+
+    *hash ^= HashBoardRows(rows, lowestFullRow, BOARD_HEIGHT);
+
+    return linesCleared;
+}
+
+typedef struct bot_expansion {
+    tetromino_type type;
+    tetromino_type hold;
+    i32 queueIndex;
+    b32 useHold;
+} bot_expansion;
+
+// Playing the piece in front of the queue, or holding it and playing whatever comes out of the hold box instead
+static i32 GetBotExpansions(bot_t* bot, bot_node* node, b32 canHold, bot_expansion* outExpansions) {
+    i32 count = 0;
+    i32 queueIndex = node->queueIndex;
+
+    outExpansions[count++] = (bot_expansion){ bot->pieces[queueIndex], node->hold, queueIndex + 1, false };
+
+    if (canHold && bot->pieces[queueIndex] != node->hold) {
+        if (node->hold != tetromino_type_empty) {
+            outExpansions[count++] = (bot_expansion){ node->hold, bot->pieces[queueIndex], queueIndex + 1, true };
+        }
+        else if (queueIndex + 1 < bot->piecesCount) {
+            outExpansions[count++] = (bot_expansion){ bot->pieces[queueIndex + 1], bot->pieces[queueIndex], queueIndex + 2, true };
+        }
+    }
+
+    return count;
+}
+
+static u64 GetBotNodeKey(bot_t* bot, bot_node* node) {
+    return node->rowsHash ^ GetPiecesZobristHash(node->hold, &bot->pieces[node->queueIndex], bot->piecesCount - node->queueIndex);
+}
+
+// True if a better way to the same node has already been found in this step, by the same rule the merge after the
+// jobs uses. Only ever true for nodes the merge would drop anyway, since whatever is in the table was kept by its job
+static b32 IsBotNodeBeaten(bot_t* bot, u64 key, bot_node* node, i32 slot, i32 depth) {
+    transposition_data seen;
+    if (!ProbeTransposition(&bot->transpositions, key, &seen) || seen.generation != bot->transpositions.generation || seen.depth != depth) {
+        return false;
+    }
+
+    return seen.score > node->reward || (seen.score == node->reward && seen.move < slot);
+}
+
+typedef struct bot_job_data {
+    bot_t* bot;
+    i32 depth;
+    b32 isRoot;
+    b32 canHold;
+} bot_job_data;
+
+static void ExpandBotNode(void* data, i32 jobIndex, i32 threadIndex) {
+    bot_job_data* jobData = data;
+    bot_t* bot = jobData->bot;
+    bot_node* node = &bot->beam[jobIndex];
+    bot_node* children = &bot->children[jobIndex * BOT_MAX_CHILDREN];
+    move_generator* generator = &bot->generators[threadIndex];
+    board_batch* batch = &bot->batches[threadIndex];
+    ClearBoardBatch(batch);
+
+    i32 childrenCount = 0;
+
+    // The whole step gets thrown away if we run out of time, so there is no point finishing it
+    if (bot->didRunOutOfTime || EngineGetSeconds() > bot->deadline || (bot->cancel && *bot->cancel != bot->cancelValue)) {
+        bot->didRunOutOfTime = true;
+        bot->childrenCounts[jobIndex] = 0;
+        return;
+    }
+
+    bot_expansion expansions[2];
+    i32 expansionsCount = GetBotExpansions(bot, node, jobData->isRoot ? jobData->canHold : true, expansions);
+
+    for (i32 i = 0; i < expansionsCount; ++i) {
+        bot_expansion* expansion = &expansions[i];
+
+        tetromino_t start = InitTetromino(expansion->type, 0, SPAWN_X, SPAWN_Y);
+        if (jobData->isRoot && !expansion->useHold) {
+            start = bot->current;
+        }
+        i32 placementsCount = GeneratePlacementsFromRows(generator, node->rows, BOARD_WIDTH, BOARD_HEIGHT, &start);
+
+        for (i32 j = 0; j < placementsCount && childrenCount < BOT_MAX_CHILDREN; ++j) {
+            bot_node* child = &children[childrenCount];
+            *child = *node;
+            child->hold = expansion->hold;
+            child->queueIndex = (i16)expansion->queueIndex;
+
+            i32 linesCleared = PlaceTetrominoInRows(child->rows, &child->rowsHash, &generator->placements[j].tetromino);
+            child->reward = node->reward + bot->weights.lineClears[linesCleared];
+
+            // Both have the same rows, so the one with more reward on the way is the better one
+            i32 slot = jobIndex * BOT_MAX_CHILDREN + childrenCount;
+            u64 key = GetBotNodeKey(bot, child);
+            if (IsBotNodeBeaten(bot, key, child, slot, jobData->depth)) {
+                continue;
+            }
+            StoreTransposition(&bot->transpositions, key, (transposition_data){ .score = child->reward, .move = (i16)slot, .depth = (u8)jobData->depth });
+
+            AddBoardToBatch(batch, child->rows, linesCleared); // Lines up with children, since it is cleared at the top
+
+            if (jobData->isRoot) {
+                // Only one job at the root, so the root moves line up with the children
+                child->rootMove = (i16)childrenCount;
+                bot->rootMoves[childrenCount] = (bot_move){ .useHold = expansion->useHold, .placement = generator->placements[j].tetromino };
+                bot->rootMovesCount = childrenCount + 1;
+            }
+
+            ++childrenCount;
+        }
+    }
+
+    ComputeBoardFeatures(batch);
+    ScoreBoardBatch(batch, bot->weights.features);
+    for (i32 i = 0; i < childrenCount; ++i) {
+        children[i].score = children[i].reward + batch->scores[i];
+    }
+
+    bot->childrenCounts[jobIndex] = childrenCount;
+}
+
+// By node, then best way first
+static int CompareBotChildKeys(const void* a, const void* b) {
+    const bot_child_key* keyA = a;
+    const bot_child_key* keyB = b;
+    if (keyA->key != keyB->key) {
+        return keyA->key < keyB->key ? -1 : 1;
+    }
+    if (keyA->reward != keyB->reward) {
+        return keyA->reward > keyB->reward ? -1 : 1;
+    }
+    return keyA->slot < keyB->slot ? -1 : keyA->slot > keyB->slot;
+}
+
+// Copies the best way to every node found in the step into the beam. Returns how many there are
+static i32 MergeBotChildren(bot_t* bot) {
+    i32 keysCount = 0;
+    for (i32 i = 0; i < bot->beamCount; ++i) {
+        for (i32 j = 0; j < bot->childrenCounts[i]; ++j) {
+            i32 slot = i * BOT_MAX_CHILDREN + j;
+            bot_node* child = &bot->children[slot];
+            bot->childKeys[keysCount++] = (bot_child_key){ GetBotNodeKey(bot, child), child->reward, slot };
+        }
+    }
+    qsort(bot->childKeys, keysCount, sizeof(bot_child_key), CompareBotChildKeys);
+
+    i32 childrenCount = 0;
+    for (i32 i = 0; i < keysCount; ++i) {
+        if (i == 0 || bot->childKeys[i].key != bot->childKeys[i - 1].key) {
+            bot->beam[childrenCount++] = bot->children[bot->childKeys[i].slot]; // The beam has room for all of them
+        }
+    }
+
+    return childrenCount;
+}
+
+static void SwapBotNodes(bot_node* a, bot_node* b) {
+    bot_node temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+// Moves the keepCount highest scoring nodes to the front, in no particular order (quickselect)
+static void SelectBestBotNodes(bot_node* nodes, i32 count, i32 keepCount) {
+    i32 low = 0;
+    i32 high = count - 1;
+    while (low < high) {
+        f32 pivot = nodes[(low + high) / 2].score;
+        i32 i = low;
+        i32 j = high;
+        while (i <= j) {
+            while (nodes[i].score > pivot) {
+                ++i;
+            }
+            while (nodes[j].score < pivot) {
+                --j;
+            }
+            if (i <= j) {
+                SwapBotNodes(&nodes[i], &nodes[j]);
+                ++i;
+                --j;
+            }
+        }
+
+        if (keepCount - 1 <= j) {
+            high = j;
+        }
+        else if (keepCount - 1 >= i) {
+            low = i;
+        }
+        else {
+            break;
+        }
+    }
+}
+
+static void InitBotForThreads(bot_t* bot, i32 threadsCount) {
+    *bot = (bot_t){ 0 };
+    bot->weights = BOT_DEFAULT_WEIGHTS;
+    bot->timeBudget = BOT_TIME_BUDGET;
+    bot->previewCount = BOT_PREVIEW_COUNT;
+    bot->beamWidth = BOT_BEAM_WIDTH;
+
+    bot->threadsCount = threadsCount;
+    bot->generators = EngineAllocate(bot->threadsCount * sizeof(move_generator), memory_tag_bot);
+    bot->batches = EngineAllocate(bot->threadsCount * sizeof(board_batch), memory_tag_bot);
+    for (i32 i = 0; i < bot->threadsCount; ++i) {
+        InitBoardBatch(&bot->batches[i], BOT_MAX_CHILDREN);
+    }
+    bot->beam = EngineAllocate(BOT_BEAM_WIDTH * BOT_MAX_CHILDREN * sizeof(bot_node), memory_tag_bot);
+    bot->children = EngineAllocate(BOT_BEAM_WIDTH * BOT_MAX_CHILDREN * sizeof(bot_node), memory_tag_bot);
+    bot->childrenCounts = EngineAllocate(BOT_BEAM_WIDTH * sizeof(i32), memory_tag_bot);
+    bot->childKeys = EngineAllocate(BOT_BEAM_WIDTH * BOT_MAX_CHILDREN * sizeof(bot_child_key), memory_tag_bot);
+    InitTranspositionTable(&bot->transpositions, BOT_TRANSPOSITION_TABLE_SIZE);
+}
+
+void InitBot(bot_t* bot) {
+    InitBotForThreads(bot, EngineGetThreadCount());
+}
+
+// Never calls EngineRunJobs, so it can be used from inside a job
+void InitSingleThreadedBot(bot_t* bot) {
+    InitBotForThreads(bot, 1);
+}
+
+void FreeBot(bot_t* bot) {
+    EngineFree(bot->generators);
+    for (i32 i = 0; i < bot->threadsCount; ++i) {
+        FreeBoardBatch(&bot->batches[i]);
+    }
+    EngineFree(bot->batches);
+    EngineFree(bot->beam);
+    EngineFree(bot->children);
+    EngineFree(bot->childrenCounts);
+    EngineFree(bot->childKeys);
+    FreeTranspositionTable(&bot->transpositions);
+    *bot = (bot_t){ 0 };
+}
+
+// Picks a move for the current piece, starting from wherever it is. next holds BOT_PREVIEW_COUNT pieces. Returns false if there is nowhere to put the piece
+b32 FindBotMove(bot_t* bot, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, bot_move* outMove) {
+    f64 startTime = EngineGetSeconds();
+    bot->deadline = startTime + bot->timeBudget;
+    bot->didRunOutOfTime = false;
+    bot->searchedDepth = 0;
+    NewTranspositionSearch(&bot->transpositions);
+
+    bot->current = *current;
+    bot->pieces[0] = current->type;
+    i32 previewCount = Clamp(bot->previewCount, 0, BOT_PREVIEW_COUNT);
+    for (i32 i = 0; i < previewCount; ++i) {
+        bot->pieces[1 + i] = next[i];
+    }
+    bot->piecesCount = 1 + previewCount;
+
+    bot_node* root = &bot->beam[0];
+    *root = (bot_node){ .hold = hold };
+    GetBoardRows(board, root->rows);
+    root->rowsHash = board->hash;
+    bot->beamCount = 1;
+    bot->rootMovesCount = 0;
+
+    i32 bestRootMove = -1;
+
+    for (i32 depth = 0; depth < bot->piecesCount; ++depth) {
+        // Nodes that used hold to play a piece from further back in the queue run out of pieces first
+        i32 expandableCount = 0;
+        for (i32 i = 0; i < bot->beamCount; ++i) {
+            if (bot->beam[i].queueIndex < bot->piecesCount) {
+                bot->beam[expandableCount++] = bot->beam[i];
+            }
+        }
+        if (expandableCount == 0) {
+            break;
+        }
+        bot->beamCount = expandableCount;
+
+        bot_job_data jobData = { .bot = bot, .depth = depth, .isRoot = depth == 0, .canHold = canHold };
+        if (bot->threadsCount > 1) {
+            EngineRunJobs(ExpandBotNode, &jobData, bot->beamCount);
+        }
+        else {
+            for (i32 i = 0; i < bot->beamCount; ++i) {
+                ExpandBotNode(&jobData, i, 0);
+            }
+        }
+
+        // The root step always counts, otherwise we wouldn't have a move at all
+        if (bot->didRunOutOfTime && depth > 0) {
+            break;
+        }
+
+        // A job can keep a node before another job finds a better way to it, or after the table lost the better one
+        i32 childrenCount = MergeBotChildren(bot);
+        if (childrenCount == 0) {
+            break;
+        }
+
+        i32 beamWidth = Clamp(bot->beamWidth, 1, BOT_BEAM_WIDTH);
+        SelectBestBotNodes(bot->beam, childrenCount, beamWidth);
+        bot->beamCount = Min(childrenCount, beamWidth);
+        bot->searchedDepth = depth + 1;
+
+        bot_node* best = &bot->beam[0];
+        for (i32 i = 1; i < bot->beamCount; ++i) {
+            if (bot->beam[i].score > best->score) {
+                best = &bot->beam[i];
+            }
+        }
+        bestRootMove = best->rootMove;
+    }
+
+    bot->searchSeconds = EngineGetSeconds() - startTime;
+
+    if (bestRootMove < 0) {
+        return false;
+    }
+
+    *outMove = bot->rootMoves[bestRootMove];
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef TETRIS_BOT_H
+#define TETRIS_BOT_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_moves.h"
+#include "tetris_features.h"
+#include "tetris_transposition.h"
+
+
+#define BOT_PREVIEW_COUNT 3
+#define BOT_BEAM_WIDTH    48
+#define BOT_MAX_CHILDREN  (2 * MOVE_GEN_MAX_PLACEMENTS) // Per node, one set of placements with and one without hold
+#define BOT_TIME_BUDGET   0.006 // Seconds per piece. Whatever depth is done by then is what we go with
+#define BOT_TRANSPOSITION_TABLE_SIZE (1 << 20)
+
+// Higher is better, so the things we want to avoid get negative weights
+typedef struct bot_weights {
+    f32 features[board_feature_count]; // Per unit of each board_feature
+    f32 lineClears[5];                 // Indexed by the number of lines cleared at once
+} bot_weights;
+
+typedef struct bot_node {
+    u16 rows[BOARD_HEIGHT];
+    u64 rowsHash; // HashBoardRows of rows
+    f32 reward; // Line clear rewards on the way here
+    f32 score;  // reward plus how good the board looks
+    tetromino_type hold;
+    i16 queueIndex; // The next piece to play from bot_t.pieces
+    i16 rootMove;   // Which of bot_t.rootMoves this line started with
+} bot_node;
+
+// Which node a child ends up at and how good the way there was, for dropping the worse ways once all the jobs are done
+typedef struct bot_child_key {
+    u64 key;
+    f32 reward;
+    i32 slot; // In bot_t.children
+} bot_child_key;
+
+typedef struct bot_move {
+    b32 useHold;
+    tetromino_t placement; // Where the piece that gets played ends up
+} bot_move;
+
+typedef struct bot_t {
+    bot_weights weights;
+    f64 timeBudget;
+    i32 previewCount; // Up to BOT_PREVIEW_COUNT. Fewer is faster and plays worse
+    i32 beamWidth;    // Up to BOT_BEAM_WIDTH. Same
+
+    tetromino_type pieces[1 + BOT_PREVIEW_COUNT];
+    i32 piecesCount;
+    tetromino_t current; // Might not be at the spawn anymore
+
+    bot_node* beam;
+    i32 beamCount;
+    bot_node* children; // BOT_MAX_CHILDREN slots for every node in the beam
+    i32* childrenCounts;
+    bot_child_key* childKeys; // One per child of the step
+    bot_move rootMoves[BOT_MAX_CHILDREN];
+    i32 rootMovesCount;
+
+    move_generator* generators; // One per thread
+    board_batch* batches;       // Same
+    i32 threadsCount;           // 1 means the search runs on the calling thread without EngineRunJobs
+    transposition_table transpositions; // Different orders of placements can end up at the same node. Lets the jobs skip the worse ways early
+    f64 deadline;
+    volatile b32 didRunOutOfTime;
+    volatile i32* cancel; // Optional. Once *cancel isn't cancelValue anymore the search stops like it ran out of time, so another thread can call it off
+    i32 cancelValue;
+
+    // From the last call to FindBotMove
+    i32 searchedDepth;
+    f64 searchSeconds;
+} bot_t;
+
+extern const bot_weights BOT_DEFAULT_WEIGHTS;
+
+extern void InitBot(bot_t* bot);
+extern void InitSingleThreadedBot(bot_t* bot);
+extern void FreeBot(bot_t* bot);
+extern f32 EvaluateBotRows(bot_weights* weights, const u16* rows);
+extern b32 FindBotMove(bot_t* bot, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, bot_move* outMove);
+
+#endif
\ No newline at end of file
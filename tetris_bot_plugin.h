@@ -0,0 +1,91 @@
+#ifndef TETRIS_BOT_PLUGIN_H
+#define TETRIS_BOT_PLUGIN_H
+
+#include "tetris_types.h"
+
+/*
+    What a bot plugin looks like from the outside. This is all a plugin needs to include, and nothing in here may
+    change in a way that breaks plugins that were built against it. Add fields at the end of the structs and bump
+    BOT_PLUGIN_VERSION instead.
+
+    A plugin is a DLL that exports BOT_PLUGIN_ENTRY_POINT as a get_bot_plugin. The tournament calls init once per game,
+    and plays different games on different threads at the same time, so an instance should only ever touch its own
+    state. decide gets called once per piece and should return within game->timeBudget seconds. A decision that takes
+    longer gets thrown away and the piece hard dropped from where it spawned.
+
+    Pieces and inputs use the game's own numbers, spelled out below. Rotations go 0 to 3 clockwise from the spawn
+    rotation, and x and y are of the piece's 4x4 box with y going up, same as tetromino_t.
+*/
+
+#define BOT_PLUGIN_VERSION 1
+#define BOT_PLUGIN_ENTRY_POINT "GetBotPlugin"
+
+#define BOT_PLUGIN_BOARD_WIDTH   10
+#define BOT_PLUGIN_BOARD_HEIGHT  20
+#define BOT_PLUGIN_PREVIEW_COUNT 3
+#define BOT_PLUGIN_MAX_INPUTS    64
+
+// tetromino_type
+#define BOT_PLUGIN_PIECE_NONE 0
+#define BOT_PLUGIN_PIECE_I    1
+#define BOT_PLUGIN_PIECE_O    2
+#define BOT_PLUGIN_PIECE_T    3
+#define BOT_PLUGIN_PIECE_S    4
+#define BOT_PLUGIN_PIECE_Z    5
+#define BOT_PLUGIN_PIECE_J    6
+#define BOT_PLUGIN_PIECE_L    7
+
+// move_input
+#define BOT_PLUGIN_INPUT_NONE       0
+#define BOT_PLUGIN_INPUT_LEFT       1
+#define BOT_PLUGIN_INPUT_RIGHT      2
+#define BOT_PLUGIN_INPUT_ROTATE_CW  3
+#define BOT_PLUGIN_INPUT_ROTATE_CCW 4
+#define BOT_PLUGIN_INPUT_SOFT_DROP  5
+#define BOT_PLUGIN_INPUT_HARD_DROP  6
+
+#ifdef _WIN32
+#define BOT_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define BOT_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef struct bot_plugin_game {
+    u32 size; // sizeof(bot_plugin_game) for the tournament, so a plugin can tell which fields are there
+    u16 rows[BOT_PLUGIN_BOARD_HEIGHT]; // Bottom row first. Bit x is set if column x is filled
+    u8 current;
+    i8 currentRotation;
+    i8 currentX;
+    i8 currentY;
+    u8 next[BOT_PLUGIN_PREVIEW_COUNT];
+    u8 hold;
+    u8 canHold;
+    i32 score;
+    i32 lines;
+    i32 level;
+    f64 timeBudget; // Seconds
+} bot_plugin_game;
+
+// Either where the piece should end up (the tournament finds the inputs), or the inputs themselves. With useHold,
+// it's the piece that comes out of the hold box (or the next one if it's empty) that gets placed
+typedef struct bot_plugin_decision {
+    u8 useHold;
+    u8 hasPlacement;
+    i8 rotation;
+    i8 x;
+    i8 y;
+    u8 inputsCount;
+    u8 inputs[BOT_PLUGIN_MAX_INPUTS];
+} bot_plugin_decision;
+
+typedef struct bot_plugin {
+    u32 version; // BOT_PLUGIN_VERSION the plugin was built with
+    const char* name;
+    void* (*init)(u64 seed); // Returns the instance the other two get
+    b32 (*decide)(void* instance, const bot_plugin_game* game, bot_plugin_decision* outDecision); // Returns false to give up
+    void (*shutdown)(void* instance);
+} bot_plugin;
+
+typedef const bot_plugin* (*get_bot_plugin)(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "tetris_env.h"
+
+/*
+    Lots of games at once for training agents, as fast as they go. Each step takes one action per env, applies it on
+    the first tick the way Scene1 applies a key press, then runs gravity and the lock delay for up to ticksPerStep
+    ticks. A lock ends the step early, so every piece gets at least one action.
+
+    The board is the rows in env_observations rather than a board_t, since a normal board fits in BOARD_HEIGHT u16s
+    and the caller wants it in that shape anyway. Moving, rotating (with ROTATION_KICKS) and clearing work on those
+    rows directly and agree with the board code on everything, the perft counts rely on the same rules.
+
+    Gravity doesn't get ticked one tick at a time: while the piece is falling we skip straight to the tick it moves
+    down on. Once it's on the ground every tick counts towards the lock delay, same as in Scene1.
+*/
+
+#define FULL_ROW ((1 << BOARD_WIDTH) - 1)
+#define ENV_ARRAY_ALIGNMENT 64
+
+
+// Returns false if any of the piece's tiles are outside the board or on a filled one
+static b32 IsEnvPieceValid(const u16* rows, tetromino_t* piece) {
+    const piece_shape* shape = GetPieceShape(piece->type, piece->rotation);
+    for (i32 row = shape->minY; row <= shape->maxY; ++row) {
+        u32 mask = shape->rowMasks[row];
+        i32 y = piece->y + row;
+        if (y < 0 || y >= BOARD_HEIGHT) {
+            return false;
+        }
+        if (piece->x < 0 && (mask & ((1 << -piece->x) - 1))) {
+            return false;
+        }
+        u32 placed = piece->x >= 0 ? mask << piece->x : mask >> -piece->x;
+        if ((placed & ~FULL_ROW) || (rows[y] & placed)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static b32 TryMoveEnvPiece(const u16* rows, tetromino_t* piece, i32 dx, i32 dy) {
+    tetromino_t moved = *piece;
+    moved.x += dx;
+    moved.y += dy;
+    if (!IsEnvPieceValid(rows, &moved)) {
+        return false;
+    }
+
+    *piece = moved;
+    return true;
+}
+
+// Same kicks as TryRotateTetromino
+static b32 TryRotateEnvPiece(const u16* rows, tetromino_t* piece, i32 direction) {
+    tetromino_t rotated = *piece;
+    rotated.rotation = (piece->rotation + direction + 4) % 4;
+
+    for (i32 i = 0; i < ArraySize(ROTATION_KICKS); ++i) {
+        rotated.x = piece->x + ROTATION_KICKS[i][0];
+        rotated.y = piece->y + ROTATION_KICKS[i][1];
+        if (IsEnvPieceValid(rows, &rotated)) {
+            *piece = rotated;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Like PlaceTetromino and ProcessLineClears, only the rows the piece covers can clear
+static i32 PlaceEnvPiece(u16* rows, tetromino_t* piece) {
+    const piece_shape* shape = GetPieceShape(piece->type, piece->rotation);
+    for (i32 row = shape->minY; row <= shape->maxY; ++row) {
+        u32 mask = shape->rowMasks[row];
+        rows[piece->y + row] |= (u16)(piece->x >= 0 ? mask << piece->x : mask >> -piece->x);
+    }
+
+    i32 linesCleared = 0;
+    for (i32 y = piece->y + shape->minY; y < Min(piece->y + shape->maxY + 1, BOARD_HEIGHT) - linesCleared;) {
+        if (y >= 0 && rows[y] == FULL_ROW) {
+            for (i32 i = y; i < BOARD_HEIGHT - 1; ++i) {
+                rows[i] = rows[i + 1];
+            }
+            rows[BOARD_HEIGHT - 1] = 0;
+            ++linesCleared;
+        }
+        else {
+            ++y;
+        }
+    }
+
+    return linesCleared;
+}
+
+static tetromino_t GetEnvPiece(env_observations* observations, i32 env) {
+    return (tetromino_t){
+        .type     = observations->currentTypes[env],
+        .rotation = observations->currentRotations[env],
+        .x        = observations->currentXs[env],
+        .y        = observations->currentYs[env]
+    };
+}
+
+static void SetEnvPiece(env_observations* observations, i32 env, tetromino_t* piece) {
+    observations->currentTypes[env]     = (u8)piece->type;
+    observations->currentRotations[env] = (u8)piece->rotation;
+    observations->currentXs[env]        = (i8)piece->x;
+    observations->currentYs[env]        = (i8)piece->y;
+}
+
+// Returns false if the new piece doesn't fit
+static b32 SpawnEnvPiece(env_batch* batch, i32 env, tetromino_type type, tetromino_t* outPiece) {
+    *outPiece = InitTetromino(type, 0, SPAWN_X, SPAWN_Y);
+    return IsEnvPieceValid(&batch->observations.rows[env * BOARD_HEIGHT], outPiece);
+}
+
+// Takes the front of the queue and tops it up from the bag
+static tetromino_type PopEnvQueue(env_batch* batch, i32 env) {
+    u8* queue = &batch->observations.queues[env * ENV_PREVIEW_COUNT];
+    tetromino_type type = queue[0];
+    for (i32 i = 0; i < ENV_PREVIEW_COUNT - 1; ++i) {
+        queue[i] = queue[i + 1];
+    }
+    queue[ENV_PREVIEW_COUNT - 1] = (u8)GetNextTetrominoFromBag(&batch->bags[env]);
+
+    return type;
+}
+
+// A new game with the next pieces from the env's bag, so every game an env plays is different
+static void ResetEnv(env_batch* batch, i32 env) {
+    env_observations* observations = &batch->observations;
+
+    u16* rows = &observations->rows[env * BOARD_HEIGHT];
+    for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+        rows[y] = 0;
+    }
+
+    tetromino_t piece = InitTetromino(GetNextTetrominoFromBag(&batch->bags[env]), 0, SPAWN_X, SPAWN_Y);
+    SetEnvPiece(observations, env, &piece);
+    for (i32 i = 0; i < ENV_PREVIEW_COUNT; ++i) {
+        observations->queues[env * ENV_PREVIEW_COUNT + i] = (u8)GetNextTetrominoFromBag(&batch->bags[env]);
+    }
+    observations->holds[env] = tetromino_type_empty;
+    observations->canHolds[env] = true;
+    observations->scores[env] = 0;
+    observations->lines[env] = 0;
+    observations->levels[env] = 1;
+    observations->rewards[env] = 0.0f;
+    observations->dones[env] = false;
+
+    batch->timersFall[env] = 0;
+    batch->timersLockDelay[env] = 0;
+    batch->gravityTicks[env] = Max(SecondsToTicks(GetCurrentGravityInSeconds(1)), 1);
+}
+
+// Same as UpdateScene1Tick, with the action for a key press and a lock ending the step
+static void StepEnv(env_batch* batch, i32 env, env_action action) {
+    env_observations* observations = &batch->observations;
+
+    if (observations->dones[env]) {
+        ResetEnv(batch, env);
+    }
+
+    u16* rows = &observations->rows[env * BOARD_HEIGHT];
+    tetromino_t piece = GetEnvPiece(observations, env);
+    i32 level = observations->levels[env];
+    i32 score = observations->scores[env];
+    i32 timerFall = batch->timersFall[env];
+    i32 timerLockDelay = batch->timersLockDelay[env];
+    b32 didHardDrop = false;
+    b32 didTopOut = false;
+
+    switch (action) {
+        case env_action_left: {
+            TryMoveEnvPiece(rows, &piece, -1, 0);
+        } break;
+        case env_action_right: {
+            TryMoveEnvPiece(rows, &piece, 1, 0);
+        } break;
+        case env_action_rotate_cw: {
+            TryRotateEnvPiece(rows, &piece, 1);
+        } break;
+        case env_action_rotate_ccw: {
+            TryRotateEnvPiece(rows, &piece, -1);
+        } break;
+        case env_action_soft_drop: {
+            if (TryMoveEnvPiece(rows, &piece, 0, -1)) {
+                score += SCORE_SOFT_DROP * level;
+                timerFall = 0;
+            }
+        } break;
+        case env_action_hard_drop: {
+            didHardDrop = true;
+            i32 dropDistance = 0;
+            while (TryMoveEnvPiece(rows, &piece, 0, -1)) {
+                ++dropDistance;
+            }
+            score += dropDistance * SCORE_HARD_DROP * level;
+        } break;
+        case env_action_hold: {
+            if (observations->canHolds[env]) {
+                observations->canHolds[env] = false;
+
+                tetromino_type currentType = piece.type;
+                tetromino_type held = observations->holds[env];
+                didTopOut = !SpawnEnvPiece(batch, env, held == tetromino_type_empty ? PopEnvQueue(batch, env) : held, &piece);
+                observations->holds[env] = (u8)currentType;
+            }
+        } break;
+        default: break;
+    }
+
+    for (i32 ticksLeft = batch->ticksPerStep; ticksLeft > 0 && !didTopOut;) {
+        // Nothing happens until gravity moves the piece, unless it is on the ground
+        if (timerLockDelay == 0 && !didHardDrop) {
+            i32 ticksToFall = Max(batch->gravityTicks[env] - timerFall, 1);
+            if (ticksToFall > ticksLeft) {
+                timerFall += ticksLeft;
+                break;
+            }
+            ticksLeft -= ticksToFall;
+        }
+        else {
+            --ticksLeft;
+        }
+        timerFall = 0;
+
+        if (TryMoveEnvPiece(rows, &piece, 0, -1)) {
+            timerLockDelay = 0;
+        }
+        else if (++timerLockDelay >= SecondsToTicks(LOCK_DELAY) || didHardDrop) {
+            i32 lineClearCount = PlaceEnvPiece(rows, &piece);
+            observations->lines[env] += lineClearCount;
+            score += GetLineClearScore(lineClearCount, level);
+            if (observations->lines[env] >= level * LINES_PER_LEVEL) {
+                observations->levels[env] = ++level;
+                batch->gravityTicks[env] = Max(SecondsToTicks(GetCurrentGravityInSeconds(level)), 1);
+            }
+
+            didTopOut = !SpawnEnvPiece(batch, env, PopEnvQueue(batch, env), &piece);
+            observations->canHolds[env] = true;
+            timerLockDelay = 0;
+            break;
+        }
+        didHardDrop = false;
+    }
+
+    SetEnvPiece(observations, env, &piece);
+    observations->rewards[env] = (f32)(score - observations->scores[env]);
+    observations->scores[env] = score;
+    observations->dones[env] = (u8)didTopOut;
+    batch->timersFall[env] = timerFall;
+    batch->timersLockDelay[env] = timerLockDelay;
+}
+
+typedef struct env_job_data {
+    env_batch* batch;
+    const u8* actions;
+} env_job_data;
+
+static void StepEnvJob(void* data, i32 jobIndex, i32 threadIndex) {
+    env_job_data* jobData = data;
+    env_batch* batch = jobData->batch;
+
+    i32 end = Min((jobIndex + 1) * ENV_ENVS_PER_JOB, batch->count);
+    for (i32 env = jobIndex * ENV_ENVS_PER_JOB; env < end; ++env) {
+        StepEnv(batch, env, (env_action)jobData->actions[env]);
+    }
+}
+
+// Hands out the next array of the layout. With no memory it only counts, for GetEnvObservationsSize
+static void* PlaceEnvArray(u8* memory, i32* offset, i32 size) {
+    void* result = memory ? memory + *offset : 0;
+    *offset = (*offset + size + ENV_ARRAY_ALIGNMENT - 1) & ~(ENV_ARRAY_ALIGNMENT - 1);
+    return result;
+}
+
+static i32 LayOutEnvObservations(u8* memory, i32 count, env_observations* outObservations) {
+    i32 offset = 0;
+    outObservations->scores           = PlaceEnvArray(memory, &offset, count * sizeof(i32));
+    outObservations->lines            = PlaceEnvArray(memory, &offset, count * sizeof(i32));
+    outObservations->levels           = PlaceEnvArray(memory, &offset, count * sizeof(i32));
+    outObservations->rewards          = PlaceEnvArray(memory, &offset, count * sizeof(f32));
+    outObservations->rows             = PlaceEnvArray(memory, &offset, count * BOARD_HEIGHT * sizeof(u16));
+    outObservations->currentTypes     = PlaceEnvArray(memory, &offset, count);
+    outObservations->currentRotations = PlaceEnvArray(memory, &offset, count);
+    outObservations->currentXs        = PlaceEnvArray(memory, &offset, count);
+    outObservations->currentYs        = PlaceEnvArray(memory, &offset, count);
+    outObservations->queues           = PlaceEnvArray(memory, &offset, count * ENV_PREVIEW_COUNT);
+    outObservations->holds            = PlaceEnvArray(memory, &offset, count);
+    outObservations->canHolds         = PlaceEnvArray(memory, &offset, count);
+    outObservations->dones            = PlaceEnvArray(memory, &offset, count);
+
+    return offset;
+}
+
+// Bytes needed for MapEnvObservations
+i32 GetEnvObservationsSize(i32 count) {
+    env_observations observations;
+    return LayOutEnvObservations(0, count, &observations);
+}
+
+// Puts every array one after the other in memory, each aligned to ENV_ARRAY_ALIGNMENT bytes. memory needs
+// GetEnvObservationsSize(count) bytes, aligned the same
+env_observations MapEnvObservations(void* memory, i32 count) {
+    env_observations observations;
+    LayOutEnvObservations(memory, count, &observations);
+    return observations;
+}
+
+// Env i deals from a bag seeded with seeds[i], or with i if there are no seeds. Every env starts a game right away
+void InitEnvBatch(env_batch* batch, i32 count, const u64* seeds, env_observations* observations, b32 useJobs) {
+    *batch = (env_batch){ 0 };
+    batch->count = count;
+    batch->ticksPerStep = ENV_TICKS_PER_STEP;
+    batch->useJobs = useJobs;
+    batch->observations = *observations;
+
+    // One allocation for all of it
+    u8* memory = EngineAllocate(count * (sizeof(tetromino_bag) + 3 * sizeof(i32)), memory_tag_tools);
+    batch->bags            = (tetromino_bag*)memory;
+    batch->timersFall      = (i32*)(memory + count * sizeof(tetromino_bag));
+    batch->timersLockDelay = batch->timersFall + count;
+    batch->gravityTicks    = batch->timersLockDelay + count;
+
+    for (i32 env = 0; env < count; ++env) {
+        InitBag(&batch->bags[env], InitRandomState(seeds ? seeds[env] : (u64)env, 0));
+        ResetEnv(batch, env);
+    }
+}
+
+void FreeEnvBatch(env_batch* batch) {
+    EngineFree(batch->bags);
+    *batch = (env_batch){ 0 };
+}
+
+// Starts a new game in every env. The bags carry on from where they were
+void ResetEnvBatch(env_batch* batch) {
+    for (i32 env = 0; env < batch->count; ++env) {
+        ResetEnv(batch, env);
+    }
+}
+
+// actions holds one env_action per env
+void StepEnvBatch(env_batch* batch, const u8* actions) {
+    env_job_data jobData = { .batch = batch, .actions = actions };
+    i32 jobsCount = (batch->count + ENV_ENVS_PER_JOB - 1) / ENV_ENVS_PER_JOB;
+
+    if (batch->useJobs && jobsCount > 1) {
+        EngineRunJobs(StepEnvJob, &jobData, jobsCount);
+    }
+    else {
+        for (i32 i = 0; i < jobsCount; ++i) {
+            StepEnvJob(&jobData, i, 0);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef TETRIS_ENV_H
+#define TETRIS_ENV_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_rules.h"
+
+
+#define ENV_PREVIEW_COUNT 3
+#define ENV_TICKS_PER_STEP SecondsToTicks(0.05f) // Game time per step, unless the piece locks sooner. Same as SELF_PLAY_INPUT_DELAY
+#define ENV_ENVS_PER_JOB 4096
+
+typedef enum env_action {
+    env_action_none = 0,
+    env_action_left,
+    env_action_right,
+    env_action_rotate_cw,
+    env_action_rotate_ccw,
+    env_action_soft_drop,
+    env_action_hard_drop,
+    env_action_hold,
+    env_action_count
+} env_action;
+
+// Owned by the caller, one element per env unless it says otherwise. This is where the envs keep their state, so
+// it is always up to date and there is nothing to copy out. Don't write to it between steps
+typedef struct env_observations {
+    i32* scores;
+    i32* lines;
+    i32* levels;
+    f32* rewards;          // What the last step added to the score
+    u16* rows;             // BOARD_HEIGHT per env, bottom row first. Bit x is set if column x is filled
+    u8* currentTypes;      // tetromino_type
+    u8* currentRotations;
+    i8* currentXs;         // Of the piece's 4x4 box, like tetromino_t
+    i8* currentYs;
+    u8* queues;            // ENV_PREVIEW_COUNT per env, next piece first
+    u8* holds;             // tetromino_type_empty if nothing is held
+    u8* canHolds;
+    u8* dones;             // Topped out on the last step. The next step starts a new game whatever the action
+} env_observations;
+
+// Independent games on normal boards with the same rules as Scene1, minus everything you can see or hear
+typedef struct env_batch {
+    i32 count;
+    i32 ticksPerStep;
+    b32 useJobs; // Steps get split into jobs of ENV_ENVS_PER_JOB envs
+    env_observations observations;
+
+    // The rest of the state, by env
+    tetromino_bag* bags;
+    i32* timersFall;
+    i32* timersLockDelay;
+    i32* gravityTicks; // For the env's level
+} env_batch;
+
+extern i32 GetEnvObservationsSize(i32 count);
+extern env_observations MapEnvObservations(void* memory, i32 count);
+extern void InitEnvBatch(env_batch* batch, i32 count, const u64* seeds, env_observations* observations, b32 useJobs);
+extern void FreeEnvBatch(env_batch* batch);
+extern void ResetEnvBatch(env_batch* batch);
+extern void StepEnvBatch(env_batch* batch, const u8* actions);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "tetris_features.h"
+
+/*
+    Every feature comes out of one pass over the rows from the top down, without ever working out the column heights.
+    covered has a bit for every column with a filled tile at or above the current row, which is enough for all of them:
+
+        aggregate height   the covered bits of every row add up to the sum of the heights
+        max height         the number of rows with anything covered
+        holes              covered but empty
+        bumpiness          columns where covered differs from the column to the right, on every row
+        wells              columns that aren't covered when both neighbours are. The depths are counted per column in a
+                           5-bit counter sliced across 5 words, one bit of the counter per word, so the sum of
+                           depth * (depth + 1) / 2 can be worked out from the counters once at the end
+
+    With SSE2 the rows of 8 boards go in one register as 16-bit lanes, so 8 boards take the same instructions as one.
+    Every x64 processor has SSE2, and so does anything the 32-bit build would realistically run on. GetBoardFeatures does
+    the same thing for one board without it, and is what everything else gets checked against.
+*/
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define FEATURES_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FULL_ROW   ((1 << BOARD_WIDTH) - 1)
+#define WALLED_ROW ((1 << (BOARD_WIDTH + 1)) - 1) // A row with the right wall on the end
+#define LEFT_WALL  1                              // Where the left wall ends up after shifting covered one to the left
+#define RIGHT_WALL (1 << (BOARD_WIDTH - 1))       // Same for the right wall, shifting to the right
+#define WELL_BITS  5                              // Enough for BOARD_HEIGHT
+
+
+// The batch's arrays share one allocation
+void InitBoardBatch(board_batch* batch, i32 capacity) {
+    i32 stride = (capacity + BOARD_BATCH_LANES - 1) / BOARD_BATCH_LANES * BOARD_BATCH_LANES;
+
+    // Biggest elements first, so everything stays aligned for SIMD loads
+    i32 featuresSize = board_feature_count * stride * sizeof(f32);
+    i32 scoresSize = stride * sizeof(f32);
+    i32 rowsSize = BOARD_HEIGHT * stride * sizeof(u16);
+    u8* memory = EngineAllocate(featuresSize + scoresSize + rowsSize + stride, memory_tag_bot);
+
+    *batch = (board_batch){
+        .features     = (f32*)memory,
+        .scores       = (f32*)(memory + featuresSize),
+        .rows         = (u16*)(memory + featuresSize + scoresSize),
+        .linesCleared = memory + featuresSize + scoresSize + rowsSize,
+        .capacity     = capacity,
+        .stride       = stride
+    };
+}
+
+void FreeBoardBatch(board_batch* batch) {
+    EngineFree(batch->features);
+    *batch = (board_batch){ 0 };
+}
+
+// Whatever is left in the lanes past count still gets computed along with the rest, but nothing reads it
+void ClearBoardBatch(board_batch* batch) {
+    batch->count = 0;
+}
+
+// Returns the board's index in the batch, or -1 if it is full
+i32 AddBoardToBatch(board_batch* batch, const u16* rows, i32 linesCleared) {
+    if (batch->count >= batch->capacity) {
+        return -1;
+    }
+
+    i32 index = batch->count++;
+    for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+        batch->rows[y * batch->stride + index] = rows[y];
+    }
+    batch->linesCleared[index] = (u8)linesCleared;
+
+    return index;
+}
+
+static inline i32 CountBits(u32 value) {
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+// The sum of depth * (depth + 1) / 2 is (sum of depth^2 + sum of depth) / 2, and both come straight out of the bit slices
+static i32 SumWellDepths(const u32* wellBits) {
+    i32 depths = 0;
+    i32 depthsSquared = 0;
+    for (i32 i = 0; i < WELL_BITS; ++i) {
+        depths += CountBits(wellBits[i]) << i;
+        for (i32 j = 0; j < WELL_BITS; ++j) {
+            depthsSquared += CountBits(wellBits[i] & wellBits[j]) << (i + j);
+        }
+    }
+
+    return (depthsSquared + depths) / 2;
+}
+
+// outFeatures holds board_feature_count values
+void GetBoardFeatures(const u16* rows, i32 linesCleared, f32* outFeatures) {
+    i32 features[board_feature_count] = { 0 };
+    u32 wellBits[WELL_BITS] = { 0 };
+
+    u32 covered = 0;
+    u32 above = rows[BOARD_HEIGHT - 1];
+    for (i32 y = BOARD_HEIGHT - 1; y >= 0; --y) {
+        u32 row = rows[y];
+
+        features[board_feature_column_transitions] += CountBits(row ^ above);
+        above = row;
+
+        features[board_feature_holes] += CountBits(covered & ~row);
+        covered |= row;
+
+        features[board_feature_aggregate_height] += CountBits(covered);
+        features[board_feature_max_height] += covered != 0;
+        features[board_feature_bumpiness] += CountBits((covered ^ (covered >> 1)) & (FULL_ROW >> 1));
+
+        u32 walled = row | (1 << BOARD_WIDTH);
+        features[board_feature_row_transitions] += CountBits((walled ^ ((walled << 1) | 1)) & WALLED_ROW);
+
+        // Add one to the depth counter of every column that is in a well on this row
+        u32 carry = ~covered & ((covered << 1) | LEFT_WALL) & ((covered >> 1) | RIGHT_WALL) & FULL_ROW;
+        for (i32 i = 0; i < WELL_BITS; ++i) {
+            u32 nextCarry = wellBits[i] & carry;
+            wellBits[i] ^= carry;
+            carry = nextCarry;
+        }
+    }
+    features[board_feature_column_transitions] += CountBits(above ^ FULL_ROW);
+    features[board_feature_wells] = SumWellDepths(wellBits);
+    features[board_feature_lines_cleared] = linesCleared;
+
+    for (i32 i = 0; i < board_feature_count; ++i) {
+        outFeatures[i] = (f32)features[i];
+    }
+}
+
+#ifdef FEATURES_USE_SSE2
+
+static inline __m128i CountBits16(__m128i value) {
+    value = _mm_sub_epi16(value, _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi16(0x5555)));
+    value = _mm_add_epi16(_mm_and_si128(value, _mm_set1_epi16(0x3333)), _mm_and_si128(_mm_srli_epi16(value, 2), _mm_set1_epi16(0x3333)));
+    value = _mm_and_si128(_mm_add_epi16(value, _mm_srli_epi16(value, 4)), _mm_set1_epi16(0x0F0F));
+    return _mm_and_si128(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), _mm_set1_epi16(0x001F));
+}
+
+static void StoreFeatureLanes(board_batch* batch, board_feature feature, i32 index, __m128i values) {
+    f32* out = &batch->features[feature * batch->stride + index];
+    _mm_storeu_ps(out,     _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, _mm_setzero_si128())));
+    _mm_storeu_ps(out + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(values, _mm_setzero_si128())));
+}
+
+// GetBoardFeatures for BOARD_BATCH_LANES boards at once
+static void ComputeBoardFeatureLanes(board_batch* batch, i32 index) {
+    const __m128i fullRow = _mm_set1_epi16(FULL_ROW);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i aggregateHeight = _mm_setzero_si128();
+    __m128i maxHeight = _mm_setzero_si128();
+    __m128i holes = _mm_setzero_si128();
+    __m128i bumpiness = _mm_setzero_si128();
+    __m128i rowTransitions = _mm_setzero_si128();
+    __m128i columnTransitions = _mm_setzero_si128();
+    __m128i wellBits[WELL_BITS];
+    for (i32 i = 0; i < WELL_BITS; ++i) {
+        wellBits[i] = _mm_setzero_si128();
+    }
+
+    __m128i covered = _mm_setzero_si128();
+    __m128i above = _mm_loadu_si128((__m128i*)&batch->rows[(BOARD_HEIGHT - 1) * batch->stride + index]);
+    for (i32 y = BOARD_HEIGHT - 1; y >= 0; --y) {
+        __m128i row = _mm_loadu_si128((__m128i*)&batch->rows[y * batch->stride + index]);
+
+        columnTransitions = _mm_add_epi16(columnTransitions, CountBits16(_mm_xor_si128(row, above)));
+        above = row;
+
+        holes = _mm_add_epi16(holes, CountBits16(_mm_andnot_si128(row, covered)));
+        covered = _mm_or_si128(covered, row);
+
+        aggregateHeight = _mm_add_epi16(aggregateHeight, CountBits16(covered));
+        maxHeight = _mm_add_epi16(maxHeight, _mm_add_epi16(one, _mm_cmpeq_epi16(covered, _mm_setzero_si128()))); // +1 unless it's 0
+        bumpiness = _mm_add_epi16(bumpiness, CountBits16(_mm_and_si128(_mm_xor_si128(covered, _mm_srli_epi16(covered, 1)), _mm_set1_epi16(FULL_ROW >> 1))));
+
+        __m128i walled = _mm_or_si128(row, _mm_set1_epi16(1 << BOARD_WIDTH));
+        rowTransitions = _mm_add_epi16(rowTransitions, CountBits16(_mm_and_si128(_mm_xor_si128(walled, _mm_or_si128(_mm_slli_epi16(walled, 1), one)), _mm_set1_epi16(WALLED_ROW))));
+
+        __m128i left = _mm_or_si128(_mm_slli_epi16(covered, 1), _mm_set1_epi16(LEFT_WALL));
+        __m128i right = _mm_or_si128(_mm_srli_epi16(covered, 1), _mm_set1_epi16(RIGHT_WALL));
+        __m128i carry = _mm_and_si128(_mm_andnot_si128(covered, _mm_and_si128(left, right)), fullRow);
+        for (i32 i = 0; i < WELL_BITS; ++i) {
+            __m128i nextCarry = _mm_and_si128(wellBits[i], carry);
+            wellBits[i] = _mm_xor_si128(wellBits[i], carry);
+            carry = nextCarry;
+        }
+    }
+    columnTransitions = _mm_add_epi16(columnTransitions, CountBits16(_mm_xor_si128(above, fullRow)));
+
+    __m128i depths = _mm_setzero_si128();
+    __m128i depthsSquared = _mm_setzero_si128();
+    for (i32 i = 0; i < WELL_BITS; ++i) {
+        depths = _mm_add_epi16(depths, _mm_slli_epi16(CountBits16(wellBits[i]), i));
+        for (i32 j = 0; j < WELL_BITS; ++j) {
+            depthsSquared = _mm_add_epi16(depthsSquared, _mm_slli_epi16(CountBits16(_mm_and_si128(wellBits[i], wellBits[j])), i + j));
+        }
+    }
+    __m128i wells = _mm_srli_epi16(_mm_add_epi16(depthsSquared, depths), 1);
+
+    __m128i linesCleared = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i*)&batch->linesCleared[index]), _mm_setzero_si128());
+
+    StoreFeatureLanes(batch, board_feature_aggregate_height, index, aggregateHeight);
+    StoreFeatureLanes(batch, board_feature_max_height, index, maxHeight);
+    StoreFeatureLanes(batch, board_feature_holes, index, holes);
+    StoreFeatureLanes(batch, board_feature_bumpiness, index, bumpiness);
+    StoreFeatureLanes(batch, board_feature_wells, index, wells);
+    StoreFeatureLanes(batch, board_feature_row_transitions, index, rowTransitions);
+    StoreFeatureLanes(batch, board_feature_column_transitions, index, columnTransitions);
+    StoreFeatureLanes(batch, board_feature_lines_cleared, index, linesCleared);
+}
+
+#endif
+
+// Fills in batch->features for every board in the batch
+void ComputeBoardFeatures(board_batch* batch) {
+#ifdef FEATURES_USE_SSE2
+    for (i32 i = 0; i < batch->count; i += BOARD_BATCH_LANES) {
+        ComputeBoardFeatureLanes(batch, i);
+    }
+#else
+    for (i32 i = 0; i < batch->count; ++i) {
+        u16 rows[BOARD_HEIGHT];
+        for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+            rows[y] = batch->rows[y * batch->stride + i];
+        }
+
+        f32 features[board_feature_count];
+        GetBoardFeatures(rows, batch->linesCleared[i], features);
+        for (i32 j = 0; j < board_feature_count; ++j) {
+            batch->features[j * batch->stride + i] = features[j];
+        }
+    }
+#endif
+}
+
+// batch->scores gets the features of every board weighted by weights, which holds board_feature_count values
+void ScoreBoardBatch(board_batch* batch, const f32* weights) {
+#ifdef FEATURES_USE_SSE2
+    for (i32 i = 0; i < batch->count; i += 4) {
+        __m128 score = _mm_setzero_ps();
+        for (i32 j = 0; j < board_feature_count; ++j) {
+            score = _mm_add_ps(score, _mm_mul_ps(_mm_set1_ps(weights[j]), _mm_loadu_ps(&batch->features[j * batch->stride + i])));
+        }
+        _mm_storeu_ps(&batch->scores[i], score);
+    }
+#else
+    for (i32 i = 0; i < batch->count; ++i) {
+        f32 score = 0.0f;
+        for (i32 j = 0; j < board_feature_count; ++j) {
+            score += weights[j] * batch->features[j * batch->stride + i];
+        }
+        batch->scores[i] = score;
+    }
+#endif
+}
\ No newline at end of file
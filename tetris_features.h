@@ -0,0 +1,42 @@
+#ifndef TETRIS_FEATURES_H
+#define TETRIS_FEATURES_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+
+
+#define BOARD_BATCH_LANES 8 // Boards that get worked on at once. Batches are always a multiple of this wide
+
+typedef enum board_feature {
+    board_feature_aggregate_height = 0, // Sum of the column heights
+    board_feature_max_height,
+    board_feature_holes,                // Empty tiles with a filled tile somewhere above them
+    board_feature_bumpiness,            // Sum of the height differences between neighbouring columns
+    board_feature_wells,                // Sum of depth * (depth + 1) / 2 over the columns lower than both neighbours. The walls count as full height
+    board_feature_row_transitions,      // Filled/empty changes along each row, with the walls counting as filled
+    board_feature_column_transitions,   // Filled/empty changes up each column, with the floor counting as filled
+    board_feature_lines_cleared,        // Whatever was passed to AddBoardToBatch
+    board_feature_count
+} board_feature;
+
+// Structure of arrays. rows[y * stride + i] is row y of board i (see GetBoardRows), so the same row of neighbouring
+// boards sits side by side in memory, and features[feature * stride + i] is the feature of board i
+typedef struct board_batch {
+    u16* rows;
+    u8* linesCleared;
+    f32* features;
+    f32* scores;
+    i32 count;
+    i32 capacity;
+    i32 stride; // capacity rounded up to BOARD_BATCH_LANES
+} board_batch;
+
+extern void InitBoardBatch(board_batch* batch, i32 capacity);
+extern void FreeBoardBatch(board_batch* batch);
+extern void ClearBoardBatch(board_batch* batch);
+extern i32 AddBoardToBatch(board_batch* batch, const u16* rows, i32 linesCleared);
+extern void GetBoardFeatures(const u16* rows, i32 linesCleared, f32* outFeatures);
+extern void ComputeBoardFeatures(board_batch* batch);
+extern void ScoreBoardBatch(board_batch* batch, const f32* weights);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "tetris_game_events.h"
+
+#include <string.h>
+
+
+/*
+    The rules only say what happened. UpdateGameState writes events into a game_events the caller owns, and passing
+    none skips even that, which is what the bot, the env and the tools do. Whoever wants to make noise, draw or keep
+    stats about a game subscribes a handler to the types it cares about, and the scene publishes the events once it
+    is done with a tick or a frame. Handlers get called in the order the events happened, and for each event in the
+    order they subscribed.
+
+    Nothing here allocates. The buffer is fixed and reused, and a subscriber is a function and a pointer.
+*/
+
+void ClearGameEvents(game_events* events) {
+    events->count = 0;
+    events->types = 0;
+}
+
+// Returns the event for the caller to fill in the rest of, or 0 if there was no room left
+game_event* PushGameEvent(game_events* events, game_event_type type, u32 tick) {
+    if (events->count >= GAME_EVENTS_MAX) {
+        ++events->droppedCount;
+        return 0;
+    }
+
+    game_event* event = &events->events[events->count++];
+    memset(event, 0, sizeof(*event));
+    event->type = type;
+    event->tick = tick;
+    events->types |= GAME_EVENT_BIT(type);
+
+    return event;
+}
+
+void AppendGameEvents(game_events* events, game_events* other) {
+    i32 count = Min(other->count, GAME_EVENTS_MAX - events->count);
+    memcpy(&events->events[events->count], other->events, count * sizeof(game_event));
+    events->count += count;
+    events->droppedCount += other->count - count;
+    events->types |= other->types;
+}
+
+// Returns false if the bus is full
+b32 SubscribeToGameEvents(game_event_bus* bus, u32 types, game_event_handler handler, void* data) {
+    if (bus->subscribersCount >= GAME_EVENTS_MAX_SUBSCRIBERS) {
+        return false;
+    }
+
+    bus->subscribers[bus->subscribersCount++] = (game_event_subscriber){
+        .types   = types,
+        .handler = handler,
+        .data    = data
+    };
+
+    return true;
+}
+
+// Hands every event to whoever wants it, then clears events for the next lot
+void PublishGameEvents(game_event_bus* bus, game_events* events) {
+    u32 wanted = 0;
+    for (i32 i = 0; i < bus->subscribersCount; ++i) {
+        wanted |= bus->subscribers[i].types;
+    }
+
+    for (i32 i = 0; i < events->count && (wanted & events->types); ++i) {
+        game_event* event = &events->events[i];
+        u32 bit = GAME_EVENT_BIT(event->type);
+        for (i32 j = 0; j < bus->subscribersCount; ++j) {
+            game_event_subscriber* subscriber = &bus->subscribers[j];
+            if (subscriber->types & bit) {
+                subscriber->handler(subscriber->data, event);
+            }
+        }
+    }
+
+    ClearGameEvents(events);
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef TETRIS_GAME_EVENTS_H
+#define TETRIS_GAME_EVENTS_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+
+
+#define GAME_EVENTS_MAX              256 // A frame's worth of ticks with room to spare. More than that get counted and dropped
+#define GAME_EVENTS_MAX_SUBSCRIBERS  8
+
+typedef enum game_event_type {
+    game_event_moved = 0,
+    game_event_rotated,
+    game_event_held,
+    game_event_soft_dropped, // One row
+    game_event_locked,
+    game_event_cleared,      // Comes right after locked
+    game_event_level_up,     // Comes right after cleared
+    game_event_game_over,
+    game_event_type_count
+} game_event_type;
+
+#define GAME_EVENT_BIT(type) (1u << (type))
+
+typedef struct game_event {
+    game_event_type type;
+    u32 tick; // tickCount of the game once the tick that did it was over
+
+    union {
+        i32 direction; // moved, rotated: -1 is left or counterclockwise, 1 right or clockwise
+        tetromino_type held; // held: what went into the hold box
+        struct {
+            tetromino_t piece;
+            i32 linesCount;
+            i32 level;  // The one it was played at
+        } locked;
+        struct {
+            i32 linesCount;
+            b32 didLevelUp;
+        } cleared;
+        i32 level; // level_up: the new one
+        i32 score; // game_over
+    };
+} game_event;
+
+// What a game did, in the order it did it. Filled by UpdateGameState, see tetris_game_events.c
+typedef struct game_events {
+    game_event events[GAME_EVENTS_MAX];
+    i32 count;
+    i32 droppedCount;
+    u32 types; // GAME_EVENT_BIT of everything in events, for when which ones is all that matters
+} game_events;
+
+typedef void (*game_event_handler)(void* data, game_event* event);
+
+typedef struct game_event_subscriber {
+    u32 types; // GAME_EVENT_BITs of the events it wants
+    game_event_handler handler;
+    void* data;
+} game_event_subscriber;
+
+typedef struct game_event_bus {
+    game_event_subscriber subscribers[GAME_EVENTS_MAX_SUBSCRIBERS];
+    i32 subscribersCount;
+} game_event_bus;
+
+extern void ClearGameEvents(game_events* events);
+extern game_event* PushGameEvent(game_events* events, game_event_type type, u32 tick);
+extern void AppendGameEvents(game_events* events, game_events* other);
+extern b32 SubscribeToGameEvents(game_event_bus* bus, u32 types, game_event_handler handler, void* data);
+extern void PublishGameEvents(game_event_bus* bus, game_events* events);
+
+static inline b32 HasGameEvent(game_events* events, game_event_type type) {
+    return (events->types & GAME_EVENT_BIT(type)) != 0;
+}
+
+#endif
\ No newline at end of file
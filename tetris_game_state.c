@@ -0,0 +1,236 @@
+#include "tetris_game_state.h"
+#include "tetris_rules.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+// Starts a new game on an empty board: the first piece spawned and the next three dealt. Leaves boardMemory alone, so
+// board can already be using it
+void InitGameState(game_state* game, board_t* board, random_state random) {
+    memset(&game->boardHash, 0, sizeof(*game) - offsetof(game_state, boardHash));
+
+    InitBag(&game->bag, random);
+
+    game->current = SpawnTetromino(board, GetNextTetrominoFromBag(&game->bag));
+    game->previous = game->current;
+    for (i32 i = 0; i < ArraySize(game->next); ++i) {
+        game->next[i] = GetNextTetrominoFromBag(&game->bag);
+    }
+    game->hold = tetromino_type_empty;
+
+    game->level = 1;
+}
+
+// Points a normal sized board at the game's tiles. Where it gets drawn stays the same
+void UseGameStateBoard(game_state* game, board_t* board) {
+    Assert(board->width == BOARD_WIDTH && board->height == BOARD_HEIGHT);
+
+    SetBoardMemory(board, game->boardMemory);
+    board->hash = game->boardHash;
+    board->stackHeight = game->boardStackHeight;
+}
+
+// board has to be the one using game's tiles
+void SnapshotGameState(game_state* game, board_t* board, game_state* outSnapshot) {
+    Assert(board->rowMasks == game->boardMemory);
+
+    game->boardHash = board->hash;
+    game->boardStackHeight = board->stackHeight;
+    memcpy(outSnapshot, game, sizeof(*game));
+}
+
+void RestoreGameState(game_state* game, board_t* board, game_state* snapshot) {
+    memcpy(game, snapshot, sizeof(*game));
+    UseGameStateBoard(game, board);
+}
+
+// Adds an event to events unless there are none to add to. The rules never look at what they pushed, so leaving events
+// out changes nothing but what the caller gets to hear about
+static inline game_event* EmitGameEvent(game_events* events, game_event_type type, game_state* game) {
+    return events ? PushGameEvent(events, type, game->tickCount) : 0;
+}
+
+// Runs one fixed step of the game with the keys as they are in input. Returns false if the game is over. Whatever
+// happened gets added to events, which can be 0 when nobody is listening
+b32 UpdateGameState(game_state* game, board_t* board, keyboard_state* input, game_events* events) {
+    game_event* event;
+
+    game->previous = game->current;
+    ++game->tickCount;
+
+    if (input->right.isDown) {
+        ++game->timerAutoMoveDelay;
+        if (game->timerAutoMoveDelay >= SecondsToTicks(AUTO_MOVE_DELAY)) {
+            ++game->timerAutoMove;
+        }
+        if (game->timerAutoMove >= SecondsToTicks(AUTO_MOVE) || input->right.didChangeState) {
+            game->timerAutoMove = 0;
+            if (TryMoveTetromino(board, &game->current, 1, 0) && (event = EmitGameEvent(events, game_event_moved, game))) {
+                event->direction = 1;
+            }
+        }
+    }
+    else if (input->left.isDown) {
+        ++game->timerAutoMoveDelay;
+        if (game->timerAutoMoveDelay >= SecondsToTicks(AUTO_MOVE_DELAY)) {
+            ++game->timerAutoMove;
+        }
+        if (game->timerAutoMove >= SecondsToTicks(AUTO_MOVE) || input->left.didChangeState) {
+            game->timerAutoMove = 0;
+            if (TryMoveTetromino(board, &game->current, -1, 0) && (event = EmitGameEvent(events, game_event_moved, game))) {
+                event->direction = -1;
+            }
+        }
+    }
+    else {
+        game->timerAutoMoveDelay = 0;
+    }
+
+    i32 rotationDirection = PRESSED(input->x) - PRESSED(input->z);
+    if (rotationDirection) {
+        if (TryRotateTetromino(board, &game->current, rotationDirection) && (event = EmitGameEvent(events, game_event_rotated, game))) {
+            event->direction = rotationDirection;
+        }
+    }
+
+    if (PRESSED(input->c) && !game->didUseHoldBox) {
+        game->didUseHoldBox = true;
+
+        tetromino_type currentType = game->current.type;
+        if (game->hold == tetromino_type_empty) {
+            game->current = SpawnTetromino(board, game->next[0]);
+            game->next[0] = game->next[1];
+            game->next[1] = game->next[2];
+            game->next[2] = GetNextTetrominoFromBag(&game->bag);
+        }
+        else {
+            game->current = SpawnTetromino(board, game->hold);
+        }
+        game->hold = currentType;
+        ++game->piecesSpawned;
+
+        if ((event = EmitGameEvent(events, game_event_held, game))) {
+            event->held = currentType;
+        }
+    }
+
+    b32 didSoftDrop = false;
+    i32 gravityInTicks = SecondsToTicks(GetCurrentGravityInSeconds(game->level));
+    if (input->down.isDown && gravityInTicks > SecondsToTicks(SOFT_DROP)) {
+        didSoftDrop = true;
+        gravityInTicks = SecondsToTicks(SOFT_DROP);
+    }
+
+    b32 didHardDrop = false;
+    if (PRESSED(input->up) || PRESSED(input->spacebar)) {
+        didHardDrop = true;
+        i32 dropDistance = GetDropDistance(board, &game->current);
+        game->current.y -= dropDistance;
+        game->score += dropDistance * SCORE_HARD_DROP * game->level;
+    }
+
+    b32 isAlive = true;
+
+    ++game->timerFall;
+    if (game->timerFall >= gravityInTicks || didHardDrop || game->timerLockDelay > 0) {
+        game->timerFall = 0;
+
+        if (!TryMoveTetromino(board, &game->current, 0, -1)) {
+            ++game->timerLockDelay;
+            if (game->timerLockDelay >= SecondsToTicks(LOCK_DELAY) || didHardDrop) {
+                PlaceTetromino(board, &game->current);
+                game->locked = game->current;
+
+                i32 lineClearCount = ProcessLineClears(board, &game->current);
+                game->lines += lineClearCount;
+                game->score += GetLineClearScore(lineClearCount, game->level);
+
+                b32 didLevelUp = game->lines >= game->level * LINES_PER_LEVEL;
+
+                if ((event = EmitGameEvent(events, game_event_locked, game))) {
+                    event->locked.piece = game->locked;
+                    event->locked.linesCount = lineClearCount;
+                    event->locked.level = game->level;
+                }
+                if (lineClearCount > 0 && (event = EmitGameEvent(events, game_event_cleared, game))) {
+                    event->cleared.linesCount = lineClearCount;
+                    event->cleared.didLevelUp = didLevelUp;
+                }
+
+                if (didLevelUp) {
+                    ++game->level;
+                    if ((event = EmitGameEvent(events, game_event_level_up, game))) {
+                        event->level = game->level;
+                    }
+                }
+
+                game->current = SpawnTetromino(board, game->next[0]);
+                game->next[0] = game->next[1];
+                game->next[1] = game->next[2];
+                game->next[2] = GetNextTetrominoFromBag(&game->bag);
+                ++game->piecesSpawned;
+
+                isAlive = IsTetrominoPosValid(board, &game->current);
+                if (isAlive) {
+                    game->timerAutoMoveDelay = 0;
+                    game->timerLockDelay = 0;
+                    game->didUseHoldBox = false;
+                }
+                else if ((event = EmitGameEvent(events, game_event_game_over, game))) {
+                    event->score = game->score;
+                }
+            }
+        }
+        else {
+            game->timerLockDelay = 0;
+
+            if (didSoftDrop) {
+                game->score += SCORE_SOFT_DROP * game->level;
+                EmitGameEvent(events, game_event_soft_dropped, game);
+            }
+        }
+    }
+
+    return isAlive;
+}
+
+u32 GetGameStateChecksum(game_state* game) {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    u8* bytes = (u8*)game;
+    for (i32 i = 0; i < (i32)sizeof(*game); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+b32 WriteGameStateFile(const char* path, game_state* game, board_t* board) {
+    game_state_file file = {
+        .magic   = GAME_STATE_FILE_MAGIC,
+        .version = GAME_STATE_FILE_VERSION
+    };
+    SnapshotGameState(game, board, &file.game);
+    file.checksum = GetGameStateChecksum(&file.game);
+
+    return EngineWriteEntireFile(path, &file, sizeof(file));
+}
+
+// Returns false if there is no file, or it is from another version or got damaged. Follow up with UseGameStateBoard
+b32 ReadGameStateFile(const char* path, game_state* outGame) {
+    i32 bytesRead = 0;
+    game_state_file* file = EngineReadEntireFile((char*)path, &bytesRead);
+    if (!file) {
+        return false;
+    }
+
+    b32 isGood = bytesRead == sizeof(*file) && file->magic == GAME_STATE_FILE_MAGIC && file->version == GAME_STATE_FILE_VERSION && file->checksum == GetGameStateChecksum(&file->game);
+    if (isGood) {
+        memcpy(outGame, &file->game, sizeof(*outGame));
+    }
+
+    EngineFree(file);
+
+    return isGood;
+}
\ No newline at end of file
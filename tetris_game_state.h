@@ -0,0 +1,65 @@
+#ifndef TETRIS_GAME_STATE_H
+#define TETRIS_GAME_STATE_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_game_events.h"
+
+
+#define GAME_STATE_FILE_MAGIC   0x54475354 // "TSGT"
+#define GAME_STATE_FILE_VERSION 2
+
+/*
+    Everything a game on a normal board is, in one block with no pointers in it, so copying it is a memcpy and
+    writing it to disk is one call. The board's arrays live in boardMemory, and the board_t the game plays on is only
+    a view into it (see UseGameStateBoard) that also knows where on the screen to draw. Bigger boards can't fit, but
+    the rest of the state works the same with their own board_t.
+
+    board_t keeps hash and stackHeight to itself, so those only make it in here when a snapshot is taken. Take
+    snapshots with SnapshotGameState rather than copying the live state.
+
+    InitGameState zeroes the state and after that it is only ever copied whole, so the padding stays zero and the
+    checksum can go over the raw bytes.
+*/
+typedef struct game_state {
+    u64 boardMemory[(BOARD_MEMORY_SIZE(BOARD_WIDTH, BOARD_HEIGHT) + 7) / 8];
+    u64 boardHash;
+    tetromino_bag bag;
+    i32 boardStackHeight;
+
+    tetromino_t current;
+    tetromino_t previous; // Where current was before the last tick, for drawing in between ticks
+    tetromino_t locked;   // Where the last piece to lock went
+    tetromino_type next[3];
+    tetromino_type hold;
+    b32 didUseHoldBox;
+    u32 piecesSpawned;    // Goes up every time current gets replaced, by locking or by holding
+    i32 score;
+    i32 level;
+    i32 lines;
+
+    // All timers are in ticks
+    i32 timerFall;
+    i32 timerAutoMoveDelay;
+    i32 timerAutoMove;
+    i32 timerLockDelay;
+    u32 tickCount;
+} game_state;
+
+typedef struct game_state_file {
+    u32 magic;
+    u32 version;
+    game_state game;
+    u32 checksum; // Of game
+} game_state_file;
+
+extern void InitGameState(game_state* game, board_t* board, random_state random);
+extern void UseGameStateBoard(game_state* game, board_t* board);
+extern void SnapshotGameState(game_state* game, board_t* board, game_state* outSnapshot);
+extern void RestoreGameState(game_state* game, board_t* board, game_state* snapshot);
+extern b32 UpdateGameState(game_state* game, board_t* board, keyboard_state* input, game_events* events);
+extern u32 GetGameStateChecksum(game_state* game);
+extern b32 WriteGameStateFile(const char* path, game_state* game, board_t* board);
+extern b32 ReadGameStateFile(const char* path, game_state* outGame);
+
+#endif
\ No newline at end of file
@@ -54,9 +54,10 @@ typedef struct bitmap_header {
 } bitmap_header;
 #pragma pack(pop)
 
+// The pixels are scene memory, so there's nothing to free. The file itself only passes through scratch memory
 bitmap_buffer LoadBMP(const char* filePath) { 
     i32 bytesRead;
-    void* contents = EngineReadEntireFile(filePath, &bytesRead);
+    void* contents = EngineReadEntireFileToScratch(filePath, &bytesRead);
     if (bytesRead == 0) {
         return (bitmap_buffer){ 0 };
     }
@@ -65,27 +66,10 @@ bitmap_buffer LoadBMP(const char* filePath) {
 
     if ((header->fileType[0] != 'B' || header->fileType[1] != 'M') || \
         (header->bitsPerPixel != 24 && header->bitsPerPixel != 32)) {
+        EngineFreeScratch(contents);
         return (bitmap_buffer) { 0 };
     }
 
-    bitmap_buffer bitmap = { 
-        .memory        = (u8*)contents + header->dataOffset,
-        .width         = header->width,
-        .height        = header->height,
-        .bytesPerPixel = 4,
-        .pitch         = header->width * 4
-    };
-
-    if (header->bitsPerPixel == 24) {
-        i32 pixelCount = bitmap.width * bitmap.height;
-        u32* newMemory = EngineAllocate(4 * pixelCount);
-        u32* newMemoryDummy = newMemory;
-        for (i32 i = 0; i < 3 * pixelCount; i += 3) {
-            *newMemory++ = (*(u32*)((u8*)bitmap.memory + i) & 0x00FFFFFF) | 0xFF000000;
-        }
-        bitmap.memory = newMemoryDummy;
-    }
-
     u32 bitShiftRed;
     u32 bitShiftGreen;
     u32 bitShiftBlue;
@@ -105,23 +89,46 @@ bitmap_buffer LoadBMP(const char* filePath) {
         bitShiftAlpha = GetLeastSignificantSetBitIndex(~(header->bitmaskRed | header->bitmaskGreen | header->bitmaskBlue));
     } break;
     default: { // I don't want/need to deal with any other type of compression
+        EngineFreeScratch(contents);
         return (bitmap_buffer){ 0 };
     } break;
     }
 
+    i32 pixelsCount = header->width * header->height;
+    i32 bytesPerPixel = header->bitsPerPixel / 8;
+    if (pixelsCount <= 0 || header->dataOffset + (i64)pixelsCount * bytesPerPixel > bytesRead) {
+        EngineFreeScratch(contents);
+        return (bitmap_buffer){ 0 };
+    }
+
+    bitmap_buffer bitmap = { 
+        .memory        = EngineAllocateScene(4 * pixelsCount, memory_tag_graphics),
+        .width         = header->width,
+        .height        = header->height,
+        .bytesPerPixel = 4,
+        .pitch         = header->width * 4
+    };
+    if (!bitmap.memory) {
+        EngineFreeScratch(contents);
+        return (bitmap_buffer){ 0 };
+    }
+
+    u8* source = (u8*)contents + header->dataOffset;
     u32* pixels = bitmap.memory;
-    i32 pixelsCount = bitmap.width * bitmap.height;
     for (i32 i = 0; i < pixelsCount; ++i) {
-        *pixels++ = \
-            (((*pixels >> bitShiftAlpha) & 0xFF) << 24) | \
-            (((*pixels >> bitShiftRed)   & 0xFF) << 16) | \
-            (((*pixels >> bitShiftGreen) & 0xFF) << 8)  | \
-            (((*pixels >> bitShiftBlue)  & 0xFF) << 0);
+        // A byte at a time, the pixel data doesn't have to start at a 4 byte boundary
+        u8* bytes = source + i * bytesPerPixel;
+        u32 pixel = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+        pixel |= bytesPerPixel == 3 ? 0xFF000000 : (u32)bytes[3] << 24;
+
+        pixels[i] = \
+            (((pixel >> bitShiftAlpha) & 0xFF) << 24) | \
+            (((pixel >> bitShiftRed)   & 0xFF) << 16) | \
+            (((pixel >> bitShiftGreen) & 0xFF) << 8)  | \
+            (((pixel >> bitShiftBlue)  & 0xFF) << 0);
     }
 
-    if (header->bitsPerPixel == 24) {
-        EngineFree(contents);
-    }
+    EngineFreeScratch(contents);
 
     return bitmap;
 }
@@ -288,8 +295,8 @@ font_t InitFont(const char* filePath, i32 sheetWidth, i32 sheetHeight, const cha
     result.characters = characters;
     for (result.charactersCount = 0; characters[result.charactersCount] != '\0'; ++result.charactersCount);
 
-    result.widths  = EngineAllocate((result.charactersCount + 1) * sizeof(i32));
-    result.offsets = EngineAllocate((result.charactersCount + 1) * sizeof(i32));
+    result.widths  = EngineAllocate((result.charactersCount + 1) * sizeof(i32), memory_tag_graphics);
+    result.offsets = EngineAllocate((result.charactersCount + 1) * sizeof(i32), memory_tag_graphics);
 
     for (i32 i = 0; i < result.charactersCount; ++i) {
         result.offsets[i] = result.spriteWidth;
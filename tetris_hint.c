@@ -0,0 +1,131 @@
+#include "tetris_hint.h"
+
+/*
+    Move hints, worked out by the bot on a thread of their own so the game never waits for them.
+
+    Requests and results each go through a hint_exchange: three slots, where the writer fills one, the reader holds
+    one, and the third sits in the middle. Publishing swaps the writer's slot with the middle one and taking swaps the
+    reader's slot with it, each with a single atomic exchange. HINT_SLOT_NEW on middle says the writer has put something
+    there the reader hasn't taken yet. Nobody ever touches a slot that the other side holds, so there is nothing to
+    lock, and a writer that publishes faster than the reader takes just overwrites the middle one.
+
+    Every request gets a new id. The bot checks latestId while it searches (bot_t.cancel), so a request that got
+    replaced gets dropped within one node of the search instead of running out its time budget. Results carry the id
+    of their request, and the game only shows the one for the piece it has now.
+*/
+
+#define HINT_SLOT_NEW 4 // Slots are 0 to 2
+
+
+static void PublishHintSlot(hint_exchange* exchange) {
+    exchange->writing = EngineAtomicExchange(&exchange->middle, exchange->writing | HINT_SLOT_NEW) & ~HINT_SLOT_NEW;
+}
+
+// Returns false if nothing new has been published since the last take
+static b32 TakeHintSlot(hint_exchange* exchange) {
+    if (!(exchange->middle & HINT_SLOT_NEW)) { // Volatile reads have acquire semantics with MSVC on x86/x64
+        return false;
+    }
+
+    exchange->reading = EngineAtomicExchange(&exchange->middle, exchange->reading) & ~HINT_SLOT_NEW;
+    return true;
+}
+
+static void HintThread(void* data) {
+    hint_t* hint = data;
+
+    for (;;) {
+        EngineWaitForSignal(hint->wakeUp);
+        if (hint->shouldQuit) {
+            break;
+        }
+
+        // Raises that came in while we were searching leave the signal set, so we come right back here for those
+        if (!TakeHintSlot(&hint->requestExchange)) {
+            continue;
+        }
+
+        hint_request* request = &hint->requests[hint->requestExchange.reading];
+        hint->bot.cancelValue = request->id;
+
+        bot_move move;
+        b32 hasMove = FindBotMove(&hint->bot, &request->board, &request->current, request->next, request->hold, request->canHold, &move);
+
+        if (hint->latestId == request->id) {
+            hint_result* result = &hint->results[hint->resultExchange.writing];
+            result->id = request->id;
+            result->hasMove = hasMove;
+            result->move = move;
+            PublishHintSlot(&hint->resultExchange);
+        }
+    }
+}
+
+b32 InitHint(hint_t* hint) {
+    *hint = (hint_t){ 0 };
+
+    for (i32 i = 0; i < ArraySize(hint->requests); ++i) {
+        hint->requests[i].board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 0, 0, 0);
+    }
+    hint->requestExchange = (hint_exchange){ .writing = 0, .middle = 1, .reading = 2 };
+    hint->resultExchange  = (hint_exchange){ .writing = 0, .middle = 1, .reading = 2 };
+
+    InitSingleThreadedBot(&hint->bot); // The job pool belongs to the game
+    hint->bot.cancel = &hint->latestId;
+
+    hint->wakeUp = EngineCreateSignal();
+    if (hint->wakeUp) {
+        hint->thread = EngineStartThread(HintThread, hint);
+    }
+    if (!hint->thread) {
+        FreeHint(hint);
+        return false;
+    }
+
+    return true;
+}
+
+// Calls off whatever the worker is doing and waits for it to stop, which is within a node of the search
+void FreeHint(hint_t* hint) {
+    if (hint->thread) {
+        EngineAtomicExchange(&hint->shouldQuit, true);
+        EngineAtomicIncrement(&hint->latestId);
+        EngineRaiseSignal(hint->wakeUp);
+        EngineJoinThread(hint->thread);
+    }
+    EngineFreeSignal(hint->wakeUp);
+
+    FreeBot(&hint->bot);
+    for (i32 i = 0; i < ArraySize(hint->requests); ++i) {
+        FreeBoard(&hint->requests[i].board);
+    }
+
+    *hint = (hint_t){ 0 };
+}
+
+// The board has to be BOARD_WIDTH by BOARD_HEIGHT and next holds BOT_PREVIEW_COUNT pieces. Returns the id the result will have
+i32 RequestHint(hint_t* hint, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold) {
+    hint_request* request = &hint->requests[hint->requestExchange.writing];
+    request->id = hint->latestId + 1; // Only we write latestId
+    CopyBoard(&request->board, board);
+    request->current = *current;
+    for (i32 i = 0; i < BOT_PREVIEW_COUNT; ++i) {
+        request->next[i] = next[i];
+    }
+    request->hold = hold;
+    request->canHold = canHold;
+
+    // latestId goes first, which cancels the search for the one before. The other way around, the worker could take
+    // this request while latestId still says it's old and call its own search off
+    EngineAtomicExchange(&hint->latestId, request->id);
+    PublishHintSlot(&hint->requestExchange);
+    EngineRaiseSignal(hint->wakeUp);
+
+    return request->id;
+}
+
+// The newest result the worker has finished, which might be for an older request. Never waits
+hint_result* GetLatestHint(hint_t* hint) {
+    TakeHintSlot(&hint->resultExchange);
+    return &hint->results[hint->resultExchange.reading];
+}
\ No newline at end of file
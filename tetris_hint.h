@@ -0,0 +1,51 @@
+#ifndef TETRIS_HINT_H
+#define TETRIS_HINT_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_bot.h"
+
+
+// Everything the bot needs to know, copied so the game can keep going while it thinks
+typedef struct hint_request {
+    i32 id;
+    board_t board; // Always BOARD_WIDTH by BOARD_HEIGHT, that is all the bot knows how to play
+    tetromino_t current;
+    tetromino_type next[BOT_PREVIEW_COUNT];
+    tetromino_type hold;
+    b32 canHold;
+} hint_request;
+
+typedef struct hint_result {
+    i32 id; // Of the request it answers. 0 before there are any
+    b32 hasMove;
+    bot_move move;
+} hint_result;
+
+// Three slots passed between one writer and one reader on another thread, see tetris_hint.c
+typedef struct hint_exchange {
+    volatile i32 middle;
+    i32 writing; // Only touched by the writer
+    i32 reading; // Only touched by the reader
+} hint_exchange;
+
+// A bot on its own thread that works out where the current piece should go. Nothing here ever waits on it
+typedef struct hint_t {
+    hint_request requests[3];
+    hint_result results[3];
+    hint_exchange requestExchange; // Game to worker
+    hint_exchange resultExchange;  // Worker to game
+    volatile i32 latestId;         // Of the last request. The worker gives up on anything older
+    volatile i32 shouldQuit;
+
+    bot_t bot; // Only touched by the worker
+    engine_thread thread;
+    engine_signal wakeUp;
+} hint_t;
+
+extern b32 InitHint(hint_t* hint);
+extern void FreeHint(hint_t* hint);
+extern i32 RequestHint(hint_t* hint, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold);
+extern hint_result* GetLatestHint(hint_t* hint);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "tetris_history.h"
+
+/*
+    Unlimited undo and redo of piece placements, without copying the whole board every time.
+
+    A snapshot is a list of references to rows, bottom row first, up to the top of the stack. Rows are reference counted
+    and never change once made, so snapshots share every row they have in common. Empty rows are just null. The board
+    keeps a version per slot (board_t.slotVersions) that goes up whenever the slot's tiles change, and we remember which
+    row each slot held at which version, so taking a snapshot only copies the rows that were placed into since the
+    last one. Line clears move rows around without changing them, so those rows still get shared.
+
+    Moving to another snapshot is not constant time: every row up to the top of the stack gets checked against it, which
+    is a version and a pointer compare per row, and then the heights get recalculated over the same rows. Only the rows
+    that differ get rewritten though. Going one placement back or forward is usually the few rows the piece touched,
+    plus whatever a line clear moved.
+
+    Snapshots after the current one are the redo list, and taking a new snapshot throws them away.
+*/
+
+struct history_row {
+    i32 references;
+    history_row* nextFree;
+    // width tiles follow
+};
+
+
+static inline tetromino_type* GetHistoryRowTiles(history_row* row) {
+    return (tetromino_type*)(row + 1);
+}
+
+// Doubles the array until it fits count elements. The old one gets freed
+static void* GrowHistoryArray(void* memory, i32 count, i32* capacity, i32 elementSize) {
+    if (count <= *capacity) {
+        return memory;
+    }
+
+    i32 newCapacity = Max(*capacity * 2, 64);
+    while (newCapacity < count) {
+        newCapacity *= 2;
+    }
+
+    u8* newMemory = EngineAllocate(newCapacity * elementSize, memory_tag_game);
+    for (i32 i = 0; i < *capacity * elementSize; ++i) {
+        newMemory[i] = ((u8*)memory)[i];
+    }
+    EngineFree(memory);
+
+    *capacity = newCapacity;
+    return newMemory;
+}
+
+static history_row* AllocateHistoryRow(board_history* history) {
+    if (!history->freeRows) {
+        // Rows come in blocks, one allocation and one table entry for many of them
+        u8* block = EngineAllocate(sizeof(void*) + HISTORY_ROWS_PER_BLOCK * history->rowSize, memory_tag_game);
+        *(void**)block = history->blocks;
+        history->blocks = block;
+
+        for (i32 i = HISTORY_ROWS_PER_BLOCK - 1; i >= 0; --i) {
+            history_row* row = (history_row*)(block + sizeof(void*) + i * history->rowSize);
+            row->nextFree = history->freeRows;
+            history->freeRows = row;
+        }
+    }
+
+    history_row* row = history->freeRows;
+    history->freeRows = row->nextFree;
+    row->references = 1;
+    ++history->rowsCount;
+
+    return row;
+}
+
+static void ReleaseHistoryRow(board_history* history, history_row* row) {
+    if (row && --row->references == 0) {
+        row->nextFree = history->freeRows;
+        history->freeRows = row;
+        --history->rowsCount;
+    }
+}
+
+// Remembers that the slot holds row as of its current version
+static void SetHistorySlotRow(board_history* history, board_t* board, i32 slot, history_row* row) {
+    if (row) {
+        ++row->references;
+    }
+    ReleaseHistoryRow(history, history->slotRows[slot]);
+    history->slotRows[slot] = row;
+    history->slotVersions[slot] = board->slotVersions[slot];
+}
+
+// The row the board has at y, made into a shared one if it isn't already. The slot's reference is the only one it has
+static history_row* GetHistoryRowOfBoard(board_history* history, board_t* board, i32 y) {
+    i32 slot = board->rowSlots[y];
+    if (board->rowFillCounts[slot] == 0) {
+        return 0;
+    }
+    if (board->slotVersions[slot] == history->slotVersions[slot] && history->slotRows[slot]) {
+        return history->slotRows[slot];
+    }
+
+    history_row* row = AllocateHistoryRow(history);
+    const tetromino_type* tiles = GetBoardRow(board, y);
+    for (i32 x = 0; x < history->width; ++x) {
+        GetHistoryRowTiles(row)[x] = tiles[x];
+    }
+
+    SetHistorySlotRow(history, board, slot, row);
+    --row->references; // Back to just the slot's
+
+    return row;
+}
+
+// The history starts out with a snapshot of the board as it is now
+void InitBoardHistory(board_history* history, board_t* board, i32 stateSize) {
+    *history = (board_history){
+        .width     = board->width,
+        .height    = board->height,
+        .stateSize = stateSize,
+        .rowSize   = (i32)((sizeof(history_row) + board->width * sizeof(tetromino_type) + 7) & ~7),
+        .current   = -1
+    };
+
+    history->slotRows     = EngineAllocate(board->height * sizeof(history_row*), memory_tag_game);
+    history->slotVersions = EngineAllocate(board->height * sizeof(u32), memory_tag_game);
+    history->emptyTiles   = EngineAllocate(board->width * sizeof(tetromino_type), memory_tag_game);
+    for (i32 slot = 0; slot < board->height; ++slot) {
+        history->slotVersions[slot] = board->slotVersions[slot] - 1; // Not seen yet
+    }
+}
+
+void FreeBoardHistory(board_history* history) {
+    for (void* block = history->blocks; block;) {
+        void* next = *(void**)block;
+        EngineFree(block);
+        block = next;
+    }
+
+    EngineFree(history->snapshots);
+    EngineFree(history->states);
+    EngineFree(history->rowRefs);
+    EngineFree(history->slotRows);
+    EngineFree(history->slotVersions);
+    EngineFree(history->emptyTiles);
+
+    *history = (board_history){ 0 };
+}
+
+// Takes a snapshot of the board and state, right after the current one. Anything that could have been redone is gone
+void PushBoardHistory(board_history* history, board_t* board, const void* state) {
+    Assert(board->width == history->width && board->height == history->height);
+
+    for (i32 i = history->current + 1; i < history->snapshotsCount; ++i) {
+        history_snapshot* snapshot = &history->snapshots[i];
+        for (i32 y = 0; y < snapshot->rowsCount; ++y) {
+            ReleaseHistoryRow(history, history->rowRefs[snapshot->rowsOffset + y]);
+        }
+    }
+    if (history->current + 1 < history->snapshotsCount) {
+        history->rowRefsCount = history->snapshots[history->current + 1].rowsOffset;
+    }
+    history->snapshotsCount = history->current + 1;
+
+    i32 statesCapacity = history->snapshotsCapacity; // Always the same as the snapshots'
+    history->snapshots = GrowHistoryArray(history->snapshots, history->snapshotsCount + 1, &history->snapshotsCapacity, sizeof(history_snapshot));
+    history->states = GrowHistoryArray(history->states, history->snapshotsCount + 1, &statesCapacity, history->stateSize);
+    history->rowRefs = GrowHistoryArray(history->rowRefs, history->rowRefsCount + board->stackHeight, &history->rowRefsCapacity, sizeof(history_row*));
+
+    history_snapshot* snapshot = &history->snapshots[history->snapshotsCount];
+    snapshot->rowsOffset = history->rowRefsCount;
+    snapshot->rowsCount  = board->stackHeight;
+    for (i32 y = 0; y < board->stackHeight; ++y) {
+        history_row* row = GetHistoryRowOfBoard(history, board, y);
+        if (row) {
+            ++row->references;
+        }
+        history->rowRefs[history->rowRefsCount++] = row;
+    }
+
+    u8* stateCopy = history->states + history->snapshotsCount * history->stateSize;
+    for (i32 i = 0; i < history->stateSize; ++i) {
+        stateCopy[i] = ((const u8*)state)[i];
+    }
+
+    history->current = history->snapshotsCount++;
+}
+
+// Puts the board and the state back to how they were in the snapshot, rewriting only the rows that differ
+static void GoToBoardHistory(board_history* history, i32 index, board_t* board, void* outState) {
+    history_snapshot* snapshot = &history->snapshots[index];
+    history_row** rows = &history->rowRefs[snapshot->rowsOffset];
+
+    i32 topRow = Max(board->stackHeight, snapshot->rowsCount);
+    for (i32 y = 0; y < topRow; ++y) {
+        history_row* wanted = y < snapshot->rowsCount ? rows[y] : 0;
+
+        i32 slot = board->rowSlots[y];
+        b32 isEmpty = board->rowFillCounts[slot] == 0;
+        b32 isKnown = board->slotVersions[slot] == history->slotVersions[slot];
+        if ((wanted == 0 && isEmpty) || (wanted != 0 && isKnown && history->slotRows[slot] == wanted)) {
+            continue;
+        }
+
+        SetBoardRow(board, y, wanted ? GetHistoryRowTiles(wanted) : history->emptyTiles);
+        SetHistorySlotRow(history, board, slot, wanted);
+    }
+    RecalculateBoardHeights(board, topRow);
+
+    const u8* state = history->states + index * history->stateSize;
+    for (i32 i = 0; i < history->stateSize; ++i) {
+        ((u8*)outState)[i] = state[i];
+    }
+
+    history->current = index;
+}
+
+// Both return false if there is nowhere to go, in which case nothing changes. Both cost O(stack height), see GoToBoardHistory
+b32 UndoBoardHistory(board_history* history, board_t* board, void* outState) {
+    if (history->current <= 0) {
+        return false;
+    }
+
+    GoToBoardHistory(history, history->current - 1, board, outState);
+    return true;
+}
+
+b32 RedoBoardHistory(board_history* history, board_t* board, void* outState) {
+    if (history->current + 1 >= history->snapshotsCount) {
+        return false;
+    }
+
+    GoToBoardHistory(history, history->current + 1, board, outState);
+    return true;
+}
\ No newline at end of file
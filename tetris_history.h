@@ -0,0 +1,52 @@
+#ifndef TETRIS_HISTORY_H
+#define TETRIS_HISTORY_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+
+
+#define HISTORY_ROWS_PER_BLOCK 256
+
+typedef struct history_row history_row;
+
+typedef struct history_snapshot {
+    i32 rowsOffset; // Into board_history.rowRefs
+    i32 rowsCount;  // The stack's height when it was taken. Everything above is empty
+} history_snapshot;
+
+// Snapshots of one board, plus stateSize bytes of whatever else the caller wants back with it. Rows are shared
+// between snapshots, see tetris_history.c
+typedef struct board_history {
+    i32 width;
+    i32 height;
+    i32 stateSize;
+    i32 rowSize; // In bytes, header included
+
+    history_snapshot* snapshots;
+    u8* states; // stateSize bytes per snapshot
+    i32 snapshotsCount;
+    i32 snapshotsCapacity;
+    i32 current; // The snapshot the board is at
+
+    history_row** rowRefs;
+    i32 rowRefsCount;
+    i32 rowRefsCapacity;
+
+    // What each slot of the board held the last time we looked at it, and its version then
+    history_row** slotRows;
+    u32* slotVersions;
+
+    history_row* freeRows;
+    void* blocks; // Linked through their first pointer
+    i32 rowsCount; // In use, for keeping an eye on memory
+
+    tetromino_type* emptyTiles;
+} board_history;
+
+extern void InitBoardHistory(board_history* history, board_t* board, i32 stateSize);
+extern void FreeBoardHistory(board_history* history);
+extern void PushBoardHistory(board_history* history, board_t* board, const void* state);
+extern b32 UndoBoardHistory(board_history* history, board_t* board, void* outState);
+extern b32 RedoBoardHistory(board_history* history, board_t* board, void* outState);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "tetris_moves.h"
+
+/*
+    Breadth first search over every (x, y, rotation) the current piece can get to with the same moves Scene1 allows:
+    one step left or right, rotating with ROTATION_KICKS, soft dropping one row and hard dropping. Gravity and lock
+    delay are ignored, so this is what a player with all the time in the world could reach.
+
+    Collision checks use a padded copy of the board as row bitmasks, one bit per column, so testing a position is
+    four ANDs instead of a loop over the tetromino's 16 bits.
+*/
+
+static inline i32 GetStateIndex(i32 x, i32 y, i32 rotation) {
+    return (rotation * MOVE_GEN_STRIDE_Y + (y + MOVE_GEN_PADDING)) * MOVE_GEN_STRIDE_X + (x + MOVE_GEN_PADDING);
+}
+
+static void BuildCollisionRows(move_generator* generator, const u16* rows, tetromino_type type) {
+    for (i32 rotation = 0; rotation < 4; ++rotation) {
+        for (i32 row = 0; row < 4; ++row) {
+            generator->pieceRows[rotation][row] = GetPieceShape(type, rotation)->rowMasks[row];
+        }
+    }
+
+    u32 walls = ~(((1u << generator->width) - 1) << MOVE_GEN_PADDING);
+
+    for (i32 i = 0; i < ArraySize(generator->collisionRows); ++i) {
+        i32 y = i - MOVE_GEN_PADDING;
+        if (y < 0 || y >= generator->height) {
+            generator->collisionRows[i] = 0xFFFFFFFF;
+            continue;
+        }
+
+        generator->collisionRows[i] = walls | (u32)rows[y] << MOVE_GEN_PADDING;
+    }
+}
+
+static inline b32 DoesTetrominoFit(move_generator* generator, tetromino_t* tetromino) {
+    if (tetromino->x < -MOVE_GEN_PADDING || tetromino->x >= generator->width || tetromino->y < -MOVE_GEN_PADDING || tetromino->y >= generator->height) {
+        return false;
+    }
+
+    u32* pieceRows = generator->pieceRows[tetromino->rotation];
+    u32* rows = &generator->collisionRows[tetromino->y + MOVE_GEN_PADDING];
+    i32 shift = tetromino->x + MOVE_GEN_PADDING;
+
+    return !(((pieceRows[0] << shift) & rows[0]) | ((pieceRows[1] << shift) & rows[1]) | ((pieceRows[2] << shift) & rows[2]) | ((pieceRows[3] << shift) & rows[3]));
+}
+
+#define LANDING_ROW_UNKNOWN -128
+
+// Every state in a column drops onto the same row, so remember it for the states above
+static i32 GetLandingRow(move_generator* generator, tetromino_t* tetromino) {
+    i32 index = GetStateIndex(tetromino->x, tetromino->y, tetromino->rotation);
+    if (generator->landingRows[index] != LANDING_ROW_UNKNOWN) {
+        return generator->landingRows[index];
+    }
+
+    tetromino_t below = *tetromino;
+    --below.y;
+    i32 row = DoesTetrominoFit(generator, &below) ? GetLandingRow(generator, &below) : tetromino->y;
+
+    generator->landingRows[index] = (i8)row;
+    return row;
+}
+
+static b32 ApplyMoveInput(move_generator* generator, tetromino_t* tetromino, move_input input) {
+    tetromino_t moved = *tetromino;
+
+    switch (input) {
+        case move_input_left: {
+            --moved.x;
+        } break;
+        case move_input_right: {
+            ++moved.x;
+        } break;
+        case move_input_soft_drop: {
+            --moved.y;
+        } break;
+        case move_input_rotate_cw:
+        case move_input_rotate_ccw: {
+            moved.rotation = (tetromino->rotation + (input == move_input_rotate_cw ? 1 : -1) + 4) % 4;
+            for (i32 i = 0; i < ArraySize(ROTATION_KICKS); ++i) {
+                moved.x = tetromino->x + ROTATION_KICKS[i][0];
+                moved.y = tetromino->y + ROTATION_KICKS[i][1];
+                if (DoesTetrominoFit(generator, &moved)) {
+                    *tetromino = moved;
+                    return true;
+                }
+            }
+            return false;
+        } break;
+        default: {
+            return false;
+        } break;
+    }
+
+    if (!DoesTetrominoFit(generator, &moved)) {
+        return false;
+    }
+
+    *tetromino = moved;
+    return true;
+}
+
+// Different rotations can cover the exact same tiles (the O always does, I, S and Z do when flipped), so placements are told apart by the tiles they cover
+static u32 GetPlacementKey(tetromino_t* tetromino) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+
+    u32 key = 0;
+    for (i32 row = shape->minY; row <= shape->maxY; ++row) {
+        key |= (u32)(shape->rowMasks[row] >> shape->minX) << (4 * (row - shape->minY));
+    }
+
+    return key | ((u32)(tetromino->x + shape->minX) & 0xFF) << 16 | ((u32)(tetromino->y + shape->minY) & 0xFF) << 24;
+}
+
+static void AddPlacement(move_generator* generator, tetromino_t* tetromino, i32 sourceState, i32 inputsCount) {
+    u32 key = GetPlacementKey(tetromino);
+    for (i32 i = 0; i < generator->placementsCount; ++i) {
+        if (generator->placementKeys[i] == key) {
+            return; // Seen already, and the search is breadth first so the earlier path can't be longer
+        }
+    }
+
+    if (generator->placementsCount >= MOVE_GEN_MAX_PLACEMENTS) {
+        return;
+    }
+
+    generator->placementKeys[generator->placementsCount] = key;
+    generator->placements[generator->placementsCount++] = (placement_t){
+        .tetromino   = *tetromino,
+        .sourceState = (u16)sourceState,
+        .inputsCount = (u8)Min(inputsCount, 255)
+    };
+}
+
+// Same as GeneratePlacements, for callers that keep their own boards as row bitmasks (bit x of rows[y] set if the tile is filled)
+i32 GeneratePlacementsFromRows(move_generator* generator, const u16* rows, i32 width, i32 height, tetromino_t* start) {
+    Assert(width <= BOARD_WIDTH && height <= BOARD_HEIGHT);
+
+    generator->width = width;
+    generator->height = height;
+    generator->placementsCount = 0;
+    for (i32 i = 0; i < ArraySize(generator->visited); ++i) {
+        generator->visited[i] = 0;
+        generator->visitedLocked[i] = 0;
+    }
+    for (i32 i = 0; i < ArraySize(generator->landingRows); ++i) {
+        generator->landingRows[i] = LANDING_ROW_UNKNOWN;
+    }
+
+    if (start->type == tetromino_type_empty) {
+        return 0;
+    }
+
+    BuildCollisionRows(generator, rows, start->type);
+
+    if (!DoesTetrominoFit(generator, start)) {
+        return 0;
+    }
+
+    i32 startIndex = GetStateIndex(start->x, start->y, start->rotation);
+    generator->visited[startIndex / 64] |= 1ull << (startIndex % 64);
+    generator->parents[startIndex] = (u16)startIndex;
+    generator->parentInputs[startIndex] = move_input_none;
+    generator->depths[startIndex] = 0;
+
+    i32 queueHead = 0;
+    i32 queueTail = 0;
+    generator->queue[queueTail++] = (move_state){ (i8)start->x, (i8)start->y, (i8)start->rotation };
+
+    while (queueHead < queueTail) {
+        move_state state = generator->queue[queueHead++];
+        tetromino_t tetromino = { .type = start->type, .rotation = state.rotation, .x = state.x, .y = state.y };
+        i32 index = GetStateIndex(state.x, state.y, state.rotation);
+
+        tetromino_t dropped = tetromino;
+        dropped.y = GetLandingRow(generator, &tetromino);
+
+        // Most states drop onto a spot some state above them already dropped onto
+        i32 droppedIndex = GetStateIndex(dropped.x, dropped.y, dropped.rotation);
+        if (!(generator->visitedLocked[droppedIndex / 64] & (1ull << (droppedIndex % 64)))) {
+            generator->visitedLocked[droppedIndex / 64] |= 1ull << (droppedIndex % 64);
+            AddPlacement(generator, &dropped, index, generator->depths[index] + 1);
+        }
+
+        for (move_input input = move_input_left; input <= move_input_soft_drop; ++input) {
+            tetromino_t moved = tetromino;
+            if (!ApplyMoveInput(generator, &moved, input)) {
+                continue;
+            }
+
+            i32 movedIndex = GetStateIndex(moved.x, moved.y, moved.rotation);
+            if (generator->visited[movedIndex / 64] & (1ull << (movedIndex % 64))) {
+                continue;
+            }
+
+            generator->visited[movedIndex / 64] |= 1ull << (movedIndex % 64);
+            generator->parents[movedIndex] = (u16)index;
+            generator->parentInputs[movedIndex] = (u8)input;
+            generator->depths[movedIndex] = (u8)Min(generator->depths[index] + 1, 255);
+            generator->queue[queueTail++] = (move_state){ (i8)moved.x, (i8)moved.y, (i8)moved.rotation };
+        }
+    }
+
+    return generator->placementsCount;
+}
+
+// Returns the number of distinct placements, which end up in generator->placements
+i32 GeneratePlacements(move_generator* generator, board_t* board, tetromino_t* start) {
+    u16 rows[BOARD_HEIGHT];
+    GetBoardRows(board, rows);
+
+    return GeneratePlacementsFromRows(generator, rows, board->width, board->height, start);
+}
+
+// Writes the inputs that take the tetromino from the start to the placement, ending with a hard drop. Returns how many there are, or 0 if they don't fit
+i32 GetPlacementPath(move_generator* generator, i32 placementIndex, move_input* outInputs, i32 maxInputs) {
+    placement_t* placement = &generator->placements[placementIndex];
+    i32 inputsCount = placement->inputsCount;
+    if (inputsCount > maxInputs) {
+        return 0;
+    }
+
+    outInputs[inputsCount - 1] = move_input_hard_drop;
+
+    i32 index = placement->sourceState;
+    for (i32 i = inputsCount - 2; i >= 0; --i) {
+        outInputs[i] = generator->parentInputs[index];
+        index = generator->parents[index];
+    }
+
+    return inputsCount;
+}
\ No newline at end of file
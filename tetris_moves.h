@@ -0,0 +1,61 @@
+#ifndef TETRIS_MOVES_H
+#define TETRIS_MOVES_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+
+
+// Tetrominoes are 4x4, so they can hang up to 3 tiles off the left and bottom edges of the board
+#define MOVE_GEN_PADDING    3
+#define MOVE_GEN_STRIDE_X   (BOARD_WIDTH  + MOVE_GEN_PADDING)
+#define MOVE_GEN_STRIDE_Y   (BOARD_HEIGHT + MOVE_GEN_PADDING)
+#define MOVE_GEN_MAX_STATES (4 * MOVE_GEN_STRIDE_X * MOVE_GEN_STRIDE_Y)
+#define MOVE_GEN_MAX_PLACEMENTS 256
+#define MOVE_GEN_MAX_PATH   64
+
+typedef enum move_input {
+    move_input_none = 0,
+    move_input_left,
+    move_input_right,
+    move_input_rotate_cw,
+    move_input_rotate_ccw,
+    move_input_soft_drop,
+    move_input_hard_drop
+} move_input;
+
+typedef struct placement_t {
+    tetromino_t tetromino; // Where it ends up locked
+    u16 sourceState;       // The state it gets hard dropped from
+    u8 inputsCount;        // Length of the shortest path, hard drop included
+} placement_t;
+
+typedef struct move_state {
+    i8 x;
+    i8 y;
+    i8 rotation;
+} move_state;
+
+// Big enough that you don't want it on the stack of a worker thread. Reuse one per thread
+typedef struct move_generator {
+    u32 collisionRows[BOARD_HEIGHT + 2 * MOVE_GEN_PADDING];
+    u32 pieceRows[4][4]; // The current tetromino's rows for each rotation
+    i32 width;
+    i32 height;
+    u64 visited[(MOVE_GEN_MAX_STATES + 63) / 64];
+    u64 visitedLocked[(MOVE_GEN_MAX_STATES + 63) / 64];
+    move_state queue[MOVE_GEN_MAX_STATES];
+    u16 parents[MOVE_GEN_MAX_STATES];
+    u8  parentInputs[MOVE_GEN_MAX_STATES];
+    u8  depths[MOVE_GEN_MAX_STATES];
+    i8  landingRows[MOVE_GEN_MAX_STATES]; // Where a hard drop from each state ends up, filled in as we go
+
+    placement_t placements[MOVE_GEN_MAX_PLACEMENTS];
+    u32 placementKeys[MOVE_GEN_MAX_PLACEMENTS];
+    i32 placementsCount;
+} move_generator;
+
+extern i32 GeneratePlacements(move_generator* generator, board_t* board, tetromino_t* start);
+extern i32 GeneratePlacementsFromRows(move_generator* generator, const u16* rows, i32 width, i32 height, tetromino_t* start);
+extern i32 GetPlacementPath(move_generator* generator, i32 placementIndex, move_input* outInputs, i32 maxInputs);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "tetris_perfect_clear.h"
+
+/*
+    Looks for a sequence of placements that leaves the board completely empty, using the pieces we know are coming:
+    the current one, the preview, the hold box and the rest of the bag (in the order the bag is going to deal them).
+
+    A perfect clear of height h fills every empty tile below row h and nothing above it, so the filled tiles plus four
+    per piece have to add up to 10 * h. Heights get tried from the lowest one the stack fits under, and for each one it
+    is a depth first search over every reachable placement (from the move generator), with or without hold. Anything
+    that puts a tile at or above the height is skipped, and so are boards that can't work out because of
+    - the height: not enough pieces left to fill it
+    - regions: a piece can't cover two columns unless they have an empty tile next to each other in some row, so
+      columns split into groups that get filled separately. Line clears never join them, since a full row has no
+      empty tiles in it. Every group needs a multiple of 4 empty tiles
+    - column parity: counting empty tiles in even columns as +1 and odd columns as -1, O, S, Z and flat I pieces
+      always cover as many of each, T, J and L can be off by 2 and an upright I by 4. If the pieces left can't make up
+      the difference, it can't be done
+
+    States that turn out to have no perfect clear go in a transposition table, keyed by the board, the pieces left and
+    the height. That stays true no matter what else happens, so other threads and later searches can trust it.
+
+    The first move of every line is made on the calling thread, and each of those is a job. A job gives up once an
+    earlier job has found a solution, and the solution from the earliest job is the one we go with, so the answer
+    doesn't depend on how the jobs got scheduled (unless we run out of time).
+*/
+
+#define FULL_ROW ((1 << BOARD_WIDTH) - 1)
+#define PERFECT_CLEAR_DEAD -1 // transposition_data.move for a state with no perfect clear
+
+typedef struct perfect_clear_expansion {
+    tetromino_type type;
+    tetromino_type hold;
+    i32 queueIndex;
+    b32 useHold;
+} perfect_clear_expansion;
+
+
+static inline i32 CountBits(u32 value) {
+    i32 count = 0;
+    for (; value; value &= value - 1) {
+        ++count;
+    }
+    return count;
+}
+
+// The biggest difference between even and odd columns each kind of piece can make
+static i32 GetColumnParitySwing(tetromino_type type) {
+    switch (type) {
+        case tetromino_type_I: return 4;
+        case tetromino_type_T:
+        case tetromino_type_J:
+        case tetromino_type_L: return 2;
+        default:               return 0;
+    }
+}
+
+// The checks from the top of the file, for a board with filledCount tiles below height and the pieces from queueIndex on left
+static b32 CanStillPerfectClear(perfect_clear_solver* solver, const u16* rows, i32 filledCount, i32 height, tetromino_type hold, i32 queueIndex) {
+    i32 emptyCount = BOARD_WIDTH * height - filledCount;
+    i32 piecesCount = solver->queueCount - queueIndex + (hold != tetromino_type_empty);
+    if (emptyCount % 4 != 0 || emptyCount / 4 > piecesCount) {
+        return false;
+    }
+
+    // Empty tiles per column, and which neighbouring columns share an empty row
+    i32 columnEmptyCounts[BOARD_WIDTH] = { 0 };
+    u32 joined = 0;
+    for (i32 y = 0; y < height; ++y) {
+        u32 empty = ~rows[y] & FULL_ROW;
+        joined |= empty & (empty >> 1);
+        for (u32 bits = empty; bits; bits &= bits - 1) {
+            i32 x = 0;
+            while (!(bits & (1u << x))) {
+                ++x;
+            }
+            ++columnEmptyCounts[x];
+        }
+    }
+
+    i32 regionCount = 0;
+    i32 parity = 0;
+    for (i32 x = 0; x < BOARD_WIDTH; ++x) {
+        regionCount += columnEmptyCounts[x];
+        if (!(joined & (1u << x))) {
+            if (regionCount % 4 != 0) {
+                return false;
+            }
+            regionCount = 0;
+        }
+        parity += x % 2 == 0 ? columnEmptyCounts[x] : -columnEmptyCounts[x];
+    }
+
+    i32 swing = GetColumnParitySwing(hold);
+    for (i32 i = queueIndex; i < solver->queueCount; ++i) {
+        swing += GetColumnParitySwing(solver->queue[i]);
+    }
+
+    return Abs(parity) <= swing;
+}
+
+// Places the tetromino and removes full lines. Returns the number of lines cleared, or -1 if it pokes out above height
+static i32 PlacePerfectClearTetromino(u16* rows, tetromino_t* tetromino, i32 height) {
+    const piece_shape* shape = GetPieceShape(tetromino->type, tetromino->rotation);
+    for (i32 row = shape->minY; row <= shape->maxY; ++row) {
+        u32 mask = shape->rowMasks[row];
+        i32 y = tetromino->y + row;
+        if (y >= height) {
+            return -1;
+        }
+        rows[y] |= (u16)(tetromino->x >= 0 ? mask << tetromino->x : mask >> -tetromino->x);
+    }
+
+    i32 linesCleared = 0;
+    for (i32 y = 0; y < height - linesCleared;) {
+        if (rows[y] == FULL_ROW) {
+            for (i32 i = y; i < height - 1; ++i) {
+                rows[i] = rows[i + 1];
+            }
+            rows[height - 1] = 0;
+            ++linesCleared;
+        }
+        else {
+            ++y;
+        }
+    }
+
+    return linesCleared;
+}
+
+// Same as the bot: the piece in front of the queue, or whatever comes out of the hold box for it
+static i32 GetPerfectClearExpansions(perfect_clear_solver* solver, tetromino_type hold, i32 queueIndex, b32 canHold, perfect_clear_expansion* outExpansions) {
+    i32 count = 0;
+    if (queueIndex >= solver->queueCount) {
+        // Only the hold box is left
+        if (hold != tetromino_type_empty && canHold) {
+            outExpansions[count++] = (perfect_clear_expansion){ hold, tetromino_type_empty, queueIndex, true };
+        }
+        return count;
+    }
+
+    outExpansions[count++] = (perfect_clear_expansion){ solver->queue[queueIndex], hold, queueIndex + 1, false };
+
+    if (canHold && solver->queue[queueIndex] != hold) {
+        if (hold != tetromino_type_empty) {
+            outExpansions[count++] = (perfect_clear_expansion){ hold, solver->queue[queueIndex], queueIndex + 1, true };
+        }
+        else if (queueIndex + 1 < solver->queueCount) {
+            outExpansions[count++] = (perfect_clear_expansion){ solver->queue[queueIndex + 1], solver->queue[queueIndex], queueIndex + 2, true };
+        }
+    }
+
+    return count;
+}
+
+static u64 GetPerfectClearKey(perfect_clear_solver* solver, const u16* rows, i32 height, tetromino_type hold, i32 queueIndex) {
+    return HashBoardRows(rows, 0, height) ^ GetPiecesZobristHash(hold, &solver->queue[queueIndex], solver->queueCount - queueIndex) ^ GetTileZobristKey(-1, height);
+}
+
+// True if the search should give up: out of time, or an earlier root has already been solved
+static b32 ShouldStopPerfectClear(perfect_clear_solver* solver, perfect_clear_thread* thread, i32 rootIndex) {
+    if (solver->didRunOutOfTime) {
+        return true;
+    }
+    if (thread->nodes % PERFECT_CLEAR_CHECK_INTERVAL == 1) {
+        if (EngineGetSeconds() > solver->deadline) {
+            solver->didRunOutOfTime = true;
+            return true;
+        }
+        for (i32 i = 0; i < rootIndex; ++i) {
+            if (solver->roots[i].isSolved) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// 1 if it found a perfect clear (in thread->moves from depth on), 0 if there isn't one, -1 if it had to stop
+static i32 SearchPerfectClear(perfect_clear_solver* solver, perfect_clear_thread* thread, i32 rootIndex, const u16* rows, i32 filledCount, i32 height, tetromino_type hold, i32 queueIndex, i32 depth) {
+    if (filledCount == 0) {
+        thread->movesCount = depth;
+        return 1;
+    }
+
+    ++thread->nodes;
+    if (ShouldStopPerfectClear(solver, thread, rootIndex)) {
+        return -1;
+    }
+
+    u64 key = GetPerfectClearKey(solver, rows, height, hold, queueIndex);
+    transposition_data seen;
+    if (ProbeTransposition(&solver->transpositions, key, &seen) && seen.move == PERFECT_CLEAR_DEAD) {
+        return 0;
+    }
+
+    perfect_clear_expansion expansions[2];
+    i32 expansionsCount = GetPerfectClearExpansions(solver, hold, queueIndex, true, expansions);
+
+    move_generator* generator = &thread->generators[depth];
+    for (i32 i = 0; i < expansionsCount; ++i) {
+        perfect_clear_expansion* expansion = &expansions[i];
+
+        tetromino_t start = InitTetromino(expansion->type, 0, SPAWN_X, SPAWN_Y);
+        i32 placementsCount = GeneratePlacementsFromRows(generator, rows, BOARD_WIDTH, BOARD_HEIGHT, &start);
+
+        for (i32 j = 0; j < placementsCount; ++j) {
+            u16 childRows[BOARD_HEIGHT];
+            for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+                childRows[y] = rows[y];
+            }
+
+            tetromino_t* placement = &generator->placements[j].tetromino;
+            i32 linesCleared = PlacePerfectClearTetromino(childRows, placement, height);
+            if (linesCleared < 0) {
+                continue;
+            }
+
+            i32 childFilledCount = filledCount + 4 - BOARD_WIDTH * linesCleared;
+            i32 childHeight = height - linesCleared;
+            if (childFilledCount > 0 && !CanStillPerfectClear(solver, childRows, childFilledCount, childHeight, expansion->hold, expansion->queueIndex)) {
+                continue;
+            }
+
+            thread->moves[depth] = (perfect_clear_move){ .useHold = expansion->useHold, .placement = *placement };
+            i32 found = SearchPerfectClear(solver, thread, rootIndex, childRows, childFilledCount, childHeight, expansion->hold, expansion->queueIndex, depth + 1);
+            if (found != 0) {
+                return found;
+            }
+        }
+    }
+
+    StoreTransposition(&solver->transpositions, key, (transposition_data){ .move = PERFECT_CLEAR_DEAD, .depth = (u8)depth });
+    return 0;
+}
+
+static void SearchPerfectClearRoot(void* data, i32 jobIndex, i32 threadIndex) {
+    perfect_clear_solver* solver = data;
+    perfect_clear_thread* thread = &solver->threads[threadIndex];
+    perfect_clear_root* root = &solver->roots[jobIndex];
+
+    i32 found = SearchPerfectClear(solver, thread, jobIndex, root->rows, root->filledCount, root->height, root->hold, root->queueIndex, 0);
+    if (found == 1) {
+        root->movesCount = thread->movesCount;
+        for (i32 i = 0; i < root->movesCount; ++i) {
+            root->moves[i] = thread->moves[i];
+        }
+        root->isSolved = true;
+    }
+}
+
+void InitPerfectClearSolver(perfect_clear_solver* solver) {
+    *solver = (perfect_clear_solver){ 0 };
+    solver->threadsCount = EngineGetThreadCount();
+    solver->threads = EngineAllocate(solver->threadsCount * sizeof(perfect_clear_thread), memory_tag_bot);
+    solver->roots = EngineAllocate(PERFECT_CLEAR_MAX_ROOTS * sizeof(perfect_clear_root), memory_tag_bot);
+    InitTranspositionTable(&solver->transpositions, PERFECT_CLEAR_TRANSPOSITION_TABLE_SIZE);
+}
+
+void FreePerfectClearSolver(perfect_clear_solver* solver) {
+    EngineFree(solver->threads);
+    EngineFree(solver->roots);
+    FreeTranspositionTable(&solver->transpositions);
+    *solver = (perfect_clear_solver){ 0 };
+}
+
+// The first move of every line, each one becoming a root. Returns true if one of them is a perfect clear already
+static b32 FindPerfectClearRoots(perfect_clear_solver* solver, const u16* rows, i32 filledCount, i32 height, tetromino_t* current, tetromino_type hold, b32 canHold) {
+    solver->rootsCount = 0;
+
+    perfect_clear_expansion expansions[2];
+    i32 expansionsCount = GetPerfectClearExpansions(solver, hold, 0, canHold, expansions);
+
+    move_generator* generator = &solver->threads[0].generators[0];
+    for (i32 i = 0; i < expansionsCount; ++i) {
+        perfect_clear_expansion* expansion = &expansions[i];
+
+        tetromino_t start = expansion->useHold ? InitTetromino(expansion->type, 0, SPAWN_X, SPAWN_Y) : *current;
+        i32 placementsCount = GeneratePlacementsFromRows(generator, rows, BOARD_WIDTH, BOARD_HEIGHT, &start);
+
+        for (i32 j = 0; j < placementsCount && solver->rootsCount < PERFECT_CLEAR_MAX_ROOTS; ++j) {
+            perfect_clear_root* root = &solver->roots[solver->rootsCount];
+            for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+                root->rows[y] = rows[y];
+            }
+
+            i32 linesCleared = PlacePerfectClearTetromino(root->rows, &generator->placements[j].tetromino, height);
+            if (linesCleared < 0) {
+                continue;
+            }
+
+            root->filledCount = filledCount + 4 - BOARD_WIDTH * linesCleared;
+            root->height = height - linesCleared;
+            root->hold = expansion->hold;
+            root->queueIndex = expansion->queueIndex;
+            root->move = (perfect_clear_move){ .useHold = expansion->useHold, .placement = generator->placements[j].tetromino };
+            root->isSolved = false;
+            root->movesCount = 0;
+
+            if (root->filledCount == 0) {
+                root->isSolved = true;
+                solver->rootsCount = 1;
+                solver->roots[0] = *root;
+                return true;
+            }
+            if (CanStillPerfectClear(solver, root->rows, root->filledCount, root->height, root->hold, root->queueIndex)) {
+                ++solver->rootsCount;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*
+    Only for boards of the normal size. next holds PERFECT_CLEAR_PREVIEW_COUNT pieces, and the rest of the bag comes
+    from bag, which doesn't get touched. The search stops after timeBudget seconds, with whatever it has found by then
+*/
+perfect_clear_result FindPerfectClear(perfect_clear_solver* solver, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, tetromino_bag* bag, f64 timeBudget) {
+    Assert(board->width == BOARD_WIDTH && board->height == BOARD_HEIGHT);
+
+    f64 startTime = EngineGetSeconds();
+    solver->deadline = startTime + timeBudget;
+    solver->didRunOutOfTime = false;
+    NewTranspositionSearch(&solver->transpositions);
+    for (i32 i = 0; i < solver->threadsCount; ++i) {
+        solver->threads[i].nodes = 0;
+    }
+
+    solver->queueCount = 0;
+    solver->queue[solver->queueCount++] = current->type;
+    for (i32 i = 0; i < PERFECT_CLEAR_PREVIEW_COUNT; ++i) {
+        solver->queue[solver->queueCount++] = next[i];
+    }
+    for (i32 i = bag->index; i < ArraySize(bag->pieces); ++i) {
+        solver->queue[solver->queueCount++] = bag->pieces[i];
+    }
+
+    u16 rows[BOARD_HEIGHT];
+    GetBoardRows(board, rows);
+    i32 filledCount = 0;
+    for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+        filledCount += CountBits(rows[y]);
+    }
+
+    perfect_clear_result result = { 0 };
+    for (i32 height = Max(board->stackHeight, 1); height <= PERFECT_CLEAR_MAX_HEIGHT && !result.isFound && !solver->didRunOutOfTime; ++height) {
+        if (!CanStillPerfectClear(solver, rows, filledCount, height, hold, 0)) {
+            continue;
+        }
+
+        if (!FindPerfectClearRoots(solver, rows, filledCount, height, current, hold, canHold)) {
+            if (solver->threadsCount > 1) {
+                EngineRunJobs(SearchPerfectClearRoot, solver, solver->rootsCount);
+            }
+            else {
+                for (i32 i = 0; i < solver->rootsCount; ++i) {
+                    SearchPerfectClearRoot(solver, i, 0);
+                }
+            }
+        }
+
+        for (i32 i = 0; i < solver->rootsCount; ++i) {
+            perfect_clear_root* root = &solver->roots[i];
+            if (root->isSolved) {
+                result.isFound = true;
+                result.height = height;
+                result.moves[0] = root->move;
+                for (i32 j = 0; j < root->movesCount; ++j) {
+                    result.moves[1 + j] = root->moves[j];
+                }
+                result.movesCount = 1 + root->movesCount;
+                break;
+            }
+        }
+    }
+
+    result.didRunOutOfTime = solver->didRunOutOfTime && !result.isFound;
+    for (i32 i = 0; i < solver->threadsCount; ++i) {
+        result.nodes += solver->threads[i].nodes;
+    }
+    result.seconds = EngineGetSeconds() - startTime;
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef TETRIS_PERFECT_CLEAR_H
+#define TETRIS_PERFECT_CLEAR_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_moves.h"
+#include "tetris_transposition.h"
+
+
+#define PERFECT_CLEAR_PREVIEW_COUNT  3
+#define PERFECT_CLEAR_MAX_PIECES     (1 + PERFECT_CLEAR_PREVIEW_COUNT + 7) // The current piece, the preview and what is left of the bag
+#define PERFECT_CLEAR_MAX_HEIGHT     6
+#define PERFECT_CLEAR_MAX_ROOTS      (2 * MOVE_GEN_MAX_PLACEMENTS)
+#define PERFECT_CLEAR_CHECK_INTERVAL 256 // Nodes between looking at the clock
+#define PERFECT_CLEAR_TRANSPOSITION_TABLE_SIZE (1 << 22)
+
+typedef struct perfect_clear_move {
+    b32 useHold;
+    tetromino_t placement; // Where the piece that gets played ends up
+} perfect_clear_move;
+
+typedef struct perfect_clear_result {
+    b32 isFound;
+    b32 didRunOutOfTime; // If neither is set, there is no perfect clear with the pieces we know about
+    perfect_clear_move moves[PERFECT_CLEAR_MAX_PIECES];
+    i32 movesCount;
+    i32 height; // Rows the perfect clear was found for
+    u64 nodes;
+    f64 seconds;
+} perfect_clear_result;
+
+// One subtree of the search, starting after the first move. Every root is a job
+typedef struct perfect_clear_root {
+    u16 rows[BOARD_HEIGHT];
+    i32 filledCount;
+    i32 height;
+    tetromino_type hold;
+    i32 queueIndex;
+    perfect_clear_move move;
+
+    volatile b32 isSolved;
+    perfect_clear_move moves[PERFECT_CLEAR_MAX_PIECES]; // The rest of the solution, if isSolved
+    i32 movesCount;
+} perfect_clear_root;
+
+// Big, reuse one per thread
+typedef struct perfect_clear_thread {
+    move_generator generators[PERFECT_CLEAR_MAX_PIECES]; // One per depth, since the placements have to survive the recursion
+    perfect_clear_move moves[PERFECT_CLEAR_MAX_PIECES];
+    i32 movesCount; // Of the last perfect clear found
+    u64 nodes;
+} perfect_clear_thread;
+
+typedef struct perfect_clear_solver {
+    perfect_clear_thread* threads;
+    i32 threadsCount;
+    perfect_clear_root* roots;
+    i32 rootsCount;
+    transposition_table transpositions; // States with no perfect clear. Those stay true, so they are kept between searches
+
+    tetromino_type queue[PERFECT_CLEAR_MAX_PIECES];
+    i32 queueCount;
+    f64 deadline;
+    volatile b32 didRunOutOfTime;
+} perfect_clear_solver;
+
+extern void InitPerfectClearSolver(perfect_clear_solver* solver);
+extern void FreePerfectClearSolver(perfect_clear_solver* solver);
+extern perfect_clear_result FindPerfectClear(perfect_clear_solver* solver, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, tetromino_bag* bag, f64 timeBudget);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "tetris_perft.h"
+
+/*
+    Counts every placement sequence of the given pieces, like perft does for chess moves. A node at depth n is the board
+    after n pieces have been locked, so two different ways of getting to the same board count twice. Each placement
+    comes from the move generator and then goes through the board code the game uses (IsTetrominoPosValid,
+    TryMoveTetromino, PlaceTetromino and ProcessLineClears), so the numbers only stay the same if all of them agree.
+
+    The first couple of levels are expanded on the calling thread. Every node at the split depth becomes a job, and each
+    job counts its subtree into its own slot, so no counter is shared between threads.
+*/
+
+#define PERFT_SPLIT_DEPTH 2
+
+typedef struct perft_thread {
+    move_generator generators[PERFT_MAX_DEPTH]; // One per depth, since the placements have to survive the recursion
+    board_t boards[PERFT_MAX_DEPTH + 1];
+} perft_thread;
+
+typedef struct perft_job {
+    board_t board;
+    u64 nodes[PERFT_MAX_DEPTH + 1];
+    u64 mismatches;
+} perft_job;
+
+typedef struct perft_state {
+    tetromino_type* pieces;
+    i32 depth;
+    perft_thread* threads;
+    perft_job* jobs;
+    i32 jobsCount;
+} perft_state;
+
+
+// If jobs isn't 0, the boards at maxDepth get copied into them to be expanded later
+static void CountPerftNodes(perft_thread* thread, board_t* board, tetromino_type* pieces, i32 depth, i32 maxDepth, u64* nodes, u64* mismatches, perft_job* jobs, i32* jobsCount) {
+    if (depth == maxDepth) {
+        return;
+    }
+
+    tetromino_t spawn = InitTetromino(pieces[depth], 0, SPAWN_X, SPAWN_Y);
+    if (!IsTetrominoPosValid(board, &spawn)) {
+        return; // Game over, nothing below this one
+    }
+
+    move_generator* generator = &thread->generators[depth];
+    i32 placementsCount = GeneratePlacements(generator, board, &spawn);
+
+    board_t* child = &thread->boards[depth + 1];
+    for (i32 i = 0; i < placementsCount; ++i) {
+        tetromino_t placement = generator->placements[i].tetromino;
+
+        // Has to be somewhere the piece can be, and resting on something
+        tetromino_t below = placement;
+        if (!IsTetrominoPosValid(board, &placement) || TryMoveTetromino(board, &below, 0, -1)) {
+            ++*mismatches;
+            continue;
+        }
+
+        ++nodes[depth + 1];
+
+        CopyBoard(child, board);
+        PlaceTetromino(child, &placement);
+        ProcessLineClears(child, &placement);
+
+        if (jobs && depth + 1 == maxDepth) {
+            CopyBoard(&jobs[(*jobsCount)++].board, child);
+            continue;
+        }
+
+        CountPerftNodes(thread, child, pieces, depth + 1, maxDepth, nodes, mismatches, jobs, jobsCount);
+    }
+}
+
+static void CountPerftJob(void* data, i32 jobIndex, i32 threadIndex) {
+    perft_state* state = data;
+    perft_job* job = &state->jobs[jobIndex];
+
+    CountPerftNodes(&state->threads[threadIndex], &job->board, state->pieces, PERFT_SPLIT_DEPTH, state->depth, job->nodes, &job->mismatches, 0, 0);
+}
+
+// pieces needs to hold depth pieces
+perft_result RunPerft(board_t* board, tetromino_type* pieces, i32 depth) {
+    perft_result result = { .depth = Clamp(depth, 0, PERFT_MAX_DEPTH) };
+    result.nodes[0] = 1;
+
+    f64 startTime = EngineGetSeconds();
+
+    perft_state state = {
+        .pieces  = pieces,
+        .depth   = result.depth,
+        .threads = EngineAllocate(EngineGetThreadCount() * sizeof(perft_thread), memory_tag_tools)
+    };
+    for (i32 i = 0; i < EngineGetThreadCount(); ++i) {
+        for (i32 j = 0; j <= PERFT_MAX_DEPTH; ++j) {
+            state.threads[i].boards[j] = InitBoard(board->width, board->height, 0, 0, 0);
+        }
+    }
+
+    if (result.depth <= PERFT_SPLIT_DEPTH) {
+        CountPerftNodes(&state.threads[0], board, pieces, 0, result.depth, result.nodes, &result.mismatches, 0, 0);
+    }
+    else {
+        // Once to find out how many jobs there are going to be, then again to fill them in
+        u64 splitNodes[PERFT_MAX_DEPTH + 1] = { 0 };
+        u64 splitMismatches = 0;
+        CountPerftNodes(&state.threads[0], board, pieces, 0, PERFT_SPLIT_DEPTH, splitNodes, &splitMismatches, 0, 0);
+
+        i32 jobsCapacity = (i32)splitNodes[PERFT_SPLIT_DEPTH];
+        state.jobs = EngineAllocate(Max(jobsCapacity, 1) * sizeof(perft_job), memory_tag_tools);
+        for (i32 i = 0; i < jobsCapacity; ++i) {
+            state.jobs[i].board = InitBoard(board->width, board->height, 0, 0, 0);
+        }
+
+        CountPerftNodes(&state.threads[0], board, pieces, 0, PERFT_SPLIT_DEPTH, result.nodes, &result.mismatches, state.jobs, &state.jobsCount);
+
+        EngineRunJobs(CountPerftJob, &state, state.jobsCount);
+
+        for (i32 i = 0; i < state.jobsCount; ++i) {
+            for (i32 j = PERFT_SPLIT_DEPTH + 1; j <= result.depth; ++j) {
+                result.nodes[j] += state.jobs[i].nodes[j];
+            }
+            result.mismatches += state.jobs[i].mismatches;
+            FreeBoard(&state.jobs[i].board);
+        }
+        EngineFree(state.jobs);
+    }
+
+    for (i32 i = 0; i < EngineGetThreadCount(); ++i) {
+        for (i32 j = 0; j <= PERFT_MAX_DEPTH; ++j) {
+            FreeBoard(&state.threads[i].boards[j]);
+        }
+    }
+    EngineFree(state.threads);
+
+    result.seconds = EngineGetSeconds() - startTime;
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef TETRIS_PERFT_H
+#define TETRIS_PERFT_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_moves.h"
+
+
+#define PERFT_MAX_DEPTH 8
+
+typedef struct perft_result {
+    u64 nodes[PERFT_MAX_DEPTH + 1]; // Number of states after each number of pieces. nodes[0] is the starting board
+    u64 mismatches;                 // Placements from the move generator that the board code disagrees with. Should be 0
+    i32 depth;
+    f64 seconds;
+} perft_result;
+
+extern perft_result RunPerft(board_t* board, tetromino_type* pieces, i32 depth);
+
+#endif
\ No newline at end of file
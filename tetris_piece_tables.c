@@ -0,0 +1,233 @@
+// Made by WritePieceTables in tetris_pieces.c, run the game with -genpieces to make it again rather than changing it by hand
+
+#include "tetris_pieces.h"
+
+
+const piece_shape PIECE_SHAPES[][4] = {
+    // .
+    {
+        { .columnBottoms = { -1, -1, -1, -1, -1 } },
+        { .columnBottoms = { -1, -1, -1, -1, -1 } },
+        { .columnBottoms = { -1, -1, -1, -1, -1 } },
+        { .columnBottoms = { -1, -1, -1, -1, -1 } }
+    },
+    // I
+    {
+        {
+            .cells         = { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 2 } },
+            .rowMasks      = { 0x00, 0x00, 0x0F, 0x00, 0x00 },
+            .columnBottoms = { 2, 2, 2, 2, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 2, .maxX = 3, .maxY = 2
+        },
+        {
+            .cells         = { { 2, 0 }, { 2, 1 }, { 2, 2 }, { 2, 3 } },
+            .rowMasks      = { 0x04, 0x04, 0x04, 0x04, 0x00 },
+            .columnBottoms = { -1, -1, 0, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 2, .minY = 0, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 } },
+            .rowMasks      = { 0x00, 0x0F, 0x00, 0x00, 0x00 },
+            .columnBottoms = { 1, 1, 1, 1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 3, .maxY = 1
+        },
+        {
+            .cells         = { { 1, 0 }, { 1, 1 }, { 1, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x02, 0x02, 0x02, 0x02, 0x00 },
+            .columnBottoms = { -1, 0, -1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 0, .maxX = 1, .maxY = 3
+        }
+    },
+    // O
+    {
+        {
+            .cells         = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x06, 0x06, 0x00, 0x00 },
+            .columnBottoms = { -1, 1, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x06, 0x06, 0x00, 0x00 },
+            .columnBottoms = { -1, 1, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x06, 0x06, 0x00, 0x00 },
+            .columnBottoms = { -1, 1, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x06, 0x06, 0x00, 0x00 },
+            .columnBottoms = { -1, 1, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 2
+        }
+    },
+    // T
+    {
+        {
+            .cells         = { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x00, 0x07, 0x02, 0x00 },
+            .columnBottoms = { 2, 2, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 2, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 1, 1 }, { 1, 2 }, { 2, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x02, 0x06, 0x02, 0x00 },
+            .columnBottoms = { -1, 1, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 1, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x02, 0x07, 0x00, 0x00 },
+            .columnBottoms = { 2, 1, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 1, 1 }, { 0, 2 }, { 1, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x02, 0x03, 0x02, 0x00 },
+            .columnBottoms = { 2, 1, -1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 1, .maxY = 3
+        }
+    },
+    // S
+    {
+        {
+            .cells         = { { 0, 2 }, { 1, 2 }, { 1, 3 }, { 2, 3 } },
+            .rowMasks      = { 0x00, 0x00, 0x03, 0x06, 0x00 },
+            .columnBottoms = { 2, 2, 3, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 2, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 2, 1 }, { 1, 2 }, { 2, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x04, 0x06, 0x02, 0x00 },
+            .columnBottoms = { -1, 2, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 0, 1 }, { 1, 1 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x03, 0x06, 0x00, 0x00 },
+            .columnBottoms = { 1, 1, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 1, 1 }, { 0, 2 }, { 1, 2 }, { 0, 3 } },
+            .rowMasks      = { 0x00, 0x02, 0x03, 0x01, 0x00 },
+            .columnBottoms = { 2, 1, -1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 1, .maxY = 3
+        }
+    },
+    // Z
+    {
+        {
+            .cells         = { { 1, 2 }, { 2, 2 }, { 0, 3 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x00, 0x06, 0x03, 0x00 },
+            .columnBottoms = { 3, 2, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 2, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 1, 1 }, { 1, 2 }, { 2, 2 }, { 2, 3 } },
+            .rowMasks      = { 0x00, 0x02, 0x06, 0x04, 0x00 },
+            .columnBottoms = { -1, 1, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 1, 1 }, { 2, 1 }, { 0, 2 }, { 1, 2 } },
+            .rowMasks      = { 0x00, 0x06, 0x03, 0x00, 0x00 },
+            .columnBottoms = { 2, 1, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 0, 1 }, { 0, 2 }, { 1, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x01, 0x03, 0x02, 0x00 },
+            .columnBottoms = { 1, 2, -1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 1, .maxY = 3
+        }
+    },
+    // J
+    {
+        {
+            .cells         = { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 0, 3 } },
+            .rowMasks      = { 0x00, 0x00, 0x07, 0x01, 0x00 },
+            .columnBottoms = { 2, 2, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 2, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 1, 1 }, { 1, 2 }, { 1, 3 }, { 2, 3 } },
+            .rowMasks      = { 0x00, 0x02, 0x02, 0x06, 0x00 },
+            .columnBottoms = { -1, 1, 3, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x04, 0x07, 0x00, 0x00 },
+            .columnBottoms = { 2, 2, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 0, 1 }, { 1, 1 }, { 1, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x03, 0x02, 0x02, 0x00 },
+            .columnBottoms = { 1, 1, -1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 1, .maxY = 3
+        }
+    },
+    // L
+    {
+        {
+            .cells         = { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 2, 3 } },
+            .rowMasks      = { 0x00, 0x00, 0x07, 0x04, 0x00 },
+            .columnBottoms = { 2, 2, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 2, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x06, 0x02, 0x02, 0x00 },
+            .columnBottoms = { -1, 1, 1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 1, .minY = 1, .maxX = 2, .maxY = 3
+        },
+        {
+            .cells         = { { 0, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } },
+            .rowMasks      = { 0x00, 0x01, 0x07, 0x00, 0x00 },
+            .columnBottoms = { 1, 2, 2, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 2, .maxY = 2
+        },
+        {
+            .cells         = { { 1, 1 }, { 1, 2 }, { 0, 3 }, { 1, 3 } },
+            .rowMasks      = { 0x00, 0x02, 0x02, 0x03, 0x00 },
+            .columnBottoms = { 3, 1, -1, -1, -1 },
+            .cellsCount    = 4,
+            .minX = 0, .minY = 1, .maxX = 1, .maxY = 3
+        }
+    }
+};
+
+const i32 PIECE_SHAPES_COUNT = 8;
\ No newline at end of file
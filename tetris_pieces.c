@@ -0,0 +1,266 @@
+#include "tetris_pieces.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+/*
+    Piece tables. A set of pieces is written down as text, one piece after the other:
+
+        <name> <size> <x> <y>
+        <size rows of size characters, top row first, '#' for a cell and anything else for none>
+
+    The piece turns clockwise in a size x size box, and the box sits at (x, y) from the piece's own x and y. That is
+    all SRS does too: the I turns in a 4x4 box, the O in a 2x2 one that doesn't change, and the rest in 3x3 ones.
+    Lines starting with '/' are comments.
+
+    Nothing reads the definitions while the game runs. WritePieceTables turns a set into tetris_piece_tables.c, with
+    every rotation's cells, row masks, bounding box and lowest cell per column worked out, so collision, placing and
+    drawing just look them up instead of walking the bits of a 4x4 mask. Run the game with -genpieces to make it
+    again after changing the set, see tetris_tools.c.
+*/
+
+const char* TETROMINO_SET_DEFINITION =
+    "I 4 0 0\n"
+    "....\n"
+    "####\n"
+    "....\n"
+    "....\n"
+    "O 2 1 1\n"
+    "##\n"
+    "##\n"
+    "T 3 0 1\n"
+    ".#.\n"
+    "###\n"
+    "...\n"
+    "S 3 0 1\n"
+    ".##\n"
+    "##.\n"
+    "...\n"
+    "Z 3 0 1\n"
+    "##.\n"
+    ".##\n"
+    "...\n"
+    "J 3 0 1\n"
+    "#..\n"
+    "###\n"
+    "...\n"
+    "L 3 0 1\n"
+    "..#\n"
+    "###\n"
+    "...\n";
+
+// The 12 of them, each turning about the middle of a 5x5 box
+const char* PENTOMINO_SET_DEFINITION =
+    "F 5 0 0\n" ".....\n" "..##.\n" ".##..\n" "..#..\n" ".....\n"
+    "I 5 0 0\n" ".....\n" ".....\n" "#####\n" ".....\n" ".....\n"
+    "L 5 0 0\n" ".....\n" "....#\n" ".####\n" ".....\n" ".....\n"
+    "N 5 0 0\n" ".....\n" ".##..\n" "..###\n" ".....\n" ".....\n"
+    "P 5 0 0\n" ".....\n" ".##..\n" ".##..\n" ".#...\n" ".....\n"
+    "T 5 0 0\n" ".....\n" ".###.\n" "..#..\n" "..#..\n" ".....\n"
+    "U 5 0 0\n" ".....\n" ".#.#.\n" ".###.\n" ".....\n" ".....\n"
+    "V 5 0 0\n" ".....\n" ".#...\n" ".#...\n" ".###.\n" ".....\n"
+    "W 5 0 0\n" ".....\n" ".#...\n" ".##..\n" "..##.\n" ".....\n"
+    "X 5 0 0\n" ".....\n" "..#..\n" ".###.\n" "..#..\n" ".....\n"
+    "Y 5 0 0\n" ".....\n" "..#..\n" ".####\n" ".....\n" ".....\n"
+    "Z 5 0 0\n" ".....\n" ".##..\n" "..#..\n" "..##.\n" ".....\n";
+
+
+// Copies the next line without its line break. Returns 0 at the end of the text
+static const char* ReadDefinitionLine(const char* at, char* outLine, i32 outLineSize) {
+    if (!*at) {
+        return 0;
+    }
+
+    i32 length = 0;
+    while (*at && *at != '\n' && *at != '\r') {
+        if (length < outLineSize - 1) {
+            outLine[length++] = *at;
+        }
+        ++at;
+    }
+    outLine[length] = '\0';
+
+    if (*at == '\r') {
+        ++at;
+    }
+    if (*at == '\n') {
+        ++at;
+    }
+
+    return at;
+}
+
+static const char* ReadDefinitionContentLine(const char* at, char* outLine, i32 outLineSize) {
+    do {
+        at = ReadDefinitionLine(at, outLine, outLineSize);
+    } while (at && (outLine[0] == '\0' || outLine[0] == '/'));
+
+    return at;
+}
+
+// Returns false if a cell ends up outside of PIECE_MAX_SIZE or there are too many of them
+static b32 MakePieceShape(b32 box[PIECE_MAX_SIZE][PIECE_MAX_SIZE], i32 size, i32 boxX, i32 boxY, piece_shape* outShape) {
+    b32 isCell[PIECE_MAX_SIZE][PIECE_MAX_SIZE] = { 0 }; // By y, then x
+    for (i32 row = 0; row < size; ++row) {
+        for (i32 column = 0; column < size; ++column) {
+            if (!box[row][column]) {
+                continue;
+            }
+
+            i32 x = boxX + column;
+            i32 y = boxY + size - 1 - row;
+            if (x < 0 || x >= PIECE_MAX_SIZE || y < 0 || y >= PIECE_MAX_SIZE) {
+                return false;
+            }
+            isCell[y][x] = true;
+        }
+    }
+
+    memset(outShape, 0, sizeof(*outShape));
+    memset(outShape->columnBottoms, -1, sizeof(outShape->columnBottoms));
+    outShape->minX = PIECE_MAX_SIZE;
+    outShape->minY = PIECE_MAX_SIZE;
+    outShape->maxX = -1;
+    outShape->maxY = -1;
+
+    for (i32 y = 0; y < PIECE_MAX_SIZE; ++y) {
+        for (i32 x = 0; x < PIECE_MAX_SIZE; ++x) {
+            if (!isCell[y][x]) {
+                continue;
+            }
+            if (outShape->cellsCount >= PIECE_MAX_CELLS) {
+                return false;
+            }
+
+            outShape->cells[outShape->cellsCount++] = (piece_cell){ (i8)x, (i8)y };
+            outShape->rowMasks[y] |= (u8)(1 << x);
+            if (outShape->columnBottoms[x] < 0) {
+                outShape->columnBottoms[x] = (i8)y;
+            }
+            outShape->minX = (i8)Min(outShape->minX, x);
+            outShape->minY = (i8)Min(outShape->minY, y);
+            outShape->maxX = (i8)Max(outShape->maxX, x);
+            outShape->maxY = (i8)Max(outShape->maxY, y);
+        }
+    }
+
+    return outShape->cellsCount > 0;
+}
+
+// Fills outShapes[1] onwards, with outShapes[0] left for the empty type, and outNames the same way. Returns the
+// number of types including the empty one, or 0 if the definition is broken
+i32 BuildPieceShapes(const char* definition, piece_shape (*outShapes)[4], char* outNames, i32 maxTypes) {
+    memset(outShapes[0], 0, sizeof(outShapes[0]));
+    for (i32 rotation = 0; rotation < 4; ++rotation) {
+        memset(outShapes[0][rotation].columnBottoms, -1, sizeof(outShapes[0][rotation].columnBottoms));
+    }
+    outNames[0] = '.';
+
+    i32 typesCount = 1;
+    char line[256];
+    const char* at = definition;
+    while ((at = ReadDefinitionContentLine(at, line, sizeof(line)))) {
+        char name;
+        i32 size, boxX, boxY;
+        if (sscanf(line, " %c %d %d %d", &name, &size, &boxX, &boxY) != 4 || size < 1 || size > PIECE_MAX_SIZE || typesCount >= maxTypes) {
+            return 0;
+        }
+
+        b32 box[PIECE_MAX_SIZE][PIECE_MAX_SIZE] = { 0 }; // Top row first
+        for (i32 row = 0; row < size; ++row) {
+            at = ReadDefinitionContentLine(at, line, sizeof(line));
+            if (!at || (i32)strlen(line) < size) {
+                return 0;
+            }
+            for (i32 column = 0; column < size; ++column) {
+                box[row][column] = line[column] == '#';
+            }
+        }
+
+        for (i32 rotation = 0; rotation < 4; ++rotation) {
+            if (!MakePieceShape(box, size, boxX, boxY, &outShapes[typesCount][rotation])) {
+                return 0;
+            }
+
+            // Clockwise
+            b32 turned[PIECE_MAX_SIZE][PIECE_MAX_SIZE];
+            for (i32 row = 0; row < size; ++row) {
+                for (i32 column = 0; column < size; ++column) {
+                    turned[row][column] = box[size - 1 - column][row];
+                }
+            }
+            memcpy(box, turned, sizeof(box));
+        }
+
+        outNames[typesCount++] = name;
+    }
+
+    return typesCount;
+}
+
+static void WriteList(char* text, i32* length, i32 size, const char* format, const i8* values, i32 count) {
+    for (i32 i = 0; i < count; ++i) {
+        *length += snprintf(text + *length, size - *length, format, values[i], i < count - 1 ? ", " : "");
+    }
+}
+
+// Writes out the C source of the tables for the set. Returns false if the definition is broken or the file couldn't be written
+b32 WritePieceTables(const char* path, const char* definition) {
+    piece_shape shapes[PIECE_MAX_TYPES][4];
+    char names[PIECE_MAX_TYPES];
+    i32 typesCount = BuildPieceShapes(definition, shapes, names, PIECE_MAX_TYPES);
+    if (!typesCount) {
+        return false;
+    }
+
+    i32 size = 1024 + typesCount * 4 * 512;
+    char* text = EngineAllocate(size, memory_tag_tools);
+    i32 length = 0;
+
+    length += snprintf(text + length, size - length,
+        "// Made by WritePieceTables in tetris_pieces.c, run the game with -genpieces to make it again rather than changing it by hand\n"
+        "\n"
+        "#include \"tetris_pieces.h\"\n"
+        "\n"
+        "\n"
+        "const piece_shape PIECE_SHAPES[][4] = {\n");
+
+    for (i32 type = 0; type < typesCount; ++type) {
+        length += snprintf(text + length, size - length, "    // %c\n    {\n", names[type]);
+        for (i32 rotation = 0; rotation < 4; ++rotation) {
+            piece_shape* shape = &shapes[type][rotation];
+            if (type == 0) {
+                length += snprintf(text + length, size - length, "        { .columnBottoms = { ");
+                WriteList(text, &length, size, "%d%s", shape->columnBottoms, PIECE_MAX_SIZE);
+                length += snprintf(text + length, size - length, " } }%s\n", rotation < 3 ? "," : "");
+                continue;
+            }
+
+            length += snprintf(text + length, size - length, "        {\n            .cells         = { ");
+            for (i32 i = 0; i < shape->cellsCount; ++i) {
+                length += snprintf(text + length, size - length, "{ %d, %d }%s", shape->cells[i].x, shape->cells[i].y, i < shape->cellsCount - 1 ? ", " : "");
+            }
+            length += snprintf(text + length, size - length, " },\n            .rowMasks      = { ");
+            for (i32 i = 0; i < PIECE_MAX_SIZE; ++i) {
+                length += snprintf(text + length, size - length, "0x%02X%s", shape->rowMasks[i], i < PIECE_MAX_SIZE - 1 ? ", " : "");
+            }
+            length += snprintf(text + length, size - length, " },\n            .columnBottoms = { ");
+            WriteList(text, &length, size, "%d%s", shape->columnBottoms, PIECE_MAX_SIZE);
+            length += snprintf(text + length, size - length,
+                " },\n"
+                "            .cellsCount    = %d,\n"
+                "            .minX = %d, .minY = %d, .maxX = %d, .maxY = %d\n"
+                "        }%s\n",
+                shape->cellsCount, shape->minX, shape->minY, shape->maxX, shape->maxY, rotation < 3 ? "," : "");
+        }
+        length += snprintf(text + length, size - length, "    }%s\n", type < typesCount - 1 ? "," : "");
+    }
+
+    length += snprintf(text + length, size - length, "};\n\nconst i32 PIECE_SHAPES_COUNT = %d;", typesCount);
+
+    b32 didWrite = length < size && EngineWriteEntireFile(path, text, length);
+    EngineFree(text);
+
+    return didWrite;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef TETRIS_PIECES_H
+#define TETRIS_PIECES_H
+
+#include "tetris.h"
+
+
+#define PIECE_MAX_SIZE  5 // Pieces rotate in a box up to this big, enough for pentominoes
+#define PIECE_MAX_CELLS 5
+#define PIECE_MAX_TYPES 32
+
+typedef struct piece_cell {
+    i8 x;
+    i8 y;
+} piece_cell;
+
+// One rotation of one piece, relative to the piece's x and y. Rows go up from y like the board's do
+typedef struct piece_shape {
+    piece_cell cells[PIECE_MAX_CELLS]; // Bottom row first, left to right within a row
+    u8 rowMasks[PIECE_MAX_SIZE];       // Bit x is set if (x, row) is a cell
+    i8 columnBottoms[PIECE_MAX_SIZE];  // The lowest cell's row in each column, -1 for columns without any
+    i8 cellsCount;
+    i8 minX;                           // Bounding box of the cells, inclusive
+    i8 minY;
+    i8 maxX;
+    i8 maxY;
+} piece_shape;
+
+// Generated by tetris_pieces.c into tetris_piece_tables.c, by type (the empty one first, with no cells) and rotation
+extern const piece_shape PIECE_SHAPES[][4];
+extern const i32 PIECE_SHAPES_COUNT;
+
+static inline const piece_shape* GetPieceShape(i32 type, i32 rotation) {
+    return &PIECE_SHAPES[type][rotation];
+}
+
+// For making the tables
+
+extern const char* TETROMINO_SET_DEFINITION;
+extern const char* PENTOMINO_SET_DEFINITION;
+
+extern i32 BuildPieceShapes(const char* definition, piece_shape (*outShapes)[4], char* outNames, i32 maxTypes);
+extern b32 WritePieceTables(const char* path, const char* definition);
+
+#endif
\ No newline at end of file
@@ -1,28 +1,116 @@
 #include "tetris_random.h"
 
+/*
+    PCG32 (XSH RR), from pcg-random.org. A 64-bit LCG underneath, with the output permuted so that even the low bits
+    are good. The increment of the LCG picks one of 2^63 streams, and since it is an LCG it can jump any number of steps
+    ahead in log time, which is what AdvanceRandomState does.
+*/
 
-#define MULTIPLIER 1664525
-#define INCREMENT 1013904223
+#define MULTIPLIER 6364136223846793005ull
 
 
-static u32 seed;
+static random_state g_random = { 0x853C49E6748FEA9Bull, 0xDA3E39CB94B95BDBull }; // Default state from the reference implementation
 
 
+random_state InitRandomState(u64 seed, u64 stream) {
+    random_state random = { 0, (stream << 1) | 1 };
+    NextRandomU32(&random);
+    random.state += seed;
+    NextRandomU32(&random);
+
+    return random;
+}
+
+// A new state on a stream of its own, seeded from this one. Handy for giving every job its own
+random_state SplitRandomState(random_state* random) {
+    u64 seed = ((u64)NextRandomU32(random) << 32) | NextRandomU32(random);
+    u64 stream = ((u64)NextRandomU32(random) << 32) | NextRandomU32(random);
+
+    return InitRandomState(seed, stream);
+}
+
+// Same as calling NextRandomU32 steps times, without doing that
+void AdvanceRandomState(random_state* random, u64 steps) {
+    u64 multiplier = MULTIPLIER;
+    u64 increment = random->increment;
+    u64 totalMultiplier = 1;
+    u64 totalIncrement = 0;
+    while (steps) {
+        if (steps & 1) {
+            totalMultiplier *= multiplier;
+            totalIncrement = totalIncrement * multiplier + increment;
+        }
+        increment *= multiplier + 1;
+        multiplier *= multiplier;
+        steps >>= 1;
+    }
+
+    random->state = totalMultiplier * random->state + totalIncrement;
+}
+
+u32 NextRandomU32(random_state* random) {
+    u64 state = random->state;
+    random->state = state * MULTIPLIER + random->increment;
+
+    u32 shifted = (u32)(((state >> 18) ^ state) >> 27);
+    u32 rotation = (u32)(state >> 59);
+    return (shifted >> rotation) | (shifted << ((0u - rotation) & 31));
+}
+
+// In [0, bound) without the bias of a plain %. The numbers below threshold are the ones that would make it uneven
+u32 NextRandomBelow(random_state* random, u32 bound) {
+    u32 threshold = (0u - bound) % bound;
+    for (;;) {
+        u32 value = NextRandomU32(random);
+        if (value >= threshold) {
+            return value % bound;
+        }
+    }
+}
+
+// Both ends included
+i32 NextRandomI32InRange(random_state* random, i32 min, i32 max) {
+    return min + (i32)NextRandomBelow(random, (u32)(max - min) + 1);
+}
+
+// In [0, 1)
+f32 NextRandomUnit(random_state* random) {
+    return (NextRandomU32(random) >> 8) * (1.0f / 16777216.0f);
+}
+
 void RandomInit(void) {
     system_time time = EngineGetSystemTime();
-    seed = time.day * time.hour * time.minute * time.second * time.millisecond;
+
+    // All of it, so no field being 0 can zero the rest. The fraction of a second from the timer makes two calls in the same millisecond differ
+    u64 seed = time.year;
+    seed = seed * 13 + time.month;
+    seed = seed * 32 + time.day;
+    seed = seed * 24 + time.hour;
+    seed = seed * 60 + time.minute;
+    seed = seed * 60 + time.second;
+    seed = seed * 1000 + time.millisecond;
+    f64 seconds = EngineGetSeconds();
+    seed ^= (u64)((seconds - (u64)seconds) * 4294967296.0) << 32;
+
+    g_random = InitRandomState(seed, 0);
+}
+
+void RandomSeed(u32 newSeed) {
+    g_random = InitRandomState(newSeed, 0);
+}
+
+random_state RandomSplit(void) {
+    return SplitRandomState(&g_random);
 }
 
 u32 RandomU32(void) {
-    seed = MULTIPLIER * seed + INCREMENT;
-    return seed;
+    return NextRandomU32(&g_random);
 }
 
 i32 RandomI32(void) {
-    seed = MULTIPLIER * seed + INCREMENT;
-    return *(i32*)&seed;
+    return (i32)NextRandomU32(&g_random);
 }
 
 i32 RandomI32InRange(i32 min, i32 max) {
-    return min + (RandomU32() % (u32)(max - min + 1));
+    return NextRandomI32InRange(&g_random, min, max);
 }
\ No newline at end of file
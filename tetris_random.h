@@ -4,7 +4,24 @@
 #include "tetris.h"
 
 
+// PCG32. Every stream is its own sequence, so two states with the same seed and different streams never overlap
+typedef struct random_state {
+    u64 state;
+    u64 increment; // Odd. Picks the stream
+} random_state;
+
+extern random_state InitRandomState(u64 seed, u64 stream);
+extern random_state SplitRandomState(random_state* random);
+extern void AdvanceRandomState(random_state* random, u64 steps);
+extern u32 NextRandomU32(random_state* random);
+extern u32 NextRandomBelow(random_state* random, u32 bound);
+extern i32 NextRandomI32InRange(random_state* random, i32 min, i32 max);
+extern f32 NextRandomUnit(random_state* random);
+
+// The same on one global state, for when nobody else needs to get the same numbers. Not for use from jobs
 extern void RandomInit(void);
+extern void RandomSeed(u32 newSeed);
+extern random_state RandomSplit(void);
 extern u32 RandomU32(void);
 extern i32 RandomI32(void);
 extern i32 RandomI32InRange(i32 min, i32 max);
@@ -0,0 +1,403 @@
+#include "tetris_replay.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+/*
+    A replay is the keys the game saw, by tick, and every so often a keyframe: the whole game as it was after a tick.
+    Playing a replay back is running the game on those keys again, which comes out the same because the game is
+    deterministic. Seeking loads the last keyframe at or before where we want to be and plays the rest, so it never
+    costs more than REPLAY_KEYFRAME_TICKS ticks however long the game was. The index of keyframes goes at the end of
+    the file, so the recorder doesn't have to know how many there will be when it starts.
+
+    Keyframes of big boards have the rows in them, which can be megabytes on the biggest marathon boards. Those get
+    spaced out so that keyframes never cost more than REPLAY_KEYFRAME_BYTES_PER_TICK on average, which makes seeking
+    simulate more ticks in return. A game that still gets to REPLAY_MAX_ARRAY_SIZE stops being recorded.
+
+    Anything that changes the game between ticks, like undoing in practice mode, has to add a keyframe right after.
+    Playback loads keyframes as it goes past them, so those jumps come out right too. For all the others loading is
+    the same as what we already have.
+*/
+
+#define REPLAY_MAX_BOARD_SIZE 4096 // The biggest marathon boards
+
+// Callers keep count * elementSize under REPLAY_MAX_ARRAY_SIZE, so the doubled size still fits an allocation
+static void* GrowReplayArray(void* memory, i64 count, i64* capacity, i32 elementSize) {
+    if (count <= *capacity) {
+        return memory;
+    }
+
+    i64 newCapacity = Max(*capacity * 2, 64);
+    while (newCapacity < count) {
+        newCapacity *= 2;
+    }
+
+    u8* newMemory = EngineAllocate((i32)(newCapacity * elementSize), memory_tag_game);
+    if (memory) {
+        memcpy(newMemory, memory, *capacity * elementSize);
+    }
+    EngineFree(memory);
+
+    *capacity = newCapacity;
+    return newMemory;
+}
+
+static inline i32 AlignReplaySize(i32 size) {
+    return (size + 7) & ~7;
+}
+
+static u32 GetReplayFileChecksum(const u8* bytes, i32 size) {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for (i32 i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static u16 GetReplayKeys(keyboard_state* input) {
+    u16 keys = 0;
+    for (i32 i = 0; i < REPLAY_KEYS_COUNT; ++i) {
+        keys |= (input->keys[i].isDown ? 1 : 0) << i;
+        keys |= (input->keys[i].didChangeState ? 1 : 0) << (i + REPLAY_KEYS_COUNT);
+    }
+
+    return keys;
+}
+
+static void SetReplayKeys(keyboard_state* input, u16 keys) {
+    for (i32 i = 0; i < REPLAY_KEYS_COUNT; ++i) {
+        input->keys[i].isDown = (keys >> i) & 1;
+        input->keys[i].didChangeState = (keys >> (i + REPLAY_KEYS_COUNT)) & 1;
+    }
+}
+
+// Recording //
+
+// Starts with a keyframe of the game as it is, which doesn't have to be a new one
+void InitReplayRecorder(replay_recorder* recorder, game_state* game, board_t* board) {
+    memset(recorder, 0, sizeof(*recorder));
+
+    recorder->boardWidth = board->width;
+    recorder->boardHeight = board->height;
+    recorder->ticksCount = game->tickCount;
+
+    AddReplayKeyframe(recorder, game, board);
+}
+
+void FreeReplayRecorder(replay_recorder* recorder) {
+    EngineFree(recorder->inputs);
+    EngineFree(recorder->keyframes);
+    EngineFree(recorder->index);
+    memset(recorder, 0, sizeof(*recorder));
+}
+
+// Call after every tick, with the keys that tick saw
+void RecordReplayTick(replay_recorder* recorder, game_state* game, board_t* board, keyboard_state* input) {
+    if (recorder->isTooBig) {
+        return;
+    }
+
+    u16 keys = GetReplayKeys(input);
+    if (keys != recorder->lastKeys) {
+        if ((i64)(recorder->inputsCount + 1) * sizeof(replay_input) > REPLAY_MAX_ARRAY_SIZE) {
+            recorder->isTooBig = true;
+            return;
+        }
+
+        recorder->inputs = GrowReplayArray(recorder->inputs, recorder->inputsCount + 1, &recorder->inputsCapacity, sizeof(replay_input));
+        recorder->inputs[recorder->inputsCount++] = (replay_input){
+            .tick = game->tickCount,
+            .keys = keys
+        };
+        recorder->lastKeys = keys;
+    }
+
+    recorder->ticksCount = game->tickCount;
+
+    if (game->tickCount - recorder->lastKeyframeTick >= recorder->keyframeTicks) {
+        AddReplayKeyframe(recorder, game, board);
+    }
+}
+
+// Also for after anything that changes the game without a tick
+void AddReplayKeyframe(replay_recorder* recorder, game_state* game, board_t* board) {
+    if (recorder->isTooBig) {
+        return;
+    }
+
+    b32 isBoardInGame = board->rowMasks == game->boardMemory;
+    i32 rowsCount = isBoardInGame ? 0 : board->stackHeight;
+    i32 size = AlignReplaySize(sizeof(replay_keyframe_data) + rowsCount * board->width); // At most 16 MB
+
+    // Every keyframe has to make it in, a replay with one missing would play back wrong after it
+    if (recorder->keyframesSize + size > REPLAY_MAX_ARRAY_SIZE || (i64)(recorder->indexCount + 1) * sizeof(replay_keyframe) > REPLAY_MAX_ARRAY_SIZE) {
+        recorder->isTooBig = true;
+        return;
+    }
+
+    recorder->keyframes = GrowReplayArray(recorder->keyframes, recorder->keyframesSize + size, &recorder->keyframesCapacity, 1);
+    recorder->index = GrowReplayArray(recorder->index, recorder->indexCount + 1, &recorder->indexCapacity, sizeof(replay_keyframe));
+
+    replay_keyframe_data* data = (replay_keyframe_data*)(recorder->keyframes + recorder->keyframesSize);
+    memset(data, 0, size);
+    if (isBoardInGame) {
+        SnapshotGameState(game, board, &data->game);
+    }
+    else {
+        memcpy(&data->game, game, sizeof(*game));
+    }
+    data->rowsCount = rowsCount;
+
+    u8* rows = (u8*)(data + 1);
+    for (i32 y = 0; y < rowsCount; ++y) {
+        const tetromino_type* row = GetBoardRow(board, y);
+        for (i32 x = 0; x < board->width; ++x) {
+            rows[y * board->width + x] = (u8)row[x];
+        }
+    }
+
+    recorder->index[recorder->indexCount++] = (replay_keyframe){
+        .tick       = game->tickCount,
+        .firstInput = recorder->inputsCount,
+        .offset     = (u32)recorder->keyframesSize,
+        .size       = size
+    };
+    recorder->keyframesSize += size;
+    recorder->lastKeyframeTick = game->tickCount;
+    recorder->keyframeTicks = Max(REPLAY_KEYFRAME_TICKS, size / REPLAY_KEYFRAME_BYTES_PER_TICK);
+}
+
+// Returns false without writing anything if the recording got too big
+b32 WriteReplayFile(replay_recorder* recorder, const char* path) {
+    i64 inputsOffset = AlignReplaySize(sizeof(replay_header));
+    i64 keyframesOffset = inputsOffset + (i64)recorder->inputsCount * sizeof(replay_input);
+    i64 indexOffset = keyframesOffset + recorder->keyframesSize;
+    i64 footerOffset = indexOffset + (i64)recorder->indexCount * sizeof(replay_keyframe);
+    i64 size = footerOffset + sizeof(replay_footer);
+    if (recorder->isTooBig || size > 0x7FFFFFFF) {
+        return false;
+    }
+
+    u8* file = EngineAllocate((i32)size, memory_tag_game);
+
+    *(replay_header*)file = (replay_header){
+        .magic       = REPLAY_FILE_MAGIC,
+        .version     = REPLAY_FILE_VERSION,
+        .boardWidth  = recorder->boardWidth,
+        .boardHeight = recorder->boardHeight,
+        .ticksCount  = recorder->ticksCount,
+        .inputsCount = recorder->inputsCount
+    };
+    memcpy(file + inputsOffset, recorder->inputs, recorder->inputsCount * sizeof(replay_input));
+    memcpy(file + keyframesOffset, recorder->keyframes, recorder->keyframesSize);
+
+    replay_keyframe* index = (replay_keyframe*)(file + indexOffset);
+    for (i32 i = 0; i < recorder->indexCount; ++i) {
+        index[i] = recorder->index[i];
+        index[i].offset += (u32)keyframesOffset;
+    }
+
+    *(replay_footer*)(file + footerOffset) = (replay_footer){
+        .indexOffset    = (u32)indexOffset,
+        .keyframesCount = recorder->indexCount,
+        .checksum       = GetReplayFileChecksum(file, (i32)footerOffset),
+        .magic          = REPLAY_FILE_MAGIC
+    };
+
+    b32 didWrite = EngineWriteEntireFile(path, file, (i32)size);
+    EngineFree(file);
+
+    return didWrite;
+}
+
+// Playback //
+
+// Everything in the file has to point inside it and make sense, the playback code takes it at its word after this
+static b32 IsReplayFileGood(u8* file, i32 size) {
+    if (size < AlignReplaySize(sizeof(replay_header)) + (i32)sizeof(replay_footer)) {
+        return false;
+    }
+
+    replay_header* header = (replay_header*)file;
+    replay_footer* footer = (replay_footer*)(file + size - sizeof(replay_footer));
+    i32 footerOffset = size - sizeof(replay_footer);
+    if (header->magic != REPLAY_FILE_MAGIC || header->version != REPLAY_FILE_VERSION || footer->magic != REPLAY_FILE_MAGIC) {
+        return false;
+    }
+    if (footer->checksum != GetReplayFileChecksum(file, footerOffset)) {
+        return false;
+    }
+
+    if (header->boardWidth < 4 || header->boardWidth > REPLAY_MAX_BOARD_SIZE || header->boardHeight < BOARD_HEIGHT || header->boardHeight > REPLAY_MAX_BOARD_SIZE) {
+        return false;
+    }
+
+    u64 inputsEnd = AlignReplaySize(sizeof(replay_header)) + (u64)header->inputsCount * sizeof(replay_input);
+    if (footer->keyframesCount == 0 || inputsEnd > footer->indexOffset || (u64)footer->indexOffset + (u64)footer->keyframesCount * sizeof(replay_keyframe) != (u64)footerOffset) {
+        return false;
+    }
+
+    b32 isBoardInGame = header->boardWidth == BOARD_WIDTH && header->boardHeight == BOARD_HEIGHT;
+    replay_keyframe* keyframes = (replay_keyframe*)(file + footer->indexOffset);
+    for (u32 i = 0; i < footer->keyframesCount; ++i) {
+        replay_keyframe* keyframe = &keyframes[i];
+        if (keyframe->offset < inputsEnd || keyframe->offset % 8 != 0 || keyframe->size < sizeof(replay_keyframe_data) || (u64)keyframe->offset + keyframe->size > footer->indexOffset) {
+            return false;
+        }
+        if (keyframe->firstInput > header->inputsCount || keyframe->tick > header->ticksCount || (i > 0 && keyframe->tick < keyframes[i - 1].tick)) {
+            return false;
+        }
+
+        replay_keyframe_data* data = (replay_keyframe_data*)(file + keyframe->offset);
+        if (data->game.tickCount != keyframe->tick || data->rowsCount < 0 || data->rowsCount > header->boardHeight || (isBoardInGame && data->rowsCount != 0)) {
+            return false;
+        }
+        if (sizeof(replay_keyframe_data) + (u64)data->rowsCount * header->boardWidth > keyframe->size) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void LoadReplayKeyframe(replay_t* replay, i32 index) {
+    replay_keyframe* keyframe = &replay->keyframes[index];
+    replay_keyframe_data* data = (replay_keyframe_data*)(replay->file + keyframe->offset);
+    board_t* board = &replay->board;
+
+    if (replay->isBoardInGame) {
+        RestoreGameState(&replay->game, board, &data->game);
+    }
+    else {
+        memcpy(&replay->game, &data->game, sizeof(replay->game));
+
+        // Only the rows that are filled now or in the keyframe can need changing. Clearing all of a big board would
+        // cost more than the rest of the seek
+        i32 rowsCount = Max(board->stackHeight, data->rowsCount);
+        u8* rows = (u8*)(data + 1);
+        for (i32 y = 0; y < rowsCount; ++y) {
+            for (i32 x = 0; x < board->width; ++x) {
+                replay->row[x] = y < data->rowsCount ? rows[y * board->width + x] : tetromino_type_empty;
+            }
+            SetBoardRow(board, y, replay->row);
+        }
+        RecalculateBoardHeights(board, data->rowsCount);
+    }
+
+    replay->nextInput = keyframe->firstInput;
+    SetReplayKeys(&replay->input, keyframe->firstInput > 0 ? replay->inputs[keyframe->firstInput - 1].keys : 0);
+    replay->nextKeyframe = index + 1;
+}
+
+// Returns false if there is no file or it isn't a good one. The board goes where x, y and tileSize say, the same as
+// for InitBoard
+b32 OpenReplay(replay_t* replay, const char* path, i32 x, i32 y, i32 tileSize) {
+    memset(replay, 0, sizeof(*replay));
+
+    i32 size = 0;
+    u8* file = EngineReadEntireFile((char*)path, &size);
+    if (!file) {
+        return false;
+    }
+
+    if (!IsReplayFileGood(file, size)) {
+        EngineFree(file);
+        return false;
+    }
+
+    replay_footer* footer = (replay_footer*)(file + size - sizeof(replay_footer));
+    replay->file = file;
+    replay->fileSize = size;
+    replay->header = (replay_header*)file;
+    replay->inputs = (replay_input*)(file + AlignReplaySize(sizeof(replay_header)));
+    replay->keyframes = (replay_keyframe*)(file + footer->indexOffset);
+    replay->keyframesCount = footer->keyframesCount;
+
+    i32 width = replay->header->boardWidth;
+    i32 height = replay->header->boardHeight;
+    if (width == BOARD_WIDTH && height == BOARD_HEIGHT) {
+        replay->board = InitBoardInMemory(width, height, replay->game.boardMemory, x, y, tileSize);
+        replay->isBoardInGame = true;
+    }
+    else {
+        replay->board = InitBoard(width, height, x, y, tileSize);
+        replay->row = EngineAllocate(width * sizeof(tetromino_type), memory_tag_game);
+    }
+
+    SeekReplay(replay, 0);
+
+    return true;
+}
+
+void CloseReplay(replay_t* replay) {
+    if (!replay->isBoardInGame) {
+        FreeBoard(&replay->board);
+        EngineFree(replay->row);
+    }
+    EngineFree(replay->file);
+    memset(replay, 0, sizeof(*replay));
+}
+
+// Plays one tick, adding what happened to events. Returns false at the end of the replay. events can be 0
+b32 StepReplay(replay_t* replay, game_events* events) {
+    if (replay->game.tickCount >= replay->header->ticksCount) {
+        return false;
+    }
+
+    if (replay->nextInput < (i32)replay->header->inputsCount && replay->inputs[replay->nextInput].tick == replay->game.tickCount + 1) {
+        SetReplayKeys(&replay->input, replay->inputs[replay->nextInput].keys);
+        ++replay->nextInput;
+    }
+
+    UpdateGameState(&replay->game, &replay->board, &replay->input, events);
+
+    while (replay->nextKeyframe < replay->keyframesCount && replay->keyframes[replay->nextKeyframe].tick == replay->game.tickCount) {
+        LoadReplayKeyframe(replay, replay->nextKeyframe);
+    }
+
+    return true;
+}
+
+// Goes to just after the given tick, or as close as the replay has
+void SeekReplay(replay_t* replay, u32 tick) {
+    tick = Clamp(tick, replay->keyframes[0].tick, replay->header->ticksCount);
+
+    // The last keyframe at or before tick
+    i32 low = 0;
+    i32 high = replay->keyframesCount - 1;
+    while (low < high) {
+        i32 middle = (low + high + 1) / 2;
+        if (replay->keyframes[middle].tick <= tick) {
+            low = middle;
+        }
+        else {
+            high = middle - 1;
+        }
+    }
+
+    // If we are already past it and not past tick, playing on from here gets there sooner
+    b32 canPlayOn = replay->nextKeyframe > low && replay->game.tickCount <= tick;
+    if (!canPlayOn) {
+        LoadReplayKeyframe(replay, low);
+    }
+
+    while (replay->game.tickCount < tick && StepReplay(replay, 0)) {
+    }
+}
+
+// Of what the game is, rather than how it happens to be laid out in memory, so it is the same however we got here
+u32 GetReplayChecksum(replay_t* replay) {
+    game_state* game = &replay->game;
+    board_t* board = &replay->board;
+
+    u32 hash = GetReplayFileChecksum((u8*)&game->bag, sizeof(game->bag));
+    hash ^= GetReplayFileChecksum((u8*)&game->current, sizeof(*game) - offsetof(game_state, current)) * 31;
+    for (i32 y = 0; y < board->stackHeight; ++y) {
+        hash = hash * 31 + GetReplayFileChecksum((u8*)GetBoardRow(board, y), board->width * sizeof(tetromino_type));
+    }
+
+    return hash ^ (u32)board->hash ^ board->stackHeight;
+}
\ No newline at end of file
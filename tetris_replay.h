@@ -0,0 +1,114 @@
+#ifndef TETRIS_REPLAY_H
+#define TETRIS_REPLAY_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_rules.h"
+#include "tetris_game_state.h"
+
+
+#define REPLAY_FILE_MAGIC     0x50525354 // "TSRP"
+#define REPLAY_FILE_VERSION   2
+#define REPLAY_KEYFRAME_TICKS (5 * TICKS_PER_SECOND) // Seeking never has to simulate more than this many ticks, on normal boards
+#define REPLAY_KEYFRAME_BYTES_PER_TICK 64 // Keyframes of big boards are big, so they come less often, about this many bytes of them per tick
+#define REPLAY_MAX_ARRAY_SIZE (1 << 29) // In bytes, for each of the recorder's arrays. Past it the recording is given up on
+#define REPLAY_KEYS_COUNT     8 // The keys the game looks at, the first ones of keyboard_state.keys
+
+// The keys as of a tick. Only ticks where they differ from the tick before get one
+typedef struct replay_input {
+    u32 tick; // tickCount after it
+    u16 keys; // Bit i is whether keys[i] is down, bit i + 8 whether it changed state
+    u16 padding;
+} replay_input;
+
+// Where a keyframe is in the file
+typedef struct replay_keyframe {
+    u32 tick;       // tickCount of its game
+    u32 firstInput; // The first input after it
+    u32 offset;
+    u32 size;
+} replay_keyframe;
+
+// A keyframe in the file. Normal boards are all in game. Bigger ones have their rows after it, bottom row first, one
+// byte per tile, up to the stack's height
+typedef struct replay_keyframe_data {
+    game_state game;
+    i32 rowsCount;
+    i32 padding;
+} replay_keyframe_data;
+
+/*
+    The file is a replay_header, the inputs, the keyframes, the index of keyframes and a replay_footer, in that order.
+    Everything is 8 byte aligned
+*/
+typedef struct replay_header {
+    u32 magic;
+    u32 version;
+    i32 boardWidth;
+    i32 boardHeight;
+    u32 ticksCount;
+    u32 inputsCount;
+} replay_header;
+
+typedef struct replay_footer {
+    u32 indexOffset;
+    u32 keyframesCount;
+    u32 checksum; // Of everything before the footer
+    u32 magic;
+} replay_footer;
+
+// A game being recorded. Everything is kept in memory until WriteReplayFile
+typedef struct replay_recorder {
+    i32 boardWidth;
+    i32 boardHeight;
+    u32 ticksCount;
+    u16 lastKeys;
+    u32 lastKeyframeTick;
+    u32 keyframeTicks; // From the last keyframe to the next one. REPLAY_KEYFRAME_TICKS, or more if the last one was big
+    b32 isTooBig;      // Something ran into REPLAY_MAX_ARRAY_SIZE. Nothing more gets recorded and WriteReplayFile fails
+
+    replay_input* inputs;
+    i32 inputsCount;
+    i64 inputsCapacity;
+
+    u8* keyframes; // replay_keyframe_data plus rows, back to back
+    i64 keyframesSize;
+    i64 keyframesCapacity;
+
+    replay_keyframe* index; // Offsets are into keyframes until the file gets written
+    i32 indexCount;
+    i64 indexCapacity;
+} replay_recorder;
+
+// A replay file being played back
+typedef struct replay_t {
+    u8* file;
+    i32 fileSize;
+    replay_header* header;
+    replay_input* inputs;
+    replay_keyframe* keyframes;
+    i32 keyframesCount;
+
+    game_state game;
+    board_t board;         // Uses game's tiles if it is the normal size
+    b32 isBoardInGame;
+    tetromino_type* row;   // For loading big boards a row at a time
+    keyboard_state input;
+    i32 nextInput;
+    i32 nextKeyframe;      // The first one past where we are
+    b32 isOver;
+} replay_t;
+
+extern void InitReplayRecorder(replay_recorder* recorder, game_state* game, board_t* board);
+extern void FreeReplayRecorder(replay_recorder* recorder);
+extern void RecordReplayTick(replay_recorder* recorder, game_state* game, board_t* board, keyboard_state* input);
+extern void AddReplayKeyframe(replay_recorder* recorder, game_state* game, board_t* board);
+extern b32 WriteReplayFile(replay_recorder* recorder, const char* path);
+
+extern b32 OpenReplay(replay_t* replay, const char* path, i32 x, i32 y, i32 tileSize);
+extern void CloseReplay(replay_t* replay);
+extern b32 StepReplay(replay_t* replay, game_events* events);
+extern void SeekReplay(replay_t* replay, u32 tick);
+extern u32 GetReplayChecksum(replay_t* replay);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "tetris_rules.h"
+
+// The rules that everything simulating a game has to agree on. The game itself is in tetris.c
+
+
+// Seconds per row at the given level
+f32 GetCurrentGravityInSeconds(i32 level) {
+    f32 gravityInSeconds = 1.0f;
+    f32 base = 0.8f - (level - 1) * 0.007f;
+    for (i32 i = 0; i < level - 1; ++i) {
+        gravityInSeconds *= base;
+    }
+
+    return gravityInSeconds;
+}
+
+i32 GetLineClearScore(i32 lineClearCount, i32 level) {
+    static const i32 LINE_CLEAR_SCORES[5] = { 0, SCORE_SINGLE, SCORE_DOUBLE, SCORE_TRIPLE, SCORE_TETRIS };
+
+    return LINE_CLEAR_SCORES[Clamp(lineClearCount, 0, 4)] * level;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef TETRIS_RULES_H
+#define TETRIS_RULES_H
+
+#include "tetris.h"
+
+
+// The game runs in fixed steps of this many per second, however fast it gets drawn
+#define TICKS_PER_SECOND 1000
+#define SECONDS_PER_TICK (1.0f / TICKS_PER_SECOND)
+#define SecondsToTicks(seconds) ((i32)((seconds) * TICKS_PER_SECOND + 0.5f))
+
+#define SOFT_DROP       0.033f // Seconds per row while soft dropping, unless gravity is already faster
+#define LOCK_DELAY      0.5f
+#define AUTO_MOVE_DELAY 0.2f   // Holding left or right starts repeating after this long
+#define AUTO_MOVE       0.05f  // Between repeats
+
+#define LINES_PER_LEVEL 10
+
+#define SCORE_SINGLE    40
+#define SCORE_DOUBLE    100
+#define SCORE_TRIPLE    300
+#define SCORE_TETRIS    1200
+#define SCORE_SOFT_DROP 1 // Per row
+#define SCORE_HARD_DROP 2 // Same
+
+extern f32 GetCurrentGravityInSeconds(i32 level);
+extern i32 GetLineClearScore(i32 lineClearCount, i32 level);
+
+#endif
\ No newline at end of file
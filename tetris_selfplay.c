@@ -0,0 +1,190 @@
+#include "tetris_selfplay.h"
+#include "tetris_rules.h"
+
+/*
+    Games played by the bot without a window, as fast as it can think. The rules are the game's own (tetris_rules.h and
+    the board code), ticked at TICKS_PER_SECOND like UpdateScene1Tick: the bot's inputs go in one every inputDelay
+    seconds while gravity and the lock delay keep going, so at high levels it can't always get where it wanted to.
+
+    The pieces come from a sequence made up front, so every game played on the same sequence gets the same pieces no
+    matter which thread plays it or when.
+*/
+
+
+// What a bag would deal with the given random state
+void GenerateBagSequence(random_state random, tetromino_type* pieces, i32 piecesCount) {
+    tetromino_bag bag;
+    InitBag(&bag, random);
+    for (i32 i = 0; i < piecesCount; ++i) {
+        pieces[i] = GetNextTetrominoFromBag(&bag);
+    }
+}
+
+// Where the player wants the piece to go, as inputs. Just a hard drop if the move generator can't find it
+static i32 GetSelfPlayInputs(move_generator* generator, board_t* board, tetromino_t* current, self_play_decision* decision, move_input* outInputs) {
+    if (!decision->hasPlacement) {
+        i32 inputsCount = Clamp(decision->inputsCount, 0, MOVE_GEN_MAX_PATH);
+        for (i32 i = 0; i < inputsCount; ++i) {
+            outInputs[i] = decision->inputs[i];
+        }
+        return inputsCount;
+    }
+
+    i32 placementsCount = GeneratePlacements(generator, board, current);
+    for (i32 i = 0; i < placementsCount; ++i) {
+        if (DoTetrominoesCoverSameTiles(&generator->placements[i].tetromino, &decision->placement)) {
+            i32 inputsCount = GetPlacementPath(generator, i, outInputs, MOVE_GEN_MAX_PATH);
+            if (inputsCount > 0) {
+                return inputsCount;
+            }
+        }
+    }
+
+    outInputs[0] = move_input_hard_drop;
+    return 1;
+}
+
+static b32 DecideWithBot(void* player, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, const self_play_result* progress, self_play_decision* outDecision) {
+    bot_move move;
+    if (!FindBotMove(player, board, current, next, hold, canHold, &move)) {
+        return false;
+    }
+
+    outDecision->useHold = move.useHold;
+    outDecision->hasPlacement = true;
+    outDecision->placement = move.placement;
+    return true;
+}
+
+// The bot has to be single threaded (InitSingleThreadedBot). The game ends when it tops out or runs out of pieces
+self_play_result PlaySelfPlayGame(bot_t* bot, const tetromino_type* pieces, i32 piecesCount, f32 inputDelay) {
+    return PlaySelfPlayGameWith(DecideWithBot, bot, &bot->generators[0], pieces, piecesCount, inputDelay); // The generator is free while the bot isn't searching
+}
+
+// Same, with anything that can decide on moves. The generator turns placements into inputs
+self_play_result PlaySelfPlayGameWith(self_play_decide decide, void* player, move_generator* generator, const tetromino_type* pieces, i32 piecesCount, f32 inputDelay) {
+    self_play_result result = { .level = 1 };
+    if (piecesCount < 4) {
+        return result;
+    }
+
+    board_t board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 0, 0, 0);
+
+    tetromino_type next[3] = { pieces[1], pieces[2], pieces[3] };
+    tetromino_type hold = tetromino_type_empty;
+    i32 piecesUsed = 4;
+    tetromino_t current = InitTetromino(pieces[0], 0, SPAWN_X, SPAWN_Y);
+
+    i32 inputTicks = Max(SecondsToTicks(inputDelay), 1);
+    move_input inputs[MOVE_GEN_MAX_PATH];
+
+    for (;;) {
+        if (!IsTetrominoPosValid(&board, &current)) {
+            result.didTopOut = true;
+            break;
+        }
+
+        self_play_decision decision = { 0 };
+        if (!decide(player, &board, &current, next, hold, true, &result, &decision)) {
+            result.didTopOut = true;
+            break;
+        }
+
+        if (decision.useHold) {
+            tetromino_type currentType = current.type;
+            if (hold == tetromino_type_empty) {
+                if (piecesUsed >= piecesCount) {
+                    break;
+                }
+                current = InitTetromino(next[0], 0, SPAWN_X, SPAWN_Y);
+                next[0] = next[1];
+                next[1] = next[2];
+                next[2] = pieces[piecesUsed++];
+            }
+            else {
+                current = InitTetromino(hold, 0, SPAWN_X, SPAWN_Y);
+            }
+            hold = currentType;
+
+            if (!IsTetrominoPosValid(&board, &current)) {
+                result.didTopOut = true;
+                break;
+            }
+        }
+
+        i32 inputsCount = GetSelfPlayInputs(generator, &board, &current, &decision, inputs);
+        i32 inputIndex = 0;
+
+        // Same as UpdateScene1Tick, with the inputs coming from the path instead of the keyboard
+        i32 gravityInTicks = SecondsToTicks(GetCurrentGravityInSeconds(result.level));
+        i32 timerInput = 0;
+        i32 timerFall = 0;
+        i32 timerLockDelay = 0;
+        for (b32 didLock = false; !didLock;) {
+            b32 didHardDrop = false;
+
+            if (++timerInput >= inputTicks && inputIndex < inputsCount) {
+                timerInput = 0;
+                switch (inputs[inputIndex++]) {
+                    case move_input_left: {
+                        TryMoveTetromino(&board, &current, -1, 0);
+                    } break;
+                    case move_input_right: {
+                        TryMoveTetromino(&board, &current, 1, 0);
+                    } break;
+                    case move_input_rotate_cw: {
+                        TryRotateTetromino(&board, &current, 1);
+                    } break;
+                    case move_input_rotate_ccw: {
+                        TryRotateTetromino(&board, &current, -1);
+                    } break;
+                    case move_input_soft_drop: {
+                        if (TryMoveTetromino(&board, &current, 0, -1)) {
+                            result.score += SCORE_SOFT_DROP * result.level;
+                            timerFall = 0;
+                        }
+                    } break;
+                    case move_input_hard_drop: {
+                        didHardDrop = true;
+                        i32 dropDistance = GetDropDistance(&board, &current);
+                        current.y -= dropDistance;
+                        result.score += dropDistance * SCORE_HARD_DROP * result.level;
+                    } break;
+                }
+            }
+
+            ++timerFall;
+            if (timerFall >= gravityInTicks || didHardDrop || timerLockDelay > 0) {
+                timerFall = 0;
+
+                if (TryMoveTetromino(&board, &current, 0, -1)) {
+                    timerLockDelay = 0;
+                }
+                else if (++timerLockDelay >= SecondsToTicks(LOCK_DELAY) || didHardDrop) {
+                    didLock = true;
+                }
+            }
+        }
+
+        PlaceTetromino(&board, &current);
+        i32 lineClearCount = ProcessLineClears(&board, &current);
+        result.lines += lineClearCount;
+        result.score += GetLineClearScore(lineClearCount, result.level);
+        if (result.lines >= result.level * LINES_PER_LEVEL) {
+            ++result.level;
+        }
+        ++result.pieces;
+
+        if (piecesUsed >= piecesCount) {
+            break;
+        }
+        current = InitTetromino(next[0], 0, SPAWN_X, SPAWN_Y);
+        next[0] = next[1];
+        next[1] = next[2];
+        next[2] = pieces[piecesUsed++];
+    }
+
+    FreeBoard(&board);
+
+    return result;
+}
\ No newline at end of file
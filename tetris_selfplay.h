@@ -0,0 +1,35 @@
+#ifndef TETRIS_SELFPLAY_H
+#define TETRIS_SELFPLAY_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_bot.h"
+
+
+#define SELF_PLAY_INPUT_DELAY 0.05f // Seconds between the bot's inputs, so gravity gets a say in where pieces end up
+
+typedef struct self_play_result {
+    i32 score;
+    i32 lines;
+    i32 level;
+    i32 pieces;     // Locked
+    b32 didTopOut;  // Otherwise it ran out of pieces
+} self_play_result;
+
+// What a player wants done with the current piece: where it should end up, or the exact inputs to get it somewhere
+typedef struct self_play_decision {
+    b32 useHold;
+    b32 hasPlacement; // Otherwise the inputs get pressed as they are
+    tetromino_t placement;
+    move_input inputs[MOVE_GEN_MAX_PATH];
+    i32 inputsCount;
+} self_play_decision;
+
+// Returns false to give up, which counts as topping out. next holds BOT_PREVIEW_COUNT pieces, and progress is the game so far
+typedef b32 (*self_play_decide)(void* player, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, const self_play_result* progress, self_play_decision* outDecision);
+
+extern void GenerateBagSequence(random_state random, tetromino_type* pieces, i32 piecesCount);
+extern self_play_result PlaySelfPlayGame(bot_t* bot, const tetromino_type* pieces, i32 piecesCount, f32 inputDelay);
+extern self_play_result PlaySelfPlayGameWith(self_play_decide decide, void* player, move_generator* generator, const tetromino_type* pieces, i32 piecesCount, f32 inputDelay);
+
+#endif
\ No newline at end of file
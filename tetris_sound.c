@@ -1,5 +1,7 @@
 #include "tetris_sound.h"
 
+#include <string.h>
+
 // http://soundfile.sapp.org/doc/WaveFormat/
 #pragma pack(push, 1)
 typedef struct wav_format {
@@ -22,9 +24,10 @@ typedef struct wav_format {
 } wav_format;
 #pragma pack(pop)
 
+// The samples are scene memory, so there's nothing to free. The file and the resampled samples only pass through scratch memory
 sound_buffer LoadWAV(const char* filePath) {
     i32 bytesRead;
-    void* contents = EngineReadEntireFile(filePath, &bytesRead);
+    void* contents = EngineReadEntireFileToScratch(filePath, &bytesRead);
     if (bytesRead == 0) {
         return (sound_buffer){ 0 };
     }
@@ -35,53 +38,61 @@ sound_buffer LoadWAV(const char* filePath) {
         (format.format[0] != 'W' || format.format[1] != 'A' || format.format[2] != 'V' || format.format[3] != 'E')     || // "WAVE"
         (format.audioFormat != 1)                                                                                      || // No compression
         (format.bitsPerSample != 16)                                                                                   || // Could probably solve this one
-        (format.numChannels >= 3))
+        (format.numChannels >= 3)                                                                                      ||
+        (44 + (i64)format.subchunk2Size > bytesRead))
     {
+        EngineFreeScratch(contents);
         return (sound_buffer){ 0 };
     }
 
-    sound_buffer result = { 
-        .samples = (u8*)contents + 44, // 44 is the size of the header before the data
-        .samplesCount = format.subchunk2Size / 2 // subchunk2Size is in bytes
-    };
+    i16* samples = (i16*)((u8*)contents + 44); // 44 is the size of the header before the data
+    i32 samplesCount = format.subchunk2Size / 2; // subchunk2Size is in bytes
 
     if (format.sampleRate != SOUND_SAMPLES_PER_SECOND) {
         f32 ratio = format.sampleRate / (f32)SOUND_SAMPLES_PER_SECOND;
 
-        result.samplesCount /= ratio;
-        i16* buffer = EngineAllocate(result.samplesCount * 2);
-        if (!buffer) {
+        i32 resampledCount = samplesCount / ratio;
+        i16* buffer = EngineAllocateScratch(resampledCount * 2);
+        if (!buffer || resampledCount == 0) {
+            EngineFreeScratch(contents);
             return (sound_buffer){ 0 };
         }
 
-        for (i32 i = 0; i < result.samplesCount - 1; ++i) {
+        for (i32 i = 0; i < resampledCount - 1; ++i) {
             f32 t = i * ratio;
             i32 index = (i32)t;
             t -= index;
 
-            buffer[i] = (1.0f - t) * result.samples[index] + t * result.samples[index + format.numChannels];
+            buffer[i] = (1.0f - t) * samples[index] + t * samples[index + format.numChannels];
         }
+        buffer[resampledCount - 1] = 0; // Nothing to interpolate towards
 
-        result.samples = buffer;
-        EngineFree(contents);
+        samples = buffer;
+        samplesCount = resampledCount;
     }
 
-    if (format.numChannels == 1) {
-        i16* buffer = EngineAllocate(result.samplesCount * 4);
-        if (!buffer) {
-            return (sound_buffer){ 0 };
-        }
+    b32 isMono = format.numChannels == 1;
 
-        for (i32 i = 0; i < result.samplesCount; ++i) {
-            buffer[2 * i]     = result.samples[i];
-            buffer[2 * i + 1] = result.samples[i];
-        }
+    sound_buffer result = {
+        .samples = EngineAllocateScene((isMono ? 2 : 1) * samplesCount * 2, memory_tag_audio),
+        .samplesCount = (isMono ? 2 : 1) * samplesCount
+    };
+    if (!result.samples) {
+        EngineFreeScratch(contents);
+        return (sound_buffer){ 0 };
+    }
 
-        EngineFree(result.samples);
-        result.samples = buffer;
-        result.samplesCount *= 2;
+    if (isMono) {
+        for (i32 i = 0; i < samplesCount; ++i) {
+            result.samples[2 * i]     = samples[i];
+            result.samples[2 * i + 1] = samples[i];
+        }
+    }
+    else {
+        memcpy(result.samples, samples, samplesCount * 2);
     }
 
+    EngineFreeScratch(contents); // The resampled samples came after it, so they go too
 
     return result;
 }
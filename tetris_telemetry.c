@@ -0,0 +1,433 @@
+#include "tetris_telemetry.h"
+#include "tetris_rules.h"
+
+#include <string.h>
+
+
+/*
+    Per piece stats, kept for good rather than just for the game.
+
+    The game puts pieces in a ring and never waits: it copies the piece in, and publishes it by bumping writeCount.
+    The flush thread takes everything between readCount and writeCount, appends it to the file as a block and then
+    bumps readCount, which is what frees those slots for the game again. Each count only ever gets written by one
+    side, so nothing has to be locked. The game wakes the thread up every TELEMETRY_FLUSH_COUNT pieces and at the end
+    of the game, so a piece costs the game a copy and an atomic exchange.
+
+    The file is append only, a block per flush, and stored by column rather than by piece: a block header with the
+    size of each column, then each column on its own. A query that needs the lines cleared only reads the block
+    headers and that column, and never touches the rest of the file. Within a column every value is stored as the difference from the one before, zigzagged
+    so small negative ones stay small, as a varint. Most columns barely change from piece to piece (the game id
+    doesn't change at all), so nearly everything ends up a byte. A block that got cut short by a crash ends the file
+    as far as reading goes.
+*/
+
+static inline u8* WriteTelemetryVarint(u8* at, u64 value) {
+    while (value >= 0x80) {
+        *at++ = (u8)value | 0x80;
+        value >>= 7;
+    }
+    *at++ = (u8)value;
+
+    return at;
+}
+
+// Returns 0 if the varint runs past end
+static inline const u8* ReadTelemetryVarint(const u8* at, const u8* end, u64* outValue) {
+    u64 value = 0;
+    for (i32 shift = 0; at < end && shift < 7 * TELEMETRY_MAX_VARINT; shift += 7) {
+        u8 byte = *at++;
+        value |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *outValue = value;
+            return at;
+        }
+    }
+
+    return 0;
+}
+
+static i64 GetTelemetryValue(telemetry_piece* piece, telemetry_column column) {
+    switch (column) {
+        case telemetry_column_game:        return piece->game;
+        case telemetry_column_tick:        return piece->tick;
+        case telemetry_column_spawn_ticks: return piece->spawnTicks;
+        case telemetry_column_x:           return piece->x;
+        case telemetry_column_y:           return piece->y;
+        case telemetry_column_type:        return piece->type;
+        case telemetry_column_rotation:    return piece->rotation;
+        case telemetry_column_lines:       return piece->lines;
+        case telemetry_column_inputs:      return piece->inputs;
+        case telemetry_column_level:       return piece->level;
+        default:                           return 0;
+    }
+}
+
+// Writing //
+
+// Only ever called from the flush thread
+static void FlushTelemetry(telemetry_t* telemetry) {
+    i32 read = telemetry->readCount;
+    i32 write = telemetry->writeCount; // Volatile reads have acquire semantics with MSVC on x86/x64
+
+    if (read == write) {
+        return;
+    }
+
+    telemetry_block_header* header = (telemetry_block_header*)telemetry->encoded;
+    *header = (telemetry_block_header){
+        .magic     = TELEMETRY_BLOCK_MAGIC,
+        .rowsCount = write - read
+    };
+
+    u8* at = (u8*)(header + 1);
+    for (i32 column = 0; column < telemetry_column_count; ++column) {
+        u8* columnStart = at;
+        i64 previous = 0;
+        for (i32 row = read; row != write; ++row) {
+            i64 value = GetTelemetryValue(&telemetry->ring[(u32)row % TELEMETRY_RING_SIZE], column);
+            i64 delta = value - previous;
+            previous = value;
+            at = WriteTelemetryVarint(at, ((u64)delta << 1) ^ (u64)(delta >> 63));
+        }
+        header->columnSizes[column] = (u32)(at - columnStart);
+    }
+
+    if (!EngineAppendToFile(telemetry->path, telemetry->encoded, (i32)(at - telemetry->encoded))) {
+        telemetry->didFailToWrite = true;
+    }
+
+    EngineAtomicExchange(&telemetry->readCount, write);
+}
+
+static void TelemetryThread(void* data) {
+    telemetry_t* telemetry = data;
+
+    for (;;) {
+        EngineWaitForSignal(telemetry->wakeUp);
+
+        // Looked at before flushing, so everything recorded before FreeTelemetry makes it to the file
+        b32 shouldQuit = telemetry->shouldQuit;
+        FlushTelemetry(telemetry);
+        if (shouldQuit) {
+            break;
+        }
+    }
+}
+
+// Pieces get appended to the file at path. Returns false if the thread couldn't be started, and then there is nothing to free
+b32 InitTelemetry(telemetry_t* telemetry, const char* path) {
+    memset(telemetry, 0, sizeof(*telemetry));
+
+    strncpy(telemetry->path, path, ArraySize(telemetry->path) - 1);
+    telemetry->encoded = EngineAllocate(sizeof(telemetry_block_header) + TELEMETRY_RING_SIZE * telemetry_column_count * TELEMETRY_MAX_VARINT, memory_tag_telemetry);
+
+    telemetry->wakeUp = EngineCreateSignal();
+    if (telemetry->wakeUp) {
+        telemetry->thread = EngineStartThread(TelemetryThread, telemetry);
+    }
+    if (!telemetry->thread) {
+        FreeTelemetry(telemetry);
+        return false;
+    }
+
+    return true;
+}
+
+// Waits for whatever is left in the ring to be written
+void FreeTelemetry(telemetry_t* telemetry) {
+    if (telemetry->thread) {
+        EngineAtomicExchange(&telemetry->shouldQuit, true);
+        EngineRaiseSignal(telemetry->wakeUp);
+        EngineJoinThread(telemetry->thread);
+    }
+    EngineFreeSignal(telemetry->wakeUp);
+    EngineFree(telemetry->encoded);
+
+    memset(telemetry, 0, sizeof(*telemetry));
+}
+
+// Never waits. If the ring is full the piece is lost
+void RecordTelemetryPiece(telemetry_t* telemetry, telemetry_piece* piece) {
+    i32 write = telemetry->writeCount; // Only we write it
+    if (write - telemetry->readCount >= TELEMETRY_RING_SIZE) {
+        ++telemetry->droppedCount;
+        return;
+    }
+
+    telemetry->ring[(u32)write % TELEMETRY_RING_SIZE] = *piece;
+    EngineAtomicExchange(&telemetry->writeCount, write + 1);
+
+    if (++telemetry->unflushedCount >= TELEMETRY_FLUSH_COUNT) {
+        telemetry->unflushedCount = 0;
+        EngineRaiseSignal(telemetry->wakeUp);
+    }
+}
+
+// Reading //
+
+// The biggest block the flush thread writes
+#define TELEMETRY_MAX_BLOCK_SIZE (sizeof(telemetry_block_header) + TELEMETRY_RING_SIZE * telemetry_column_count * TELEMETRY_MAX_VARINT)
+
+// Reads every block header, and nothing else. Returns how many good ones there are, at the front of *outHeaders
+static i32 ReadTelemetryHeaders(engine_file file, i64 fileSize, telemetry_block_header** outHeaders, telemetry_table* table) {
+    telemetry_block_header* headers = 0;
+    i32 headersCount = 0;
+    i32 headersCapacity = 0;
+
+    i64 at = 0;
+    while (at + (i64)sizeof(telemetry_block_header) <= fileSize) {
+        telemetry_block_header header;
+        if (!EngineReadFromFile(file, at, &header, sizeof(header))) {
+            break;
+        }
+        table->bytesReadCount += sizeof(header);
+
+        i64 blockSize = sizeof(telemetry_block_header);
+        for (i32 column = 0; column < telemetry_column_count; ++column) {
+            blockSize += header.columnSizes[column];
+        }
+        if (header.magic != TELEMETRY_BLOCK_MAGIC || header.rowsCount > TELEMETRY_RING_SIZE || blockSize > TELEMETRY_MAX_BLOCK_SIZE || blockSize > fileSize - at) {
+            break;
+        }
+
+        if (headersCount == headersCapacity) {
+            headersCapacity = Max(headersCapacity * 2, 64);
+            telemetry_block_header* newHeaders = EngineAllocate(headersCapacity * sizeof(telemetry_block_header), memory_tag_telemetry);
+            if (headers) {
+                memcpy(newHeaders, headers, headersCount * sizeof(telemetry_block_header));
+            }
+            EngineFree(headers);
+            headers = newHeaders;
+        }
+        headers[headersCount++] = header;
+
+        at += blockSize;
+    }
+
+    *outHeaders = headers;
+    return headersCount;
+}
+
+// Returns false if there is no file. A file with nothing good in it is just an empty table
+b32 ReadTelemetryTable(const char* path, u32 columnMask, telemetry_table* outTable) {
+    memset(outTable, 0, sizeof(*outTable));
+
+    i64 size = 0;
+    engine_file file = EngineOpenFile(path, &size);
+    if (!file) {
+        return false;
+    }
+    outTable->bytesCount = size;
+
+    // The headers say where every column is, and how many rows there are so the columns can be allocated once
+    telemetry_block_header* headers;
+    outTable->blocksCount = ReadTelemetryHeaders(file, size, &headers, outTable);
+    for (i32 block = 0; block < outTable->blocksCount; ++block) {
+        outTable->rowsCount += headers[block].rowsCount;
+    }
+
+    for (i32 column = 0; column < telemetry_column_count; ++column) {
+        if (columnMask & TELEMETRY_COLUMN_BIT(column)) {
+            outTable->columns[column] = EngineAllocate(Max(outTable->rowsCount, 1) * sizeof(i32), memory_tag_telemetry);
+        }
+    }
+
+    u8* buffer = EngineAllocate(TELEMETRY_MAX_BLOCK_SIZE, memory_tag_telemetry);
+    i32 firstRow = 0;
+    i64 blockAt = 0;
+    for (i32 block = 0; block < outTable->blocksCount; ++block) {
+        telemetry_block_header* header = &headers[block];
+
+        // Columns next to each other that are both wanted get read together
+        i64 columnAt = blockAt + sizeof(telemetry_block_header);
+        for (i32 column = 0; column < telemetry_column_count; ) {
+            if (!outTable->columns[column]) {
+                columnAt += header->columnSizes[column++];
+                continue;
+            }
+
+            i32 runEnd = column;
+            i32 runSize = 0;
+            while (runEnd < telemetry_column_count && outTable->columns[runEnd]) {
+                runSize += header->columnSizes[runEnd++];
+            }
+            if (!EngineReadFromFile(file, columnAt, buffer, runSize)) {
+                memset(buffer, 0, runSize); // Reads as garbage, the same as a damaged column
+            }
+            outTable->bytesReadCount += runSize;
+
+            const u8* columnStart = buffer;
+            for (; column < runEnd; ++column) {
+                const u8* columnEnd = columnStart + header->columnSizes[column];
+
+                i32* values = outTable->columns[column];
+                const u8* read = columnStart;
+                i64 value = 0;
+                for (u32 row = 0; row < header->rowsCount; ++row) {
+                    u64 zigzag = 0;
+                    read = read ? ReadTelemetryVarint(read, columnEnd, &zigzag) : 0;
+                    value += (i64)(zigzag >> 1) ^ -(i64)(zigzag & 1);
+                    values[firstRow + row] = (i32)value; // A damaged column just reads as garbage from there on
+                }
+
+                columnStart = columnEnd;
+            }
+            columnAt += runSize;
+        }
+
+        firstRow += header->rowsCount;
+        blockAt = columnAt;
+    }
+
+    EngineFree(buffer);
+    EngineFree(headers);
+    EngineCloseFile(file);
+
+    return true;
+}
+
+void FreeTelemetryTable(telemetry_table* table) {
+    for (i32 column = 0; column < telemetry_column_count; ++column) {
+        EngineFree(table->columns[column]);
+    }
+    memset(table, 0, sizeof(*table));
+}
+
+// Pieces over time played, which is up to the last lock of each game. Needs TELEMETRY_PPS_COLUMNS
+f64 GetTelemetryPiecesPerSecond(telemetry_table* table) {
+    i32* games = table->columns[telemetry_column_game];
+    i32* ticks = table->columns[telemetry_column_tick];
+
+    i64 ticksCount = 0;
+    for (i32 row = 0; row < table->rowsCount; ++row) {
+        b32 isLastOfGame = row == table->rowsCount - 1 || games[row + 1] != games[row];
+        if (isLastOfGame) {
+            ticksCount += (u32)ticks[row];
+        }
+    }
+
+    return ticksCount > 0 ? table->rowsCount / (ticksCount * (f64)SECONDS_PER_TICK) : 0.0;
+}
+
+// Key presses more than the fewest that would have done it on an empty board, per piece. Needs
+// TELEMETRY_FINESSE_COLUMNS
+f64 GetTelemetryFinesseErrors(telemetry_table* table) {
+    i32* types = table->columns[telemetry_column_type];
+    i32* rotations = table->columns[telemetry_column_rotation];
+    i32* xs = table->columns[telemetry_column_x];
+    i32* inputs = table->columns[telemetry_column_inputs];
+
+    i64 errorsCount = 0;
+    i64 piecesCount = 0;
+    for (i32 row = 0; row < table->rowsCount; ++row) {
+        i32 fewest = GetFinesseInputs(types[row], rotations[row], xs[row]);
+        if (fewest > 0) {
+            errorsCount += Max(inputs[row] - fewest, 0);
+            ++piecesCount;
+        }
+    }
+
+    return piecesCount > 0 ? (f64)errorsCount / piecesCount : 0.0;
+}
+
+// Needs TELEMETRY_CLEARS_COLUMNS
+telemetry_clears GetTelemetryClears(telemetry_table* table) {
+    i32* lines = table->columns[telemetry_column_lines];
+
+    telemetry_clears clears = { .piecesCount = table->rowsCount };
+    for (i32 row = 0; row < table->rowsCount; ++row) {
+        ++clears.counts[Clamp(lines[row], 0, 4)];
+    }
+
+    return clears;
+}
+
+/*
+    Finesse: the fewest key presses that get a piece from where it spawns to a column and rotation on an empty board.
+    Holding left or right all the way to the wall is one press, so a column next to the wall is two: hold, then tap
+    back. Turning twice is two presses since there is no key for it. The hard drop counts as one. Tucks and spins
+    can't be done in this few, so they show up as errors, the same as in every other finesse trainer.
+
+    What counts is where the piece ends up, not which rotation got it there. O looks the same whichever way it is
+    turned, and so do I, S and Z turned twice (one column over for I), so every rotation and column gets the fewest
+    presses of all the ones that cover the same tiles once dropped
+*/
+
+#define FINESSE_MIN_X   (-3) // Tetrominoes are 4x4, so they can hang up to 3 tiles off the left edge
+#define FINESSE_X_COUNT (BOARD_WIDTH + 6)
+
+static i8 g_finesseInputs[8][4][FINESSE_X_COUNT];
+static b32 g_isFinesseReady;
+
+static void InitFinesseInputs(void) {
+    memset(g_finesseInputs, -1, sizeof(g_finesseInputs));
+
+    board_t board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 0, 0, 0);
+    for (i32 type = tetromino_type_I; type <= tetromino_type_L; ++type) {
+        i8 inputs[4][FINESSE_X_COUNT];
+        tetromino_t dropped[4][FINESSE_X_COUNT];
+        memset(inputs, -1, sizeof(inputs));
+
+        for (i32 rotation = 0; rotation < 4; ++rotation) {
+            tetromino_t tetromino = SpawnTetromino(&board, type);
+            i32 turns = rotation == 2 ? 2 : rotation != 0;
+            for (i32 i = 0; i < turns; ++i) {
+                TryRotateTetromino(&board, &tetromino, rotation == 3 ? -1 : 1);
+            }
+
+            i32 startX = tetromino.x;
+            tetromino_t left = tetromino;
+            while (TryMoveTetromino(&board, &left, -1, 0)) {
+            }
+            tetromino_t right = tetromino;
+            while (TryMoveTetromino(&board, &right, 1, 0)) {
+            }
+
+            for (i32 x = left.x; x <= right.x; ++x) {
+                i32 moves = Min(Abs(x - startX), Min(1 + x - left.x, 1 + right.x - x));
+                if (x - FINESSE_MIN_X >= 0 && x - FINESSE_MIN_X < FINESSE_X_COUNT) {
+                    inputs[rotation][x - FINESSE_MIN_X] = (i8)(turns + moves + 1);
+
+                    tetromino_t* drop = &dropped[rotation][x - FINESSE_MIN_X];
+                    *drop = tetromino;
+                    drop->x = x;
+                    drop->y -= GetDropDistance(&board, drop);
+                }
+            }
+        }
+
+        for (i32 rotation = 0; rotation < 4; ++rotation) {
+            for (i32 x = 0; x < FINESSE_X_COUNT; ++x) {
+                if (inputs[rotation][x] < 0) {
+                    continue;
+                }
+
+                i8 fewest = inputs[rotation][x];
+                for (i32 otherRotation = 0; otherRotation < 4; ++otherRotation) {
+                    for (i32 otherX = 0; otherX < FINESSE_X_COUNT; ++otherX) {
+                        if (inputs[otherRotation][otherX] >= 0 && inputs[otherRotation][otherX] < fewest && DoTetrominoesCoverSameTiles(&dropped[rotation][x], &dropped[otherRotation][otherX])) {
+                            fewest = inputs[otherRotation][otherX];
+                        }
+                    }
+                }
+                g_finesseInputs[type][rotation][x] = fewest;
+            }
+        }
+    }
+    FreeBoard(&board);
+
+    g_isFinesseReady = true;
+}
+
+// Returns -1 for places a piece can't be on a normal board
+i32 GetFinesseInputs(tetromino_type type, i32 rotation, i32 x) {
+    if (!g_isFinesseReady) {
+        InitFinesseInputs();
+    }
+
+    if (type < tetromino_type_I || type > tetromino_type_L || rotation < 0 || rotation > 3 || x < FINESSE_MIN_X || x - FINESSE_MIN_X >= FINESSE_X_COUNT) {
+        return -1;
+    }
+
+    return g_finesseInputs[type][rotation][x - FINESSE_MIN_X];
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef TETRIS_TELEMETRY_H
+#define TETRIS_TELEMETRY_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+
+
+#define TELEMETRY_BLOCK_MAGIC 0x4C545354 // "TSTL"
+#define TELEMETRY_RING_SIZE   1024 // Pieces. If the flush thread falls this far behind, pieces get dropped rather than waited for
+#define TELEMETRY_FLUSH_COUNT 256  // Pieces between wake ups of the flush thread
+#define TELEMETRY_MAX_VARINT  10
+
+// What we keep about every piece that locks
+typedef struct telemetry_piece {
+    u32 game;       // Random, the same for every piece of a game
+    u32 tick;       // tickCount when it locked
+    u32 spawnTicks; // Since it spawned, or got swapped in from the hold box
+    i16 x;
+    i16 y;
+    u8 type;
+    u8 rotation;
+    u8 lines;       // Cleared by it
+    u8 inputs;      // Key presses it took, the hard drop included. Soft drops and holds don't count
+    u16 level;
+    u16 padding;
+} telemetry_piece;
+
+// In the order they are in the file
+typedef enum telemetry_column {
+    telemetry_column_game = 0,
+    telemetry_column_tick,
+    telemetry_column_spawn_ticks,
+    telemetry_column_x,
+    telemetry_column_y,
+    telemetry_column_type,
+    telemetry_column_rotation,
+    telemetry_column_lines,
+    telemetry_column_inputs,
+    telemetry_column_level,
+    telemetry_column_count
+} telemetry_column;
+
+#define TELEMETRY_COLUMN_BIT(column) (1u << (column))
+
+// The file is these back to back, each followed by its columns in order
+typedef struct telemetry_block_header {
+    u32 magic;
+    u32 rowsCount;
+    u32 columnSizes[telemetry_column_count]; // In bytes
+} telemetry_block_header;
+
+// Collects pieces during a game and has a thread of its own append them to the file. See tetris_telemetry.c
+typedef struct telemetry_t {
+    char path[260];
+    telemetry_piece ring[TELEMETRY_RING_SIZE];
+    volatile i32 writeCount; // Pieces ever put in the ring. Only the game changes it
+    volatile i32 readCount;  // Pieces ever taken out. Only the flush thread changes it
+    i32 droppedCount;
+    i32 unflushedCount;      // Since the flush thread was last woken up
+    volatile i32 shouldQuit;
+
+    engine_thread thread;
+    engine_signal wakeUp;
+    u8* encoded;             // The flush thread's, one block's worth
+    b32 didFailToWrite;
+} telemetry_t;
+
+// Columns of a whole file, read for a query. Only the ones asked for are there, the rest are 0
+typedef struct telemetry_table {
+    i32 rowsCount;
+    i32 blocksCount;
+    i64 bytesCount;     // Of the file
+    i64 bytesReadCount; // Of the file that had to be read, the block headers and the columns asked for
+    i32* columns[telemetry_column_count];
+} telemetry_table;
+
+typedef struct telemetry_clears {
+    i64 piecesCount;
+    i64 counts[5]; // By lines cleared
+} telemetry_clears;
+
+extern b32 InitTelemetry(telemetry_t* telemetry, const char* path);
+extern void FreeTelemetry(telemetry_t* telemetry);
+extern void RecordTelemetryPiece(telemetry_t* telemetry, telemetry_piece* piece);
+
+extern b32 ReadTelemetryTable(const char* path, u32 columnMask, telemetry_table* outTable);
+extern void FreeTelemetryTable(telemetry_table* table);
+extern f64 GetTelemetryPiecesPerSecond(telemetry_table* table);
+extern f64 GetTelemetryFinesseErrors(telemetry_table* table);
+extern telemetry_clears GetTelemetryClears(telemetry_table* table);
+extern i32 GetFinesseInputs(tetromino_type type, i32 rotation, i32 x);
+
+#define TELEMETRY_PPS_COLUMNS     (TELEMETRY_COLUMN_BIT(telemetry_column_game) | TELEMETRY_COLUMN_BIT(telemetry_column_tick))
+#define TELEMETRY_FINESSE_COLUMNS (TELEMETRY_COLUMN_BIT(telemetry_column_type) | TELEMETRY_COLUMN_BIT(telemetry_column_rotation) | TELEMETRY_COLUMN_BIT(telemetry_column_x) | TELEMETRY_COLUMN_BIT(telemetry_column_inputs))
+#define TELEMETRY_CLEARS_COLUMNS  (TELEMETRY_COLUMN_BIT(telemetry_column_lines))
+
+#endif
\ No newline at end of file
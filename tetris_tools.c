@@ -0,0 +1,1078 @@
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_random.h"
+#include "tetris_perft.h"
+#include "tetris_tuner.h"
+#include "tetris_perfect_clear.h"
+#include "tetris_env.h"
+#include "tetris_tournament.h"
+#include "tetris_versus.h"
+#include "tetris_replay.h"
+#include "tetris_telemetry.h"
+#include "tetris_pieces.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Things that run instead of the game when asked for on the command line, with their output going to the console
+
+    -perft <depth> [-seed <n>] [-board <file>]
+        Counts every placement sequence of the first <depth> pieces of the bag that <n> seeds (1 by default), starting
+        from an empty board or one read from <file>. The file has one line per row, top row first, with '.' for empty
+        tiles and anything else for filled ones
+
+    -tune [-generations <n>] [-population <n>] [-games <n>] [-pieces <n>] [-preview <n>] [-beam <n>] [-seed <n>] [-checkpoint <file>]
+        Tunes the bot's weights with self-play until <n> generations have been done (100 by default). Progress goes to
+        <file>.0 and <file>.1 (tune.dat by default), and running again with the same settings carries on from there
+
+    -pc [-seed <n>] [-board <file>] [-time <seconds>]
+        Looks for a perfect clear from the board in <file> (same format as for -perft, empty by default) with the
+        pieces a new game with seed <n> would start with: the current piece, the preview and the rest of the first
+        bag. Gives up after <seconds> (1 by default). Whatever it finds gets played out with the board code to check it
+
+    -boardbench
+        Times line clears and a frame's worth of looking at the tiles in view on boards from the normal size up to the
+        biggest marathon ones. Both should stay about the same as the boards get taller, and clears should only grow
+        with the width
+
+    -tournament <player> [<player> ...] [-games <n>] [-pieces <n>] [-budget <ms>] [-seed <n>] [-summary <file>]
+        Plays every player on the same <n> bag sequences (16 by default) of up to <n> pieces each (1000 by default)
+        and writes totals and head to head wins to <file> (tournament.txt by default). A player is the path of a bot
+        plugin DLL (see tetris_bot_plugin.h) or "builtin" for our own bot. Moves that take longer than <ms> (20 by
+        default) get thrown away
+
+    -envbench [-envs <n>] [-steps <n>]
+        Steps <n> envs (65536 by default) with random actions <n> times (100 by default), on this thread and then
+        split into jobs, and prints environment steps per second for both
+
+    -versustest [-frames <n>] [-latency <ms>] [-jitter <ms>] [-loss <percent>] [-seed <n>] [-port <n>]
+        Plays two versus sessions against each other over UDP on this machine, on port <n> and the one after it (7700
+        by default), with random inputs, until both have simulated <n> frames (6000 by default). A new match starts
+        whenever one ends. Packets get held back by <ms> (50 by default) plus up to <ms> more (20 by default) and
+        <percent> of them (5 by default) get thrown away. Prints rollbacks, stalls, desyncs and the slowest update,
+        which has to stay well under the 16.7 ms of a 60 Hz frame
+
+    -replaytest [-minutes <n>] [-height <n>] [-seeks <n>] [-seed <n>] [-file <file>]
+        Records <n> minutes (60 by default) of random play on a board 10 wide and <n> tall (4096 by default, so the
+        game lasts), writes the replay to <file> (replaytest.bin by default) and opens it again. Plays it through from
+        the start, then seeks to <n> random ticks (1000 by default) in random order and checks that each comes out the
+        same as playing through did. Seeks have to stay well under a frame for scrubbing to feel instant
+
+    -stats [-file <file>] [-generate <n>] [-pieces <n>] [-seed <n>]
+        Prints pieces per second, finesse errors and how many lines pieces cleared over every game in <file>
+        (data/telemetry.bin by default), with how many bytes of it each of them had to read and how long it took.
+        With -generate, <n> made up games of up to <n> pieces each (200 by default) get written to <file> first
+        (statstest.bin by default then, so the real stats are left alone), along with what recording a piece costs
+
+    -genpieces [-set <set>] [-out <file>]
+        Writes the piece tables for <set> to <file> (tetris_piece_tables.c by default, which is the one the game is
+        built with). <set> is "tetrominoes" (the default), "pentominoes" or the path of a file with pieces written
+        down the way tetris_pieces.c describes. The game itself only knows how to deal out the 7 tetrominoes, so other
+        sets are for whoever teaches it more
+*/
+
+#define PERFT_DEFAULT_SEED 1
+
+#define BOARD_BENCH_CLEARS     256
+#define BOARD_BENCH_STACK      64 // Rows of garbage under the ones that get cleared
+#define BOARD_BENCH_VIEW_ROWS  60
+#define BOARD_BENCH_VIEW_WIDTH 30
+
+#define PC_DEFAULT_TIME 1.0
+
+#define ENV_BENCH_DEFAULT_ENVS  65536
+#define ENV_BENCH_DEFAULT_STEPS 100
+
+#define TOURNAMENT_DEFAULT_SUMMARY "tournament.txt"
+
+#define VERSUS_TEST_DEFAULT_FRAMES  6000
+#define VERSUS_TEST_DEFAULT_LATENCY 50 // ms
+#define VERSUS_TEST_DEFAULT_JITTER  20 // ms
+#define VERSUS_TEST_DEFAULT_LOSS    5  // Percent
+#define VERSUS_TEST_DEFAULT_PORT    7700
+#define VERSUS_TEST_MAX_WIND_DOWN   600 // Updates to wait for the second side to see a match end after the first did
+
+#define REPLAY_TEST_DEFAULT_MINUTES 60
+#define REPLAY_TEST_DEFAULT_HEIGHT  4096
+#define REPLAY_TEST_DEFAULT_SEEKS   1000
+#define REPLAY_TEST_DEFAULT_FILE    "replaytest.bin"
+#define REPLAY_TEST_PRESS_TICKS     250 // Between key presses, so a piece takes a second or so
+
+#define STATS_DEFAULT_FILE      "data/telemetry.bin"
+#define STATS_DEFAULT_TEST_FILE "statstest.bin"
+#define STATS_DEFAULT_PIECES    200
+
+#define GEN_PIECES_DEFAULT_FILE "tetris_piece_tables.c"
+
+#define TUNE_DEFAULT_GENERATIONS 100
+#define TUNE_DEFAULT_CHECKPOINT  "tune.dat"
+
+// Known good counts from an empty board with PERFT_DEFAULT_SEED. If these change, the rules changed
+static const u64 PERFT_REFERENCE_NODES[] = { 1, 17, 298, 10600, 389224, 14584556 };
+
+
+// Returns what comes after the argument, or 0 if it isn't there
+static const char* FindArgument(const char* commandLine, const char* name) {
+    const char* argument = strstr(commandLine, name);
+    if (!argument) {
+        return 0;
+    }
+
+    argument += strlen(name);
+    while (*argument == ' ') {
+        ++argument;
+    }
+
+    return argument;
+}
+
+static b32 ReadBoardFile(board_t* board, const char* filePath) {
+    i32 bytesRead = 0;
+    char* file = EngineReadEntireFile((char*)filePath, &bytesRead);
+    if (!file) {
+        return false;
+    }
+
+    // Count the rows first, since the bottom row is the last one in the file
+    i32 rowsCount = 0;
+    for (i32 i = 0; i < bytesRead; ++i) {
+        if (file[i] == '\n' || i == bytesRead - 1) {
+            ++rowsCount;
+        }
+    }
+
+    i32 y = Min(rowsCount, board->height) - 1;
+    i32 x = 0;
+    for (i32 i = 0; i < bytesRead && y >= 0; ++i) {
+        if (file[i] == '\n') {
+            --y;
+            x = 0;
+        }
+        else if (file[i] != '\r') {
+            if (file[i] != '.' && x < board->width) {
+                SetBoardTile(board, x, y, tetromino_type_I); // Any type will do
+            }
+            ++x;
+        }
+    }
+
+    EngineFree(file);
+
+    return true;
+}
+
+static void RunPerftTool(const char* commandLine) {
+    i32 depth = atoi(FindArgument(commandLine, "-perft"));
+
+    const char* seedArgument = FindArgument(commandLine, "-seed");
+    u32 seed = seedArgument ? (u32)strtoul(seedArgument, 0, 10) : PERFT_DEFAULT_SEED;
+
+    board_t board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 0, 0, 0);
+
+    b32 isReferenceBoard = seed == PERFT_DEFAULT_SEED;
+    const char* boardArgument = FindArgument(commandLine, "-board");
+    if (boardArgument) {
+        char filePath[260] = { 0 };
+        for (i32 i = 0; i < ArraySize(filePath) - 1 && boardArgument[i] && boardArgument[i] != ' '; ++i) {
+            filePath[i] = boardArgument[i];
+        }
+
+        if (!ReadBoardFile(&board, filePath)) {
+            char text[320];
+            snprintf(text, sizeof(text), "Couldn't read %s\n", filePath);
+            EnginePrint(text);
+            FreeBoard(&board);
+            return;
+        }
+        isReferenceBoard = false;
+    }
+
+    tetromino_type pieces[PERFT_MAX_DEPTH];
+    tetromino_bag bag;
+    InitBag(&bag, InitRandomState(seed, 0));
+    for (i32 i = 0; i < ArraySize(pieces); ++i) {
+        pieces[i] = GetNextTetrominoFromBag(&bag);
+    }
+
+    char text[256];
+    snprintf(text, sizeof(text), "perft depth %d, seed %u, %d threads\n", Clamp(depth, 0, PERFT_MAX_DEPTH), seed, EngineGetThreadCount());
+    EnginePrint(text);
+
+    perft_result result = RunPerft(&board, pieces, depth);
+
+    u64 totalNodes = 0;
+    b32 didMatchReference = true;
+    for (i32 i = 1; i <= result.depth; ++i) {
+        totalNodes += result.nodes[i];
+
+        const char* check = "";
+        if (isReferenceBoard && i < ArraySize(PERFT_REFERENCE_NODES)) {
+            b32 isMatch = result.nodes[i] == PERFT_REFERENCE_NODES[i];
+            didMatchReference &= isMatch;
+            check = isMatch ? " ok" : " MISMATCH";
+        }
+
+        snprintf(text, sizeof(text), "depth %d: %llu%s\n", i, (unsigned long long)result.nodes[i], check);
+        EnginePrint(text);
+    }
+
+    snprintf(text, sizeof(text), "%llu nodes in %.3f s, %.0f nodes/s\n", (unsigned long long)totalNodes, result.seconds, totalNodes / Max(result.seconds, 1e-9));
+    EnginePrint(text);
+
+    if (result.mismatches) {
+        snprintf(text, sizeof(text), "%llu placements the board code didn't agree with\n", (unsigned long long)result.mismatches);
+        EnginePrint(text);
+    }
+    if (!didMatchReference) {
+        EnginePrint("Counts differ from the reference\n");
+    }
+
+    FreeBoard(&board);
+}
+
+static void RunPerfectClearTool(const char* commandLine) {
+    const char* seedArgument = FindArgument(commandLine, "-seed");
+    u32 seed = seedArgument ? (u32)strtoul(seedArgument, 0, 10) : PERFT_DEFAULT_SEED;
+
+    const char* timeArgument = FindArgument(commandLine, "-time");
+    f64 timeBudget = timeArgument ? strtod(timeArgument, 0) : PC_DEFAULT_TIME;
+
+    board_t board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 0, 0, 0);
+
+    char text[320];
+    const char* boardArgument = FindArgument(commandLine, "-board");
+    if (boardArgument) {
+        char filePath[260] = { 0 };
+        for (i32 i = 0; i < ArraySize(filePath) - 1 && boardArgument[i] && boardArgument[i] != ' '; ++i) {
+            filePath[i] = boardArgument[i];
+        }
+
+        if (!ReadBoardFile(&board, filePath)) {
+            snprintf(text, sizeof(text), "Couldn't read %s\n", filePath);
+            EnginePrint(text);
+            FreeBoard(&board);
+            return;
+        }
+    }
+
+    // Dealt the same way InitScene1 does
+    tetromino_bag bag;
+    InitBag(&bag, InitRandomState(seed, 0));
+    tetromino_t current = InitTetromino(GetNextTetrominoFromBag(&bag), 0, SPAWN_X, SPAWN_Y);
+    tetromino_type next[PERFECT_CLEAR_PREVIEW_COUNT];
+    for (i32 i = 0; i < ArraySize(next); ++i) {
+        next[i] = GetNextTetrominoFromBag(&bag);
+    }
+
+    perfect_clear_solver solver;
+    InitPerfectClearSolver(&solver);
+    perfect_clear_result result = FindPerfectClear(&solver, &board, &current, next, tetromino_type_empty, true, &bag, timeBudget);
+    FreePerfectClearSolver(&solver);
+
+    if (!result.isFound) {
+        snprintf(text, sizeof(text), "%s after %llu nodes in %.3f s\n", result.didRunOutOfTime ? "Ran out of time" : "No perfect clear", (unsigned long long)result.nodes, result.seconds);
+        EnginePrint(text);
+        FreeBoard(&board);
+        return;
+    }
+
+    snprintf(text, sizeof(text), "Perfect clear of height %d in %d pieces, %llu nodes in %.3f s\n", result.height, result.movesCount, (unsigned long long)result.nodes, result.seconds);
+    EnginePrint(text);
+
+    const char* TYPE_NAMES = " IOTSZJL";
+    for (i32 i = 0; i < result.movesCount; ++i) {
+        tetromino_t* placement = &result.moves[i].placement;
+        snprintf(text, sizeof(text), "%2d: %c rotation %d at (%d, %d)%s\n", i + 1, TYPE_NAMES[placement->type], placement->rotation, placement->x, placement->y, result.moves[i].useHold ? ", from hold" : "");
+        EnginePrint(text);
+
+        if (!IsTetrominoPosValid(&board, placement)) {
+            EnginePrint("The board code says it doesn't fit\n");
+            break;
+        }
+        PlaceTetromino(&board, placement);
+        ProcessLineClears(&board, placement);
+    }
+    EnginePrint(board.stackHeight == 0 ? "Board is empty\n" : "Board is NOT empty\n");
+
+    FreeBoard(&board);
+}
+
+// Fills row y, apart from column gap, with horizontal I pieces. Whatever is left over at the right goes in a tile at a time
+static void FillBoardBenchRow(board_t* board, i32 y, i32 gap) {
+    for (i32 x = 0; x < board->width;) {
+        if (x + 4 <= board->width && (gap < x || gap >= x + 4)) {
+            tetromino_t piece = InitTetromino(tetromino_type_I, 0, x, y - 2); // The I's tiles are in the third row of its box
+            PlaceTetromino(board, &piece);
+            x += 4;
+        }
+        else {
+            if (x != gap) {
+                SetBoardTile(board, x, y, tetromino_type_I);
+            }
+            ++x;
+        }
+    }
+}
+
+static void RunBoardBenchTool(void) {
+    const i32 sizes[][2] = { { BOARD_WIDTH, BOARD_HEIGHT }, { 10, 1000 }, { 10, 4000 }, { 100, 200 }, { 1000, 2000 }, { 4000, 4000 } };
+
+    char text[256];
+    for (i32 i = 0; i < ArraySize(sizes); ++i) {
+        board_t board = InitBoard(sizes[i][0], sizes[i][1], 0, 0, 1);
+        SetBoardView(&board, BOARD_BENCH_VIEW_WIDTH, BOARD_BENCH_VIEW_ROWS);
+
+        // Garbage with a hole in the middle of every row, so it never clears
+        i32 stack = Min(BOARD_BENCH_STACK, board.height - 8);
+        for (i32 y = 0; y < stack; ++y) {
+            FillBoardBenchRow(&board, y, board.width / 2);
+        }
+
+        f64 clearSeconds = 0.0;
+        i32 linesCleared = 0;
+        for (i32 j = 0; j < BOARD_BENCH_CLEARS; ++j) {
+            i32 gap = j % board.width;
+            for (i32 y = stack; y < stack + 4; ++y) {
+                FillBoardBenchRow(&board, y, gap);
+            }
+
+            tetromino_t piece = InitTetromino(tetromino_type_I, 1, gap - 2, stack); // Upright, in the third column of its box
+            f64 start = EngineGetSeconds();
+            PlaceTetromino(&board, &piece);
+            linesCleared += ProcessLineClears(&board, &piece);
+            clearSeconds += EngineGetSeconds() - start;
+        }
+
+        // What DrawBoard looks at every frame, with the view on top of the stack
+        tetromino_t top = InitTetromino(tetromino_type_I, 0, board.width / 2, board.stackHeight);
+        ScrollBoardViewTo(&board, &top);
+
+        i32 filledTiles = 0;
+        f64 start = EngineGetSeconds();
+        for (i32 j = 0; j < BOARD_BENCH_CLEARS; ++j) {
+            i32 topRow = Min(board.viewY + board.viewRows, board.stackHeight);
+            for (i32 y = board.viewY; y < topRow; ++y) {
+                for (i32 x = board.viewX; x < board.viewX + board.viewColumns; ++x) {
+                    filledTiles += GetBoardTile(&board, x, y) != tetromino_type_empty;
+                }
+            }
+        }
+        f64 viewSeconds = EngineGetSeconds() - start;
+
+        snprintf(text, sizeof(text), "%5d x %-5d  %8.3f us per clear (%d lines)  %8.3f us per view (%d tiles)\n", board.width, board.height,
+            1e6 * clearSeconds / BOARD_BENCH_CLEARS, linesCleared, 1e6 * viewSeconds / BOARD_BENCH_CLEARS, filledTiles / BOARD_BENCH_CLEARS);
+        EnginePrint(text);
+
+        FreeBoard(&board);
+    }
+}
+
+static i32 GetIntArgument(const char* commandLine, const char* name, i32 defaultValue) {
+    const char* argument = FindArgument(commandLine, name);
+    return argument ? atoi(argument) : defaultValue;
+}
+
+static void RunEnvBenchTool(const char* commandLine) {
+    i32 envsCount = Max(GetIntArgument(commandLine, "-envs", ENV_BENCH_DEFAULT_ENVS), 1);
+    i32 stepsCount = Max(GetIntArgument(commandLine, "-steps", ENV_BENCH_DEFAULT_STEPS), 1);
+
+    env_observations observations = MapEnvObservations(EngineAllocate(GetEnvObservationsSize(envsCount), memory_tag_tools), envsCount);
+    u8* actions = EngineAllocate(envsCount, memory_tag_tools);
+
+    char text[256];
+    for (i32 useJobs = 0; useJobs < 2; ++useJobs) {
+        env_batch batch;
+        InitEnvBatch(&batch, envsCount, 0, &observations, useJobs);
+
+        random_state random = InitRandomState(1, 0);
+        i64 gamesCount = 0;
+        f64 seconds = 0.0;
+        for (i32 i = 0; i < stepsCount; ++i) {
+            for (i32 env = 0; env < envsCount; ++env) {
+                actions[env] = (u8)NextRandomBelow(&random, env_action_count);
+            }
+
+            f64 start = EngineGetSeconds();
+            StepEnvBatch(&batch, actions);
+            seconds += EngineGetSeconds() - start;
+
+            for (i32 env = 0; env < envsCount; ++env) {
+                gamesCount += observations.dones[env];
+            }
+        }
+
+        snprintf(text, sizeof(text), "%-7s %8.2f M steps per second (%lld games over)\n", useJobs ? "jobs" : "single",
+            (f64)envsCount * stepsCount / seconds / 1e6, gamesCount);
+        EnginePrint(text);
+
+        FreeEnvBatch(&batch);
+    }
+
+    EngineFree(observations.scores); // The first array is at the start of the memory
+    EngineFree(actions);
+}
+
+// Copies the word the argument starts with, up to the next space. Returns the word's length, which is outWordSize or
+// more if it didn't fit, in which case outWord is left empty
+static i32 CopyWordArgument(const char* argument, char* outWord, i32 outWordSize) {
+    i32 length = 0;
+    while (argument[length] && argument[length] != ' ') {
+        ++length;
+    }
+
+    if (length >= outWordSize) {
+        outWord[0] = 0;
+        return length;
+    }
+
+    for (i32 i = 0; i < length; ++i) {
+        outWord[i] = argument[i];
+    }
+    outWord[length] = 0;
+    return length;
+}
+
+// For options followed by a path. outPath is left alone if the option isn't there. Returns false, after saying so, if
+// the path doesn't fit
+static b32 GetPathArgument(const char* commandLine, const char* name, char* outPath, i32 outPathSize) {
+    const char* argument = FindArgument(commandLine, name);
+    if (!argument) {
+        return true;
+    }
+
+    char word[260];
+    i32 length = CopyWordArgument(argument, word, ArraySize(word));
+    if (length >= outPathSize || length >= (i32)ArraySize(word)) {
+        char text[128];
+        snprintf(text, sizeof(text), "The %s path is too long, it can be at most %d characters\n", name, outPathSize - 1);
+        EnginePrint(text);
+        return false;
+    }
+
+    memcpy(outPath, word, length + 1);
+    return true;
+}
+
+static void RunTournamentTool(const char* commandLine) {
+    tournament_settings settings = TOURNAMENT_DEFAULT_SETTINGS;
+    settings.gamesCount     = GetIntArgument(commandLine, "-games", settings.gamesCount);
+    settings.maxPieces      = GetIntArgument(commandLine, "-pieces", settings.maxPieces);
+    settings.moveTimeBudget = GetIntArgument(commandLine, "-budget", (i32)(1e3 * settings.moveTimeBudget)) / 1e3;
+    settings.seed           = (u32)GetIntArgument(commandLine, "-seed", settings.seed);
+
+    char summaryPath[260] = TOURNAMENT_DEFAULT_SUMMARY;
+    if (!GetPathArgument(commandLine, "-summary", summaryPath, ArraySize(summaryPath))) {
+        return;
+    }
+
+    // Everything up to the next option is a player
+    char paths[TOURNAMENT_MAX_PLAYERS][260];
+    const char* pathPointers[TOURNAMENT_MAX_PLAYERS];
+    i32 playersCount = 0;
+    const char* argument = FindArgument(commandLine, "-tournament");
+    while (*argument && *argument != '-' && playersCount < TOURNAMENT_MAX_PLAYERS) {
+        i32 length = CopyWordArgument(argument, paths[playersCount], ArraySize(paths[playersCount]));
+        if (length >= (i32)ArraySize(paths[playersCount])) {
+            char text[128];
+            snprintf(text, sizeof(text), "Player %d's path is too long, it can be at most %d characters\n", playersCount + 1, (i32)ArraySize(paths[playersCount]) - 1);
+            EnginePrint(text);
+            return;
+        }
+        pathPointers[playersCount] = paths[playersCount];
+        argument += length;
+        ++playersCount;
+        while (*argument == ' ') {
+            ++argument;
+        }
+    }
+
+    if (playersCount == 0) {
+        EnginePrint("No players. Give DLL paths or " TOURNAMENT_BUILTIN_PLAYER " after -tournament\n");
+        return;
+    }
+
+    RunTournament(pathPointers, playersCount, &settings, summaryPath);
+}
+
+// Something that looks a bit like someone playing: a few frames of one thing, then another
+static u8 GetVersusTestInput(random_state* random, u8* input, i32* framesLeft) {
+    static const u8 INPUTS[] = {
+        0, 0, 0, VERSUS_INPUT_LEFT, VERSUS_INPUT_LEFT, VERSUS_INPUT_RIGHT, VERSUS_INPUT_RIGHT, VERSUS_INPUT_ROTATE_CW,
+        VERSUS_INPUT_ROTATE_CCW, VERSUS_INPUT_SOFT_DROP, VERSUS_INPUT_HARD_DROP, VERSUS_INPUT_HOLD, VERSUS_INPUT_LEFT | VERSUS_INPUT_ROTATE_CW
+    };
+
+    if (--*framesLeft <= 0) {
+        *input = INPUTS[NextRandomBelow(random, ArraySize(INPUTS))];
+        *framesLeft = NextRandomI32InRange(random, 1, 12);
+    }
+
+    return *input;
+}
+
+static void RunVersusTestTool(const char* commandLine) {
+    i32 framesCount = Max(GetIntArgument(commandLine, "-frames", VERSUS_TEST_DEFAULT_FRAMES), 1);
+    u32 seed = (u32)GetIntArgument(commandLine, "-seed", 1);
+    u16 port = (u16)GetIntArgument(commandLine, "-port", VERSUS_TEST_DEFAULT_PORT);
+
+    versus_network_settings network = {
+        .latency = GetIntArgument(commandLine, "-latency", VERSUS_TEST_DEFAULT_LATENCY) / 1e3f,
+        .jitter  = GetIntArgument(commandLine, "-jitter", VERSUS_TEST_DEFAULT_JITTER) / 1e3f,
+        .loss    = GetIntArgument(commandLine, "-loss", VERSUS_TEST_DEFAULT_LOSS) / 100.0f
+    };
+
+    versus_session* sessions = EngineAllocate(2 * sizeof(versus_session), memory_tag_tools);
+    random_state inputRandoms[2] = { InitRandomState(seed, 10), InitRandomState(seed, 11) };
+    u8 inputs[2] = { 0 };
+    i32 inputFramesLeft[2] = { 0 };
+
+    versus_stats totals[2] = { 0 };
+    i32 framesDone[2] = { 0 };
+    i32 resultsCounts[versus_result_desynced + 1] = { 0 };
+    i32 matchesCount = 0;
+    i32 updatesCount = 0;
+    f64 updateSeconds = 0.0;
+    f64 maxUpdateSeconds = 0.0;
+    char text[256];
+
+    while (framesDone[0] < framesCount || framesDone[1] < framesCount) {
+        for (i32 i = 0; i < 2; ++i) {
+            if (!InitVersusSession(&sessions[i], port + i, port + 1 - i, seed + matchesCount, &network)) {
+                snprintf(text, sizeof(text), "Couldn't open port %d\n", port + i);
+                EnginePrint(text);
+                if (i == 1) {
+                    FreeVersusSession(&sessions[0]);
+                }
+                EngineFree(sessions);
+                return;
+            }
+        }
+
+        i32 windDownUpdates = 0;
+        while (windDownUpdates < VERSUS_TEST_MAX_WIND_DOWN) {
+            for (i32 i = 0; i < 2; ++i) {
+                u8 input = GetVersusTestInput(&inputRandoms[i], &inputs[i], &inputFramesLeft[i]);
+
+                f64 start = EngineGetSeconds();
+                UpdateVersusSession(&sessions[i], 1.0f / 60.0f, input);
+                f64 seconds = EngineGetSeconds() - start;
+                ClearGameEvents(&sessions[i].localEvents); // Nobody to play sounds to
+
+                updateSeconds += seconds;
+                maxUpdateSeconds = Max(maxUpdateSeconds, seconds);
+                ++updatesCount;
+            }
+
+            b32 isOver0 = sessions[0].result != versus_result_playing;
+            b32 isOver1 = sessions[1].result != versus_result_playing;
+            if (isOver0 && isOver1) {
+                break;
+            }
+            if (isOver0 || isOver1 || sessions[0].frame >= framesCount - framesDone[0]) {
+                ++windDownUpdates;
+            }
+        }
+
+        ++matchesCount;
+        for (i32 i = 0; i < 2; ++i) {
+            versus_session* session = &sessions[i];
+            framesDone[i] += session->frame;
+            ++resultsCounts[session->result];
+
+            totals[i].rollbacksCount        += session->stats.rollbacksCount;
+            totals[i].rolledBackFramesCount += session->stats.rolledBackFramesCount;
+            totals[i].maxRollback            = Max(totals[i].maxRollback, session->stats.maxRollback);
+            totals[i].stallsCount           += session->stats.stallsCount;
+            totals[i].syncWaitsCount        += session->stats.syncWaitsCount;
+            totals[i].packetsSent           += session->stats.packetsSent;
+            totals[i].packetsDropped        += session->stats.packetsDropped;
+            totals[i].packetsReceived       += session->stats.packetsReceived;
+
+            FreeVersusSession(session);
+        }
+    }
+
+    snprintf(text, sizeof(text), "%d matches: %d won, %d lost, %d drawn, %d still going, %d disconnected, %d desynced (counted from both sides)\n",
+        matchesCount, resultsCounts[versus_result_won], resultsCounts[versus_result_lost], resultsCounts[versus_result_draw],
+        resultsCounts[versus_result_playing], resultsCounts[versus_result_disconnected], resultsCounts[versus_result_desynced]);
+    EnginePrint(text);
+
+    for (i32 i = 0; i < 2; ++i) {
+        versus_stats* stats = &totals[i];
+        snprintf(text, sizeof(text), "player %d: %d frames, %d rollbacks of %.1f frames on average (%d at most), %d stalls, %d sync waits, %d of %d packets dropped, %d received\n",
+            i, framesDone[i], stats->rollbacksCount, stats->rollbacksCount ? (f64)stats->rolledBackFramesCount / stats->rollbacksCount : 0.0,
+            stats->maxRollback, stats->stallsCount, stats->syncWaitsCount, stats->packetsDropped, stats->packetsSent, stats->packetsReceived);
+        EnginePrint(text);
+    }
+
+    snprintf(text, sizeof(text), "update: %.3f ms on average, %.3f ms at most\n", 1e3 * updateSeconds / updatesCount, 1e3 * maxUpdateSeconds);
+    EnginePrint(text);
+
+    EngineFree(sessions);
+}
+
+static void RunTuneTool(const char* commandLine) {
+    tuner_settings settings = TUNER_DEFAULT_SETTINGS;
+    settings.population        = GetIntArgument(commandLine, "-population", settings.population);
+    settings.gamesPerCandidate = GetIntArgument(commandLine, "-games", settings.gamesPerCandidate);
+    settings.maxPieces         = GetIntArgument(commandLine, "-pieces", settings.maxPieces);
+    settings.previewCount      = GetIntArgument(commandLine, "-preview", settings.previewCount);
+    settings.beamWidth         = GetIntArgument(commandLine, "-beam", settings.beamWidth);
+    settings.seed              = (u32)GetIntArgument(commandLine, "-seed", settings.seed);
+
+    i32 generations = GetIntArgument(commandLine, "-generations", TUNE_DEFAULT_GENERATIONS);
+
+    char checkpointPath[260] = TUNE_DEFAULT_CHECKPOINT;
+    if (!GetPathArgument(commandLine, "-checkpoint", checkpointPath, ArraySize(checkpointPath))) {
+        return;
+    }
+
+    RunTuner(&settings, generations, checkpointPath);
+}
+
+// Turns each piece and moves it somewhere at random, then drops it. Good enough to fill lines now and then, and
+// presses keys about as often as a person would, which is what decides how big a replay gets
+typedef struct replay_test_player {
+    random_state random;
+    u32 piece; // piecesSpawned the presses are for
+    i32 presses[16]; // Key indices
+    i32 pressesCount;
+    i32 pressIndex;
+    i32 timer;
+} replay_test_player;
+
+static void UpdateReplayTestInput(replay_test_player* player, game_state* game, keyboard_state* input) {
+    // Presses last a tick, like a quick tap
+    for (i32 i = 0; i < REPLAY_KEYS_COUNT; ++i) {
+        input->keys[i].didChangeState = input->keys[i].isDown;
+        input->keys[i].isDown = false;
+    }
+
+    if (game->piecesSpawned != player->piece) {
+        player->piece = game->piecesSpawned;
+        player->pressesCount = 0;
+        player->pressIndex = 0;
+
+        i32 rotations = NextRandomBelow(&player->random, 4);
+        for (i32 i = 0; i < rotations; ++i) {
+            player->presses[player->pressesCount++] = 5; // x
+        }
+        i32 moves = NextRandomI32InRange(&player->random, -5, 5);
+        for (i32 i = 0; i < Abs(moves); ++i) {
+            player->presses[player->pressesCount++] = moves < 0 ? 2 : 3; // left, right
+        }
+        player->presses[player->pressesCount++] = 7; // spacebar
+    }
+
+    if (++player->timer >= REPLAY_TEST_PRESS_TICKS && player->pressIndex < player->pressesCount) {
+        player->timer = 0;
+        keyboard_key_state* key = &input->keys[player->presses[player->pressIndex++]];
+        key->isDown = true;
+        key->didChangeState = true;
+    }
+}
+
+static int CompareTicks(const void* a, const void* b) {
+    u32 tickA = *(const u32*)a;
+    u32 tickB = *(const u32*)b;
+    return tickA < tickB ? -1 : tickA > tickB;
+}
+
+static void RunReplayTestTool(const char* commandLine) {
+    i32 minutes = Max(GetIntArgument(commandLine, "-minutes", REPLAY_TEST_DEFAULT_MINUTES), 1);
+    i32 height = Clamp(GetIntArgument(commandLine, "-height", REPLAY_TEST_DEFAULT_HEIGHT), BOARD_HEIGHT, 4096);
+    i32 seeksCount = Max(GetIntArgument(commandLine, "-seeks", REPLAY_TEST_DEFAULT_SEEKS), 1);
+    u32 seed = (u32)GetIntArgument(commandLine, "-seed", 1);
+
+    char path[260] = REPLAY_TEST_DEFAULT_FILE;
+    if (!GetPathArgument(commandLine, "-file", path, ArraySize(path))) {
+        return;
+    }
+
+    char text[256];
+
+    // Record
+    game_state game = { 0 };
+    board_t board = height == BOARD_HEIGHT ? InitBoardInMemory(BOARD_WIDTH, BOARD_HEIGHT, game.boardMemory, 0, 0, 0) : InitBoard(BOARD_WIDTH, height, 0, 0, 0);
+    InitGameState(&game, &board, InitRandomState(seed, 1));
+
+    replay_recorder recorder;
+    InitReplayRecorder(&recorder, &game, &board);
+
+    keyboard_state input = { 0 };
+    replay_test_player player = {
+        .random = InitRandomState(seed, 2),
+        .piece  = (u32)-1
+    };
+
+    f64 start = EngineGetSeconds();
+    u32 ticksCount = (u32)minutes * 60 * TICKS_PER_SECOND;
+    b32 isAlive = true;
+    while (isAlive && game.tickCount < ticksCount) {
+        UpdateReplayTestInput(&player, &game, &input);
+
+        isAlive = UpdateGameState(&game, &board, &input, 0);
+        RecordReplayTick(&recorder, &game, &board, &input);
+    }
+    f64 recordSeconds = EngineGetSeconds() - start;
+
+    snprintf(text, sizeof(text), "recorded %.1f minutes%s: %u pieces, %d lines, %d inputs, %d keyframes, in %.2f s\n",
+        game.tickCount / (60.0 * TICKS_PER_SECOND), isAlive ? "" : " (topped out)", game.piecesSpawned, game.lines,
+        recorder.inputsCount, recorder.indexCount, recordSeconds);
+    EnginePrint(text);
+
+    b32 didWrite = WriteReplayFile(&recorder, path);
+    FreeReplayRecorder(&recorder);
+    if (height != BOARD_HEIGHT) {
+        FreeBoard(&board);
+    }
+
+    if (!didWrite) {
+        snprintf(text, sizeof(text), "Couldn't write %s\n", path);
+        EnginePrint(text);
+        return;
+    }
+
+    // Play back
+    replay_t* replay = EngineAllocate(sizeof(replay_t), memory_tag_tools);
+    start = EngineGetSeconds();
+    if (!OpenReplay(replay, path, 0, 0, 0)) {
+        snprintf(text, sizeof(text), "Couldn't open %s\n", path);
+        EnginePrint(text);
+        EngineFree(replay);
+        return;
+    }
+    f64 openSeconds = EngineGetSeconds() - start;
+
+    u32* targets = EngineAllocate(seeksCount * sizeof(u32), memory_tag_tools);
+    u32* sortedTargets = EngineAllocate(seeksCount * sizeof(u32), memory_tag_tools);
+    u32* checksums = EngineAllocate(seeksCount * sizeof(u32), memory_tag_tools); // By sorted target
+
+    random_state random = InitRandomState(seed, 3);
+    u32 firstTick = replay->keyframes[0].tick;
+    for (i32 i = 0; i < seeksCount; ++i) {
+        targets[i] = firstTick + NextRandomBelow(&random, replay->header->ticksCount - firstTick + 1);
+        sortedTargets[i] = targets[i];
+    }
+    qsort(sortedTargets, seeksCount, sizeof(u32), CompareTicks);
+
+    start = EngineGetSeconds();
+    i32 checksumsCount = 0;
+    do {
+        while (checksumsCount < seeksCount && sortedTargets[checksumsCount] == replay->game.tickCount) {
+            checksums[checksumsCount++] = GetReplayChecksum(replay);
+        }
+    } while (StepReplay(replay, 0));
+    f64 playSeconds = EngineGetSeconds() - start;
+
+    b32 isSameGame = replay->game.tickCount == game.tickCount && replay->game.score == game.score && replay->game.lines == game.lines && replay->game.piecesSpawned == game.piecesSpawned;
+    snprintf(text, sizeof(text), "file: %d KB, opened in %.2f ms; played through in %.2f s, %.1f times real time, %s\n",
+        replay->fileSize / 1024, 1e3 * openSeconds,
+        playSeconds, replay->game.tickCount * SECONDS_PER_TICK / playSeconds, isSameGame ? "same game as recorded" : "NOT THE SAME GAME AS RECORDED");
+    EnginePrint(text);
+
+    // Seek
+    i32 mismatchesCount = 0;
+    f64 seekSeconds = 0.0;
+    f64 maxSeekSeconds = 0.0;
+    for (i32 i = 0; i < seeksCount; ++i) {
+        start = EngineGetSeconds();
+        SeekReplay(replay, targets[i]);
+        f64 seconds = EngineGetSeconds() - start;
+        seekSeconds += seconds;
+        maxSeekSeconds = Max(maxSeekSeconds, seconds);
+
+        u32* found = bsearch(&targets[i], sortedTargets, seeksCount, sizeof(u32), CompareTicks);
+        if (replay->game.tickCount != targets[i] || GetReplayChecksum(replay) != checksums[found - sortedTargets]) {
+            ++mismatchesCount;
+        }
+    }
+
+    snprintf(text, sizeof(text), "%d seeks: %.3f ms on average, %.3f ms at most, %d not the same as playing through\n",
+        seeksCount, 1e3 * seekSeconds / seeksCount, 1e3 * maxSeekSeconds, mismatchesCount);
+    EnginePrint(text);
+
+    EngineFree(targets);
+    EngineFree(sortedTargets);
+    EngineFree(checksums);
+    CloseReplay(replay);
+    EngineFree(replay);
+}
+
+// Made up games that look enough like real ones for the queries to have something to chew on. Each one gets its own
+// telemetry_t, the same as a game played for real does
+static void GenerateStats(const char* path, i32 gamesCount, i32 piecesCount, u32 seed) {
+    char text[256];
+
+    telemetry_t* telemetry = EngineAllocate(sizeof(telemetry_t), memory_tag_tools);
+    random_state random = InitRandomState(seed, 1);
+    f64 recordSeconds = 0.0;
+    f64 maxRecordSeconds = 0.0;
+    f64 freeSeconds = 0.0;
+    i64 recordedCount = 0;
+    i64 droppedCount = 0;
+    for (i32 game = 0; game < gamesCount; ++game) {
+        if (!InitTelemetry(telemetry, path)) {
+            EnginePrint("Couldn't start the telemetry thread\n");
+            break;
+        }
+
+        u32 id = NextRandomU32(&random);
+        u32 tick = 0;
+        i32 lines = 0;
+        i32 count = NextRandomI32InRange(&random, piecesCount / 4, piecesCount);
+        for (i32 i = 0; i < count; ++i) {
+            telemetry_piece piece = { 0 };
+            piece.game = id;
+            piece.type = (u8)NextRandomI32InRange(&random, tetromino_type_I, tetromino_type_L);
+            piece.rotation = (u8)NextRandomBelow(&random, 4);
+
+            i32 fewest;
+            do {
+                piece.x = (i16)NextRandomI32InRange(&random, -3, BOARD_WIDTH + 2);
+                fewest = GetFinesseInputs(piece.type, piece.rotation, piece.x);
+            } while (fewest < 0);
+
+            piece.inputs = (u8)(fewest + (NextRandomBelow(&random, 8) == 0 ? NextRandomI32InRange(&random, 1, 3) : 0));
+            piece.y = (i16)NextRandomI32InRange(&random, 0, BOARD_HEIGHT - 2);
+            piece.lines = (u8)(NextRandomBelow(&random, 3) == 0 ? NextRandomI32InRange(&random, 1, 4) : 0);
+            piece.level = (u16)(1 + lines / 10);
+            piece.spawnTicks = (u32)NextRandomI32InRange(&random, 200, 2000);
+            tick += piece.spawnTicks;
+            piece.tick = tick;
+            lines += piece.lines;
+
+            f64 start = EngineGetSeconds();
+            RecordTelemetryPiece(telemetry, &piece);
+            f64 seconds = EngineGetSeconds() - start;
+            recordSeconds += seconds;
+            maxRecordSeconds = Max(maxRecordSeconds, seconds);
+            ++recordedCount;
+        }
+
+        droppedCount += telemetry->droppedCount;
+
+        f64 start = EngineGetSeconds();
+        FreeTelemetry(telemetry);
+        freeSeconds += EngineGetSeconds() - start;
+    }
+    EngineFree(telemetry);
+
+    snprintf(text, sizeof(text), "generated %d games, %lld pieces: %.3f us per piece on average, %.3f us at most, %lld dropped, %.2f ms per game for the last flush\n",
+        gamesCount, recordedCount, 1e6 * recordSeconds / Max(recordedCount, 1), 1e6 * maxRecordSeconds, droppedCount, 1e3 * freeSeconds / Max(gamesCount, 1));
+    EnginePrint(text);
+}
+
+// Pieces turned where they spawn into a rotation that looks the same once dropped, so every turn was for nothing
+static const struct {
+    tetromino_type type;
+    i32 rotation;
+} FINESSE_CHECKS[] = {
+    { tetromino_type_O, 1 },
+    { tetromino_type_O, 2 },
+    { tetromino_type_O, 3 },
+    { tetromino_type_I, 2 },
+    { tetromino_type_S, 2 },
+    { tetromino_type_Z, 2 }
+};
+
+// Returns false, after saying which, if a piece from FINESSE_CHECKS doesn't come out as one error per turn
+static b32 CheckFinesseErrors(void) {
+    b32 isOk = true;
+    for (i32 i = 0; i < ArraySize(FINESSE_CHECKS); ++i) {
+        i32 type = FINESSE_CHECKS[i].type;
+        i32 rotation = FINESSE_CHECKS[i].rotation;
+        i32 turns = rotation == 2 ? 2 : 1;
+
+        // Where it spawns is the only column it gets to with just the hard drop
+        i32 x = -3;
+        while (x < BOARD_WIDTH && GetFinesseInputs(type, 0, x) != 1) {
+            ++x;
+        }
+        i32 inputs = turns + 1;
+
+        telemetry_table table = { .rowsCount = 1 };
+        table.columns[telemetry_column_type] = &type;
+        table.columns[telemetry_column_rotation] = &rotation;
+        table.columns[telemetry_column_x] = &x;
+        table.columns[telemetry_column_inputs] = &inputs;
+        f64 errors = GetTelemetryFinesseErrors(&table);
+
+        if (errors != turns) {
+            char text[128];
+            snprintf(text, sizeof(text), "finesse check: type %d turned to rotation %d scores %.0f errors instead of %d\n", type, rotation, errors, turns);
+            EnginePrint(text);
+            isOk = false;
+        }
+    }
+
+    return isOk;
+}
+
+static b32 ReadStatsTable(const char* path, u32 columnMask, telemetry_table* outTable, f64* outSeconds) {
+    f64 start = EngineGetSeconds();
+    b32 didRead = ReadTelemetryTable(path, columnMask, outTable);
+    *outSeconds = EngineGetSeconds() - start;
+
+    if (!didRead) {
+        char text[300];
+        snprintf(text, sizeof(text), "Couldn't read %s\n", path);
+        EnginePrint(text);
+    }
+
+    return didRead;
+}
+
+static void RunStatsTool(const char* commandLine) {
+    i32 gamesCount = GetIntArgument(commandLine, "-generate", 0);
+
+    char path[260] = STATS_DEFAULT_FILE;
+    if (gamesCount > 0) {
+        strcpy(path, STATS_DEFAULT_TEST_FILE);
+    }
+    if (!GetPathArgument(commandLine, "-file", path, ArraySize(path))) {
+        return;
+    }
+
+    if (gamesCount > 0) {
+        i32 piecesCount = Max(GetIntArgument(commandLine, "-pieces", STATS_DEFAULT_PIECES), 1);
+        GenerateStats(path, gamesCount, piecesCount, (u32)GetIntArgument(commandLine, "-seed", 1));
+    }
+
+    char text[256];
+    telemetry_table table;
+    f64 seconds;
+
+    if (!ReadStatsTable(path, TELEMETRY_PPS_COLUMNS, &table, &seconds)) {
+        return;
+    }
+    snprintf(text, sizeof(text), "%d pieces in %d blocks, %lld KB\n", table.rowsCount, table.blocksCount, table.bytesCount / 1024);
+    EnginePrint(text);
+    snprintf(text, sizeof(text), "pieces per second: %.3f (%lld KB read, %.2f ms)\n", GetTelemetryPiecesPerSecond(&table), table.bytesReadCount / 1024, 1e3 * seconds);
+    EnginePrint(text);
+    FreeTelemetryTable(&table);
+
+    if (!ReadStatsTable(path, TELEMETRY_FINESSE_COLUMNS, &table, &seconds)) {
+        return;
+    }
+    const char* check = CheckFinesseErrors() ? "" : " MISMATCH";
+    snprintf(text, sizeof(text), "finesse errors per piece: %.3f (%lld KB read, %.2f ms)%s\n", GetTelemetryFinesseErrors(&table), table.bytesReadCount / 1024, 1e3 * seconds, check);
+    EnginePrint(text);
+    FreeTelemetryTable(&table);
+
+    if (!ReadStatsTable(path, TELEMETRY_CLEARS_COLUMNS, &table, &seconds)) {
+        return;
+    }
+    telemetry_clears clears = GetTelemetryClears(&table);
+    f64 piecesCount = (f64)Max(clears.piecesCount, 1);
+    snprintf(text, sizeof(text), "clears: none %.1f%%, single %.1f%%, double %.1f%%, triple %.1f%%, tetris %.1f%% (%lld KB read, %.2f ms)\n",
+        100.0 * clears.counts[0] / piecesCount, 100.0 * clears.counts[1] / piecesCount, 100.0 * clears.counts[2] / piecesCount,
+        100.0 * clears.counts[3] / piecesCount, 100.0 * clears.counts[4] / piecesCount, table.bytesReadCount / 1024, 1e3 * seconds);
+    EnginePrint(text);
+    FreeTelemetryTable(&table);
+}
+
+static void RunGenPiecesTool(const char* commandLine) {
+    char text[256];
+
+    char setName[260] = "tetrominoes";
+    if (!GetPathArgument(commandLine, "-set", setName, ArraySize(setName))) {
+        return;
+    }
+
+    char path[260] = GEN_PIECES_DEFAULT_FILE;
+    if (!GetPathArgument(commandLine, "-out", path, ArraySize(path))) {
+        return;
+    }
+
+    const char* definition = 0;
+    char* fileDefinition = 0;
+    if (!strcmp(setName, "tetrominoes")) {
+        definition = TETROMINO_SET_DEFINITION;
+    }
+    else if (!strcmp(setName, "pentominoes")) {
+        definition = PENTOMINO_SET_DEFINITION;
+    }
+    else {
+        i32 size = 0;
+        void* contents = EngineReadEntireFile(setName, &size);
+        if (!contents) {
+            snprintf(text, sizeof(text), "Couldn't read %s\n", setName);
+            EnginePrint(text);
+            return;
+        }
+
+        // The definition has to end in a 0
+        fileDefinition = EngineAllocate(size + 1, memory_tag_tools);
+        memcpy(fileDefinition, contents, size);
+        fileDefinition[size] = '\0';
+        EngineFree(contents);
+        definition = fileDefinition;
+    }
+
+    piece_shape shapes[PIECE_MAX_TYPES][4];
+    char names[PIECE_MAX_TYPES + 1] = { 0 };
+    i32 typesCount = BuildPieceShapes(definition, shapes, names, PIECE_MAX_TYPES);
+    if (!typesCount || !WritePieceTables(path, definition)) {
+        snprintf(text, sizeof(text), typesCount ? "Couldn't write %s\n" : "Something is wrong with the pieces in %s\n", typesCount ? path : setName);
+        EnginePrint(text);
+        EngineFree(fileDefinition);
+        return;
+    }
+
+    snprintf(text, sizeof(text), "wrote %d pieces (%s) to %s\n", typesCount - 1, names + 1, path);
+    EnginePrint(text);
+
+    b32 isSameAsBuilt = typesCount == PIECE_SHAPES_COUNT && !memcmp(shapes, PIECE_SHAPES, typesCount * sizeof(shapes[0]));
+    EnginePrint(isSameAsBuilt ? "the same as the tables this was built with\n" : "not the same as the tables this was built with, build again for them to be used\n");
+
+    EngineFree(fileDefinition);
+}
+
+// Returns false if the command line didn't ask for a tool, in which case the game should start as usual
+b32 RunTool(const char* commandLine) {
+    // First, since its arguments are paths that could have anything in them
+    if (FindArgument(commandLine, "-tournament")) {
+        RunTournamentTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-perft")) {
+        RunPerftTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-tune")) {
+        RunTuneTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-pc")) {
+        RunPerfectClearTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-envbench")) {
+        RunEnvBenchTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-versustest")) {
+        RunVersusTestTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-replaytest")) {
+        RunReplayTestTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-genpieces")) {
+        RunGenPiecesTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-stats")) {
+        RunStatsTool(commandLine);
+        return true;
+    }
+    if (FindArgument(commandLine, "-boardbench")) {
+        RunBoardBenchTool();
+        return true;
+    }
+
+    return false;
+}
\ No newline at end of file
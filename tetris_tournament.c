@@ -0,0 +1,328 @@
+#include "tetris_tournament.h"
+#include "tetris_selfplay.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Bots against each other on the same pieces. Every player plays every one of gamesCount bag sequences to the end or
+    maxPieces, each game as its own job, using the self-play rules (tetris_selfplay.c). Jobs go sequence by sequence,
+    so the players of a sequence are running at around the same time and get about the same share of the machine.
+
+    Players are bot plugins (tetris_bot_plugin.h), either loaded from a DLL or our own bot behind the same interface,
+    so it gets no advantage from knowing the game's insides. A decision can't be interrupted, so the time budget gets
+    checked once it returns: anything over moveTimeBudget is thrown away and the piece gets hard dropped from where it
+    spawned, and the overrun is counted against the player.
+
+    The summary file has a line per player with its totals, then a table of how many sequences each player scored
+    more on than each other player.
+*/
+
+#define TOURNAMENT_SUMMARY_SIZE (4096 + TOURNAMENT_MAX_PLAYERS * TOURNAMENT_MAX_PLAYERS * 16)
+
+const tournament_settings TOURNAMENT_DEFAULT_SETTINGS = {
+    .gamesCount     = 16,
+    .maxPieces      = 1000,
+    .moveTimeBudget = 0.02,
+    .seed           = 1
+};
+
+typedef struct tournament_player {
+    const bot_plugin* plugin;
+    void* library; // 0 for the built-in bot
+} tournament_player;
+
+typedef struct tournament_game {
+    self_play_result result;
+    i32 decisions;
+    i32 overruns;
+    f64 decideSeconds;
+    f64 maxDecideSeconds;
+} tournament_game;
+
+typedef struct tournament_run {
+    tournament_settings* settings;
+    tournament_player* players;
+    i32 playersCount;
+    tetromino_type* sequences; // maxPieces per game
+    tournament_game* games;    // By player, then sequence
+    move_generator* generators; // One per thread
+} tournament_run;
+
+typedef struct tournament_move_context {
+    const bot_plugin* plugin;
+    void* instance;
+    f64 timeBudget;
+    tournament_game* game;
+} tournament_move_context;
+
+
+// Our own bot as a plugin. It only gets to see what any other plugin would
+typedef struct builtin_bot_instance {
+    bot_t bot;
+    board_t board;
+} builtin_bot_instance;
+
+static void* InitBuiltinBot(u64 seed) {
+    builtin_bot_instance* instance = EngineAllocate(sizeof(builtin_bot_instance), memory_tag_tools);
+    InitSingleThreadedBot(&instance->bot); // Other games are running on the other threads
+    instance->board = InitBoard(BOARD_WIDTH, BOARD_HEIGHT, 0, 0, 0);
+    return instance;
+}
+
+static b32 DecideWithBuiltinBot(void* data, const bot_plugin_game* game, bot_plugin_decision* outDecision) {
+    builtin_bot_instance* instance = data;
+
+    tetromino_type tiles[BOARD_WIDTH];
+    for (i32 y = 0; y < BOARD_HEIGHT; ++y) {
+        for (i32 x = 0; x < BOARD_WIDTH; ++x) {
+            tiles[x] = (game->rows[y] & (1 << x)) ? tetromino_type_I : tetromino_type_empty; // The bot doesn't care which
+        }
+        SetBoardRow(&instance->board, y, tiles);
+    }
+    RecalculateBoardHeights(&instance->board, BOARD_HEIGHT);
+
+    // Half, so the bot's own idea of time running out leaves plenty of room
+    instance->bot.timeBudget = Min(BOT_TIME_BUDGET, game->timeBudget / 2);
+
+    tetromino_t current = InitTetromino(game->current, game->currentRotation, game->currentX, game->currentY);
+    tetromino_type next[BOT_PREVIEW_COUNT];
+    for (i32 i = 0; i < BOT_PREVIEW_COUNT; ++i) {
+        next[i] = game->next[i];
+    }
+
+    bot_move move;
+    if (!FindBotMove(&instance->bot, &instance->board, &current, next, game->hold, game->canHold, &move)) {
+        return false;
+    }
+
+    outDecision->useHold = (u8)move.useHold;
+    outDecision->hasPlacement = true;
+    outDecision->rotation = (i8)move.placement.rotation;
+    outDecision->x = (i8)move.placement.x;
+    outDecision->y = (i8)move.placement.y;
+    return true;
+}
+
+static void ShutdownBuiltinBot(void* data) {
+    builtin_bot_instance* instance = data;
+    FreeBot(&instance->bot);
+    FreeBoard(&instance->board);
+    EngineFree(instance);
+}
+
+const bot_plugin BUILTIN_BOT_PLUGIN = {
+    .version  = BOT_PLUGIN_VERSION,
+    .name     = TOURNAMENT_BUILTIN_PLAYER,
+    .init     = InitBuiltinBot,
+    .decide   = DecideWithBuiltinBot,
+    .shutdown = ShutdownBuiltinBot
+};
+
+// Hands the game to the plugin and turns what it says into something PlaySelfPlayGameWith understands
+static b32 DecideWithPlugin(void* player, board_t* board, tetromino_t* current, tetromino_type* next, tetromino_type hold, b32 canHold, const self_play_result* progress, self_play_decision* outDecision) {
+    tournament_move_context* context = player;
+
+    bot_plugin_game game = {
+        .size            = sizeof(bot_plugin_game),
+        .current         = (u8)current->type,
+        .currentRotation = (i8)current->rotation,
+        .currentX        = (i8)current->x,
+        .currentY        = (i8)current->y,
+        .hold            = (u8)hold,
+        .canHold         = (u8)canHold,
+        .score           = progress->score,
+        .lines           = progress->lines,
+        .level           = progress->level,
+        .timeBudget      = context->timeBudget
+    };
+    GetBoardRows(board, game.rows);
+    for (i32 i = 0; i < BOT_PLUGIN_PREVIEW_COUNT; ++i) {
+        game.next[i] = (u8)next[i];
+    }
+
+    bot_plugin_decision decision = { 0 };
+    f64 startTime = EngineGetSeconds();
+    b32 didDecide = context->plugin->decide(context->instance, &game, &decision);
+    f64 seconds = EngineGetSeconds() - startTime;
+
+    tournament_game* stats = context->game;
+    ++stats->decisions;
+    stats->decideSeconds += seconds;
+    stats->maxDecideSeconds = Max(stats->maxDecideSeconds, seconds);
+
+    if (seconds > context->timeBudget) {
+        ++stats->overruns;
+        outDecision->inputs[0] = move_input_hard_drop;
+        outDecision->inputsCount = 1;
+        return true;
+    }
+    if (!didDecide) {
+        return false;
+    }
+
+    outDecision->useHold = decision.useHold != 0;
+    if (decision.hasPlacement && decision.rotation >= 0 && decision.rotation < 4) {
+        tetromino_type type = current->type;
+        if (decision.useHold) {
+            type = hold != tetromino_type_empty ? hold : next[0];
+        }
+        outDecision->hasPlacement = true;
+        outDecision->placement = InitTetromino(type, decision.rotation, decision.x, decision.y);
+    }
+    else if (!decision.hasPlacement) {
+        outDecision->inputsCount = Min(decision.inputsCount, MOVE_GEN_MAX_PATH);
+        for (i32 i = 0; i < outDecision->inputsCount; ++i) {
+            outDecision->inputs[i] = decision.inputs[i] <= move_input_hard_drop ? (move_input)decision.inputs[i] : move_input_none;
+        }
+    }
+    else {
+        outDecision->inputs[0] = move_input_hard_drop; // A rotation that doesn't exist
+        outDecision->inputsCount = 1;
+    }
+
+    return true;
+}
+
+static void PlayTournamentGame(void* data, i32 jobIndex, i32 threadIndex) {
+    tournament_run* run = data;
+    i32 player = jobIndex % run->playersCount;
+    i32 sequence = jobIndex / run->playersCount;
+
+    tournament_move_context context = {
+        .plugin     = run->players[player].plugin,
+        .timeBudget = run->settings->moveTimeBudget,
+        .game       = &run->games[player * run->settings->gamesCount + sequence]
+    };
+    context.instance = context.plugin->init(((u64)run->settings->seed << 32) | (u32)sequence);
+
+    const tetromino_type* pieces = &run->sequences[sequence * run->settings->maxPieces];
+    context.game->result = PlaySelfPlayGameWith(DecideWithPlugin, &context, &run->generators[threadIndex], pieces, run->settings->maxPieces, SELF_PLAY_INPUT_DELAY);
+
+    context.plugin->shutdown(context.instance);
+}
+
+static b32 LoadTournamentPlayer(tournament_player* player, const char* path) {
+    *player = (tournament_player){ 0 };
+
+    if (strcmp(path, TOURNAMENT_BUILTIN_PLAYER) == 0) {
+        player->plugin = &BUILTIN_BOT_PLUGIN;
+        return true;
+    }
+
+    char text[512];
+    player->library = EngineLoadLibrary(path);
+    get_bot_plugin getPlugin = player->library ? (get_bot_plugin)EngineGetLibraryFunction(player->library, BOT_PLUGIN_ENTRY_POINT) : 0;
+    if (!getPlugin) {
+        snprintf(text, sizeof(text), "Couldn't load %s, or it doesn't export %s\n", path, BOT_PLUGIN_ENTRY_POINT);
+        EnginePrint(text);
+        EngineFreeLibrary(player->library);
+        return false;
+    }
+
+    // Older plugins see a prefix of the structs they know about, newer ones might expect fields we don't have
+    player->plugin = getPlugin();
+    if (!player->plugin || player->plugin->version < 1 || player->plugin->version > BOT_PLUGIN_VERSION) {
+        snprintf(text, sizeof(text), "%s is for a plugin version we don't know (we are on %d)\n", path, BOT_PLUGIN_VERSION);
+        EnginePrint(text);
+        EngineFreeLibrary(player->library);
+        return false;
+    }
+
+    return true;
+}
+
+static i32 WriteTournamentSummary(tournament_run* run, char* text, i32 textSize) {
+    tournament_settings* settings = run->settings;
+    i32 length = snprintf(text, textSize, "games %d pieces %d budget_ms %.3f seed %u\n", settings->gamesCount, settings->maxPieces, 1e3 * settings->moveTimeBudget, settings->seed);
+    length += snprintf(text + length, textSize - length, "player name score lines pieces topouts overruns mean_ms max_ms\n");
+
+    for (i32 i = 0; i < run->playersCount; ++i) {
+        i64 score = 0, lines = 0, pieces = 0, decisions = 0;
+        i32 topOuts = 0, overruns = 0;
+        f64 seconds = 0.0, maxSeconds = 0.0;
+        for (i32 j = 0; j < settings->gamesCount; ++j) {
+            tournament_game* game = &run->games[i * settings->gamesCount + j];
+            score += game->result.score;
+            lines += game->result.lines;
+            pieces += game->result.pieces;
+            topOuts += game->result.didTopOut;
+            decisions += game->decisions;
+            overruns += game->overruns;
+            seconds += game->decideSeconds;
+            maxSeconds = Max(maxSeconds, game->maxDecideSeconds);
+        }
+
+        length += snprintf(text + length, textSize - length, "%d %s %lld %lld %lld %d %d %.3f %.3f\n", i, run->players[i].plugin->name,
+            score, lines, pieces, topOuts, overruns, decisions ? 1e3 * seconds / decisions : 0.0, 1e3 * maxSeconds);
+    }
+
+    // Row player beat column player on this many sequences
+    length += snprintf(text + length, textSize - length, "wins\n");
+    for (i32 i = 0; i < run->playersCount; ++i) {
+        for (i32 j = 0; j < run->playersCount; ++j) {
+            i32 wins = 0;
+            for (i32 k = 0; k < settings->gamesCount; ++k) {
+                wins += run->games[i * settings->gamesCount + k].result.score > run->games[j * settings->gamesCount + k].result.score;
+            }
+            length += snprintf(text + length, textSize - length, j + 1 < run->playersCount ? "%d " : "%d\n", wins);
+        }
+    }
+
+    return length;
+}
+
+// playerPaths are DLLs or TOURNAMENT_BUILTIN_PLAYER. Returns false if a player couldn't be loaded or the summary couldn't be written
+b32 RunTournament(const char** playerPaths, i32 playersCount, tournament_settings* settings, const char* summaryPath) {
+    playersCount = Min(playersCount, TOURNAMENT_MAX_PLAYERS);
+    if (playersCount < 1 || settings->gamesCount < 1 || settings->maxPieces < 4) {
+        return false;
+    }
+
+    tournament_player players[TOURNAMENT_MAX_PLAYERS];
+    for (i32 i = 0; i < playersCount; ++i) {
+        if (!LoadTournamentPlayer(&players[i], playerPaths[i])) {
+            for (i32 j = 0; j < i; ++j) {
+                EngineFreeLibrary(players[j].library);
+            }
+            return false;
+        }
+    }
+
+    tournament_run run = {
+        .settings     = settings,
+        .players      = players,
+        .playersCount = playersCount,
+        .sequences    = EngineAllocate(settings->gamesCount * settings->maxPieces * sizeof(tetromino_type), memory_tag_tools),
+        .games        = EngineAllocate(playersCount * settings->gamesCount * sizeof(tournament_game), memory_tag_tools),
+        .generators   = EngineAllocate(EngineGetThreadCount() * sizeof(move_generator), memory_tag_tools)
+    };
+    for (i32 i = 0; i < settings->gamesCount; ++i) {
+        GenerateBagSequence(InitRandomState(settings->seed, i), &run.sequences[i * settings->maxPieces], settings->maxPieces);
+    }
+
+    char text[256];
+    snprintf(text, sizeof(text), "%d players, %d games of up to %d pieces each, %d threads\n", playersCount, settings->gamesCount, settings->maxPieces, EngineGetThreadCount());
+    EnginePrint(text);
+
+    f64 startTime = EngineGetSeconds();
+    EngineRunJobs(PlayTournamentGame, &run, playersCount * settings->gamesCount);
+
+    char* summary = EngineAllocate(TOURNAMENT_SUMMARY_SIZE, memory_tag_tools);
+    i32 summaryLength = WriteTournamentSummary(&run, summary, TOURNAMENT_SUMMARY_SIZE);
+    EnginePrint(summary);
+    b32 didWrite = EngineWriteEntireFile(summaryPath, summary, summaryLength);
+
+    snprintf(text, sizeof(text), didWrite ? "Took %.1f s, summary is in %s\n" : "Took %.1f s, couldn't write %s\n", EngineGetSeconds() - startTime, summaryPath);
+    EnginePrint(text);
+
+    EngineFree(summary);
+    EngineFree(run.sequences);
+    EngineFree(run.games);
+    EngineFree(run.generators);
+    for (i32 i = 0; i < playersCount; ++i) {
+        EngineFreeLibrary(players[i].library);
+    }
+
+    return didWrite;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef TETRIS_TOURNAMENT_H
+#define TETRIS_TOURNAMENT_H
+
+#include "tetris.h"
+#include "tetris_bot_plugin.h"
+
+
+#define TOURNAMENT_MAX_PLAYERS 16
+#define TOURNAMENT_BUILTIN_PLAYER "builtin" // Instead of a DLL path, plays our own bot through the same plugin interface
+
+typedef struct tournament_settings {
+    i32 gamesCount; // Piece sequences. Every player plays every one of them
+    i32 maxPieces;  // Per game
+    f64 moveTimeBudget;
+    u32 seed;
+} tournament_settings;
+
+extern const tournament_settings TOURNAMENT_DEFAULT_SETTINGS;
+extern const bot_plugin BUILTIN_BOT_PLUGIN;
+
+extern b32 RunTournament(const char** playerPaths, i32 playersCount, tournament_settings* settings, const char* summaryPath);
+
+#endif
\ No newline at end of file
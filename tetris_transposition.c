@@ -0,0 +1,85 @@
+#include "tetris_transposition.h"
+
+#include <string.h>
+
+/*
+    A fixed size hash table of states we have already seen, keyed by Zobrist hashes (see board_t.hash). The low bits of
+    the key pick a bucket and the state can go in any entry of it.
+
+    There are no locks. Every entry is two 64-bit words that get written one after the other, so two threads storing
+    into the same entry at once can leave it with the check from one and the data from the other. The check is the key
+    xored with the data, so an entry like that doesn't match anything and gets treated as empty. The worst that can
+    happen is losing a store, which a cache like this can live with.
+
+    When a bucket is full, the entry that gets replaced is the one that is least worth keeping: entries from old
+    searches go first, then the shallowest ones.
+*/
+
+
+// sizeInBytes gets rounded down to a power of two number of buckets
+void InitTranspositionTable(transposition_table* table, i32 sizeInBytes) {
+    i32 bucketSize = TRANSPOSITION_BUCKET_SIZE * sizeof(transposition_entry);
+    i32 bucketsCount = 1;
+    while (bucketsCount * 2 * bucketSize <= sizeInBytes) {
+        bucketsCount *= 2;
+    }
+
+    *table = (transposition_table){ 0 };
+    table->entries = EngineAllocate(bucketsCount * bucketSize, memory_tag_bot); // Zeroed, which reads as empty
+    table->bucketsMask = bucketsCount - 1;
+}
+
+void FreeTranspositionTable(transposition_table* table) {
+    EngineFree(table->entries);
+    *table = (transposition_table){ 0 };
+}
+
+// Makes everything already in the table the first to go. Only clears the table once every 255 searches, when the
+// generation wraps around and entries from that long ago would start looking like they are from this one
+void NewTranspositionSearch(transposition_table* table) {
+    // 0 is what an empty entry has, so skip it to keep empty entries from looking new
+    if (++table->generation == 0) {
+        memset(table->entries, 0, (table->bucketsMask + 1) * TRANSPOSITION_BUCKET_SIZE * sizeof(transposition_entry));
+        table->generation = 1;
+    }
+}
+
+b32 ProbeTransposition(transposition_table* table, u64 key, transposition_data* outData) {
+    transposition_entry* bucket = &table->entries[(key & table->bucketsMask) * TRANSPOSITION_BUCKET_SIZE];
+    for (i32 i = 0; i < TRANSPOSITION_BUCKET_SIZE; ++i) {
+        u64 data = bucket[i].data;
+        u64 check = bucket[i].check;
+        if ((check ^ data) == key && data) {
+            outData->packed = data;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StoreTransposition(transposition_table* table, u64 key, transposition_data data) {
+    transposition_entry* bucket = &table->entries[(key & table->bucketsMask) * TRANSPOSITION_BUCKET_SIZE];
+    data.generation = table->generation;
+
+    transposition_entry* replace = &bucket[0];
+    i32 replaceWorth = 0x7FFFFFFF;
+    for (i32 i = 0; i < TRANSPOSITION_BUCKET_SIZE; ++i) {
+        transposition_data old = { .packed = bucket[i].data };
+        if ((bucket[i].check ^ old.packed) == key) {
+            replace = &bucket[i]; // Same state, so this is the newer version of it
+            break;
+        }
+
+        // Empty entries have generation 0, so they are as old as it gets
+        i32 age = (u8)(table->generation - old.generation);
+        i32 worth = old.packed ? old.depth - 256 * age : -0x10000;
+        if (worth < replaceWorth) {
+            replace = &bucket[i];
+            replaceWorth = worth;
+        }
+    }
+
+    replace->data = data.packed;
+    replace->check = key ^ data.packed;
+}
\ No newline at end of file
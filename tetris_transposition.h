@@ -0,0 +1,41 @@
+#ifndef TETRIS_TRANSPOSITION_H
+#define TETRIS_TRANSPOSITION_H
+
+#include "tetris.h"
+
+
+#define TRANSPOSITION_BUCKET_SIZE 4 // Entries per bucket. 4 of them make a 64 byte cache line
+
+// What gets stored for a state. Fits in 64 bits so an entry can be written without a lock
+typedef union transposition_data {
+    struct {
+        f32 score;
+        i16 move;      // Whatever the search wants to remember about how it got here
+        u8 depth;      // How many pieces deep the state was found. Deeper entries are worth more
+        u8 generation; // Set by StoreTransposition. Entries with the table's generation are from this search
+    };
+    u64 packed;
+} transposition_data;
+
+// check is the key xored with data. A reader that catches an entry halfway through being written gets a check that
+// doesn't match any key, so it just looks like a miss
+typedef struct transposition_entry {
+    volatile u64 check;
+    volatile u64 data;
+} transposition_entry;
+
+// Shared by every thread of a search without locks. Only InitTranspositionTable, FreeTranspositionTable and
+// NewTranspositionSearch have to be called while nobody else is using it
+typedef struct transposition_table {
+    transposition_entry* entries;
+    u64 bucketsMask;
+    u8 generation;
+} transposition_table;
+
+extern void InitTranspositionTable(transposition_table* table, i32 sizeInBytes);
+extern void FreeTranspositionTable(transposition_table* table);
+extern void NewTranspositionSearch(transposition_table* table);
+extern b32 ProbeTransposition(transposition_table* table, u64 key, transposition_data* outData);
+extern void StoreTransposition(transposition_table* table, u64 key, transposition_data data);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include "tetris_tuner.h"
+#include "tetris_selfplay.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+    A genetic algorithm over bot weights. Every generation, each candidate plays the same gamesPerCandidate self-play
+    games (tetris_selfplay.c) and gets the mean score as its fitness. The best quarter carries over as is, and the rest
+    of the next generation are crossovers of tournament winners with some gaussian noise added.
+
+    The bot's evaluation is linear in the weights, so scaling them all by the same amount doesn't change how it plays.
+    Every candidate gets normalized to length 1, which keeps the search on the part of the space that matters.
+
+    Every game of every candidate is its own job. EngineRunJobs hands jobs out one at a time from a shared counter, so
+    a thread that finishes a short game just takes the next one and nobody sits idle while the long games finish.
+    Each thread has its own single threaded bot.
+
+    After every generation the population gets written to one of two checkpoint files, taking turns, so a crash while
+    writing one still leaves the other. Running again with the same settings picks up from the newest one. Everything
+    random comes from a stream picked by the generation number (and the game, for the pieces), so a resumed run does
+    exactly what the original would have.
+*/
+
+#define TUNER_CHECKPOINT_MAGIC   0x454E5554 // "TUNE"
+#define TUNER_CHECKPOINT_VERSION 2
+
+#define TUNER_INITIAL_SPREAD    0.3f
+#define TUNER_MUTATION          0.1f
+#define TUNER_MUTATION_DECAY    0.97f // Per generation
+#define TUNER_MIN_MUTATION      0.01f
+#define TUNER_TOURNAMENT_SIZE   3
+
+// Random streams. The pieces of game g in generation n come from stream (n << 32) | g
+#define TUNER_BREEDING_STREAM(generation) (((u64)(generation) << 32) | 0xFFFFFFFF)
+#define TUNER_START_STREAM                (~0ull)
+
+const tuner_settings TUNER_DEFAULT_SETTINGS = {
+    .population        = 24,
+    .gamesPerCandidate = 8,
+    .maxPieces         = 500,
+    .previewCount      = 1,
+    .beamWidth         = 8,
+    .seed              = 1
+};
+
+static const char* FEATURE_NAMES[board_feature_count] = {
+    [board_feature_aggregate_height]   = "aggregate_height",
+    [board_feature_max_height]         = "max_height",
+    [board_feature_holes]              = "holes",
+    [board_feature_bumpiness]          = "bumpiness",
+    [board_feature_wells]              = "wells",
+    [board_feature_row_transitions]    = "row_transitions",
+    [board_feature_column_transitions] = "column_transitions",
+    [board_feature_lines_cleared]      = "lines_cleared"
+};
+
+typedef struct tuner_checkpoint {
+    u32 magic;
+    u32 version;
+    tuner_settings settings;
+    i32 generation; // The next one to run
+    f32 genes[TUNER_MAX_POPULATION][TUNER_GENES];
+    u32 checksum;   // Of everything above
+} tuner_checkpoint;
+
+typedef struct tuner_run {
+    tuner_settings* settings;
+    tuner_checkpoint* checkpoint;
+    tetromino_type* sequences; // maxPieces for every game
+    bot_t* bots;               // One per thread
+    self_play_result* results; // gamesPerCandidate for every candidate
+} tuner_run;
+
+
+static u32 GetCheckpointChecksum(tuner_checkpoint* checkpoint) {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    u8* bytes = (u8*)checkpoint;
+    for (i32 i = 0; i < (i32)offsetof(tuner_checkpoint, checksum); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static void GetCheckpointPath(const char* checkpointPath, i32 slot, char* outPath, i32 outPathSize) {
+    snprintf(outPath, outPathSize, "%s.%d", checkpointPath, slot);
+}
+
+static void WriteCheckpoint(tuner_checkpoint* checkpoint, const char* checkpointPath) {
+    checkpoint->checksum = GetCheckpointChecksum(checkpoint);
+
+    char path[280];
+    GetCheckpointPath(checkpointPath, checkpoint->generation % 2, path, sizeof(path));
+    if (!EngineWriteEntireFile(path, checkpoint, sizeof(*checkpoint))) {
+        char text[320];
+        snprintf(text, sizeof(text), "Couldn't write %s\n", path);
+        EnginePrint(text);
+    }
+}
+
+// Returns false if neither slot has a good checkpoint in it
+static b32 ReadCheckpoint(tuner_checkpoint* outCheckpoint, const char* checkpointPath) {
+    b32 didFind = false;
+    for (i32 slot = 0; slot < 2; ++slot) {
+        char path[280];
+        GetCheckpointPath(checkpointPath, slot, path, sizeof(path));
+
+        i32 bytesRead = 0;
+        tuner_checkpoint* checkpoint = EngineReadEntireFile(path, &bytesRead);
+        if (!checkpoint) {
+            continue;
+        }
+
+        b32 isGood = bytesRead == sizeof(*checkpoint) && checkpoint->magic == TUNER_CHECKPOINT_MAGIC && checkpoint->version == TUNER_CHECKPOINT_VERSION && checkpoint->checksum == GetCheckpointChecksum(checkpoint);
+        if (isGood && (!didFind || checkpoint->generation > outCheckpoint->generation)) {
+            *outCheckpoint = *checkpoint;
+            didFind = true;
+        }
+
+        EngineFree(checkpoint);
+    }
+
+    return didFind;
+}
+
+// Box-Muller
+static f32 NextRandomGaussian(random_state* random) {
+    f32 a = 1.0f - NextRandomUnit(random); // Can't be 0, logf would blow up
+    f32 b = NextRandomUnit(random);
+    return sqrtf(-2.0f * logf(a)) * cosf(TWO_PI * b);
+}
+
+static void NormalizeGenes(f32* genes) {
+    f32 lengthSquared = 0.0f;
+    for (i32 i = 0; i < TUNER_GENES; ++i) {
+        lengthSquared += genes[i] * genes[i];
+    }
+    if (lengthSquared > 0.0f) {
+        f32 scale = 1.0f / sqrtf(lengthSquared);
+        for (i32 i = 0; i < TUNER_GENES; ++i) {
+            genes[i] *= scale;
+        }
+    }
+}
+
+static void GetGenesFromWeights(const bot_weights* weights, f32* outGenes) {
+    for (i32 i = 0; i < board_feature_count; ++i) {
+        outGenes[i] = weights->features[i];
+    }
+    for (i32 i = 1; i <= 4; ++i) {
+        outGenes[board_feature_count + i - 1] = weights->lineClears[i];
+    }
+}
+
+static void SetWeightsFromGenes(bot_weights* weights, const f32* genes) {
+    for (i32 i = 0; i < board_feature_count; ++i) {
+        weights->features[i] = genes[i];
+    }
+    weights->lineClears[0] = 0.0f;
+    for (i32 i = 1; i <= 4; ++i) {
+        weights->lineClears[i] = genes[board_feature_count + i - 1];
+    }
+}
+
+// Every game of a generation gets its own pieces, and every candidate plays the same ones
+static random_state GetGameRandom(tuner_settings* settings, i32 generation, i32 game) {
+    return InitRandomState(settings->seed, ((u64)generation << 32) | (u32)game);
+}
+
+static void PlayTunerGame(void* data, i32 jobIndex, i32 threadIndex) {
+    tuner_run* run = data;
+    i32 candidate = jobIndex / run->settings->gamesPerCandidate;
+    i32 game = jobIndex % run->settings->gamesPerCandidate;
+
+    bot_t* bot = &run->bots[threadIndex];
+    SetWeightsFromGenes(&bot->weights, run->checkpoint->genes[candidate]);
+    run->results[jobIndex] = PlaySelfPlayGame(bot, &run->sequences[game * run->settings->maxPieces], run->settings->maxPieces, SELF_PLAY_INPUT_DELAY);
+}
+
+static i32 PickTournamentWinner(random_state* random, f32* fitness, i32 population) {
+    i32 winner = NextRandomI32InRange(random, 0, population - 1);
+    for (i32 i = 1; i < TUNER_TOURNAMENT_SIZE; ++i) {
+        i32 challenger = NextRandomI32InRange(random, 0, population - 1);
+        if (fitness[challenger] > fitness[winner]) {
+            winner = challenger;
+        }
+    }
+
+    return winner;
+}
+
+// In the same form as BOT_DEFAULT_WEIGHTS, so they can be pasted straight in
+static void PrintGenes(const f32* genes) {
+    char text[128];
+    EnginePrint("    .features = {\n");
+    for (i32 i = 0; i < board_feature_count; ++i) {
+        snprintf(text, sizeof(text), "        [board_feature_%s] = %.4ff,\n", FEATURE_NAMES[i], genes[i]);
+        EnginePrint(text);
+    }
+    EnginePrint("    },\n");
+    snprintf(text, sizeof(text), "    .lineClears = { 0.0f, %.4ff, %.4ff, %.4ff, %.4ff }\n", genes[board_feature_count], genes[board_feature_count + 1], genes[board_feature_count + 2], genes[board_feature_count + 3]);
+    EnginePrint(text);
+}
+
+// Fills in the next generation from the current one, which is sorted best first
+static void BreedNextGeneration(tuner_checkpoint* checkpoint, f32* fitness) {
+    i32 population = checkpoint->settings.population;
+    random_state random = InitRandomState(checkpoint->settings.seed, TUNER_BREEDING_STREAM(checkpoint->generation));
+    f32 nextGenes[TUNER_MAX_POPULATION][TUNER_GENES];
+
+    f32 mutation = Max(TUNER_MUTATION * powf(TUNER_MUTATION_DECAY, (f32)checkpoint->generation), TUNER_MIN_MUTATION);
+    i32 elitesCount = Max(population / 4, 1);
+    for (i32 i = 0; i < population; ++i) {
+        if (i < elitesCount) {
+            for (i32 j = 0; j < TUNER_GENES; ++j) {
+                nextGenes[i][j] = checkpoint->genes[i][j];
+            }
+            continue;
+        }
+
+        f32* a = checkpoint->genes[PickTournamentWinner(&random, fitness, population)];
+        f32* b = checkpoint->genes[PickTournamentWinner(&random, fitness, population)];
+        for (i32 j = 0; j < TUNER_GENES; ++j) {
+            nextGenes[i][j] = a[j] + NextRandomUnit(&random) * (b[j] - a[j]) + mutation * NextRandomGaussian(&random);
+        }
+        NormalizeGenes(nextGenes[i]);
+    }
+
+    for (i32 i = 0; i < population; ++i) {
+        for (i32 j = 0; j < TUNER_GENES; ++j) {
+            checkpoint->genes[i][j] = nextGenes[i][j];
+        }
+    }
+}
+
+static b32 AreTunerSettingsEqual(tuner_settings* a, tuner_settings* b) {
+    return a->population == b->population && a->gamesPerCandidate == b->gamesPerCandidate && a->maxPieces == b->maxPieces &&
+           a->previewCount == b->previewCount && a->beamWidth == b->beamWidth && a->seed == b->seed;
+}
+
+// Runs until generations generations have been done in total, counting the ones from earlier runs with the same checkpoint
+void RunTuner(tuner_settings* settings, i32 generations, const char* checkpointPath) {
+    char text[256];
+
+    settings->population = Clamp(settings->population, 2, TUNER_MAX_POPULATION);
+    settings->gamesPerCandidate = Max(settings->gamesPerCandidate, 1);
+    settings->maxPieces = Max(settings->maxPieces, 4);
+
+    tuner_checkpoint* checkpoint = EngineAllocate(sizeof(tuner_checkpoint), memory_tag_tools);
+    if (ReadCheckpoint(checkpoint, checkpointPath)) {
+        if (!AreTunerSettingsEqual(&checkpoint->settings, settings)) {
+            snprintf(text, sizeof(text), "%s.0/.1 were made with different settings. Use the same ones or another -checkpoint\n", checkpointPath);
+            EnginePrint(text);
+            EngineFree(checkpoint);
+            return;
+        }
+
+        snprintf(text, sizeof(text), "Resuming from generation %d\n", checkpoint->generation);
+        EnginePrint(text);
+    }
+    else {
+        *checkpoint = (tuner_checkpoint){
+            .magic    = TUNER_CHECKPOINT_MAGIC,
+            .version  = TUNER_CHECKPOINT_VERSION,
+            .settings = *settings
+        };
+
+        // Start around the weights the game ships with
+        random_state random = InitRandomState(settings->seed, TUNER_START_STREAM);
+        GetGenesFromWeights(&BOT_DEFAULT_WEIGHTS, checkpoint->genes[0]);
+        NormalizeGenes(checkpoint->genes[0]);
+        for (i32 i = 1; i < settings->population; ++i) {
+            for (i32 j = 0; j < TUNER_GENES; ++j) {
+                checkpoint->genes[i][j] = checkpoint->genes[0][j] + TUNER_INITIAL_SPREAD * NextRandomGaussian(&random);
+            }
+            NormalizeGenes(checkpoint->genes[i]);
+        }
+    }
+
+    i32 gamesCount = settings->population * settings->gamesPerCandidate;
+    tuner_run run = {
+        .settings   = settings,
+        .checkpoint = checkpoint,
+        .sequences  = EngineAllocate(settings->gamesPerCandidate * settings->maxPieces * sizeof(tetromino_type), memory_tag_tools),
+        .bots       = EngineAllocate(EngineGetThreadCount() * sizeof(bot_t), memory_tag_tools),
+        .results    = EngineAllocate(gamesCount * sizeof(self_play_result), memory_tag_tools)
+    };
+    for (i32 i = 0; i < EngineGetThreadCount(); ++i) {
+        InitSingleThreadedBot(&run.bots[i]);
+        run.bots[i].timeBudget = 1e9; // Always search to the full depth, so results don't depend on how busy the machine is
+        run.bots[i].previewCount = settings->previewCount;
+        run.bots[i].beamWidth = settings->beamWidth;
+    }
+
+    snprintf(text, sizeof(text), "Tuning with %d candidates, %d games of up to %d pieces each, %d threads\n", settings->population, settings->gamesPerCandidate, settings->maxPieces, EngineGetThreadCount());
+    EnginePrint(text);
+
+    f32 fitness[TUNER_MAX_POPULATION];
+    while (checkpoint->generation < generations) {
+        f64 startTime = EngineGetSeconds();
+
+        for (i32 i = 0; i < settings->gamesPerCandidate; ++i) {
+            GenerateBagSequence(GetGameRandom(settings, checkpoint->generation, i), &run.sequences[i * settings->maxPieces], settings->maxPieces);
+        }
+
+        EngineRunJobs(PlayTunerGame, &run, gamesCount);
+
+        f32 totalLines = 0.0f;
+        for (i32 i = 0; i < settings->population; ++i) {
+            f32 totalScore = 0.0f;
+            for (i32 j = 0; j < settings->gamesPerCandidate; ++j) {
+                totalScore += (f32)run.results[i * settings->gamesPerCandidate + j].score;
+                totalLines += (f32)run.results[i * settings->gamesPerCandidate + j].lines;
+            }
+            fitness[i] = totalScore / settings->gamesPerCandidate;
+        }
+
+        // Best first. Small enough for insertion sort
+        for (i32 i = 1; i < settings->population; ++i) {
+            for (i32 j = i; j > 0 && fitness[j] > fitness[j - 1]; --j) {
+                f32 temp = fitness[j];
+                fitness[j] = fitness[j - 1];
+                fitness[j - 1] = temp;
+
+                for (i32 k = 0; k < TUNER_GENES; ++k) {
+                    temp = checkpoint->genes[j][k];
+                    checkpoint->genes[j][k] = checkpoint->genes[j - 1][k];
+                    checkpoint->genes[j - 1][k] = temp;
+                }
+            }
+        }
+
+        f32 meanFitness = 0.0f;
+        for (i32 i = 0; i < settings->population; ++i) {
+            meanFitness += fitness[i] / settings->population;
+        }
+
+        snprintf(text, sizeof(text), "Generation %d: best %.0f, mean %.0f, %.1f lines per game, %.1f s\n", checkpoint->generation, fitness[0], meanFitness, totalLines / gamesCount, EngineGetSeconds() - startTime);
+        EnginePrint(text);
+        PrintGenes(checkpoint->genes[0]);
+
+        BreedNextGeneration(checkpoint, fitness);
+        ++checkpoint->generation;
+        WriteCheckpoint(checkpoint, checkpointPath);
+    }
+
+    for (i32 i = 0; i < EngineGetThreadCount(); ++i) {
+        FreeBot(&run.bots[i]);
+    }
+    EngineFree(run.bots);
+    EngineFree(run.sequences);
+    EngineFree(run.results);
+    EngineFree(checkpoint);
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef TETRIS_TUNER_H
+#define TETRIS_TUNER_H
+
+#include "tetris.h"
+#include "tetris_bot.h"
+
+
+#define TUNER_MAX_POPULATION 64
+#define TUNER_GENES (board_feature_count + 4) // The feature weights, then the rewards for 1 to 4 lines
+
+typedef struct tuner_settings {
+    i32 population;
+    i32 gamesPerCandidate;
+    i32 maxPieces;    // Per game
+    i32 previewCount; // For the bot. See bot_t
+    i32 beamWidth;
+    u32 seed;
+} tuner_settings;
+
+extern const tuner_settings TUNER_DEFAULT_SETTINGS;
+
+extern void RunTuner(tuner_settings* settings, i32 generations, const char* checkpointPath);
+
+#endif
\ No newline at end of file
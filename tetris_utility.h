@@ -6,6 +6,7 @@
 #define Assert(expression) if (!(expression)) *(char*)0 = 0
 #define Min(a, b) ((a) < (b) ? (a) : (b))
 #define Max(a, b) ((a) > (b) ? (a) : (b))
+#define Abs(a) ((a) < 0 ? -(a) : (a))
 #define Clamp(val, min, max) ((val) < (min) ? (min) : (val) > (max) ? (max) : (val))
 
 #define PI     3.14159265f
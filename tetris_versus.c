@@ -0,0 +1,405 @@
+#include "tetris_versus.h"
+#include "tetris_random.h"
+
+#include <string.h>
+
+/*
+    Rollback netcode for two players, each on their own instance of the game.
+
+    Both sides run both games, frame by frame, from both players' inputs. Local inputs are known right away. Remote
+    ones take a while to get here, so until they do we guess that the other player is still holding whatever they
+    held last, and keep going. When the real inputs show up and don't match the guess, we restore the snapshot from
+    the start of the first frame we got wrong and simulate everything from there again. That is cheap because the
+    whole world is a couple of game_states with no pointers in it, and a frame is only VERSUS_TICKS_PER_FRAME ticks.
+
+    This only works if the simulation is the same on both sides given the same inputs: no floats that could come out
+    differently, no global random state, nothing that depends on how fast we are drawing. The two games share a seed
+    (player 0 picks it), and the garbage holes come from a random state that is part of the world.
+
+    To catch it when it goes wrong anyway, both sides checksum the world after every frame for which they have both
+    players' inputs, and send the latest one along with their inputs. Different checksums for the same frame means a
+    desync, and there is no coming back from that.
+
+    We never get more than VERSUS_MAX_ROLLBACK frames ahead of the last remote input we have. If the other side is
+    slower or the connection is bad, we wait for it instead of guessing further, so a rollback never has to redo more
+    than that.
+
+    Each side sends how far ahead of the other it thinks it is. Both see the other's frame late by the same latency,
+    so half of the difference between the two is how far ahead we really are. Whoever is ahead sits out a frame now
+    and then until that is gone. Otherwise the side that started first stays ahead by the round trip forever, and
+    gets all the rollbacks.
+*/
+
+static const i32 GARBAGE_FOR_LINES[5] = { 0, 0, 1, 2, 4 };
+
+#define GARBAGE_TILE tetromino_type_O // There is no grey tile
+
+
+static inline i32 GetHistoryIndex(i32 frame) {
+    return frame & (VERSUS_HISTORY_SIZE - 1);
+}
+
+static void SaveVersusWorld(versus_session* session, versus_world* outWorld) {
+    for (i32 player = 0; player < 2; ++player) {
+        SnapshotGameState(&session->world.games[player], &session->boards[player], &outWorld->games[player]);
+    }
+    outWorld->garbageRandom = session->world.garbageRandom;
+    for (i32 player = 0; player < 2; ++player) {
+        outWorld->pendingGarbage[player] = session->world.pendingGarbage[player];
+        outWorld->isGameOver[player] = session->world.isGameOver[player];
+    }
+}
+
+static void LoadVersusWorld(versus_session* session, versus_world* world) {
+    memcpy(&session->world, world, sizeof(*world));
+    for (i32 player = 0; player < 2; ++player) {
+        UseGameStateBoard(&session->world.games[player], &session->boards[player]);
+    }
+}
+
+static u32 GetVersusWorldChecksum(versus_world* world) {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    u8* bytes = (u8*)world;
+    for (i32 i = 0; i < (i32)sizeof(*world); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+static void StartVersusSession(versus_session* session, u32 seed) {
+    session->seed = seed;
+    session->isStarted = true;
+
+    // Both games get the same pieces
+    for (i32 player = 0; player < 2; ++player) {
+        session->boards[player] = InitBoardInMemory(BOARD_WIDTH, BOARD_HEIGHT, session->world.games[player].boardMemory, session->boards[player].x, session->boards[player].y, session->boards[player].tileSize);
+        InitGameState(&session->world.games[player], &session->boards[player], InitRandomState(seed, 1));
+    }
+    session->world.garbageRandom = InitRandomState(seed, 2);
+
+    SaveVersusWorld(session, &session->snapshots[0]);
+}
+
+// Returns false if the board couldn't make room for all of it, which is game over
+static b32 AddGarbageRows(board_t* board, i32 rowsCount, i32 holeX) {
+    if (board->stackHeight + rowsCount > board->height) {
+        return false;
+    }
+
+    for (i32 y = board->stackHeight - 1; y >= 0; --y) {
+        SetBoardRow(board, y + rowsCount, GetBoardRow(board, y));
+    }
+
+    tetromino_type row[BOARD_WIDTH];
+    for (i32 x = 0; x < board->width; ++x) {
+        row[x] = x == holeX ? tetromino_type_empty : GARBAGE_TILE;
+    }
+    for (i32 y = 0; y < rowsCount; ++y) {
+        SetBoardRow(board, y, row);
+    }
+
+    RecalculateBoardHeights(board, board->stackHeight + rowsCount);
+    return true;
+}
+
+static void SetVersusKeys(keyboard_state* keyboard, u8 input, u8 previousInput) {
+    keyboard_key_state* keys[7] = { &keyboard->left, &keyboard->right, &keyboard->x, &keyboard->z, &keyboard->c, &keyboard->down, &keyboard->spacebar };
+    for (i32 i = 0; i < ArraySize(keys); ++i) {
+        keys[i]->isDown = (input >> i) & 1;
+        keys[i]->didChangeState = ((input ^ previousInput) >> i) & 1;
+    }
+}
+
+// The remote input that goes with a frame: the real one if it is here, a guess otherwise
+static u8 GetRemoteInput(versus_session* session, i32 frame) {
+    i32 remotePlayer = 1 - session->localPlayer;
+    if (frame <= session->remoteConfirmedFrame) {
+        return session->inputs[remotePlayer][GetHistoryIndex(frame)];
+    }
+
+    return session->remoteConfirmedFrame >= 0 ? session->inputs[remotePlayer][GetHistoryIndex(session->remoteConfirmedFrame)] : 0;
+}
+
+static void SimulateVersusFrame(versus_session* session, i32 frame, b32 isResimulating) {
+    versus_world* world = &session->world;
+    i32 index = GetHistoryIndex(frame);
+
+    session->usedInputs[session->localPlayer][index] = session->inputs[session->localPlayer][index];
+    session->usedInputs[1 - session->localPlayer][index] = GetRemoteInput(session, frame);
+
+    keyboard_state keyboards[2] = { 0 };
+    for (i32 player = 0; player < 2; ++player) {
+        u8 previousInput = frame > 0 ? session->usedInputs[player][GetHistoryIndex(frame - 1)] : 0;
+        SetVersusKeys(&keyboards[player], session->usedInputs[player][index], previousInput);
+    }
+
+    game_events events;
+    events.droppedCount = 0;
+    for (i32 tick = 0; tick < VERSUS_TICKS_PER_FRAME; ++tick) {
+        for (i32 player = 0; player < 2; ++player) {
+            if (world->isGameOver[player]) {
+                continue;
+            }
+
+            game_state* game = &world->games[player];
+            board_t* board = &session->boards[player];
+            i32 linesBefore = game->lines;
+
+            ClearGameEvents(&events);
+            b32 isAlive = UpdateGameState(game, board, &keyboards[player], &events);
+
+            // Garbage cancels out what is waiting to come in first
+            i32 garbage = GARBAGE_FOR_LINES[Min(game->lines - linesBefore, 4)];
+            i32 cancelled = Min(garbage, world->pendingGarbage[player]);
+            world->pendingGarbage[player] -= cancelled;
+            world->pendingGarbage[1 - player] += garbage - cancelled;
+
+            if (isAlive && HasGameEvent(&events, game_event_locked) && world->pendingGarbage[player] > 0) {
+                i32 holeX = NextRandomBelow(&world->garbageRandom, board->width);
+                isAlive = AddGarbageRows(board, world->pendingGarbage[player], holeX) && IsTetrominoPosValid(board, &game->current);
+                world->pendingGarbage[player] = 0;
+            }
+
+            world->isGameOver[player] = !isAlive;
+            if (player == session->localPlayer && !isResimulating) {
+                AppendGameEvents(&session->localEvents, &events);
+            }
+        }
+
+        // Presses only happen on the first tick of the frame
+        for (i32 player = 0; player < 2; ++player) {
+            for (i32 i = 0; i < ArraySize(keyboards[player].keys); ++i) {
+                keyboards[player].keys[i].didChangeState = false;
+            }
+        }
+    }
+
+    SaveVersusWorld(session, &session->snapshots[GetHistoryIndex(frame + 1)]);
+}
+
+static void SendVersusPacketNow(versus_session* session, versus_packet* packet) {
+    EngineSendPacket(session->socket, session->remotePort, packet, sizeof(*packet));
+}
+
+static void SendVersusPacket(versus_session* session) {
+    versus_packet packet = {
+        .magic         = VERSUS_PACKET_MAGIC,
+        .seed          = session->isStarted ? session->seed : 0,
+        .frame         = session->frame,
+        .advantage     = session->frame - session->remoteFrame,
+        .ackFrame      = session->remoteConfirmedFrame,
+        .firstFrame    = Max(session->remoteAckFrame + 1, session->frame - VERSUS_HISTORY_SIZE),
+        .checksumFrame = session->checkedFrame,
+        .checksum      = session->checkedFrame >= 0 ? session->checksums[GetHistoryIndex(session->checkedFrame)] : 0
+    };
+    packet.inputsCount = Max(session->frame - packet.firstFrame, 0);
+    for (i32 i = 0; i < packet.inputsCount; ++i) {
+        packet.inputs[i] = session->inputs[session->localPlayer][GetHistoryIndex(packet.firstFrame + i)];
+    }
+
+    ++session->stats.packetsSent;
+    versus_network_settings* network = &session->network;
+    if (network->latency <= 0.0f && network->jitter <= 0.0f && network->loss <= 0.0f) {
+        SendVersusPacketNow(session, &packet);
+        return;
+    }
+
+    if (NextRandomUnit(&session->networkRandom) < network->loss || session->delayedPacketsCount == ArraySize(session->delayedPackets)) {
+        ++session->stats.packetsDropped;
+        return;
+    }
+
+    versus_delayed_packet* delayed = &session->delayedPackets[session->delayedPacketsCount++];
+    delayed->sendTime = session->time + network->latency + network->jitter * NextRandomUnit(&session->networkRandom);
+    delayed->packet = packet;
+}
+
+static void SendDelayedVersusPackets(versus_session* session) {
+    i32 keptCount = 0;
+    for (i32 i = 0; i < session->delayedPacketsCount; ++i) {
+        versus_delayed_packet* delayed = &session->delayedPackets[i];
+        if (delayed->sendTime <= session->time) {
+            SendVersusPacketNow(session, &delayed->packet);
+        }
+        else {
+            session->delayedPackets[keptCount++] = *delayed;
+        }
+    }
+    session->delayedPacketsCount = keptCount;
+}
+
+// Returns the first frame that was simulated with a wrong guess, or session->frame if there wasn't one
+static i32 ReceiveVersusPackets(versus_session* session) {
+    i32 remotePlayer = 1 - session->localPlayer;
+    i32 rollbackFrame = session->frame;
+
+    versus_packet packet;
+    i32 size;
+    while ((size = EngineReceivePacket(session->socket, &packet, sizeof(packet))) > 0) {
+        if (size != sizeof(packet) || packet.magic != VERSUS_PACKET_MAGIC || packet.inputsCount < 0 || packet.inputsCount > ArraySize(packet.inputs)) {
+            continue;
+        }
+        ++session->stats.packetsReceived;
+        session->lastReceiveTime = session->time;
+
+        if (!session->isStarted) {
+            if (session->localPlayer == 0) {
+                StartVersusSession(session, session->seed);
+            }
+            else if (packet.seed != 0) {
+                StartVersusSession(session, packet.seed);
+            }
+            else {
+                continue; // Player 0 hasn't heard from us yet either
+            }
+        }
+
+        session->remoteAckFrame = Max(session->remoteAckFrame, packet.ackFrame);
+        if (packet.frame > session->remoteFrame) {
+            session->remoteFrame = packet.frame;
+            session->remoteAdvantage = packet.advantage;
+        }
+
+        for (i32 i = 0; i < packet.inputsCount; ++i) {
+            i32 frame = packet.firstFrame + i;
+            if (frame <= session->remoteConfirmedFrame) {
+                continue;
+            }
+            // Only in order, and never so far ahead that it would land on something we still need
+            if (frame != session->remoteConfirmedFrame + 1 || frame >= session->frame + VERSUS_HISTORY_SIZE / 2) {
+                break;
+            }
+
+            i32 index = GetHistoryIndex(frame);
+            session->inputs[remotePlayer][index] = packet.inputs[i];
+            session->remoteConfirmedFrame = frame;
+            if (frame < session->frame && session->usedInputs[remotePlayer][index] != packet.inputs[i]) {
+                rollbackFrame = Min(rollbackFrame, frame);
+            }
+        }
+
+        if (packet.checksumFrame > session->remoteChecksumFrame) {
+            session->remoteChecksumFrame = packet.checksumFrame;
+            session->remoteChecksum = packet.checksum;
+        }
+    }
+
+    return rollbackFrame;
+}
+
+// Works out the checksums of the frames that are now final, compares them with the other side's, and sees if
+// anyone has lost
+static void CheckVersusFrames(versus_session* session) {
+    i32 lastFrame = Min(session->remoteConfirmedFrame, session->frame - 1);
+    while (session->checkedFrame < lastFrame && session->result == versus_result_playing) {
+        i32 frame = ++session->checkedFrame;
+        versus_world* world = &session->snapshots[GetHistoryIndex(frame + 1)];
+        session->checksums[GetHistoryIndex(frame)] = GetVersusWorldChecksum(world);
+
+        if (world->isGameOver[0] || world->isGameOver[1]) {
+            if (world->isGameOver[0] && world->isGameOver[1]) {
+                session->result = versus_result_draw;
+            }
+            else {
+                session->result = world->isGameOver[session->localPlayer] ? versus_result_lost : versus_result_won;
+            }
+        }
+    }
+
+    i32 frame = session->remoteChecksumFrame;
+    if (frame >= 0 && frame <= session->checkedFrame) {
+        if (frame > session->checkedFrame - VERSUS_HISTORY_SIZE && session->checksums[GetHistoryIndex(frame)] != session->remoteChecksum) {
+            session->result = versus_result_desynced;
+        }
+        session->remoteChecksumFrame = -1;
+    }
+}
+
+// seed is only used if we end up player 0. Returns false if the local port is taken
+b32 InitVersusSession(versus_session* session, u16 localPort, u16 remotePort, u32 seed, versus_network_settings* network) {
+    memset(session, 0, sizeof(*session));
+
+    session->socket = EngineOpenSocket(localPort);
+    if (!session->socket) {
+        return false;
+    }
+
+    session->remotePort = remotePort;
+    session->localPlayer = localPort < remotePort ? 0 : 1;
+    session->seed = seed != 0 ? seed : 1; // 0 in a packet means no seed yet
+    session->remoteConfirmedFrame = -1;
+    session->remoteAckFrame = -1;
+    session->checkedFrame = -1;
+    session->remoteChecksumFrame = -1;
+    session->network = *network;
+    session->networkRandom = InitRandomState(localPort, 3);
+
+    for (i32 player = 0; player < 2; ++player) {
+        session->boards[player] = InitBoardInMemory(BOARD_WIDTH, BOARD_HEIGHT, session->world.games[player].boardMemory, 0, 0, 0);
+    }
+
+    return true;
+}
+
+void FreeVersusSession(versus_session* session) {
+    EngineCloseSocket(session->socket);
+    session->socket = 0;
+}
+
+// Call once a frame, whether or not there is a game going. localInput is the VERSUS_INPUT_ bits the local player has
+// down. Simulates as many frames as deltaTime covers, unless that would get too far ahead of the other side
+void UpdateVersusSession(versus_session* session, f32 deltaTime, u8 localInput) {
+    session->time += deltaTime;
+
+    i32 rollbackFrame = ReceiveVersusPackets(session);
+    if (rollbackFrame < session->frame) {
+        i32 rollback = session->frame - rollbackFrame;
+        ++session->stats.rollbacksCount;
+        session->stats.rolledBackFramesCount += rollback;
+        session->stats.maxRollback = Max(session->stats.maxRollback, rollback);
+
+        LoadVersusWorld(session, &session->snapshots[GetHistoryIndex(rollbackFrame)]);
+        for (i32 frame = rollbackFrame; frame < session->frame; ++frame) {
+            SimulateVersusFrame(session, frame, true);
+        }
+    }
+
+    if (session->isStarted) {
+        CheckVersusFrames(session);
+    }
+
+    if (session->isStarted && session->result == versus_result_playing) {
+        session->secondsSinceLastFrame += Min(deltaTime, VERSUS_MAX_FRAMES_PER_UPDATE * VERSUS_SECONDS_PER_FRAME);
+        while (session->secondsSinceLastFrame >= VERSUS_SECONDS_PER_FRAME) {
+            b32 canAdvance = session->frame - session->remoteConfirmedFrame <= VERSUS_MAX_ROLLBACK && session->frame - session->remoteAckFrame < VERSUS_HISTORY_SIZE;
+            if (!canAdvance) {
+                ++session->stats.stallsCount;
+                session->secondsSinceLastFrame = VERSUS_SECONDS_PER_FRAME; // Go as soon as we can, but don't build up a backlog
+                break;
+            }
+
+            session->secondsSinceLastFrame -= VERSUS_SECONDS_PER_FRAME;
+
+            i32 lead = (session->frame - session->remoteFrame - session->remoteAdvantage) / 2;
+            if (lead > 0 && session->frame - session->lastSyncWaitFrame >= VERSUS_SYNC_INTERVAL) {
+                ++session->stats.syncWaitsCount;
+                session->lastSyncWaitFrame = session->frame;
+                continue;
+            }
+
+            session->inputs[session->localPlayer][GetHistoryIndex(session->frame)] = localInput;
+            SimulateVersusFrame(session, session->frame, false);
+            ++session->frame;
+        }
+
+        if (session->time - session->lastReceiveTime > VERSUS_TIMEOUT) {
+            session->result = versus_result_disconnected;
+        }
+    }
+
+    // Keeps going after the game is over, the other side might still need our last inputs to see it end too
+    SendVersusPacket(session);
+    SendDelayedVersusPackets(session);
+}
\ No newline at end of file
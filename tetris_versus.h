@@ -0,0 +1,131 @@
+#ifndef TETRIS_VERSUS_H
+#define TETRIS_VERSUS_H
+
+#include "tetris.h"
+#include "tetris_board.h"
+#include "tetris_rules.h"
+#include "tetris_game_state.h"
+
+
+#define VERSUS_TICKS_PER_FRAME      16  // Inputs go over the wire once a frame, that is 62.5 times a second
+#define VERSUS_SECONDS_PER_FRAME    (VERSUS_TICKS_PER_FRAME * SECONDS_PER_TICK)
+#define VERSUS_MAX_ROLLBACK         12  // Frames we can get ahead of the last input we have from the other side before we wait for it
+#define VERSUS_HISTORY_SIZE         32  // Frames of inputs, snapshots and checksums kept around. Has to be well over twice VERSUS_MAX_ROLLBACK
+#define VERSUS_MAX_FRAMES_PER_UPDATE 4  // After a stall we drop time rather than catch up
+#define VERSUS_SYNC_INTERVAL        10  // Frames between the waits of the side that is ahead, so it slows down without stuttering
+#define VERSUS_TIMEOUT              5.0f // Seconds without hearing from the other side before we give up on them
+#define VERSUS_MAX_DELAYED_PACKETS  256
+#define VERSUS_PACKET_MAGIC         0x53565354 // "TSVS"
+
+// The keys a player has down during a frame. A tap that comes and goes within a frame still counts as down for it
+#define VERSUS_INPUT_LEFT       0x01
+#define VERSUS_INPUT_RIGHT      0x02
+#define VERSUS_INPUT_ROTATE_CW  0x04
+#define VERSUS_INPUT_ROTATE_CCW 0x08
+#define VERSUS_INPUT_HOLD       0x10
+#define VERSUS_INPUT_SOFT_DROP  0x20
+#define VERSUS_INPUT_HARD_DROP  0x40
+
+typedef enum versus_result {
+    versus_result_playing = 0,
+    versus_result_won,
+    versus_result_lost,
+    versus_result_draw,         // Both topped out in the same frame
+    versus_result_disconnected,
+    versus_result_desynced      // The two sides worked out different games from the same inputs
+} versus_result;
+
+// Sent every update. Inputs get sent again until the other side says it has them, so a lost packet costs nothing
+// but some delay
+typedef struct versus_packet {
+    u32 magic;
+    u32 seed;          // Player 0 picks it, player 1 takes it from the first packet it gets. 0 until then
+    i32 frame;         // The sender's, as of sending
+    i32 advantage;     // How many frames the sender thinks it is ahead, see UpdateVersusSession
+    i32 ackFrame;      // The sender has all of the receiver's inputs up to here
+    i32 firstFrame;    // Of inputs
+    i32 inputsCount;
+    i32 checksumFrame; // The sender's checksum of the game after this frame, both players' inputs known. -1 before there is one
+    u32 checksum;
+    u8 inputs[VERSUS_HISTORY_SIZE];
+} versus_packet;
+
+// For trying out bad connections on localhost. Outgoing packets get held back or thrown away
+typedef struct versus_network_settings {
+    f32 latency; // Seconds, one way
+    f32 jitter;  // Up to this many seconds more, at random. Packets can arrive out of order
+    f32 loss;    // 0 to 1
+} versus_network_settings;
+
+typedef struct versus_delayed_packet {
+    f64 sendTime;
+    versus_packet packet;
+} versus_delayed_packet;
+
+// Everything that gets rolled back. Pointer-free like game_state, so a snapshot is a copy
+typedef struct versus_world {
+    game_state games[2];
+    random_state garbageRandom;
+    i32 pendingGarbage[2]; // Rows each player gets at their next lock
+    b32 isGameOver[2];
+} versus_world;
+
+typedef struct versus_stats {
+    i32 rollbacksCount;
+    i32 rolledBackFramesCount;
+    i32 maxRollback;         // Frames
+    i32 stallsCount;         // Updates that wanted a frame and had to wait for the other side
+    i32 syncWaitsCount;      // Frames skipped to let the other side catch up
+    i32 packetsSent;
+    i32 packetsDropped;      // On purpose, see versus_network_settings
+    i32 packetsReceived;
+} versus_stats;
+
+/*
+    Two games, one per player, simulated the same way on both sides from both players' inputs. See tetris_versus.c
+*/
+typedef struct versus_session {
+    engine_socket socket;
+    u16 remotePort;
+    i32 localPlayer; // The one on the lower port is player 0
+    u32 seed;
+    b32 isStarted;   // We have heard from the other side and both games are set up
+    versus_result result;
+    game_events localEvents; // The local player's since the caller last published them. Not from re-simulated frames
+
+    f64 time;        // Sum of the deltaTimes given to UpdateVersusSession
+    f64 lastReceiveTime;
+    f32 secondsSinceLastFrame;
+
+    i32 frame;                // The next one to simulate
+    i32 remoteFrame;          // The other side's, as of the latest packet
+    i32 remoteAdvantage;      // Same
+    i32 lastSyncWaitFrame;
+    i32 remoteConfirmedFrame; // Every remote input up to here has arrived. -1 before any have
+    i32 remoteAckFrame;       // The other side has every local input up to here
+    i32 checkedFrame;         // Checksums are worked out up to here
+    i32 remoteChecksumFrame;  // Of the latest checksum from the other side that hasn't been compared yet, -1 if none
+    u32 remoteChecksum;
+
+    // All by frame % VERSUS_HISTORY_SIZE
+    u8 inputs[2][VERSUS_HISTORY_SIZE];           // By player. Remote ones only from remoteConfirmedFrame down
+    u8 usedInputs[2][VERSUS_HISTORY_SIZE];       // What the simulation went with, guesses included
+    versus_world snapshots[VERSUS_HISTORY_SIZE]; // At the start of each frame
+    u32 checksums[VERSUS_HISTORY_SIZE];          // Of the snapshot after each frame
+
+    versus_world world;
+    board_t boards[2]; // Views into world. Where they get drawn is up to whoever draws them
+
+    versus_network_settings network;
+    random_state networkRandom;
+    versus_delayed_packet delayedPackets[VERSUS_MAX_DELAYED_PACKETS];
+    i32 delayedPacketsCount;
+
+    versus_stats stats;
+} versus_session;
+
+extern b32 InitVersusSession(versus_session* session, u16 localPort, u16 remotePort, u32 seed, versus_network_settings* network);
+extern void FreeVersusSession(versus_session* session);
+extern void UpdateVersusSession(versus_session* session, f32 deltaTime, u8 localInput);
+
+#endif
\ No newline at end of file
@@ -1,14 +1,20 @@
+#include <WinSock2.h> // Has to come before Windows.h, which pulls in the old one otherwise
 #include <Windows.h>
 #include <dsound.h>
 #include "tetris.h"
 #include "win32_tetris.h"
 #pragma comment(lib, "winmm.lib")  // Perhaps I should just add these to additional dependencies instead?
 #pragma comment(lib, "dsound.lib") // ...Like, for compatability reasons and stuff
+#pragma comment(lib, "ws2_32.lib")
 
 // Debug / testing. Remove!
 #include <stdio.h>
 #include <math.h>
 
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
 typedef struct win32_bitmap {
     BITMAPINFO info;
     void* memory;
@@ -22,10 +28,200 @@ typedef struct win32_ivec2 {
     i32 y;
 } win32_ivec2;
 
+// Not defined in older SDKs. The flag itself needs Windows 10 1803 or later, we fall back to a normal timer otherwise
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+typedef enum frame_pacer_mode {
+    frame_pacer_mode_uncapped = 0, // Never wait
+    frame_pacer_mode_fixed,        // Only sleep on the timer, never spin. Cheapest, but late by however much the timer oversleeps
+    frame_pacer_mode_hybrid,       // Sleep on the timer until a fixed margin before the deadline, spin for the rest
+    frame_pacer_mode_adaptive      // Like hybrid, but the margin is learned from how late the timer actually wakes us up
+} frame_pacer_mode;
+
+typedef struct frame_pacer_stats {
+    i32 frameCount;
+    i32 missedDeadlineCount; // The frame itself took longer than the frame time
+    i32 lateWakeupCount;     // The frame was on time, but we overslept past the deadline
+    i64 worstLatenessTicks;
+    i64 totalSleepTicks;
+    i64 totalSpinTicks;
+} frame_pacer_stats;
+
+typedef struct frame_pacer {
+    frame_pacer_mode mode;
+    HANDLE timer;
+    b32 isTimerHighResolution;
+
+    i64 frequency;
+    i64 ticksPerFrame;
+    i64 deadline;
+    i64 lastFrameEnd;
+
+    i64 spinMarginTicks;
+    f64 wakeupErrorMean;      // How late the timer wakes us up on average, in ticks
+    f64 wakeupErrorDeviation; // Mean absolute deviation of the above
+
+    frame_pacer_stats stats;      // Since the last report
+    frame_pacer_stats statsTotal; // Since startup
+} frame_pacer;
+
+typedef struct win32_input_event {
+    i64 performanceCount;
+    i32 keyIndex;
+    b32 isDown;
+} win32_input_event;
+
+#define INPUT_QUEUE_SIZE 256 // Must be a power of two
+
+// Single producer, single consumer. The indices only ever grow and are wrapped when used
+typedef struct win32_input_queue {
+    win32_input_event events[INPUT_QUEUE_SIZE];
+    volatile LONG writeIndex; // Only written by the polling thread
+    volatile LONG readIndex;  // Only written by the main thread
+} win32_input_queue;
+
+typedef struct win32_input_poller {
+    win32_input_queue queue;
+    HANDLE thread;
+    volatile LONG isRunning;
+} win32_input_poller;
+
+#define MAX_WORKER_THREADS 15
+
+// Only one batch of jobs runs at a time, and EngineRunJobs doesn't return before every worker it woke up is done with it
+typedef struct win32_job_queue {
+    engine_job job;
+    void* data;
+    i32 jobsCount;
+    volatile LONG nextJobIndex;
+    volatile LONG workersDone;
+
+    HANDLE semaphore;
+    HANDLE threads[MAX_WORKER_THREADS];
+    i32 workersCount;
+} win32_job_queue;
+
+// Small allocations come out of a pool instead of getting their own VirtualAlloc, which would be a syscall and 64 KB
+// of address space each. Every chunk of the pool holds blocks of one power of two size, so the size of a block is
+// found from its address, and freed blocks go on a list per size. Chunks are never given back
+#define POOL_MIN_BLOCK_SHIFT 4  // 16 bytes
+#define POOL_MAX_BLOCK_SHIFT 15 // 32 KB, anything bigger gets its own VirtualAlloc
+#define POOL_SIZE_CLASS_COUNT (POOL_MAX_BLOCK_SHIFT - POOL_MIN_BLOCK_SHIFT + 1)
+#define POOL_CHUNK_SIZE (64 * 1024)
+#define POOL_RESERVE_SIZE (64 * 1024 * 1024)
+#define POOL_CHUNK_COUNT (POOL_RESERVE_SIZE / POOL_CHUNK_SIZE)
+
+typedef struct win32_pool {
+    u8* memory; // Reserved on first use
+    i32 chunksCount;
+    u8 chunkSizeClasses[POOL_CHUNK_COUNT];
+    void* freeBlocks[POOL_SIZE_CLASS_COUNT]; // Every free block starts with a pointer to the next one
+} win32_pool;
+
+typedef struct win32_allocation {
+    u8* memory; // 0 for an empty slot
+    i32 size;
+    memory_tag tag;
+    u64 serial; // Counts up from 1 in the order things got allocated. 0 once it has been reported as a leak
+} win32_allocation;
+
+// Every live EngineAllocate allocation by address, so EngineFree knows its size and tag and can tell when it is handed
+// something it never gave out. Open addressing with linear probing, never more than half full
+#define ALLOCATION_TABLE_MIN_CAPACITY 1024
+
+typedef struct win32_allocation_table {
+    win32_allocation* slots;
+    i32 capacity;
+    i32 count;
+    u64 lastSerial;
+} win32_allocation_table;
+
+// The scene and scratch arenas reserve their address space once and commit more of it as they grow, never less. So
+// once a scene has been through, the next one with the same needs doesn't make a single syscall for its memory
+#define ARENA_ALIGNMENT 16
+#define ARENA_COMMIT_STEP (1024 * 1024)
+#define SCENE_ARENA_RESERVE_SIZE (256 * 1024 * 1024)
+#define SCRATCH_ARENA_RESERVE_SIZE (128 * 1024 * 1024)
+#define SCENE_MEMORY_MAX_DEPTH 8
+
+typedef struct win32_arena {
+    u8* memory; // Reserved on first use
+    size_t reservedSize;
+    size_t committedSize;
+    size_t usedSize;
+} win32_arena;
+
+// How things stood at an EnginePushSceneMemory
+typedef struct win32_scene_mark {
+    size_t usedSize;
+    u64 lastSerial;
+    i64 tagBytes[memory_tag_count];
+    i32 tagCounts[memory_tag_count];
+} win32_scene_mark;
+
+#define MEMORY_LEAKS_MAX_PRINTED 8
+
+#define KeyIndex(key) (i32)((offsetof(keyboard_state, key) - offsetof(keyboard_state, keys)) / sizeof(keyboard_key_state))
+
+typedef struct key_binding {
+    i32 virtualKey;
+    i32 keyIndex;
+} key_binding;
+
+static const key_binding KEY_BINDINGS[] = {
+    { VK_UP,     KeyIndex(up)       },
+    { 'W',       KeyIndex(up)       },
+    { VK_DOWN,   KeyIndex(down)     },
+    { 'S',       KeyIndex(down)     },
+    { VK_LEFT,   KeyIndex(left)     },
+    { 'A',       KeyIndex(left)     },
+    { VK_RIGHT,  KeyIndex(right)    },
+    { 'D',       KeyIndex(right)    },
+    { 'Z',       KeyIndex(z)        },
+    { 'J',       KeyIndex(z)        },
+    { 'X',       KeyIndex(x)        },
+    { 'K',       KeyIndex(x)        },
+    { 'C',       KeyIndex(c)        },
+    { 'L',       KeyIndex(c)        },
+    { VK_SPACE,  KeyIndex(spacebar) },
+    { VK_RETURN, KeyIndex(enter)    },
+    { VK_ESCAPE, KeyIndex(esc)      },
+    { 'F',       KeyIndex(f)        },
+    { 'U',       KeyIndex(u)        },
+    { 'R',       KeyIndex(r)        },
+};
+
 
 static b32 g_isRunning;
 static win32_bitmap g_bitmapBuffer;
 static HWND g_window;
+static win32_job_queue g_jobQueue;
+static b32 g_isWinsockStarted;
+static b32 g_isReportingMemory;
+static SRWLOCK g_memoryLock = SRWLOCK_INIT; // For everything below but the arenas, which only the main thread touches
+static win32_pool g_pool;
+static win32_allocation_table g_allocations;
+static memory_stats g_memoryStats;
+static i64 g_sceneTagBytes[memory_tag_count]; // Scene memory by tag, so a pop knows how much to take off each
+static i32 g_sceneTagCounts[memory_tag_count];
+static win32_arena g_sceneArena   = { .reservedSize = SCENE_ARENA_RESERVE_SIZE };
+static win32_arena g_scratchArena = { .reservedSize = SCRATCH_ARENA_RESERVE_SIZE };
+static win32_scene_mark g_sceneMarks[SCENE_MEMORY_MAX_DEPTH]; // One for every EnginePushSceneMemory still open
+static i32 g_sceneDepth;
+
+static const char* MEMORY_TAG_NAMES[memory_tag_count] = {
+    [memory_tag_other]     = "other",
+    [memory_tag_graphics]  = "graphics",
+    [memory_tag_audio]     = "audio",
+    [memory_tag_scene]     = "scene",
+    [memory_tag_game]      = "game",
+    [memory_tag_bot]       = "bot",
+    [memory_tag_telemetry] = "telemetry",
+    [memory_tag_tools]     = "tools",
+    [memory_tag_files]     = "files",
+};
 
 
 // Credit: Raymond Chen
@@ -48,7 +244,369 @@ static void ToggleFullscreen(HWND window) {
     }
 }
 
-void* EngineReadEntireFile(const char* filePath, i32* bytesRead) {
+static i32 GetPoolSizeClass(i32 size) {
+    i32 sizeClass = 0;
+    while ((1 << (sizeClass + POOL_MIN_BLOCK_SHIFT)) < size) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+// The caller holds g_memoryLock. Returns 0 when the pool is out of chunks, the caller gets the memory some other way
+static void* AllocateFromPool(win32_pool* pool, i32 size) {
+    i32 sizeClass = GetPoolSizeClass(size);
+
+    if (!pool->memory) {
+        pool->memory = VirtualAlloc(NULL, POOL_RESERVE_SIZE, MEM_RESERVE, PAGE_READWRITE);
+    }
+
+    void* block = pool->freeBlocks[sizeClass];
+    if (!block && pool->memory && pool->chunksCount < POOL_CHUNK_COUNT) {
+        u8* chunk = pool->memory + (size_t)pool->chunksCount * POOL_CHUNK_SIZE;
+        if (VirtualAlloc(chunk, POOL_CHUNK_SIZE, MEM_COMMIT, PAGE_READWRITE)) {
+            pool->chunkSizeClasses[pool->chunksCount++] = (u8)sizeClass;
+
+            // Linked back to front, so blocks get handed out in address order
+            i32 blockSize = 1 << (sizeClass + POOL_MIN_BLOCK_SHIFT);
+            for (i32 offset = POOL_CHUNK_SIZE - blockSize; offset >= 0; offset -= blockSize) {
+                *(void**)(chunk + offset) = block;
+                block = chunk + offset;
+            }
+        }
+    }
+    if (block) {
+        pool->freeBlocks[sizeClass] = *(void**)block;
+    }
+
+    return block;
+}
+
+// The caller holds g_memoryLock. Returns false if memory didn't come from the pool
+static b32 FreeToPool(win32_pool* pool, void* memory) {
+    if (!pool->memory || (u8*)memory < pool->memory || (u8*)memory >= pool->memory + POOL_RESERVE_SIZE) {
+        return false;
+    }
+
+    i32 sizeClass = pool->chunkSizeClasses[((u8*)memory - pool->memory) / POOL_CHUNK_SIZE];
+    *(void**)memory = pool->freeBlocks[sizeClass];
+    pool->freeBlocks[sizeClass] = memory;
+
+    return true;
+}
+
+static inline i32 GetAllocationSlot(win32_allocation_table* table, u8* memory) {
+    return (i32)((((u64)(size_t)memory >> 4) * 0x9E3779B97F4A7C15ull) >> 32) & (table->capacity - 1);
+}
+
+static b32 GrowAllocationTable(win32_allocation_table* table) {
+    i32 capacity = table->capacity ? 2 * table->capacity : ALLOCATION_TABLE_MIN_CAPACITY;
+    win32_allocation* slots = VirtualAlloc(NULL, capacity * sizeof(win32_allocation), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!slots) {
+        return false;
+    }
+
+    win32_allocation* oldSlots = table->slots;
+    i32 oldCapacity = table->capacity;
+    table->slots = slots;
+    table->capacity = capacity;
+
+    for (i32 i = 0; i < oldCapacity; ++i) {
+        if (oldSlots[i].memory) {
+            i32 slot = GetAllocationSlot(table, oldSlots[i].memory);
+            while (slots[slot].memory) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            slots[slot] = oldSlots[i];
+        }
+    }
+
+    if (oldSlots) {
+        VirtualFree(oldSlots, 0, MEM_RELEASE);
+    }
+
+    return true;
+}
+
+// The caller holds g_memoryLock
+static void CountAllocation(memory_tag tag, i64 size) {
+    memory_tag_stats* stats = &g_memoryStats.tags[tag];
+    stats->liveBytes += size;
+    stats->highWaterBytes = Max(stats->highWaterBytes, stats->liveBytes);
+    ++stats->liveCount;
+    ++stats->allocationsCount;
+}
+
+// The caller holds g_memoryLock. Returns false if the table couldn't grow
+static b32 TrackAllocation(win32_allocation_table* table, u8* memory, i32 size, memory_tag tag) {
+    if (2 * (table->count + 1) > table->capacity && !GrowAllocationTable(table)) {
+        return false;
+    }
+
+    i32 slot = GetAllocationSlot(table, memory);
+    while (table->slots[slot].memory) {
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    table->slots[slot] = (win32_allocation){
+        .memory = memory,
+        .size   = size,
+        .tag    = tag,
+        .serial = ++table->lastSerial
+    };
+    ++table->count;
+
+    CountAllocation(tag, size);
+
+    return true;
+}
+
+// The caller holds g_memoryLock. Returns false if memory isn't a live allocation
+static b32 UntrackAllocation(win32_allocation_table* table, u8* memory) {
+    if (table->count == 0) {
+        return false;
+    }
+
+    i32 mask = table->capacity - 1;
+    i32 slot = GetAllocationSlot(table, memory);
+    while (table->slots[slot].memory != memory) {
+        if (!table->slots[slot].memory) {
+            return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    memory_tag_stats* stats = &g_memoryStats.tags[table->slots[slot].tag];
+    stats->liveBytes -= table->slots[slot].size;
+    --stats->liveCount;
+
+    // Moves later entries back into the hole when it is on their probe path, so lookups never need tombstones
+    i32 hole = slot;
+    for (i32 next = (hole + 1) & mask; table->slots[next].memory; next = (next + 1) & mask) {
+        i32 home = GetAllocationSlot(table, table->slots[next].memory);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table->slots[hole] = table->slots[next];
+            hole = next;
+        }
+    }
+    table->slots[hole].memory = 0;
+    --table->count;
+
+    return true;
+}
+
+// Returns 0 when the arena is full
+static void* AllocateFromArena(win32_arena* arena, i32 size) {
+    if (!arena->memory) {
+        arena->memory = VirtualAlloc(NULL, arena->reservedSize, MEM_RESERVE, PAGE_READWRITE);
+        if (!arena->memory) {
+            return 0;
+        }
+    }
+
+    size_t start = (arena->usedSize + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (size < 0 || start + size > arena->reservedSize) {
+        return 0;
+    }
+
+    if (start + size > arena->committedSize) {
+        size_t committedSize = (start + size + ARENA_COMMIT_STEP - 1) & ~(size_t)(ARENA_COMMIT_STEP - 1);
+        if (!VirtualAlloc(arena->memory + arena->committedSize, committedSize - arena->committedSize, MEM_COMMIT, PAGE_READWRITE)) {
+            return 0;
+        }
+        arena->committedSize = committedSize;
+    }
+
+    arena->usedSize = start + size;
+
+    return arena->memory + start;
+}
+
+void* EngineAllocate(i32 size, memory_tag tag) {
+    if (size <= 0) {
+        return 0;
+    }
+
+    AcquireSRWLockExclusive(&g_memoryLock);
+
+    u8* memory = 0;
+    if (size <= (1 << POOL_MAX_BLOCK_SHIFT)) {
+        memory = AllocateFromPool(&g_pool, size);
+    }
+    if (memory) {
+        memset(memory, 0, size); // Freed blocks come back dirty
+    }
+    else {
+        memory = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+
+    // Anything EngineFree can't find counts as an invalid free, so rather no memory than untracked memory
+    if (memory && !TrackAllocation(&g_allocations, memory, size, tag)) {
+        if (!FreeToPool(&g_pool, memory)) {
+            VirtualFree(memory, 0, MEM_RELEASE);
+        }
+        memory = 0;
+    }
+
+    ReleaseSRWLockExclusive(&g_memoryLock);
+
+    return memory;
+}
+
+void EngineFree(void* memory) {
+    if (!memory) {
+        return;
+    }
+
+    AcquireSRWLockExclusive(&g_memoryLock);
+
+    // Not freeing it is all we can do, it could be anything
+    b32 isValid = UntrackAllocation(&g_allocations, memory);
+    if (isValid && !FreeToPool(&g_pool, memory)) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+    }
+    if (!isValid) {
+        ++g_memoryStats.invalidFreesCount;
+    }
+
+    ReleaseSRWLockExclusive(&g_memoryLock);
+
+    if (!isValid) {
+        char text[128];
+        sprintf_s(text, sizeof(text), "memory: EngineFree got %p, which isn't a live allocation\n", memory);
+        EnginePrint(text);
+    }
+}
+
+memory_stats EngineGetMemoryStats(void) {
+    AcquireSRWLockShared(&g_memoryLock);
+    memory_stats stats = g_memoryStats;
+    ReleaseSRWLockShared(&g_memoryLock);
+
+    return stats;
+}
+
+static void ReportMemoryStats(const char* when) {
+    memory_stats stats = EngineGetMemoryStats();
+
+    char text[256];
+    sprintf_s(text, sizeof(text), "memory %s: scene %.2f MB (%.2f MB high water), scratch %.2f MB high water, %d invalid frees, %d leaks\n", \
+        when, stats.sceneBytes / (1024.0 * 1024.0), stats.sceneHighWaterBytes / (1024.0 * 1024.0), stats.scratchHighWaterBytes / (1024.0 * 1024.0), \
+        stats.invalidFreesCount, stats.leaksCount);
+    EnginePrint(text);
+
+    for (i32 tag = 0; tag < memory_tag_count; ++tag) {
+        memory_tag_stats* tagStats = &stats.tags[tag];
+        if (tagStats->allocationsCount > 0) {
+            sprintf_s(text, sizeof(text), "    %-10s %9.1f KB in %5d (%9.1f KB high water), %lld allocations\n", \
+                MEMORY_TAG_NAMES[tag], tagStats->liveBytes / 1024.0, tagStats->liveCount, tagStats->highWaterBytes / 1024.0, tagStats->allocationsCount);
+            EnginePrint(text);
+        }
+    }
+}
+
+// Scenes nest, the pause menu sits on top of the game it paused, so pops have to come in the opposite order of pushes
+void EnginePushSceneMemory(void) {
+    if (g_sceneDepth == SCENE_MEMORY_MAX_DEPTH) {
+        return;
+    }
+
+    win32_scene_mark* mark = &g_sceneMarks[g_sceneDepth++];
+    mark->usedSize = g_sceneArena.usedSize;
+
+    AcquireSRWLockExclusive(&g_memoryLock);
+    mark->lastSerial = g_allocations.lastSerial;
+    memcpy(mark->tagBytes, g_sceneTagBytes, sizeof(g_sceneTagBytes));
+    memcpy(mark->tagCounts, g_sceneTagCounts, sizeof(g_sceneTagCounts));
+    ReleaseSRWLockExclusive(&g_memoryLock);
+}
+
+// Whatever EngineAllocate gave out since the push and is still around now counts as a leak, the scene should have freed it
+void EnginePopSceneMemory(void) {
+    if (g_sceneDepth == 0) {
+        return;
+    }
+
+    win32_scene_mark* mark = &g_sceneMarks[--g_sceneDepth];
+    g_sceneArena.usedSize = mark->usedSize;
+
+    win32_allocation leaks[MEMORY_LEAKS_MAX_PRINTED];
+    i32 leaksCount = 0;
+
+    AcquireSRWLockExclusive(&g_memoryLock);
+
+    for (i32 tag = 0; tag < memory_tag_count; ++tag) {
+        g_memoryStats.tags[tag].liveBytes -= g_sceneTagBytes[tag] - mark->tagBytes[tag];
+        g_memoryStats.tags[tag].liveCount -= g_sceneTagCounts[tag] - mark->tagCounts[tag];
+        g_sceneTagBytes[tag]  = mark->tagBytes[tag];
+        g_sceneTagCounts[tag] = mark->tagCounts[tag];
+    }
+    g_memoryStats.sceneBytes = mark->usedSize;
+
+    for (i32 i = 0; i < g_allocations.capacity; ++i) {
+        win32_allocation* allocation = &g_allocations.slots[i];
+        if (allocation->memory && allocation->serial > mark->lastSerial) {
+            if (leaksCount < MEMORY_LEAKS_MAX_PRINTED) {
+                leaks[leaksCount] = *allocation;
+            }
+            ++leaksCount;
+            allocation->serial = 0; // Once is enough, the scene under this one shouldn't report it again
+        }
+    }
+    g_memoryStats.leaksCount += leaksCount;
+
+    ReleaseSRWLockExclusive(&g_memoryLock);
+
+    for (i32 i = 0; i < Min(leaksCount, MEMORY_LEAKS_MAX_PRINTED); ++i) {
+        char text[128];
+        sprintf_s(text, sizeof(text), "memory: leaked %d bytes of %s at %p, allocated in the scene that just closed\n", leaks[i].size, MEMORY_TAG_NAMES[leaks[i].tag], leaks[i].memory);
+        EnginePrint(text);
+    }
+    if (leaksCount > MEMORY_LEAKS_MAX_PRINTED) {
+        char text[64];
+        sprintf_s(text, sizeof(text), "memory: and %d more leaks\n", leaksCount - MEMORY_LEAKS_MAX_PRINTED);
+        EnginePrint(text);
+    }
+
+    if (g_isReportingMemory) {
+        ReportMemoryStats("after a scene closed");
+    }
+}
+
+void* EngineAllocateScene(i32 size, memory_tag tag) {
+    void* memory = AllocateFromArena(&g_sceneArena, size);
+    if (!memory) {
+        return 0;
+    }
+
+    memset(memory, 0, size); // Could be left over from the last scene
+
+    AcquireSRWLockExclusive(&g_memoryLock);
+    CountAllocation(tag, size);
+    g_sceneTagBytes[tag] += size;
+    ++g_sceneTagCounts[tag];
+    g_memoryStats.sceneBytes = g_sceneArena.usedSize;
+    g_memoryStats.sceneHighWaterBytes = Max(g_memoryStats.sceneHighWaterBytes, g_memoryStats.sceneBytes);
+    ReleaseSRWLockExclusive(&g_memoryLock);
+
+    return memory;
+}
+
+void* EngineAllocateScratch(i32 size) {
+    void* memory = AllocateFromArena(&g_scratchArena, size);
+
+    AcquireSRWLockExclusive(&g_memoryLock);
+    g_memoryStats.scratchHighWaterBytes = Max(g_memoryStats.scratchHighWaterBytes, (i64)g_scratchArena.usedSize);
+    ReleaseSRWLockExclusive(&g_memoryLock);
+
+    return memory;
+}
+
+void EngineFreeScratch(void* memory) {
+    if ((u8*)memory >= g_scratchArena.memory && (u8*)memory < g_scratchArena.memory + g_scratchArena.usedSize) {
+        g_scratchArena.usedSize = (u8*)memory - g_scratchArena.memory;
+    }
+}
+
+static void* ReadEntireFile(const char* filePath, i32* bytesRead, b32 isScratch) {
     HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
     if (fileHandle == INVALID_HANDLE_VALUE) {
         *bytesRead = 0;
@@ -56,13 +614,13 @@ void* EngineReadEntireFile(const char* filePath, i32* bytesRead) {
     }
 
     LARGE_INTEGER fileSize;
-    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart > 0x7FFFFFFF) {
         CloseHandle(fileHandle);
         *bytesRead = 0;
         return 0;
     }
 
-    void* fileBuffer = VirtualAlloc(NULL, fileSize.QuadPart, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    void* fileBuffer = isScratch ? EngineAllocateScratch((i32)fileSize.QuadPart) : EngineAllocate((i32)fileSize.QuadPart, memory_tag_files);
     if (!fileBuffer) {
         CloseHandle(fileHandle);
         *bytesRead = 0;
@@ -70,7 +628,12 @@ void* EngineReadEntireFile(const char* filePath, i32* bytesRead) {
     }
 
     if (!ReadFile(fileHandle, fileBuffer, fileSize.QuadPart, bytesRead, NULL)) {
-        VirtualFree(fileBuffer, 0, MEM_RELEASE);
+        if (isScratch) {
+            EngineFreeScratch(fileBuffer);
+        }
+        else {
+            EngineFree(fileBuffer);
+        }
         CloseHandle(fileHandle);
         *bytesRead = 0;
         return 0;
@@ -81,6 +644,14 @@ void* EngineReadEntireFile(const char* filePath, i32* bytesRead) {
     return fileBuffer;
 }
 
+void* EngineReadEntireFile(const char* filePath, i32* bytesRead) {
+    return ReadEntireFile(filePath, bytesRead, false);
+}
+
+void* EngineReadEntireFileToScratch(const char* filePath, i32* bytesRead) {
+    return ReadEntireFile(filePath, bytesRead, true);
+}
+
 b32 EngineWriteEntireFile(const char* filePath, const void* buffer, i32 bufferSize) {
     HANDLE fileHandle = CreateFileA(filePath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
     if (fileHandle == INVALID_HANDLE_VALUE) {
@@ -98,12 +669,63 @@ b32 EngineWriteEntireFile(const char* filePath, const void* buffer, i32 bufferSi
     return bytesWritten == bufferSize;
 }
 
-void* EngineAllocate(i32 size) {
-    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+// Creates the file if it isn't there. Nothing else can write to it meanwhile, readers are fine
+b32 EngineAppendToFile(const char* filePath, const void* buffer, i32 bufferSize) {
+    HANDLE fileHandle = CreateFileA(filePath, FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    DWORD bytesWritten;
+    if (!WriteFile(fileHandle, buffer, bufferSize, &bytesWritten, NULL)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    CloseHandle(fileHandle);
+
+    return bytesWritten == bufferSize;
+}
+
+b32 EngineDeleteFile(const char* filePath) {
+    return DeleteFileA(filePath);
 }
 
-void EngineFree(void* memory) {
-    VirtualFree(memory, 0, MEM_RELEASE);
+// Returns 0 if there is no file
+engine_file EngineOpenFile(const char* filePath, i64* outFileSize) {
+    HANDLE fileHandle = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        return 0;
+    }
+
+    *outFileSize = fileSize.QuadPart;
+    return fileHandle;
+}
+
+// Returns false unless all size bytes were there
+b32 EngineReadFromFile(engine_file file, i64 offset, void* buffer, i32 size) {
+    OVERLAPPED overlapped = { 0 }; // The handle isn't overlapped, so this just says where to read from
+    overlapped.Offset = (DWORD)offset;
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+    DWORD bytesRead;
+    if (!ReadFile(file, buffer, size, &bytesRead, &overlapped)) {
+        return false;
+    }
+
+    return bytesRead == (DWORD)size;
+}
+
+void EngineCloseFile(engine_file file) {
+    if (file) {
+        CloseHandle(file);
+    }
 }
 
 static void ClearSoundBuffer(LPDIRECTSOUNDBUFFER* soundBuffer) {
@@ -210,6 +832,192 @@ static inline f32 PerformanceCountDiffInSeconds(LARGE_INTEGER startCount, LARGE_
     return (endCount.QuadPart - startCount.QuadPart) / (f32)performanceFrequency.QuadPart;
 }
 
+#define FRAME_PACER_HYBRID_MARGIN_MS      1.0f
+#define FRAME_PACER_ADAPTIVE_MIN_MARGIN_MS 0.1f
+#define FRAME_PACER_ADAPTIVE_MAX_MARGIN_MS 4.0f
+#define FRAME_PACER_LEARNING_RATE         0.05
+
+static inline i64 MillisecondsToTicks(frame_pacer* pacer, f64 milliseconds) {
+    return (i64)(milliseconds * pacer->frequency / 1000.0);
+}
+
+static inline f32 TicksToMilliseconds(frame_pacer* pacer, i64 ticks) {
+    return 1000.0f * ticks / (f32)pacer->frequency;
+}
+
+static void InitFramePacer(frame_pacer* pacer, frame_pacer_mode mode, i32 targetHz) {
+    *pacer = (frame_pacer){ .mode = mode };
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    pacer->frequency = frequency.QuadPart;
+
+    if (mode != frame_pacer_mode_uncapped && targetHz > 0) {
+        pacer->ticksPerFrame = pacer->frequency / targetHz;
+    }
+    else {
+        pacer->mode = frame_pacer_mode_uncapped;
+    }
+
+    pacer->timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    pacer->isTimerHighResolution = pacer->timer != NULL;
+    if (!pacer->timer) {
+        pacer->timer = CreateWaitableTimerW(NULL, FALSE, NULL);
+    }
+
+    // The regular timer is only as good as timeBeginPeriod(1), so start out a bit more careful with it
+    f32 initialMarginMs = pacer->isTimerHighResolution ? FRAME_PACER_HYBRID_MARGIN_MS : 2.0f * FRAME_PACER_HYBRID_MARGIN_MS;
+    pacer->spinMarginTicks = MillisecondsToTicks(pacer, initialMarginMs);
+    pacer->wakeupErrorMean = 0.5 * pacer->spinMarginTicks;
+    pacer->wakeupErrorDeviation = 0.25 * pacer->spinMarginTicks;
+
+    pacer->lastFrameEnd = GetCurrentPerformanceCount().QuadPart;
+    pacer->deadline = pacer->lastFrameEnd + pacer->ticksPerFrame;
+}
+
+static void SleepOnTimer(frame_pacer* pacer, i64 ticks) {
+    LARGE_INTEGER dueTime = { .QuadPart = -(ticks * 10000000 / pacer->frequency) }; // Relative, in 100 ns units
+    if (dueTime.QuadPart >= 0) {
+        return;
+    }
+
+    if (pacer->timer && SetWaitableTimer(pacer->timer, &dueTime, 0, NULL, NULL, FALSE)) {
+        WaitForSingleObject(pacer->timer, INFINITE);
+    }
+    else {
+        DWORD milliseconds = (DWORD)(-dueTime.QuadPart / 10000);
+        if (milliseconds >= 1) {
+            Sleep(milliseconds);
+        }
+    }
+}
+
+static void LearnWakeupError(frame_pacer* pacer, i64 errorTicks) {
+    f64 difference = errorTicks - pacer->wakeupErrorMean;
+    pacer->wakeupErrorMean += FRAME_PACER_LEARNING_RATE * difference;
+    pacer->wakeupErrorDeviation += FRAME_PACER_LEARNING_RATE * ((difference < 0 ? -difference : difference) - pacer->wakeupErrorDeviation);
+
+    // Leave room for a few deviations worth of bad luck before we have to count it as a late wakeup
+    f64 margin = pacer->wakeupErrorMean + 4.0 * pacer->wakeupErrorDeviation;
+    margin = Clamp(margin, (f64)MillisecondsToTicks(pacer, FRAME_PACER_ADAPTIVE_MIN_MARGIN_MS), (f64)MillisecondsToTicks(pacer, FRAME_PACER_ADAPTIVE_MAX_MARGIN_MS));
+    pacer->spinMarginTicks = (i64)margin;
+}
+
+static void RecordFrame(frame_pacer_stats* stats, b32 didMissDeadline, b32 didWakeUpLate, i64 latenessTicks, i64 sleepTicks, i64 spinTicks) {
+    ++stats->frameCount;
+    stats->missedDeadlineCount += didMissDeadline;
+    stats->lateWakeupCount += didWakeUpLate;
+    stats->worstLatenessTicks = Max(stats->worstLatenessTicks, latenessTicks);
+    stats->totalSleepTicks += sleepTicks;
+    stats->totalSpinTicks += spinTicks;
+}
+
+// Returns the duration of the frame that just ended in seconds
+static f32 WaitForEndOfFrame(frame_pacer* pacer) {
+    i64 now = GetCurrentPerformanceCount().QuadPart;
+
+    if (pacer->mode == frame_pacer_mode_uncapped) {
+        f32 seconds = (now - pacer->lastFrameEnd) / (f32)pacer->frequency;
+        RecordFrame(&pacer->stats, false, false, 0, 0, 0);
+        RecordFrame(&pacer->statsTotal, false, false, 0, 0, 0);
+        pacer->lastFrameEnd = now;
+        return seconds;
+    }
+
+    b32 didMissDeadline = now > pacer->deadline;
+    b32 didWakeUpLate = false;
+    i64 sleepTicks = 0;
+    i64 spinTicks = 0;
+
+    if (!didMissDeadline) {
+        i64 margin = pacer->mode == frame_pacer_mode_fixed ? 0 : pacer->spinMarginTicks;
+        i64 wakeupTarget = pacer->deadline - margin;
+
+        if (wakeupTarget > now) {
+            SleepOnTimer(pacer, wakeupTarget - now);
+
+            i64 wokeUpAt = GetCurrentPerformanceCount().QuadPart;
+            sleepTicks = wokeUpAt - now;
+            if (pacer->mode == frame_pacer_mode_adaptive) {
+                LearnWakeupError(pacer, wokeUpAt - wakeupTarget);
+            }
+            now = wokeUpAt;
+        }
+
+        if (pacer->mode != frame_pacer_mode_fixed) {
+            i64 spinStart = now;
+            while (now < pacer->deadline) {
+                YieldProcessor();
+                now = GetCurrentPerformanceCount().QuadPart;
+            }
+            spinTicks = now - spinStart;
+        }
+
+        didWakeUpLate = now > pacer->deadline + pacer->ticksPerFrame / 100;
+    }
+
+    i64 latenessTicks = Max(now - pacer->deadline, 0);
+    RecordFrame(&pacer->stats, didMissDeadline, didWakeUpLate, latenessTicks, sleepTicks, spinTicks);
+    RecordFrame(&pacer->statsTotal, didMissDeadline, didWakeUpLate, latenessTicks, sleepTicks, spinTicks);
+
+    // Keep the game's timing the same as before when we make it in time
+    f32 seconds = didMissDeadline ? (now - pacer->lastFrameEnd) / (f32)pacer->frequency : pacer->ticksPerFrame / (f32)pacer->frequency;
+
+    // Deadlines are absolute so that small errors don't add up. If we fall behind by a whole frame we just start over from now
+    pacer->deadline += pacer->ticksPerFrame;
+    if (pacer->deadline <= now) {
+        pacer->deadline = now + pacer->ticksPerFrame;
+    }
+    pacer->lastFrameEnd = now;
+
+    return seconds;
+}
+
+static void ReportFramePacerStats(frame_pacer* pacer) {
+    frame_pacer_stats* stats = &pacer->stats;
+    if (stats->frameCount == 0) {
+        return;
+    }
+
+    char buffer[256];
+    sprintf_s(buffer, sizeof(buffer), "pacer: %d frames, %d missed (%d total), %d late wakeups (%d total), worst %.2f ms late, margin %.3f ms, slept %.2f ms/f, spun %.2f ms/f%s\n", \
+        stats->frameCount, stats->missedDeadlineCount, pacer->statsTotal.missedDeadlineCount, stats->lateWakeupCount, pacer->statsTotal.lateWakeupCount, \
+        TicksToMilliseconds(pacer, stats->worstLatenessTicks), TicksToMilliseconds(pacer, pacer->spinMarginTicks), \
+        TicksToMilliseconds(pacer, stats->totalSleepTicks) / stats->frameCount, TicksToMilliseconds(pacer, stats->totalSpinTicks) / stats->frameCount, \
+        pacer->isTimerHighResolution ? "" : " (low resolution timer)");
+    OutputDebugStringA(buffer);
+
+    *stats = (frame_pacer_stats){ 0 };
+}
+
+// Usage: Tetris.exe [-pacer uncapped|fixed|hybrid|adaptive] [-fps N] [-inputthread] [-memstats]
+static void ParseFramePacerOptions(const char* cmdLine, frame_pacer_mode* mode, i32* targetHz) {
+    const char* pacer = strstr(cmdLine, "-pacer ");
+    if (pacer) {
+        pacer += sizeof("-pacer ") - 1;
+        if (strncmp(pacer, "uncapped", 8) == 0) {
+            *mode = frame_pacer_mode_uncapped;
+        }
+        else if (strncmp(pacer, "fixed", 5) == 0) {
+            *mode = frame_pacer_mode_fixed;
+        }
+        else if (strncmp(pacer, "hybrid", 6) == 0) {
+            *mode = frame_pacer_mode_hybrid;
+        }
+        else if (strncmp(pacer, "adaptive", 8) == 0) {
+            *mode = frame_pacer_mode_adaptive;
+        }
+    }
+
+    const char* fps = strstr(cmdLine, "-fps ");
+    if (fps) {
+        i32 value = atoi(fps + sizeof("-fps ") - 1);
+        if (value > 0) {
+            *targetHz = value;
+        }
+    }
+}
+
 static win32_ivec2 GetWindowDimensions(HWND window) {
     RECT clientRect;
     GetClientRect(window, &clientRect);
@@ -386,12 +1194,172 @@ static void UpdateKeyboardKey(keyboard_key_state* keyState, b32 isDown) {
     }
 }
 
-static void ProcessPendingMessages(HWND window, win32_bitmap* bitmapBuffer, keyboard_state* keyboardState) {
+static i32 GetKeyIndex(WPARAM virtualKey) {
+    for (i32 i = 0; i < ArraySize(KEY_BINDINGS); ++i) {
+        if (KEY_BINDINGS[i].virtualKey == virtualKey) {
+            return KEY_BINDINGS[i].keyIndex;
+        }
+    }
+    return -1;
+}
+
+static b32 PushInputEvent(win32_input_queue* queue, win32_input_event event) {
+    LONG writeIndex = queue->writeIndex;
+    if (writeIndex - queue->readIndex >= INPUT_QUEUE_SIZE) {
+        return false;
+    }
+
+    queue->events[writeIndex & (INPUT_QUEUE_SIZE - 1)] = event;
+    InterlockedExchange(&queue->writeIndex, writeIndex + 1); // Publishes the event
+
+    return true;
+}
+
+static b32 PopInputEvent(win32_input_queue* queue, win32_input_event* outEvent) {
+    LONG readIndex = queue->readIndex;
+    if (readIndex == queue->writeIndex) { // Volatile reads have acquire semantics with MSVC on x86/x64
+        return false;
+    }
+
+    *outEvent = queue->events[readIndex & (INPUT_QUEUE_SIZE - 1)];
+    InterlockedExchange(&queue->readIndex, readIndex + 1);
+
+    return true;
+}
+
+// Polls the keyboard every millisecond so that key changes get timestamps much finer than the frame
+static DWORD WINAPI InputPollingThread(LPVOID parameter) {
+    win32_input_poller* poller = parameter;
+
+    HANDLE timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) {
+        timer = CreateWaitableTimerW(NULL, FALSE, NULL);
+    }
+    LARGE_INTEGER dueTime = { .QuadPart = -10000 }; // 1 ms
+    if (!timer || !SetWaitableTimer(timer, &dueTime, 1, NULL, NULL, FALSE)) {
+        return 1;
+    }
+
+    b32 keysDown[ArraySize(((keyboard_state*)0)->keys)] = { 0 };
+
+    while (poller->isRunning) {
+        WaitForSingleObject(timer, INFINITE);
+
+        b32 newKeysDown[ArraySize(keysDown)] = { 0 };
+        if (GetForegroundWindow() == g_window) { // GetAsyncKeyState doesn't care about focus
+            for (i32 i = 0; i < ArraySize(KEY_BINDINGS); ++i) {
+                if (GetAsyncKeyState(KEY_BINDINGS[i].virtualKey) & 0x8000) {
+                    newKeysDown[KEY_BINDINGS[i].keyIndex] = true;
+                }
+            }
+        }
+
+        i64 now = GetCurrentPerformanceCount().QuadPart;
+        for (i32 i = 0; i < ArraySize(keysDown); ++i) {
+            // If the queue is full (the main thread is stuck, eg. in a window drag) the change gets tried again next poll
+            if (newKeysDown[i] != keysDown[i] && PushInputEvent(&poller->queue, (win32_input_event){ .performanceCount = now, .keyIndex = i, .isDown = newKeysDown[i] })) {
+                keysDown[i] = newKeysDown[i];
+            }
+        }
+    }
+
+    CloseHandle(timer);
+
+    return 0;
+}
+
+static b32 StartInputPoller(win32_input_poller* poller) {
+    poller->isRunning = true;
+    poller->thread = CreateThread(NULL, 0, InputPollingThread, poller, 0, NULL);
+    if (!poller->thread) {
+        poller->isRunning = false;
+        return false;
+    }
+
+    SetThreadPriority(poller->thread, THREAD_PRIORITY_TIME_CRITICAL);
+
+    return true;
+}
+
+static void StopInputPoller(win32_input_poller* poller) {
+    if (poller->thread) {
+        InterlockedExchange(&poller->isRunning, false);
+        WaitForSingleObject(poller->thread, INFINITE);
+        CloseHandle(poller->thread);
+        poller->thread = 0;
+    }
+}
+
+static void AddInputEvent(keyboard_state* keyboardState, win32_input_event event, i64 performanceCountAtLastUpdate, i64 performanceFrequency) {
+    UpdateKeyboardKey(&keyboardState->keys[event.keyIndex], event.isDown);
+
+    if (keyboardState->eventsCount < MAX_INPUT_EVENTS) {
+        f32 time = (event.performanceCount - performanceCountAtLastUpdate) / (f32)performanceFrequency;
+        keyboardState->events[keyboardState->eventsCount++] = (input_event){
+            .time     = Max(time, 0.0f),
+            .keyIndex = event.keyIndex,
+            .isDown   = event.isDown
+        };
+    }
+}
+
+static void RunQueuedJobs(win32_job_queue* queue, i32 threadIndex) {
+    for (;;) {
+        LONG jobIndex = InterlockedIncrement(&queue->nextJobIndex) - 1;
+        if (jobIndex >= queue->jobsCount) {
+            break;
+        }
+
+        queue->job(queue->data, jobIndex, threadIndex);
+    }
+}
+
+static DWORD WINAPI WorkerThread(LPVOID parameter) {
+    i32 threadIndex = (i32)(INT_PTR)parameter;
+
+    for (;;) {
+        WaitForSingleObject(g_jobQueue.semaphore, INFINITE);
+        RunQueuedJobs(&g_jobQueue, threadIndex);
+        InterlockedIncrement(&g_jobQueue.workersDone);
+    }
+}
+
+// The main thread counts as one of the threads, so one core gets no worker. The workers live until the process exits
+static void StartWorkerThreads(win32_job_queue* queue, i32 threadsCount) {
+    queue->semaphore = CreateSemaphoreW(NULL, 0, MAX_WORKER_THREADS, NULL);
+    if (!queue->semaphore) {
+        return;
+    }
+
+    for (i32 i = 0; i < Min(threadsCount - 1, MAX_WORKER_THREADS); ++i) {
+        HANDLE thread = CreateThread(NULL, 0, WorkerThread, (LPVOID)(INT_PTR)(i + 1), 0, NULL);
+        if (!thread) {
+            break;
+        }
+        queue->threads[queue->workersCount++] = thread;
+    }
+}
+
+// message.time is in GetTickCount milliseconds, which only move once per system timer tick (usually 15.6 ms). That is
+// still closer than when the queue happened to get drained, but the timing is only finer than a frame with -inputthread
+static i64 GetMessagePerformanceCount(DWORD messageTime, i64 performanceFrequency) {
+    i64 now = GetCurrentPerformanceCount().QuadPart;
+    DWORD age = GetTickCount() - messageTime; // Both wrap around the same way
+    if (age > 1000) { // Not from this queue drain, so the clocks don't agree about something
+        return now;
+    }
+
+    return now - (i64)age * performanceFrequency / 1000;
+}
+
+// If the poller is running, it is the only source of key events. The messages are only used for the mouse then
+static void ProcessPendingMessages(HWND window, win32_bitmap* bitmapBuffer, keyboard_state* keyboardState, win32_input_poller* poller, i64 performanceCountAtLastUpdate, i64 performanceFrequency) {
     for (i32 i = 0; i < ArraySize(keyboardState->keys); ++i) {
         keyboardState->keys[i].didChangeState = false;
     }
     keyboardState->mouseLeft.didChangeState  = false;
     keyboardState->mouseRight.didChangeState = false;
+    keyboardState->eventsCount = 0;
 
     MSG message;
     while (PeekMessage(&message, 0, 0, 0, PM_REMOVE)) {
@@ -404,49 +1372,14 @@ static void ProcessPendingMessages(HWND window, win32_bitmap* bitmapBuffer, keyb
                 b32 isDown  = (message.lParam & (1 << 31)) == 0;
                 b32 altKeyIsDown = (message.lParam & (1 << 29)) != 0 && isDown;
 
-                if (wasDown != isDown) {
-                    switch (message.wParam) {
-                        case VK_UP: 
-                        case 'W': {
-                            UpdateKeyboardKey(&keyboardState->up, isDown);
-                        } break;
-                        case VK_DOWN:
-                        case 'S': {
-                            UpdateKeyboardKey(&keyboardState->down, isDown);
-                        } break;
-                        case VK_LEFT:
-                        case 'A': {
-                            UpdateKeyboardKey(&keyboardState->left, isDown);
-                        } break;
-                        case VK_RIGHT:
-                        case 'D': {
-                            UpdateKeyboardKey(&keyboardState->right, isDown);
-                        } break;
-                        case 'Z':
-                        case 'J': {
-                            UpdateKeyboardKey(&keyboardState->z, isDown);
-                        } break;
-                        case 'X':
-                        case 'K': {
-                            UpdateKeyboardKey(&keyboardState->x, isDown);
-                        } break;
-                        case 'C':
-                        case 'L': {
-                            UpdateKeyboardKey(&keyboardState->c, isDown);
-                        } break;
-                        case VK_SPACE: {
-                            UpdateKeyboardKey(&keyboardState->spacebar, isDown);
-                        } break;
-                        case VK_RETURN: {
-                            UpdateKeyboardKey(&keyboardState->enter, isDown);
-                        } break;
-                        case VK_ESCAPE: {
-                            UpdateKeyboardKey(&keyboardState->esc, isDown);
-                        } break;
-                        case 'F': {
-                            UpdateKeyboardKey(&keyboardState->f, isDown);
-                        } break;
-                    }
+                i32 keyIndex = GetKeyIndex(message.wParam);
+                if (wasDown != isDown && keyIndex != -1 && !poller->thread) {
+                    win32_input_event event = {
+                        .performanceCount = GetMessagePerformanceCount(message.time, performanceFrequency),
+                        .keyIndex = keyIndex,
+                        .isDown = isDown
+                    };
+                    AddInputEvent(keyboardState, event, performanceCountAtLastUpdate, performanceFrequency);
                 }
             } break;
             case WM_LBUTTONDOWN:
@@ -462,6 +1395,11 @@ static void ProcessPendingMessages(HWND window, win32_bitmap* bitmapBuffer, keyb
         TranslateMessage(&message);
         DispatchMessageA(&message);
     }
+
+    win32_input_event event;
+    while (PopInputEvent(&poller->queue, &event)) {
+        AddInputEvent(keyboardState, event, performanceCountAtLastUpdate, performanceFrequency);
+    }
 }
 
 static void GetCursorPosition(HWND window, win32_bitmap* bitmap, i32* outX, i32* outY) {
@@ -526,6 +1464,19 @@ static LRESULT CALLBACK WndProc(HWND window, UINT message, WPARAM wParam, LPARAM
 }
 
 int CALLBACK WinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prevInstance, _In_ LPSTR cmdLine, _In_ int showCmd) {
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    StartWorkerThreads(&g_jobQueue, systemInfo.dwNumberOfProcessors);
+
+    g_isReportingMemory = strstr(cmdLine, "-memstats") != 0;
+
+    if (RunTool(cmdLine)) {
+        if (g_isReportingMemory) {
+            ReportMemoryStats("after the tool");
+        }
+        return 0;
+    }
+
     WNDCLASSA windowClass = {
         .style = CS_HREDRAW | CS_VREDRAW,
         .lpfnWndProc = WndProc,
@@ -568,6 +1519,19 @@ int CALLBACK WinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prevInstance, _
     if (screenRefreshRate > 1 && screenRefreshRate < refreshRate) {
         refreshRate = screenRefreshRate;
     }
+
+    frame_pacer_mode pacerMode = frame_pacer_mode_adaptive;
+    ParseFramePacerOptions(cmdLine, &pacerMode, &refreshRate);
+
+    frame_pacer pacer;
+    InitFramePacer(&pacer, pacerMode, refreshRate);
+
+    static win32_input_poller poller;
+    if (strstr(cmdLine, "-inputthread")) {
+        StartInputPoller(&poller);
+    }
+    i64 performanceCountAtLastUpdate = GetCurrentPerformanceCount().QuadPart;
+
     f32 secondsPerFrame = 1.0f / refreshRate;
 
     f32 secondsForLastFrame = secondsPerFrame;
@@ -579,13 +1543,13 @@ int CALLBACK WinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prevInstance, _
 
     InitBitmap(&g_bitmapBuffer, BITMAP_WIDTH, BITMAP_HEIGHT);
 
-    OnStartup();
+    OnStartup(cmdLine);
 
     g_isRunning = true;
     while (g_isRunning) {
         LARGE_INTEGER performanceCountAtStartOfFrame = GetCurrentPerformanceCount();
 
-        ProcessPendingMessages(g_window, &g_bitmapBuffer, &keyboardState);
+        ProcessPendingMessages(g_window, &g_bitmapBuffer, &keyboardState, &poller, performanceCountAtLastUpdate, performanceFrequence.QuadPart);
 
         CURSORINFO cursorInfo = { .cbSize = sizeof(CURSORINFO) };
         GetCursorInfo(&cursorInfo);
@@ -664,7 +1628,9 @@ int CALLBACK WinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prevInstance, _
             .bytesPerPixel = 4
         };
 
+        performanceCountAtLastUpdate = GetCurrentPerformanceCount().QuadPart;
         Update(&graphicsBuffer, &soundBuffer, &keyboardState, secondsForLastFrame);
+        g_scratchArena.usedSize = 0; // Scratch memory only lasts the frame
 
         if (soundIsValid) {
             FillSoundBuffer(&secondarySoundBuffer, &soundBuffer, byteToLock, bytesToWrite);
@@ -674,31 +1640,32 @@ int CALLBACK WinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prevInstance, _
         DisplayBitmapInWindow(&g_bitmapBuffer, deviceContext, windowDimensions.x, windowDimensions.y);
 
         LARGE_INTEGER performanceCountAtEndOfFrame = GetCurrentPerformanceCount();
-        f32 secondsElapsedForFrame = PerformanceCountDiffInSeconds(performanceCountAtStartOfFrame, performanceCountAtEndOfFrame, performanceFrequence);
-        if (secondsElapsedForFrame < secondsPerFrame) {
-            secondsForLastFrame = secondsPerFrame;
-            f32 millisecondsToSleep = 1000 * (secondsPerFrame - secondsElapsedForFrame);
-            if (millisecondsToSleep >= 1) {
-                Sleep(millisecondsToSleep - 1);
-            }
-            while (secondsElapsedForFrame < secondsPerFrame) {
-                secondsElapsedForFrame = PerformanceCountDiffInSeconds(performanceCountAtStartOfFrame, GetCurrentPerformanceCount(), performanceFrequence);
-            }
-        }
-        else {
-            secondsForLastFrame = secondsElapsedForFrame;
-        }
+
+        secondsForLastFrame = WaitForEndOfFrame(&pacer);
 #if 1
-        f32 debugSeconds = PerformanceCountDiffInSeconds(performanceCountAtStartOfFrame, GetCurrentPerformanceCount(), performanceFrequence);
-        f32 debugFPS = 1.0f / debugSeconds;
         f32 debugElapsed = PerformanceCountDiffInSeconds(performanceCountAtStartOfFrame, performanceCountAtEndOfFrame, performanceFrequence);
-        char debugBuffer[64];
-        sprintf_s(debugBuffer, 64, "%.2f ms/f, %.2f fps, %.2f elapsed\n", 1000.0f * debugSeconds, debugFPS, 1000.0f * debugElapsed);
-        OutputDebugStringA(debugBuffer);
-
+        static f32 debugSecondsSinceReport = 0.0f;
+        debugSecondsSinceReport += secondsForLastFrame;
+        if (debugSecondsSinceReport >= 1.0f) {
+            debugSecondsSinceReport = 0.0f;
+            char debugBuffer[64];
+            sprintf_s(debugBuffer, 64, "%.2f ms/f, %.2f fps, %.2f elapsed\n", 1000.0f * secondsForLastFrame, 1.0f / secondsForLastFrame, 1000.0f * debugElapsed);
+            OutputDebugStringA(debugBuffer);
+            ReportFramePacerStats(&pacer);
+        }
 #endif
     }
 
+    StopInputPoller(&poller);
+
+    if (g_isReportingMemory) {
+        ReportMemoryStats("at exit");
+    }
+
+    if (pacer.timer) {
+        CloseHandle(pacer.timer);
+    }
+
     timeEndPeriod(1);
 
     return 0;
@@ -717,4 +1684,205 @@ void EngineClose(void) {
 
 void EngineToggleFullscreen(void) {
     ToggleFullscreen(g_window);
+}
+
+// We are a windows subsystem program, so there is no console unless we borrow the one we were started from.
+// If the output is redirected to a file, the handle is already there
+void EnginePrint(const char* text) {
+    static b32 didLookForConsole = false;
+    if (!didLookForConsole) {
+        didLookForConsole = true;
+
+        HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+        if ((!output || output == INVALID_HANDLE_VALUE) && AttachConsole(ATTACH_PARENT_PROCESS)) {
+            output = CreateFileA("CONOUT$", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+            SetStdHandle(STD_OUTPUT_HANDLE, output);
+        }
+    }
+
+    OutputDebugStringA(text);
+
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (output && output != INVALID_HANDLE_VALUE) {
+        DWORD bytesWritten;
+        WriteFile(output, text, (DWORD)strlen(text), &bytesWritten, NULL);
+    }
+}
+
+f64 EngineGetSeconds(void) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return GetCurrentPerformanceCount().QuadPart / (f64)frequency.QuadPart;
+}
+
+i32 EngineGetThreadCount(void) {
+    return g_jobQueue.workersCount + 1;
+}
+
+// Blocks until every job has run. The calling thread runs jobs too, as thread 0
+void EngineRunJobs(engine_job job, void* data, i32 jobsCount) {
+    win32_job_queue* queue = &g_jobQueue;
+
+    i32 workersToWake = Min(queue->workersCount, jobsCount - 1);
+
+    queue->job = job;
+    queue->data = data;
+    queue->jobsCount = jobsCount;
+    queue->workersDone = 0;
+    InterlockedExchange(&queue->nextJobIndex, 0); // Full barrier, so the workers see everything above
+
+    if (workersToWake > 0) {
+        ReleaseSemaphore(queue->semaphore, workersToWake, NULL);
+    }
+
+    RunQueuedJobs(queue, 0);
+
+    // Every job has been taken by now, but the workers might still be running theirs
+    while (queue->workersDone < workersToWake) {
+        YieldProcessor();
+    }
+}
+
+typedef struct win32_thread_start {
+    engine_thread_proc proc;
+    void* data;
+} win32_thread_start;
+
+static DWORD WINAPI EngineThread(LPVOID parameter) {
+    win32_thread_start start = *(win32_thread_start*)parameter;
+    EngineFree(parameter);
+
+    start.proc(start.data);
+
+    return 0;
+}
+
+// Returns 0 if the thread couldn't be started
+engine_thread EngineStartThread(engine_thread_proc proc, void* data) {
+    win32_thread_start* start = EngineAllocate(sizeof(win32_thread_start), memory_tag_other);
+    if (!start) {
+        return 0;
+    }
+    start->proc = proc;
+    start->data = data;
+
+    HANDLE thread = CreateThread(NULL, 0, EngineThread, start, 0, NULL);
+    if (!thread) {
+        EngineFree(start);
+    }
+
+    return thread;
+}
+
+// Waits for the thread to return
+void EngineJoinThread(engine_thread thread) {
+    if (thread) {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+}
+
+engine_signal EngineCreateSignal(void) {
+    return CreateEventW(NULL, FALSE, FALSE, NULL); // Auto-reset, so every wait eats one raise
+}
+
+void EngineFreeSignal(engine_signal signal) {
+    if (signal) {
+        CloseHandle(signal);
+    }
+}
+
+void EngineRaiseSignal(engine_signal signal) {
+    SetEvent(signal);
+}
+
+void EngineWaitForSignal(engine_signal signal) {
+    WaitForSingleObject(signal, INFINITE);
+}
+
+// Both are full barriers and return the old value
+i32 EngineAtomicExchange(volatile i32* target, i32 value) {
+    return InterlockedExchange((volatile LONG*)target, value);
+}
+
+i32 EngineAtomicIncrement(volatile i32* target) {
+    return InterlockedIncrement((volatile LONG*)target) - 1;
+}
+
+// A DLL. Returns 0 if it can't be loaded
+void* EngineLoadLibrary(const char* filePath) {
+    return LoadLibraryA(filePath);
+}
+
+// Returns 0 if the library doesn't export it
+void* EngineGetLibraryFunction(void* library, const char* name) {
+    return (void*)GetProcAddress(library, name);
+}
+
+void EngineFreeLibrary(void* library) {
+    if (library) {
+        FreeLibrary(library);
+    }
+}
+
+// UDP on 127.0.0.1, so the port is the whole address. Never blocks. Returns 0 if the port is taken
+engine_socket EngineOpenSocket(u16 port) {
+    if (!g_isWinsockStarted) {
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+            return 0;
+        }
+        g_isWinsockStarted = true;
+    }
+
+    SOCKET winsockSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (winsockSocket == INVALID_SOCKET) {
+        return 0;
+    }
+
+    struct sockaddr_in address = { 0 };
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    u_long isNonBlocking = 1;
+    if (bind(winsockSocket, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR || ioctlsocket(winsockSocket, FIONBIO, &isNonBlocking) == SOCKET_ERROR) {
+        closesocket(winsockSocket);
+        return 0;
+    }
+
+    return (engine_socket)winsockSocket;
+}
+
+void EngineCloseSocket(engine_socket engineSocket) {
+    if (engineSocket) {
+        closesocket((SOCKET)engineSocket);
+    }
+}
+
+// To the socket on the given port of this machine. Nothing says it gets there
+b32 EngineSendPacket(engine_socket engineSocket, u16 port, const void* data, i32 size) {
+    struct sockaddr_in address = { 0 };
+    address.sin_family      = AF_INET;
+    address.sin_port        = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    return sendto((SOCKET)engineSocket, data, size, 0, (struct sockaddr*)&address, sizeof(address)) == size;
+}
+
+// Returns the size of the packet, or 0 if there isn't one waiting
+i32 EngineReceivePacket(engine_socket engineSocket, void* buffer, i32 bufferSize) {
+    for (;;) {
+        i32 size = recvfrom((SOCKET)engineSocket, buffer, bufferSize, 0, NULL, NULL);
+        if (size != SOCKET_ERROR) {
+            return size;
+        }
+
+        // A send to a port nobody had open yet comes back as a reset on the next receive, and a packet that doesn't
+        // fit gets dropped. Neither means there is nothing more to read
+        i32 error = WSAGetLastError();
+        if (error != WSAECONNRESET && error != WSAEMSGSIZE) {
+            return 0;
+        }
+    }
 }
\ No newline at end of file
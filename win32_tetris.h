@@ -25,13 +25,99 @@ typedef struct sytem_time {
     u16 millisecond;
 } system_time;
 
+// Jobs get run by a pool of worker threads and the thread that called EngineRunJobs. threadIndex is
+// in [0, EngineGetThreadCount()) and never shared by two jobs running at the same time, so it can index per-thread scratch memory
+typedef void (*engine_job)(void* data, i32 jobIndex, i32 threadIndex);
+
+// For work that outlives a frame. These threads are separate from the job pool, so they can call EngineRunJobs only if nothing else does
+typedef void (*engine_thread_proc)(void* data);
+typedef void* engine_thread;
+typedef void* engine_signal; // Wakes up one waiting thread. Raising it while nobody waits makes the next wait return right away
+
+typedef void* engine_socket;
+typedef void* engine_file;
+
+// What memory is for. Only used for EngineGetMemoryStats
+typedef enum memory_tag {
+    memory_tag_other = 0,
+    memory_tag_graphics,  // Bitmaps and fonts
+    memory_tag_audio,     // Sounds and music
+    memory_tag_scene,     // Scene state and data
+    memory_tag_game,      // Boards, history, replays
+    memory_tag_bot,       // Bot search, transposition table, perfect clear solver
+    memory_tag_telemetry,
+    memory_tag_tools,     // Tools, self play, tuning, tournaments, env batches
+    memory_tag_files,     // From EngineReadEntireFile
+    memory_tag_count
+} memory_tag;
+
+typedef struct memory_tag_stats {
+    i64 liveBytes; // As asked for, the pool rounds small allocations up some more
+    i64 highWaterBytes;
+    i32 liveCount;
+    i64 allocationsCount; // Since startup
+} memory_tag_stats;
+
+// EngineAllocate and scene memory together, by tag
+typedef struct memory_stats {
+    memory_tag_stats tags[memory_tag_count];
+    i64 sceneBytes;
+    i64 sceneHighWaterBytes;
+    i64 scratchHighWaterBytes;
+    i32 invalidFreesCount; // EngineFree of something EngineAllocate didn't return, or already freed
+    i32 leaksCount;        // EngineAllocate allocations still live when the scene they were made in closed
+} memory_stats;
+
 
 extern void* EngineReadEntireFile(char* fileName, i32* bytesRead);
 extern b32 EngineWriteEntireFile(const char* fileName, const void* buffer, i32 bufferSize);
-extern void* EngineAllocate(i32 size);
+extern b32 EngineAppendToFile(const char* fileName, const void* buffer, i32 bufferSize);
+extern b32 EngineDeleteFile(const char* fileName);
+
+// For reading parts of a file without loading all of it. Others can still append to it while it is open
+extern engine_file EngineOpenFile(const char* fileName, i64* outFileSize);
+extern b32 EngineReadFromFile(engine_file file, i64 offset, void* buffer, i32 size);
+extern void EngineCloseFile(engine_file file);
+
+// Memory comes back zeroed and 16 byte aligned, except scratch memory which isn't zeroed. EngineAllocate is for anything
+// that can outlive a scene and works from any thread, small sizes come out of a pool so only big ones cost a syscall.
+// The rest is only for the thread that calls Update
+extern void* EngineAllocate(i32 size, memory_tag tag);
 extern void EngineFree(void* memory);
+extern memory_stats EngineGetMemoryStats(void);
+
+// Scene memory lasts until the EnginePopSceneMemory that matches the last EnginePushSceneMemory before it was allocated,
+// and isn't freed one by one. Anything allocated before the first push lasts for the whole run
+extern void EnginePushSceneMemory(void);
+extern void EnginePopSceneMemory(void);
+extern void* EngineAllocateScene(i32 size, memory_tag tag);
+
+// Scratch memory lasts until the end of the frame. EngineFreeScratch gives back memory and everything allocated after it
+extern void* EngineAllocateScratch(i32 size);
+extern void EngineFreeScratch(void* memory);
+extern void* EngineReadEntireFileToScratch(const char* fileName, i32* bytesRead);
+
 extern system_time EngineGetSystemTime(void);
 extern void EngineClose(void);
 extern void EngineToggleFullscreen(void);
+extern void EnginePrint(const char* text);
+extern f64 EngineGetSeconds(void);
+extern i32 EngineGetThreadCount(void);
+extern void EngineRunJobs(engine_job job, void* data, i32 jobsCount);
+extern engine_thread EngineStartThread(engine_thread_proc proc, void* data);
+extern void EngineJoinThread(engine_thread thread);
+extern engine_signal EngineCreateSignal(void);
+extern void EngineFreeSignal(engine_signal signal);
+extern void EngineRaiseSignal(engine_signal signal);
+extern void EngineWaitForSignal(engine_signal signal);
+extern i32 EngineAtomicExchange(volatile i32* target, i32 value);
+extern i32 EngineAtomicIncrement(volatile i32* target);
+extern void* EngineLoadLibrary(const char* filePath);
+extern void* EngineGetLibraryFunction(void* library, const char* name);
+extern void EngineFreeLibrary(void* library);
+extern engine_socket EngineOpenSocket(u16 port);
+extern void EngineCloseSocket(engine_socket socket);
+extern b32 EngineSendPacket(engine_socket socket, u16 port, const void* data, i32 size);
+extern i32 EngineReceivePacket(engine_socket socket, void* buffer, i32 bufferSize);
 
 #endif
\ No newline at end of file